@@ -16,14 +16,16 @@
 //                                                                      //
 // Initial version: Apr 22, 2000                                        //
 //                                                                      //
-// A set of inline byte swapping routines for arrays.                   //
+// A set of byte swapping routines for arrays.                          //
 //                                                                      //
-// The bswapcpy16() and bswapcpy32() routines are used for packing      //
-// arrays of basic types into a buffer in a byte swapped order. Use     //
-// of asm and the `bswap' opcode (available on i486 and up) reduces     //
-// byte swapping overhead on linux.                                     //
+// The bswapcpy16(), bswapcpy32() and bswapcpy64() routines are used    //
+// for packing arrays of basic types into a buffer in a byte swapped    //
+// order, and for unpacking them. On x86 they use the SSSE3 or AVX2     //
+// byte shuffle instructions when the CPU supports them (checked at     //
+// run time), and a scalar loop otherwise.                              //
 //                                                                      //
-// Use of routines is similar to that of memcpy.                        //
+// Use of routines is similar to that of memcpy: the arrays must not    //
+// overlap, and do not have to be aligned.                              //
 //                                                                      //
 // ATTENTION:                                                           //
 //                                                                      //
@@ -32,50 +34,29 @@
 //                                                                      //
 // For arrays of short type (2 bytes in size) use bswapcpy16().         //
 // For arrays of of 4-byte types (int, float) use bswapcpy32().         //
+// For arrays of of 8-byte types (long long, double) use bswapcpy64().  //
 //                                                                      //
 //                                                                      //
 // Author: Alexandre V. Vaniachine <AVVaniachine@lbl.gov>               //
 //                                                                      //
 //////////////////////////////////////////////////////////////////////////
 
-#if !defined(__CINT__)
-#include <sys/types.h>
-#endif
+#include <stddef.h>
 
-extern inline void * bswapcpy16(void * to, const void * from, size_t n)
-{
-int d0, d1, d2, d3;
-__asm__ __volatile__(
-        "cld\n"
-        "1:\tlodsw\n\t"
-        "rorw $8, %%ax\n\t"
-        "stosw\n\t"
-        "loop 1b\n\t"
-        :"=&c" (d0), "=&D" (d1), "=&S" (d2), "=&a" (d3)
-        :"0" (n), "1" ((long) to),"2" ((long) from)
-        :"memory");
-return (to);
-}
+void *bswapcpy16(void *to, const void *from, size_t n);
+void *bswapcpy32(void *to, const void *from, size_t n);
+void *bswapcpy64(void *to, const void *from, size_t n);
+
+namespace ROOT {
+namespace Internal {
+
+/// The implementations of the byte swapping copies. The routines above use the fastest one supported by the CPU.
+enum class EBswapcpyKernel { kScalar, kSSSE3, kAVX2 };
+
+bool IsBswapcpyKernelSupported(EBswapcpyKernel kernel);
+void *BswapcpyWithKernel(EBswapcpyKernel kernel, void *to, const void *from, size_t n, size_t size);
+
+} // namespace Internal
+} // namespace ROOT
 
-extern inline void * bswapcpy32(void * to, const void * from, size_t n)
-{
-int d0, d1, d2, d3;
-__asm__ __volatile__(
-        "cld\n"
-        "1:\tlodsl\n\t"
-#if !defined __i486__ && !defined __pentium__ && !defined __pentiumpro__ && \
-    !defined __pentium4__ && !defined __x86_64__
-        "rorw $8, %%ax\n\t"
-        "rorl $16, %%eax\n\t"
-        "rorw $8, %%ax\n\t"
-#else
-        "bswap %%eax\n\t"
-#endif
-        "stosl\n\t"
-        "loop 1b\n\t"
-        :"=&c" (d0), "=&D" (d1), "=&S" (d2), "=&a" (d3)
-        :"0" (n), "1" ((long) to),"2" ((long) from)
-        :"memory");
-return (to);
-}
 #endif
@@ -0,0 +1,214 @@
+// @(#)root/base:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2017, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+//////////////////////////////////////////////////////////////////////////
+//                                                                      //
+// Bswapcpy                                                             //
+//                                                                      //
+// Byte swapping copies of arrays, see Bswapcpy.h.                      //
+//                                                                      //
+// The vectorized kernels reverse the bytes of each element with one    //
+// byte shuffle per 16 (SSSE3) or 32 (AVX2) bytes: the elements never   //
+// straddle a 16 bytes lane, so AVX2 repeats the SSSE3 mask in its two  //
+// lanes. The kernels are selected once, the first time a routine is    //
+// called, from the features of the CPU. Tests can run each kernel    //
+// with ROOT::Internal::BswapcpyWithKernel.                             //
+//                                                                      //
+//////////////////////////////////////////////////////////////////////////
+
+#include "Bswapcpy.h"
+#include "RtypesCore.h"
+
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5)) && !defined(__INTEL_COMPILER)
+#define R__BSWAPCPY_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef void (*BswapcpyKernel_t)(char *to, const char *from, size_t n);
+
+struct BswapcpyKernels {
+   BswapcpyKernel_t fSwap16;
+   BswapcpyKernel_t fSwap32;
+   BswapcpyKernel_t fSwap64;
+};
+
+inline UShort_t SwapValue(UShort_t x)
+{
+   return (UShort_t)((x >> 8) | (x << 8));
+}
+
+inline UInt_t SwapValue(UInt_t x)
+{
+#if defined(__GNUC__)
+   return __builtin_bswap32(x);
+#else
+   return ((x & 0xff000000u) >> 24) | ((x & 0x00ff0000u) >> 8) | ((x & 0x0000ff00u) << 8) | ((x & 0x000000ffu) << 24);
+#endif
+}
+
+inline ULong64_t SwapValue(ULong64_t x)
+{
+   return ((ULong64_t)SwapValue((UInt_t)x) << 32) | SwapValue((UInt_t)(x >> 32));
+}
+
+/// Byte swap the n elements of type T one by one.
+template <typename T>
+void BswapcpyScalar(char *to, const char *from, size_t n)
+{
+   for (size_t i = 0; i < n; ++i) {
+      T x;
+      memcpy(&x, from + i * sizeof(T), sizeof(T));
+      x = SwapValue(x);
+      memcpy(to + i * sizeof(T), &x, sizeof(T));
+   }
+}
+
+#ifdef R__BSWAPCPY_X86
+
+/// Shuffle masks reversing the bytes of the elements of 2, 4 and 8 bytes, for two 16 bytes lanes.
+alignas(32) const char kSwapMask16[32] = {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+alignas(32) const char kSwapMask32[32] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+alignas(32) const char kSwapMask64[32] = {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                          7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8};
+
+template <typename T>
+const char *GetSwapMask()
+{
+   return sizeof(T) == 2 ? kSwapMask16 : (sizeof(T) == 4 ? kSwapMask32 : kSwapMask64);
+}
+
+template <typename T>
+__attribute__((target("ssse3"))) void BswapcpySSSE3(char *to, const char *from, size_t n)
+{
+   const size_t nbytes = n * sizeof(T);
+   const __m128i mask = _mm_load_si128((const __m128i *)GetSwapMask<T>());
+   size_t i = 0;
+   for (; i + 16 <= nbytes; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(from + i));
+      _mm_storeu_si128((__m128i *)(to + i), _mm_shuffle_epi8(v, mask));
+   }
+   BswapcpyScalar<T>(to + i, from + i, (nbytes - i) / sizeof(T));
+}
+
+template <typename T>
+__attribute__((target("avx2"))) void BswapcpyAVX2(char *to, const char *from, size_t n)
+{
+   const size_t nbytes = n * sizeof(T);
+   const __m256i mask = _mm256_load_si256((const __m256i *)GetSwapMask<T>());
+   size_t i = 0;
+   for (; i + 64 <= nbytes; i += 64) {
+      __m256i v0 = _mm256_loadu_si256((const __m256i *)(from + i));
+      __m256i v1 = _mm256_loadu_si256((const __m256i *)(from + i + 32));
+      _mm256_storeu_si256((__m256i *)(to + i), _mm256_shuffle_epi8(v0, mask));
+      _mm256_storeu_si256((__m256i *)(to + i + 32), _mm256_shuffle_epi8(v1, mask));
+   }
+   for (; i + 32 <= nbytes; i += 32) {
+      __m256i v = _mm256_loadu_si256((const __m256i *)(from + i));
+      _mm256_storeu_si256((__m256i *)(to + i), _mm256_shuffle_epi8(v, mask));
+   }
+   BswapcpyScalar<T>(to + i, from + i, (nbytes - i) / sizeof(T));
+}
+
+#endif // R__BSWAPCPY_X86
+
+/// The kernels of the given implementation, or null kernels if the CPU does not support it.
+BswapcpyKernels GetKernelsOf(ROOT::Internal::EBswapcpyKernel kernel)
+{
+   switch (kernel) {
+#ifdef R__BSWAPCPY_X86
+   case ROOT::Internal::EBswapcpyKernel::kAVX2:
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+         return {BswapcpyAVX2<UShort_t>, BswapcpyAVX2<UInt_t>, BswapcpyAVX2<ULong64_t>};
+      break;
+   case ROOT::Internal::EBswapcpyKernel::kSSSE3:
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("ssse3"))
+         return {BswapcpySSSE3<UShort_t>, BswapcpySSSE3<UInt_t>, BswapcpySSSE3<ULong64_t>};
+      break;
+#endif
+   case ROOT::Internal::EBswapcpyKernel::kScalar:
+      return {BswapcpyScalar<UShort_t>, BswapcpyScalar<UInt_t>, BswapcpyScalar<ULong64_t>};
+   default: break;
+   }
+   return {nullptr, nullptr, nullptr};
+}
+
+BswapcpyKernels SelectKernels()
+{
+   auto kernels = GetKernelsOf(ROOT::Internal::EBswapcpyKernel::kAVX2);
+   if (!kernels.fSwap16)
+      kernels = GetKernelsOf(ROOT::Internal::EBswapcpyKernel::kSSSE3);
+   if (!kernels.fSwap16)
+      kernels = GetKernelsOf(ROOT::Internal::EBswapcpyKernel::kScalar);
+   return kernels;
+}
+
+const BswapcpyKernels &GetKernels()
+{
+   static const BswapcpyKernels kernels = SelectKernels();
+   return kernels;
+}
+
+} // unnamed namespace
+
+////////////////////////////////////////////////////////////////////////////////
+/// Copy n elements of 2 bytes from `from` to `to`, swapping their bytes.
+
+void *bswapcpy16(void *to, const void *from, size_t n)
+{
+   GetKernels().fSwap16((char *)to, (const char *)from, n);
+   return to;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Copy n elements of 4 bytes from `from` to `to`, swapping their bytes.
+
+void *bswapcpy32(void *to, const void *from, size_t n)
+{
+   GetKernels().fSwap32((char *)to, (const char *)from, n);
+   return to;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Copy n elements of 8 bytes from `from` to `to`, swapping their bytes.
+
+void *bswapcpy64(void *to, const void *from, size_t n)
+{
+   GetKernels().fSwap64((char *)to, (const char *)from, n);
+   return to;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Whether the CPU supports the given implementation of the byte swapping copies.
+
+bool ROOT::Internal::IsBswapcpyKernelSupported(EBswapcpyKernel kernel)
+{
+   return GetKernelsOf(kernel).fSwap16 != nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Copy n elements of `size` (2, 4 or 8) bytes from `from` to `to`, swapping their bytes with the given
+/// implementation, which must be supported by the CPU. Meant for testing the implementations one by one.
+
+void *ROOT::Internal::BswapcpyWithKernel(EBswapcpyKernel kernel, void *to, const void *from, size_t n, size_t size)
+{
+   const auto kernels = GetKernelsOf(kernel);
+   auto swap = size == 2 ? kernels.fSwap16 : (size == 4 ? kernels.fSwap32 : kernels.fSwap64);
+   swap((char *)to, (const char *)from, n);
+   return to;
+}
@@ -46,6 +46,20 @@ enum ECompressionAlgorithm {
    kUndefinedCompressionAlgorithm
 };
 
+/// Filters that pre-condition the data before their compression, to make the data of numeric types more
+/// compressible. They can be combined; the filters applied to a compressed block are recorded in its header, so
+/// that they are undone transparently when the block is decompressed.
+enum ECompressionFilter {
+   /// No filter
+   kNoCompressionFilter = 0,
+   /// Replace each element by its difference with the previous one, for slowly varying or monotonic integers
+   kDeltaFilter = 1,
+   /// Group the bytes of the elements by significance (byte shuffle), for floating point and small integer values
+   kShuffleFilter = 2,
+   /// Union of all the filters
+   kAllCompressionFilters = kDeltaFilter | kShuffleFilter
+};
+
 /// Deprecated name, do *not* use:
 static const enum ECompressionAlgorithm kUseGlobalSetting = kUseGlobalCompressionSetting;
 
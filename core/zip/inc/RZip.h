@@ -23,6 +23,13 @@ extern "C" unsigned long R__memcompress(char *tgt, unsigned long tgtsize, char *
 
 extern "C" void R__zipMultipleAlgorithm(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep, ROOT::ECompressionAlgorithm);
 
+/**
+ * Same as R__zipMultipleAlgorithm, after applying the ROOT::ECompressionFilter `filters` to the source buffer seen as
+ * an array of elements of `typesize` bytes (1, 2, 4 or 8).  R__unzip undoes the filters.
+ */
+extern "C" void R__zipFiltered(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep,
+                               ROOT::ECompressionAlgorithm, int filters, int typesize);
+
 /**
  * This is a historical definition, prior to ROOT supporting multiple algorithms in a single file.  Use
  * R__zipMultipleAlgorithm instead.
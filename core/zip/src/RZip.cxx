@@ -16,6 +16,8 @@
 #include "zlib.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 // The size of the ROOT block framing headers for compression:
@@ -30,6 +32,7 @@
 static void R__zipOld(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgrt, int *irep);
 static void R__zipZLIB(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgrt, int *irep);
 static void R__unzipZLIB(int *srcsize, unsigned char *src, int *tgtsize, unsigned char *tgt, int *irep);
+static void R__unzipFiltered(int *srcsize, unsigned char *src, int *tgtsize, unsigned char *tgt, int *irep);
 
 /* ===========================================================================
    R__ZipMode is used to select the compression algorithm when R__zip is called
@@ -238,6 +241,145 @@ void R__zip(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *
                            ROOT::ECompressionAlgorithm::kUseGlobalCompressionSetting);
 }
 
+/**
+ * Pre-conditioning filters (see ROOT::ECompressionFilter).
+ *
+ * The data are seen as an array of `typesize` bytes elements, in the big-endian byte order of the ROOT files.
+ * The trailing bytes that do not make a whole element are left unchanged.
+ *
+ * A filtered block has its own header: the signature "FT", then a byte with the filters in its lower 4 bits and
+ * log2(typesize) in its upper 4 bits, then the usual compressed and decompressed sizes. It is followed by the
+ * block, with its own header, of the filtered data compressed with the requested algorithm.
+ */
+
+static int R__log2TypeSize(int typesize)
+{
+   switch (typesize) {
+   case 2: return 1;
+   case 4: return 2;
+   case 8: return 3;
+   default: return 0;
+   }
+}
+
+static unsigned long long R__loadBigEndian(const unsigned char *src, int typesize)
+{
+   unsigned long long value = 0;
+   for (int i = 0; i < typesize; ++i)
+      value = (value << 8) | src[i];
+   return value;
+}
+
+static void R__storeBigEndian(unsigned char *tgt, int typesize, unsigned long long value)
+{
+   for (int i = typesize - 1; i >= 0; --i) {
+      tgt[i] = (unsigned char)(value & 0xff);
+      value >>= 8;
+   }
+}
+
+/// Replace each element by its difference with the previous one; the differences wrap around.
+static void R__deltaEncode(unsigned char *buf, int size, int typesize)
+{
+   unsigned long long previous = 0;
+   const int nelements = size / typesize;
+   for (int i = 0; i < nelements; ++i) {
+      unsigned char *element = buf + i * typesize;
+      unsigned long long value = R__loadBigEndian(element, typesize);
+      R__storeBigEndian(element, typesize, value - previous);
+      previous = value;
+   }
+}
+
+static void R__deltaDecode(unsigned char *buf, int size, int typesize)
+{
+   unsigned long long previous = 0;
+   const int nelements = size / typesize;
+   for (int i = 0; i < nelements; ++i) {
+      unsigned char *element = buf + i * typesize;
+      previous += R__loadBigEndian(element, typesize);
+      R__storeBigEndian(element, typesize, previous);
+   }
+}
+
+/// Write the first byte of all the elements, then their second byte, etc.
+static void R__shuffle(const unsigned char *src, unsigned char *tgt, int size, int typesize)
+{
+   const int nelements = size / typesize;
+   for (int b = 0; b < typesize; ++b) {
+      for (int i = 0; i < nelements; ++i)
+         tgt[b * nelements + i] = src[i * typesize + b];
+   }
+   memcpy(tgt + nelements * typesize, src + nelements * typesize, size - nelements * typesize);
+}
+
+static void R__unshuffle(const unsigned char *src, unsigned char *tgt, int size, int typesize)
+{
+   const int nelements = size / typesize;
+   for (int b = 0; b < typesize; ++b) {
+      for (int i = 0; i < nelements; ++i)
+         tgt[i * typesize + b] = src[b * nelements + i];
+   }
+   memcpy(tgt + nelements * typesize, src + nelements * typesize, size - nelements * typesize);
+}
+
+void R__zipFiltered(int cxlevel, int *srcsize, char *src, int *tgtsize, char *tgt, int *irep,
+                    ROOT::ECompressionAlgorithm compressionAlgorithm, int filters, int typesize)
+{
+   int log2TypeSize = R__log2TypeSize(typesize);
+   typesize = 1 << log2TypeSize;
+   filters &= ROOT::kAllCompressionFilters;
+   if (typesize == 1)
+      filters &= ~ROOT::kShuffleFilter; // shuffling single bytes does nothing
+   if (!filters) {
+      R__zipMultipleAlgorithm(cxlevel, srcsize, src, tgtsize, tgt, irep, compressionAlgorithm);
+      return;
+   }
+
+   *irep = 0;
+   if (*srcsize < 1 + 2 * HDRSIZE + 1 || *tgtsize <= 2 * HDRSIZE || cxlevel <= 0)
+      return;
+
+   unsigned char *filtered = (unsigned char *)malloc(2 * (size_t)*srcsize);
+   if (!filtered) {
+      R__error("cannot allocate the buffer of the filtered data");
+      return;
+   }
+   unsigned char *delta = filtered + *srcsize;
+   unsigned char *input = (unsigned char *)src;
+   if (filters & ROOT::kDeltaFilter) {
+      memcpy(delta, input, *srcsize);
+      R__deltaEncode(delta, *srcsize, typesize);
+      input = delta;
+   }
+   if (filters & ROOT::kShuffleFilter) {
+      R__shuffle(input, filtered, *srcsize, typesize);
+      input = filtered;
+   }
+
+   int innerTgtSize = *tgtsize - HDRSIZE;
+   int nout = 0;
+   R__zipMultipleAlgorithm(cxlevel, srcsize, (char *)input, &innerTgtSize, tgt + HDRSIZE, &nout,
+                           compressionAlgorithm);
+   free(filtered);
+   if (nout == 0 || nout > 0xffffff)
+      return;
+
+   tgt[0] = 'F'; /* Signature of the filtered blocks */
+   tgt[1] = 'T';
+   tgt[2] = (char)(filters | (log2TypeSize << 4));
+
+   tgt[3] = (char)(nout & 0xff); /* size of the block of the filtered data */
+   tgt[4] = (char)((nout >> 8) & 0xff);
+   tgt[5] = (char)((nout >> 16) & 0xff);
+
+   tgt[6] = (char)(*srcsize & 0xff); /* decompressed size */
+   tgt[7] = (char)((*srcsize >> 8) & 0xff);
+   tgt[8] = (char)((*srcsize >> 16) & 0xff);
+
+   *irep = nout + HDRSIZE;
+}
+
 /**
  * Below are the routines for unzipping (inflating) buffers.
  */
@@ -262,10 +404,16 @@ static int is_valid_header_lz4(unsigned char *src)
    return src[0] == 'L' && src[1] == '4';
 }
 
+static int is_valid_header_filtered(unsigned char *src)
+{
+   return src[0] == 'F' && src[1] == 'T' && (src[2] & 0x0f) && !(src[2] & 0x0f & ~ROOT::kAllCompressionFilters) &&
+          (src[2] >> 4) <= 3;
+}
+
 static int is_valid_header(unsigned char *src)
 {
    return is_valid_header_zlib(src) || is_valid_header_old(src) || is_valid_header_lzma(src) ||
-          is_valid_header_lz4(src);
+          is_valid_header_lz4(src) || is_valid_header_filtered(src);
 }
 
 int R__unzip_header(int *srcsize, uch *src, int *tgtsize)
@@ -357,6 +505,9 @@ void R__unzip(int *srcsize, uch *src, int *tgtsize, uch *tgt, int *irep)
   } else if (is_valid_header_lz4(src)) {
      R__unzipLZ4(srcsize, src, tgtsize, tgt, irep);
      return;
+  } else if (is_valid_header_filtered(src)) {
+     R__unzipFiltered(srcsize, src, tgtsize, tgt, irep);
+     return;
   }
 
   /* Old zlib format */
@@ -409,3 +560,33 @@ void R__unzipZLIB(int *srcsize, unsigned char *src, int *tgtsize, unsigned char
      *irep = stream.total_out;
      return;
 }
+
+/**
+ * Decompress the block of the filtered data that follows the header, then undo the filters.
+ */
+static void R__unzipFiltered(int *srcsize, unsigned char *src, int *tgtsize, unsigned char *tgt, int *irep)
+{
+   const int filters = src[2] & 0x0f;
+   const int typesize = 1 << (src[2] >> 4);
+   int innerSrcSize = *srcsize - HDRSIZE;
+   *irep = 0;
+   int nout = 0;
+   R__unzip(&innerSrcSize, src + HDRSIZE, tgtsize, tgt, &nout);
+   if (nout == 0)
+      return;
+
+   if (filters & ROOT::kShuffleFilter) {
+      unsigned char *shuffled = (unsigned char *)malloc(nout);
+      if (!shuffled) {
+         fprintf(stderr, "R__unzip: cannot allocate the buffer of the filtered data\n");
+         return;
+      }
+      memcpy(shuffled, tgt, nout);
+      R__unshuffle(shuffled, tgt, nout, typesize);
+      free(shuffled);
+   }
+   if (filters & ROOT::kDeltaFilter)
+      R__deltaDecode(tgt, nout, typesize);
+
+   *irep = nout;
+}
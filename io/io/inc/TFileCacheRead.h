@@ -71,6 +71,7 @@ protected:
    Bool_t         fBIsTransferred;
 
    void SetEnablePrefetchingImpl(Bool_t setPrefetching = kFALSE); // Can not be virtual as it is called from the constructor.
+   void StartPrefetching();
 
 private:
    TFileCacheRead(const TFileCacheRead &);            //cannot be copied
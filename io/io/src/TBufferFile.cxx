@@ -40,12 +40,7 @@ The concrete implementation of TBuffer for writing/reading to/from a ROOT file o
 #include "TArrayC.h"
 #include "TROOT.h"
 
-#if (defined(__linux) || defined(__APPLE__)) && defined(__i386__) && \
-     defined(__GNUC__)
-#define USE_BSWAPCPY
-#endif
-
-#ifdef USE_BSWAPCPY
+#ifdef R__BYTESWAP
 #include "Bswapcpy.h"
 #endif
 
@@ -235,6 +230,53 @@ static void frombufOld(char *&buf, Long_t *x)
    buf += sizeof(Long_t);
 }
 
+// Number of elements converted at once by ReadConvertedArray and WriteConvertedArray.
+static const Int_t kConvertChunk = 256;
+
+////////////////////////////////////////////////////////////////////////////////
+/// Read n values of the 4-byte type From from buf and store them converted into
+/// `to`. The values are byte swapped by chunks (see bswapcpy32) into a temporary
+/// array rather than one at a time.
+
+template <typename From, typename To, typename Convert>
+static void ReadConvertedArray(char *&buf, To *to, Int_t n, Convert convert)
+{
+   static_assert(sizeof(From) == 4, "ReadConvertedArray only handles 4-byte values");
+   From chunk[kConvertChunk];
+   for (Int_t i = 0; i < n; i += kConvertChunk) {
+      const Int_t m = (n - i < kConvertChunk) ? n - i : kConvertChunk;
+#ifdef R__BYTESWAP
+      bswapcpy32(chunk, buf, m);
+#else
+      memcpy(chunk, buf, m * sizeof(From));
+#endif
+      buf += m * sizeof(From);
+      for (Int_t j = 0; j < m; j++) to[i + j] = convert(chunk[j]);
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Convert the n elements of `from` to values of the 4-byte type To and write
+/// them into buf, which must be large enough. The values are byte swapped by
+/// chunks (see bswapcpy32) rather than one at a time.
+
+template <typename To, typename From, typename Convert>
+static void WriteConvertedArray(char *&buf, const From *from, Int_t n, Convert convert)
+{
+   static_assert(sizeof(To) == 4, "WriteConvertedArray only handles 4-byte values");
+   To chunk[kConvertChunk];
+   for (Int_t i = 0; i < n; i += kConvertChunk) {
+      const Int_t m = (n - i < kConvertChunk) ? n - i : kConvertChunk;
+      for (Int_t j = 0; j < m; j++) chunk[j] = convert(from[i + j]);
+#ifdef R__BYTESWAP
+      bswapcpy32(buf, chunk, m);
+#else
+      memcpy(buf, chunk, m * sizeof(To));
+#endif
+      buf += m * sizeof(To);
+   }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Read Long from TBuffer.
 
@@ -830,13 +872,8 @@ Int_t TBufferFile::ReadArray(Short_t *&h)
    if (!h) h = new Short_t[n];
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy16(h, fBufCur, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &h[i]);
-# endif
 #else
    memcpy(h, fBufCur, l);
    fBufCur += l;
@@ -863,13 +900,8 @@ Int_t TBufferFile::ReadArray(Int_t *&ii)
    if (!ii) ii = new Int_t[n];
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(ii, fBufCur, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &ii[i]);
-# endif
 #else
    memcpy(ii, fBufCur, l);
    fBufCur += l;
@@ -922,8 +954,8 @@ Int_t TBufferFile::ReadArray(Long64_t *&ll)
    if (!ll) ll = new Long64_t[n];
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &ll[i]);
+   bswapcpy64(ll, fBufCur, n);
+   fBufCur += l;
 #else
    memcpy(ll, fBufCur, l);
    fBufCur += l;
@@ -950,13 +982,8 @@ Int_t TBufferFile::ReadArray(Float_t *&f)
    if (!f) f = new Float_t[n];
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(f, fBufCur, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &f[i]);
-# endif
 #else
    memcpy(f, fBufCur, l);
    fBufCur += l;
@@ -983,8 +1010,8 @@ Int_t TBufferFile::ReadArray(Double_t *&d)
    if (!d) d = new Double_t[n];
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &d[i]);
+   bswapcpy64(d, fBufCur, n);
+   fBufCur += l;
 #else
    memcpy(d, fBufCur, l);
    fBufCur += l;
@@ -1103,13 +1130,8 @@ Int_t TBufferFile::ReadStaticArray(Short_t *h)
    if (!h) return 0;
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy16(h, fBufCur, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &h[i]);
-# endif
 #else
    memcpy(h, fBufCur, l);
    fBufCur += l;
@@ -1135,13 +1157,8 @@ Int_t TBufferFile::ReadStaticArray(Int_t *ii)
    if (!ii) return 0;
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(ii, fBufCur, n);
    fBufCur += sizeof(Int_t)*n;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &ii[i]);
-# endif
 #else
    memcpy(ii, fBufCur, l);
    fBufCur += l;
@@ -1192,8 +1209,8 @@ Int_t TBufferFile::ReadStaticArray(Long64_t *ll)
    if (!ll) return 0;
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &ll[i]);
+   bswapcpy64(ll, fBufCur, n);
+   fBufCur += l;
 #else
    memcpy(ll, fBufCur, l);
    fBufCur += l;
@@ -1219,13 +1236,8 @@ Int_t TBufferFile::ReadStaticArray(Float_t *f)
    if (!f) return 0;
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(f, fBufCur, n);
    fBufCur += sizeof(Float_t)*n;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &f[i]);
-# endif
 #else
    memcpy(f, fBufCur, l);
    fBufCur += l;
@@ -1251,8 +1263,8 @@ Int_t TBufferFile::ReadStaticArray(Double_t *d)
    if (!d) return 0;
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &d[i]);
+   bswapcpy64(d, fBufCur, n);
+   fBufCur += l;
 #else
    memcpy(d, fBufCur, l);
    fBufCur += l;
@@ -1369,13 +1381,8 @@ void TBufferFile::ReadFastArray(Short_t *h, Int_t n)
    if (n <= 0 || l > fBufSize) return;
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy16(h, fBufCur, n);
    fBufCur += sizeof(Short_t)*n;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &h[i]);
-# endif
 #else
    memcpy(h, fBufCur, l);
    fBufCur += l;
@@ -1391,13 +1398,8 @@ void TBufferFile::ReadFastArray(Int_t *ii, Int_t n)
    if (l <= 0 || l > fBufSize) return;
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(ii, fBufCur, n);
    fBufCur += sizeof(Int_t)*n;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &ii[i]);
-# endif
 #else
    memcpy(ii, fBufCur, l);
    fBufCur += l;
@@ -1429,8 +1431,8 @@ void TBufferFile::ReadFastArray(Long64_t *ll, Int_t n)
    if (l <= 0 || l > fBufSize) return;
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &ll[i]);
+   bswapcpy64(ll, fBufCur, n);
+   fBufCur += l;
 #else
    memcpy(ll, fBufCur, l);
    fBufCur += l;
@@ -1446,13 +1448,8 @@ void TBufferFile::ReadFastArray(Float_t *f, Int_t n)
    if (l <= 0 || l > fBufSize) return;
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(f, fBufCur, n);
    fBufCur += sizeof(Float_t)*n;
-# else
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &f[i]);
-# endif
 #else
    memcpy(f, fBufCur, l);
    fBufCur += l;
@@ -1468,8 +1465,8 @@ void TBufferFile::ReadFastArray(Double_t *d, Int_t n)
    if (l <= 0 || l > fBufSize) return;
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      frombuf(fBufCur, &d[i]);
+   bswapcpy64(d, fBufCur, n);
+   fBufCur += l;
 #else
    memcpy(d, fBufCur, l);
    fBufCur += l;
@@ -1488,9 +1485,7 @@ void TBufferFile::ReadFastArrayFloat16(Float_t *f, Int_t n, TStreamerElement *el
       //a range was specified. We read an integer and convert it back to a float
       Double_t xmin = ele->GetXmin();
       Double_t factor = ele->GetFactor();
-      for (int j=0;j < n; j++) {
-         UInt_t aint; *this >> aint; f[j] = (Float_t)(aint/factor + xmin);
-      }
+      ReadConvertedArray<UInt_t>(fBufCur, f, n, [=](UInt_t aint) { return (Float_t)(aint/factor + xmin); });
    } else {
       Int_t i;
       Int_t nbits = 0;
@@ -1525,9 +1520,7 @@ void TBufferFile::ReadFastArrayWithFactor(Float_t *ptr, Int_t n, Double_t factor
    if (n <= 0 || 3*n > fBufSize) return;
 
    //a range was specified. We read an integer and convert it back to a float
-   for (int j=0;j < n; j++) {
-      UInt_t aint; *this >> aint; ptr[j] = (Float_t)(aint/factor + minvalue);
-   }
+   ReadConvertedArray<UInt_t>(fBufCur, ptr, n, [=](UInt_t aint) { return (Float_t)(aint/factor + minvalue); });
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1570,20 +1563,14 @@ void TBufferFile::ReadFastArrayDouble32(Double_t *d, Int_t n, TStreamerElement *
       //a range was specified. We read an integer and convert it back to a double.
       Double_t xmin = ele->GetXmin();
       Double_t factor = ele->GetFactor();
-      for (int j=0;j < n; j++) {
-         UInt_t aint; *this >> aint; d[j] = (Double_t)(aint/factor + xmin);
-      }
+      ReadConvertedArray<UInt_t>(fBufCur, d, n, [=](UInt_t aint) { return (Double_t)(aint/factor + xmin); });
    } else {
       Int_t i;
       Int_t nbits = 0;
       if (ele) nbits = (Int_t)ele->GetXmin();
       if (!nbits) {
          //we read a float and convert it to double
-         Float_t afloat;
-         for (i = 0; i < n; i++) {
-            *this >> afloat;
-            d[i] = (Double_t)afloat;
-         }
+         ReadConvertedArray<Float_t>(fBufCur, d, n, [](Float_t afloat) { return (Double_t)afloat; });
       } else {
          //we read the exponent and the truncated mantissa of the float
          //and rebuild the double.
@@ -1615,9 +1602,7 @@ void TBufferFile::ReadFastArrayWithFactor(Double_t *d, Int_t n, Double_t factor,
    if (n <= 0 || 3*n > fBufSize) return;
 
    //a range was specified. We read an integer and convert it back to a double.
-   for (int j=0;j < n; j++) {
-      UInt_t aint; *this >> aint; d[j] = (Double_t)(aint/factor + minvalue);
-   }
+   ReadConvertedArray<UInt_t>(fBufCur, d, n, [=](UInt_t aint) { return (Double_t)(aint/factor + minvalue); });
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1630,11 +1615,7 @@ void TBufferFile::ReadFastArrayWithNbits(Double_t *d, Int_t n, Int_t nbits)
 
    if (!nbits) {
       //we read a float and convert it to double
-      Float_t afloat;
-      for (Int_t i = 0; i < n; i++) {
-         *this >> afloat;
-         d[i] = (Double_t)afloat;
-      }
+      ReadConvertedArray<Float_t>(fBufCur, d, n, [](Float_t afloat) { return (Double_t)afloat; });
    } else {
       //we read the exponent and the truncated mantissa of the float
       //and rebuild the double.
@@ -1802,13 +1783,8 @@ void TBufferFile::WriteArray(const Short_t *h, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy16(fBufCur, h, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, h[i]);
-# endif
 #else
    memcpy(fBufCur, h, l);
    fBufCur += l;
@@ -1832,13 +1808,8 @@ void TBufferFile::WriteArray(const Int_t *ii, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(fBufCur, ii, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, ii[i]);
-# endif
 #else
    memcpy(fBufCur, ii, l);
    fBufCur += l;
@@ -1900,8 +1871,8 @@ void TBufferFile::WriteArray(const Long64_t *ll, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, ll[i]);
+   bswapcpy64(fBufCur, ll, n);
+   fBufCur += l;
 #else
    memcpy(fBufCur, ll, l);
    fBufCur += l;
@@ -1925,13 +1896,8 @@ void TBufferFile::WriteArray(const Float_t *f, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(fBufCur, f, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, f[i]);
-# endif
 #else
    memcpy(fBufCur, f, l);
    fBufCur += l;
@@ -1955,8 +1921,8 @@ void TBufferFile::WriteArray(const Double_t *d, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, d[i]);
+   bswapcpy64(fBufCur, d, n);
+   fBufCur += l;
 #else
    memcpy(fBufCur, d, l);
    fBufCur += l;
@@ -2068,13 +2034,8 @@ void TBufferFile::WriteFastArray(const Short_t *h, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy16(fBufCur, h, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, h[i]);
-# endif
 #else
    memcpy(fBufCur, h, l);
    fBufCur += l;
@@ -2092,13 +2053,8 @@ void TBufferFile::WriteFastArray(const Int_t *ii, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(fBufCur, ii, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, ii[i]);
-# endif
 #else
    memcpy(fBufCur, ii, l);
    fBufCur += l;
@@ -2144,8 +2100,8 @@ void TBufferFile::WriteFastArray(const Long64_t *ll, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, ll[i]);
+   bswapcpy64(fBufCur, ll, n);
+   fBufCur += l;
 #else
    memcpy(fBufCur, ll, l);
    fBufCur += l;
@@ -2163,13 +2119,8 @@ void TBufferFile::WriteFastArray(const Float_t *f, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-# ifdef USE_BSWAPCPY
    bswapcpy32(fBufCur, f, n);
    fBufCur += l;
-# else
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, f[i]);
-# endif
 #else
    memcpy(fBufCur, f, l);
    fBufCur += l;
@@ -2187,8 +2138,8 @@ void TBufferFile::WriteFastArray(const Double_t *d, Int_t n)
    if (fBufCur + l > fBufMax) AutoExpand(fBufSize+l);
 
 #ifdef R__BYTESWAP
-   for (int i = 0; i < n; i++)
-      tobuf(fBufCur, d[i]);
+   bswapcpy64(fBufCur, d, n);
+   fBufCur += l;
 #else
    memcpy(fBufCur, d, l);
    fBufCur += l;
@@ -2213,12 +2164,11 @@ void TBufferFile::WriteFastArrayFloat16(const Float_t *f, Int_t n, TStreamerElem
       Double_t factor = ele->GetFactor();
       Double_t xmin = ele->GetXmin();
       Double_t xmax = ele->GetXmax();
-      for (int j = 0; j < n; j++) {
-         Float_t x = f[j];
+      WriteConvertedArray<UInt_t>(fBufCur, f, n, [=](Float_t x) {
          if (x < xmin) x = xmin;
          if (x > xmax) x = xmax;
-         UInt_t aint = UInt_t(0.5+factor*(x-xmin)); *this << aint;
-      }
+         return UInt_t(0.5+factor*(x-xmin));
+      });
    } else {
       Int_t nbits = 0;
       //number of bits stored in fXmin (see TStreamerElement::GetRange)
@@ -2264,12 +2214,11 @@ void TBufferFile::WriteFastArrayDouble32(const Double_t *d, Int_t n, TStreamerEl
       Double_t factor = ele->GetFactor();
       Double_t xmin = ele->GetXmin();
       Double_t xmax = ele->GetXmax();
-      for (int j = 0; j < n; j++) {
-         Double_t x = d[j];
+      WriteConvertedArray<UInt_t>(fBufCur, d, n, [=](Double_t x) {
          if (x < xmin) x = xmin;
          if (x > xmax) x = xmax;
-         UInt_t aint = UInt_t(0.5+factor*(x-xmin)); *this << aint;
-      }
+         return UInt_t(0.5+factor*(x-xmin));
+      });
    } else {
       Int_t nbits = 0;
       //number of bits stored in fXmin (see TStreamerElement::GetRange)
@@ -2277,10 +2226,7 @@ void TBufferFile::WriteFastArrayDouble32(const Double_t *d, Int_t n, TStreamerEl
       Int_t i;
       if (!nbits) {
          //if no range and no bits specified, we convert from double to float
-         for (i = 0; i < n; i++) {
-            Float_t afloat = (Float_t)d[i];
-            *this << afloat;
-         }
+         WriteConvertedArray<Float_t>(fBufCur, d, n, [](Double_t x) { return (Float_t)x; });
       } else {
          //a range is not specified, but nbits is.
          //In this case we truncate the mantissa to nbits and we stream
@@ -388,13 +388,18 @@ Int_t TFileCacheRead::ReadBufferExt(char *buf, Long64_t pos, Int_t len, Int_t &l
 
 
 ////////////////////////////////////////////////////////////////////////////////
-///prefetch the first block
+/// Hand the blocks registered with Prefetch and SecondPrefetch since they were
+/// last sorted to the prefetching thread, which reads them in the background.
+/// A TTreeCache calls it as soon as it has registered the baskets of the next
+/// cluster, so that they are read while the current cluster is processed.
 
-Int_t TFileCacheRead::ReadBufferExtPrefetch(char *buf, Long64_t pos, Int_t len, Int_t &loc)
+void TFileCacheRead::StartPrefetching()
 {
+   if (!fPrefetch) return;
+
+   //prefetch the first block
    if (fNseek > 0 && !fIsSorted) {
       Sort();
-      loc = -1;
       fPrefetch->ReadBlock(fPos, fLen, fNb);
       fPrefetchedBlocks++;
       fIsTransferred = kTRUE;
@@ -403,10 +408,20 @@ Int_t TFileCacheRead::ReadBufferExtPrefetch(char *buf, Long64_t pos, Int_t len,
    //try to prefetch the second block
    if (fBNseek > 0 && !fBIsSorted) {
       SecondSort();
-      loc = -1;
       fPrefetch->ReadBlock(fBPos, fBLen, fBNb);
       fPrefetchedBlocks++;
    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+///prefetch the first block
+
+Int_t TFileCacheRead::ReadBufferExtPrefetch(char *buf, Long64_t pos, Int_t len, Int_t &loc)
+{
+   if ((fNseek > 0 && !fIsSorted) || (fBNseek > 0 && !fBIsSorted)) {
+      StartPrefetching();
+      loc = -1;
+   }
 
    // in case we are writing and reading to/from this file, we must check
    // if this buffer is in the write cache (not yet written to the file)
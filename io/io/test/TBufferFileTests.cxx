@@ -0,0 +1,104 @@
+#include "Bswapcpy.h"
+#include "TBufferFile.h"
+#include "TStreamerElement.h"
+#include "TVirtualStreamerInfo.h"
+
+#include "gtest/gtest.h"
+
+#include <initializer_list>
+#include <string.h>
+#include <vector>
+
+// Lengths around the vector widths of the byte swapping and the chunks of the Double32_t conversions
+static const Int_t gLengths[] = {1, 3, 7, 8, 15, 33, 255, 256, 257, 1001};
+
+template <typename T>
+static void CheckRoundTrip()
+{
+   for (Int_t n : gLengths) {
+      std::vector<T> values(n), read(n);
+      for (Int_t i = 0; i < n; ++i)
+         values[i] = T(i * 37 - 500) / T(3);
+      TBufferFile wb(TBuffer::kWrite);
+      wb.WriteFastArray(values.data(), n);
+      TBufferFile rb(TBuffer::kRead, wb.Length(), wb.Buffer(), kFALSE);
+      rb.ReadFastArray(read.data(), n);
+      EXPECT_EQ(Int_t(n * sizeof(T)), rb.Length());
+      EXPECT_EQ(values, read);
+   }
+}
+
+TEST(TBufferFile, FastArrayRoundTrip)
+{
+   CheckRoundTrip<Short_t>();
+   CheckRoundTrip<Int_t>();
+   CheckRoundTrip<Long64_t>();
+   CheckRoundTrip<Float_t>();
+   CheckRoundTrip<Double_t>();
+}
+
+TEST(TBufferFile, FastArrayByteOrder)
+{
+   const Int_t ii[2] = {0x01020304, 0x05060708};
+   const Long64_t ll[1] = {0x0102030405060708LL};
+   TBufferFile b(TBuffer::kWrite);
+   b.WriteFastArray(ii, 2);
+   b.WriteFastArray(ll, 1);
+   const char expected[] = {1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 4, 5, 6, 7, 8};
+   ASSERT_EQ(Int_t(sizeof(expected)), b.Length());
+   for (UInt_t i = 0; i < sizeof(expected); ++i)
+      EXPECT_EQ(expected[i], b.Buffer()[i]);
+}
+
+TEST(TBufferFile, Double32RoundTrip)
+{
+   TStreamerElement range("d", "[0,100,20]", 0, TVirtualStreamerInfo::kDouble32, "Double32_t");
+   ASSERT_NE(0, range.GetFactor());
+   for (Int_t n : gLengths) {
+      std::vector<Double_t> values(n), read(n), readRange(n);
+      for (Int_t i = 0; i < n; ++i)
+         values[i] = (i % 1000) * 0.1;
+      TBufferFile wb(TBuffer::kWrite);
+      wb.WriteFastArrayDouble32(values.data(), n, nullptr);
+      wb.WriteFastArrayDouble32(values.data(), n, &range);
+      EXPECT_EQ(Int_t(2 * n * sizeof(Float_t)), wb.Length());
+      TBufferFile rb(TBuffer::kRead, wb.Length(), wb.Buffer(), kFALSE);
+      rb.ReadFastArrayDouble32(read.data(), n, nullptr);
+      rb.ReadFastArrayDouble32(readRange.data(), n, &range);
+      for (Int_t i = 0; i < n; ++i) {
+         EXPECT_EQ(Double_t(Float_t(values[i])), read[i]);
+         EXPECT_NEAR(values[i], readRange[i], 1e-4);
+      }
+   }
+}
+
+// Each implementation of the byte swapping copies must reverse the bytes of every element, whatever the vector width
+// of the implementation and the alignment of the arrays
+TEST(Bswapcpy, Kernels)
+{
+   using ROOT::Internal::EBswapcpyKernel;
+   ASSERT_TRUE(ROOT::Internal::IsBswapcpyKernelSupported(EBswapcpyKernel::kScalar));
+   const size_t maxN = 100;
+   char from[8 * maxN + 1];
+   for (size_t i = 0; i < sizeof(from); ++i)
+      from[i] = char(i * 7 + 1);
+   for (auto kernel : {EBswapcpyKernel::kScalar, EBswapcpyKernel::kSSSE3, EBswapcpyKernel::kAVX2}) {
+      if (!ROOT::Internal::IsBswapcpyKernelSupported(kernel))
+         continue;
+      for (size_t size : {2, 4, 8}) {
+         for (size_t n = 0; n <= maxN; ++n) {
+            for (size_t offset : {0, 1}) {
+               char to[8 * maxN + 1];
+               memset(to, 0, sizeof(to));
+               ROOT::Internal::BswapcpyWithKernel(kernel, to + offset, from + offset, n, size);
+               for (size_t i = 0; i < n * size; ++i)
+                  ASSERT_EQ(from[offset + i], to[offset + i / size * size + size - 1 - i % size])
+                     << "kernel " << int(kernel) << ", size " << size << ", n " << n << ", offset " << offset;
+               // nothing is written past the n elements
+               for (size_t i = offset + n * size; i < sizeof(to); ++i)
+                  ASSERT_EQ(0, to[i]);
+            }
+         }
+      }
+   }
+}
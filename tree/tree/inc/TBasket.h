@@ -68,6 +68,7 @@ protected:
    TBranch    *fBranch{nullptr};              ///<Pointer to the basket support branch
    TBuffer    *fCompressedBufferRef{nullptr}; ///<! Compressed buffer.
    Int_t       fLastWriteBufferSize{0};       ///<! Size of the buffer last time we wrote it to disk
+   Int_t       fCompressedSize{-1};           ///<! Size of the object if compressed ahead of WriteBuffer, -1 otherwise
 
 public:
    // The IO bits flag is to provide improved forward-compatibility detection.
@@ -104,6 +105,7 @@ public:
    virtual ~TBasket();
 
    virtual void    AdjustSize(Int_t newsize);
+           Int_t   CompressBuffer(Short_t cycle);
    virtual void    DeleteEntryOffset();
    virtual Int_t   DropBuffers();
    TBranch        *GetBranch() const {return fBranch;}
@@ -132,6 +134,7 @@ public:
    virtual void    SetWriteMode();
    inline  void    Update(Int_t newlast) { Update(newlast,newlast); };
    virtual void    Update(Int_t newlast, Int_t skipped);
+           void    UseOwnCompressedBuffer();
    virtual Int_t   WriteBuffer();
 
    ClassDef(TBasket, 3); // the TBranch buffers
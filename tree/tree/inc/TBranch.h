@@ -77,6 +77,7 @@ protected:
 
    static Int_t fgCount;          ///<! branch counter
    Int_t       fCompress;         ///<  Compression level and algorithm
+   Int_t       fCompressFilters;  ///<  Filters applied to the baskets before compression, see ROOT::ECompressionFilter
    Int_t       fBasketSize;       ///<  Initial Size of  Basket Buffer
    Int_t       fEntryOffsetLen;   ///<  Initial Length of fEntryOffset table in the basket buffers
    Int_t       fWriteBasket;      ///<  Last basket number written
@@ -113,6 +114,7 @@ protected:
    TList      *fBrowsables;       ///<! List of TVirtualBranchBrowsables used for Browse()
 
    Bool_t      fSkipZip;          ///<! After being read, the buffer will not be unzipped.
+   Bool_t      fAutoCompressionDone; ///<! True once the compression settings were selected by the tree
 
    typedef void (TBranch::*ReadLeaves_t)(TBuffer &b);
    ReadLeaves_t fReadLeaves;      ///<! Pointer to the ReadLeaves implementation to use.
@@ -135,7 +137,12 @@ protected:
 
 private:
    Int_t FillEntryBuffer(TBasket* basket,TBuffer* buf, Int_t& lnew);
+   Bool_t   CanFillBulk() const;
+   Long64_t GetBulkFillCapacity();
+   Int_t    FillBulkImpl(Long64_t first, Long64_t nentries, ROOT::Internal::TBranchIMTHelper *);
    Int_t    WriteBasketImpl(TBasket* basket, Int_t where, ROOT::Internal::TBranchIMTHelper *);
+   Int_t    WritePipelinedBasket(TBasket* basket, Int_t where);
+   void     SelectCompressionSettings(TBasket* basket);
    TBranch(const TBranch&) = delete;             // not implemented
    TBranch& operator=(const TBranch&) = delete;  // not implemented
 
@@ -169,9 +176,11 @@ public:
            Int_t     GetCompressionAlgorithm() const;
            Int_t     GetCompressionLevel() const;
            Int_t     GetCompressionSettings() const;
+           Int_t     GetCompressionFilters() const { return fCompressFilters; }
    TDirectory       *GetDirectory() const {return fDirectory;}
    virtual Int_t     GetEntry(Long64_t entry=0, Int_t getall = 0);
    virtual Int_t     GetEntryExport(Long64_t entry, Int_t getall, TClonesArray *list, Int_t n);
+           Int_t     GetBulkEntries(Long64_t entry, TBuffer &user_buf);
            Int_t     GetEntryOffsetLen() const { return fEntryOffsetLen; }
            Int_t     GetEvent(Long64_t entry=0) {return GetEntry(entry);}
    const char       *GetIconName() const;
@@ -221,6 +230,7 @@ public:
    void              SetCompressionAlgorithm(Int_t algorithm=0);
    void              SetCompressionLevel(Int_t level=1);
    void              SetCompressionSettings(Int_t settings=1);
+   void              SetCompressionFilters(Int_t filters);
    virtual void      SetEntries(Long64_t entries);
    virtual void      SetEntryOffsetLen(Int_t len, Bool_t updateSubBranches = kFALSE);
    virtual void      SetFirstEntry( Long64_t entry );
@@ -237,7 +247,7 @@ public:
 
    static  void      ResetCount();
 
-   ClassDef(TBranch, 13); // Branch descriptor
+   ClassDef(TBranch, 14); // Branch descriptor
 };
 
 //______________________________________________________________________________
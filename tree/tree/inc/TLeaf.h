@@ -53,6 +53,8 @@ protected:
                                                                   // polymorphism!), this will generate an appropriate
                                                                   // offset array.
 
+  Bool_t ReadBasketFastImpl(TBuffer &b, Long64_t n, Int_t size);
+
 public:
    enum EStatusBits {
       kIndirectAddress = BIT(11), ///< Data member is a pointer to an array of basic types.
@@ -67,6 +69,7 @@ public:
    virtual Bool_t   CanGenerateOffsetArray() {return fLeafCount;} // overload and return true if this leaf can generate its own offset array.
    virtual void     Export(TClonesArray *, Int_t) {}
    virtual void     FillBasket(TBuffer &b);
+   virtual Bool_t   FillBasketFast(TBuffer &, Long64_t, Long64_t) { return kFALSE; }
    virtual Int_t   *GenerateOffsetArray(Int_t base, Int_t events) { return GenerateOffsetArrayBase(base, events); }
    TBranch         *GetBranch() const { return fBranch; }
    virtual TLeaf   *GetLeafCount() const { return fLeafCount; }
@@ -93,6 +96,7 @@ public:
    virtual void     PrintValue(Int_t i = 0) const;
    virtual void     ReadBasket(TBuffer &) {}
    virtual void     ReadBasketExport(TBuffer &, TClonesArray *, Int_t) {}
+   virtual Bool_t   ReadBasketFast(TBuffer &, Long64_t) { return kFALSE; }
    virtual void     ReadValue(std::istream & /*s*/, Char_t /*delim*/ = ' ') {
       Error("ReadValue", "Not implemented!");
    }
@@ -38,6 +38,7 @@ public:
 
    virtual void    Export(TClonesArray* list, Int_t n);
    virtual void    FillBasket(TBuffer& b);
+   virtual Bool_t  FillBasketFast(TBuffer& b, Long64_t first, Long64_t n);
    virtual Int_t   GetMaximum() const { return fMaximum; }
    virtual Int_t   GetMinimum() const { return fMinimum; }
    const char     *GetTypeName() const;
@@ -47,6 +48,7 @@ public:
    virtual void    PrintValue(Int_t i = 0) const;
    virtual void    ReadBasket(TBuffer&);
    virtual void    ReadBasketExport(TBuffer&, TClonesArray* list, Int_t n);
+   virtual Bool_t  ReadBasketFast(TBuffer&, Long64_t);
    virtual void    ReadValue(std::istream &s, Char_t delim = ' ');
    virtual void    SetAddress(void* addr = 0);
    virtual void    SetMaximum(Char_t max) { fMaximum = max; }
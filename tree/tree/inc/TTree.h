@@ -67,6 +67,12 @@ class TTreeCloner;
 class TFileMergeInfo;
 class TVirtualPerfStats;
 
+namespace ROOT {
+  namespace Internal {
+    class TBasketWritePipeline; ///< Compresses the full baskets in the background during TTree::Fill.
+  }
+}
+
 class TTree : public TNamed, public TAttLine, public TAttFill, public TAttMarker {
 
    using TIOFeatures = ROOT::TIOFeatures;
@@ -125,6 +131,7 @@ protected:
    TBuffer       *fTransientBuffer;       ///<! Pointer to the current transient buffer.
    Bool_t         fCacheDoAutoInit;       ///<! true if cache auto creation or resize check is needed
    Bool_t         fCacheDoClusterPrefetch;///<! true if cache is prefetching whole clusters
+   Bool_t         fCacheDoReadAhead;      ///<! true if cache reads the next cluster asynchronously
    Bool_t         fCacheUserSet;          ///<! true if the cache setting was explicitly given by user
    Bool_t         fIMTEnabled;            ///<! true if implicit multi-threading is enabled for this tree
    UInt_t         fNEntriesSinceSorting;  ///<! Number of entries processed since the last re-sorting of branches
@@ -139,9 +146,13 @@ private:
    mutable Bool_t fIMTFlush{false};               ///<! True if we are doing a multithreaded flush.
    mutable std::atomic<Long64_t> fIMTTotBytes;    ///<! Total bytes for the IMT flush baskets
    mutable std::atomic<Long64_t> fIMTZipBytes;    ///<! Zip bytes for the IMT flush baskets.
+   ROOT::Internal::TBasketWritePipeline *fBasketPipeline{nullptr}; ///<! Background compression of full baskets
+   Int_t fAutoCompression{0}; ///<! Objective of the selection of the branches' compression, see SetAutoCompression
 
    void             InitializeBranchLists(bool checkLeafCount);
    void             SortBranchesByTime();
+   void             CheckFlushAndSave();
+   Int_t            WritePipelinedBaskets(Bool_t wait) const;
 
 protected:
    virtual void     KeepCircular();
@@ -183,6 +194,8 @@ protected:
    friend class TChainIndex;
    // So that the TTreeCloner can access the protected interfaces
    friend class TTreeCloner;
+   // So that the branches can hand their full baskets over to fBasketPipeline
+   friend class TBranch;
 
    // use to update fFriendLockStatus
    enum ELockStatusBits {
@@ -231,6 +244,14 @@ public:
       kSplitCollectionOfPointers = 100
    };
 
+   // Objectives of the automatic selection of the branches' compression settings, see SetAutoCompression
+   enum EAutoCompression {
+      kNoAutoCompression = 0,   ///< Use the compression settings of the branches
+      kAutoCompressionSize,     ///< Smallest compressed size
+      kAutoCompressionSpeed,    ///< Fastest decompression
+      kAutoCompressionBalanced  ///< Smallest size among the settings that decompress fast
+   };
+
    class TClusterIterator
    {
    private:
@@ -358,17 +379,20 @@ public:
    virtual void            DropBaskets();
    virtual void            DropBuffers(Int_t nbytes);
    virtual Int_t           Fill();
+   virtual Long64_t        FillBulk(Long64_t nentries);
    virtual TBranch        *FindBranch(const char* name);
    virtual TLeaf          *FindLeaf(const char* name);
    virtual Int_t           Fit(const char* funcname, const char* varexp, const char* selection = "", Option_t* option = "", Option_t* goption = "", Long64_t nentries = kMaxEntries, Long64_t firstentry = 0); // *MENU*
    virtual Int_t           FlushBaskets() const;
    virtual const char     *GetAlias(const char* aliasName) const;
    virtual Long64_t        GetAutoFlush() const {return fAutoFlush;}
+           Int_t           GetAutoCompression() const {return fAutoCompression;}
    virtual Long64_t        GetAutoSave()  const {return fAutoSave;}
    virtual TBranch        *GetBranch(const char* name);
    virtual TBranchRef     *GetBranchRef() const { return fBranchRef; };
    virtual Bool_t          GetBranchStatus(const char* branchname) const;
    static  Int_t           GetBranchStyle();
+   virtual Bool_t          GetCacheReadAhead() const { return fCacheDoReadAhead; }
    virtual Long64_t        GetCacheSize() const { return fCacheSize; }
    virtual TClusterIterator GetClusterIterator(Long64_t firstentry);
    virtual Long64_t        GetChainEntryNumber(Long64_t entry) const { return entry; }
@@ -423,6 +447,7 @@ public:
    TVirtualTreePlayer     *GetPlayer();
    virtual Int_t           GetPacketSize() const { return fPacketSize; }
    virtual TVirtualPerfStats *GetPerfStats() const { return fPerfStats; }
+           Long64_t        GetPipelinedCompression() const;
    virtual Long64_t        GetReadEntry()  const { return fReadEntry; }
    virtual Long64_t        GetReadEvent()  const { return fReadEntry; }
    virtual Int_t           GetScanField()  const { return fScanField; }
@@ -499,6 +524,7 @@ public:
    virtual Long64_t        Scan(const char* varexp = "", const char* selection = "", Option_t* option = "", Long64_t nentries = kMaxEntries, Long64_t firstentry = 0); // *MENU*
    virtual Bool_t          SetAlias(const char* aliasName, const char* aliasFormula);
    virtual void            SetAutoSave(Long64_t autos = -300000000);
+   virtual void            SetAutoCompression(Int_t objective = kAutoCompressionBalanced);
    virtual void            SetAutoFlush(Long64_t autof = -30000000);
    virtual void            SetBasketSize(const char* bname, Int_t buffsize = 16000);
 #if !defined(__CINT__)
@@ -524,6 +550,7 @@ public:
 #endif
    virtual void            SetBranchStatus(const char* bname, Bool_t status = 1, UInt_t* found = 0);
    static  void            SetBranchStyle(Int_t style = 1);  //style=0 for old branch, =1 for new branch style
+   virtual void            SetCacheReadAhead(Bool_t enabled = kTRUE);
    virtual Int_t           SetCacheSize(Long64_t cachesize = -1);
    virtual Int_t           SetCacheEntryRange(Long64_t first, Long64_t last);
    virtual void            SetCacheLearnEntries(Int_t n=10);
@@ -561,6 +588,7 @@ public:
    virtual void            SetObject(const char* name, const char* title);
    virtual void            SetParallelUnzip(Bool_t opt=kTRUE, Float_t RelSize=-1);
    virtual void            SetPerfStats(TVirtualPerfStats* perf);
+   virtual void            SetPipelinedCompression(Long64_t maxInFlightBytes = 32000000);
    virtual void            SetScanField(Int_t n = 50) { fScanField = n; } // *MENU*
    virtual void            SetTimerInterval(Int_t msec = 333) { fTimerInterval=msec; }
    virtual void            SetTreeIndex(TVirtualIndex* index);
@@ -27,44 +27,54 @@
 
 #include "TTreeCache.h"
 
-#include <queue>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 class TTree;
 class TBranch;
-class TThread;
-class TCondition;
 class TBasket;
 class TMutex;
 
+namespace ROOT {
+namespace Experimental {
+class TTaskGroup;
+}
+}
+
 class TTreeCacheUnzip : public TTreeCache {
 public:
    // We have three possibilities for the unzipping mode:
    // enable, disable and force
    enum EParUnzipMode { kEnable, kDisable, kForce };
 
+   // The unzipping status of a basket
+   enum EUnzipStatus { kUntouched, kProgress, kFinished };
+
 protected:
 
    // Members for paral. managing
-   TThread    *fUnzipThread[10];
-   Bool_t      fActiveThread;          ///< Used to terminate gracefully the unzippers
-   TCondition *fUnzipStartCondition;   ///< Used to signal the threads to start.
-   TCondition *fUnzipDoneCondition;    ///< Used to wait for an unzip tour to finish. Gives the Async feel.
    Bool_t      fParallel;              ///< Indicate if we want to activate the parallelism (for this instance)
    Bool_t      fAsyncReading;
-   TMutex     *fMutexList;             ///< Mutex to protect the various lists. Used by the condvars.
+   Bool_t      fUnzipTasksStarted;     ///<! Whether the unzipping tasks of the baskets in the cache were started
+   TMutex     *fMutexList;             ///< Mutex to protect the various lists.
    TMutex     *fIOMutex;
 
-   Int_t       fCycle;
+   std::atomic<Int_t> fCycle;          ///<! Incremented when the content of the cache changes
    static TTreeCacheUnzip::EParUnzipMode fgParallel;  ///< Indicate if we want to activate the parallelism
 
-   Int_t       fLastReadPos;
-   Int_t       fBlocksToGo;
+   std::unique_ptr<ROOT::Experimental::TTaskGroup> fUnzipTaskGroup; ///<! The tasks unzipping the baskets in advance
+   std::mutex              fUnzipDoneMutex;     ///<! Used with fUnzipDoneCondition
+   std::condition_variable fUnzipDoneCondition; ///<! Signalled when a task has unzipped a basket or has ended
+   std::atomic<Int_t>      fNRunningTasks;      ///<! Number of unzipping tasks that may be using the arrays below
 
    // Unzipping related members
-   Int_t      *fUnzipLen;         ///<! [fNseek] Length of the unzipped buffers
-   char      **fUnzipChunks;      ///<! [fNseek] Individual unzipped chunks. Their summed size is kept under control.
-   Byte_t     *fUnzipStatus;      ///<! [fNSeek] For each blk, tells us if it's unzipped or pending
-   Long64_t    fTotalUnzipBytes;  ///<! The total sum of the currently unzipped blks
+   std::vector<Int_t>      fUnzipLen;    ///<! [fNseek] Length of the unzipped buffers
+   std::vector<std::unique_ptr<char[]>> fUnzipChunks; ///<! [fNseek] Individual unzipped chunks
+   std::unique_ptr<std::atomic<Byte_t>[]> fUnzipStatus; ///<! [fNseek] For each blk, its EUnzipStatus
+   std::atomic<Long64_t>   fTotalUnzipBytes;  ///<! The total sum of the currently unzipped blks
 
    Int_t       fNseekMax;         ///<!  fNseek can change so we need to know its max size
    Long64_t    fUnzipBufferSize;  ///<!  Max Size for the ready unzipped blocks (default is 2*fBufferSize)
@@ -72,24 +82,19 @@ protected:
    static Double_t fgRelBuffSize; ///< This is the percentage of the TTreeCacheUnzip that will be used
 
    // Members use to keep statistics
-   Int_t       fNUnzip;           ///<! number of blocks that were unzipped
-   Int_t       fNFound;           ///<! number of blocks that were found in the cache
-   Int_t       fNStalls;          ///<! number of hits which caused a stall
-   Int_t       fNMissed;          ///<! number of blocks that were not found in the cache and were unzipped
-
-   std::queue<Int_t>       fActiveBlks; ///< The blocks which are active now
+   std::atomic<Int_t> fNUnzip;    ///<! number of blocks that were unzipped
+   std::atomic<Int_t> fNFound;    ///<! number of blocks that were found in the cache
+   std::atomic<Int_t> fNStalls;   ///<! number of hits which caused a stall
+   std::atomic<Int_t> fNMissed;   ///<! number of blocks that were not found in the cache and were unzipped
 
 private:
    TTreeCacheUnzip(const TTreeCacheUnzip &);            //this class cannot be copied
    TTreeCacheUnzip& operator=(const TTreeCacheUnzip &);
 
-   char *fCompBuffer;
-   Int_t fCompBufferSize;
-
    // Private methods
    void  Init();
-   Int_t StartThreadUnzip(Int_t nthreads);
-   Int_t StopThreadUnzip();
+   void  StartUnzipTasks();
+   void  WaitUnzipTasks();
 
 public:
    TTreeCacheUnzip();
@@ -103,17 +108,11 @@ public:
    virtual void        StopLearningPhase();
    void                UpdateBranches(TTree *tree);
 
-   // Methods related to the thread
+   // Methods related to the parallel unzipping
    static EParUnzipMode GetParallelUnzip();
    static Bool_t        IsParallelUnzip();
    static Int_t         SetParallelUnzip(TTreeCacheUnzip::EParUnzipMode option = TTreeCacheUnzip::kEnable);
 
-   Bool_t               IsActiveThread();
-   Bool_t               IsQueueEmpty();
-
-   void                 WaitUnzipStartSignal();
-   void                 SendUnzipStartSignal(Bool_t broadcast);
-
    // Unzipping related methods
    Int_t          GetRecordHeader(char *buf, Int_t maxbytes, Int_t &nbytes, Int_t &objlen, Int_t &keylen);
    virtual void   ResetCache();
@@ -122,7 +121,7 @@ public:
    void           SetUnzipBufferSize(Long64_t bufferSize);
    static void    SetUnzipRelBufferSize(Float_t relbufferSize);
    Int_t          UnzipBuffer(char **dest, char *src);
-   Int_t          UnzipCache(Int_t &startindex, Int_t &locbuffsz, char *&locbuff);
+   Int_t          UnzipCache(Int_t index, Int_t cycle, const char *src);
 
    // Methods to get stats
    Int_t  GetNUnzip() { return fNUnzip; }
@@ -131,8 +130,6 @@ public:
 
    void Print(Option_t* option = "") const;
 
-   // static members
-   static void* UnzipLoop(void *arg);
    ClassDef(TTreeCacheUnzip,0)  //Specialization of TTreeCache for parallel unzipping
 };
 
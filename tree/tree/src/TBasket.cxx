@@ -756,6 +756,7 @@ void TBasket::Reset()
    Int_t *storeDisplacement = fDisplacement;
    fDisplacement= 0;
    fBuffer      = 0;
+   fCompressedSize = -1;
 
    fBufferRef->Reset();
    fBufferRef->SetWriteMode();
@@ -980,53 +981,30 @@ void TBasket::Update(Int_t offset, Int_t skipped)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// Write buffer of this basket on the current file.
-///
-/// The function returns the number of bytes committed to the memory.
-/// If a write error occurs, the number of bytes returned is -1.
-/// If no data are written, the number of bytes returned is 0.
+/// Stop sharing the compressed buffer of the branch, if it does, so that the
+/// basket can be compressed concurrently with the other baskets of the branch.
+/// The basket allocates its own compressed buffer at the next compression.
 
-Int_t TBasket::WriteBuffer()
+void TBasket::UseOwnCompressedBuffer()
 {
-   const Int_t kWrite = 1;
-
-   TFile *file = fBranch->GetFile(kWrite);
-   if (!file) return 0;
-   if (!file->IsWritable()) {
-      return -1;
-   }
-   fMotherDir = file; // fBranch->GetDirectory();
-
-   // This mutex prevents multiple TBasket::WriteBuffer invocations from interacting
-   // with the underlying TFile at once - TFile is assumed to *not* be thread-safe.
-   //
-   // The only parallelism we'd like to exploit (right now!) is the compression
-   // step - everything else should be serialized at the TFile level.
-#ifdef R__USE_IMT
-   std::unique_lock<std::mutex> sentry(file->fWriteMutex);
-#endif  // R__USE_IMT
-
-   if (R__unlikely(fBufferRef->TestBit(TBufferFile::kNotDecompressed))) {
-      // Read the basket information that was saved inside the buffer.
-      Bool_t writing = fBufferRef->IsWriting();
-      fBufferRef->SetReadMode();
-      fBufferRef->SetBufferOffset(0);
-
-      Streamer(*fBufferRef);
-      if (writing) fBufferRef->SetWriteMode();
-      Int_t nout = fNbytes - fKeylen;
-
-      fBuffer = fBufferRef->Buffer();
+   if (!fOwnsCompressedBuffer) fCompressedBufferRef = nullptr;
+}
 
-      Create(nout,file);
-      fBufferRef->SetBufferOffset(0);
-      fHeaderOnly = kTRUE;
+////////////////////////////////////////////////////////////////////////////////
+/// Prepare the buffer of this basket to be written: transfer the entry offset
+/// table at the end of the buffer and compress it, with `cycle` as the cycle
+/// of the key of the basket.
+///
+/// This only uses the buffers of the basket, not the file, so that it can run
+/// in a thread other than the one filling the tree (see
+/// TTree::SetPipelinedCompression); WriteBuffer then writes the result.
+///
+/// The function returns the size of the object in the file, without its key,
+/// or -1 in case of error.
 
-      Streamer(*fBufferRef);         //write key itself again
-      int nBytes = WriteFileKeepBuffer();
-      fHeaderOnly = kFALSE;
-      return nBytes>0 ? fKeylen+nout : -1;
-   }
+Int_t TBasket::CompressBuffer(Short_t cycle)
+{
+   const Int_t kWrite = 1;
 
    // Transfer fEntryOffset table at the end of fBuffer.
    fLast = fBufferRef->Length();
@@ -1067,79 +1045,132 @@ Int_t TBasket::WriteBuffer()
    fObjlen    = lbuf - fKeylen;
 
    fHeaderOnly = kTRUE;
-   fCycle = fBranch->GetWriteBasket();
+   fCycle = cycle;
+   fBuffer = fBufferRef->Buffer();
    Int_t cxlevel = fBranch->GetCompressionLevel();
    ROOT::ECompressionAlgorithm cxAlgorithm = static_cast<ROOT::ECompressionAlgorithm>(fBranch->GetCompressionAlgorithm());
+   // The filters see the buffer as an array of values of the type of the branch's leaf.
+   Int_t cxFilters = fBranch->GetCompressionFilters();
+   Int_t typesize = 1;
+   if (cxFilters && fBranch->GetNleaves() == 1)
+      typesize = static_cast<TLeaf *>(fBranch->GetListOfLeaves()->UncheckedAt(0))->GetLenType();
    if (cxlevel > 0) {
       Int_t nbuffers = 1 + (fObjlen - 1) / kMAXZIPBUF;
       Int_t buflen = fKeylen + fObjlen + 9 * nbuffers + 28; //add 28 bytes in case object is placed in a deleted gap
-      InitializeCompressedBuffer(buflen, file);
+      InitializeCompressedBuffer(buflen, fBranch->GetFile(kWrite));
       if (!fCompressedBufferRef) {
          Warning("WriteBuffer", "Unable to allocate the compressed buffer");
          return -1;
       }
       fCompressedBufferRef->SetWriteMode();
-      fBuffer = fCompressedBufferRef->Buffer();
       char *objbuf = fBufferRef->Buffer() + fKeylen;
-      char *bufcur = &fBuffer[fKeylen];
+      char *bufcur = &fCompressedBufferRef->Buffer()[fKeylen];
       noutot = 0;
       nzip   = 0;
       for (Int_t i = 0; i < nbuffers; ++i) {
          if (i == nbuffers - 1) bufmax = fObjlen - nzip;
          else bufmax = kMAXZIPBUF;
-         // Compress the buffer.  Note that we allow multiple TBasket compressions to occur at once
-         // for a given TFile: that's because the compression buffer when we use IMT is no longer
-         // shared amongst several threads.
-#ifdef R__USE_IMT
-         sentry.unlock();
-#endif  // R__USE_IMT
          // NOTE this is declared with C linkage, so it shouldn't except.  Also, when
          // USE_IMT is defined, we are guaranteed that the compression buffer is unique per-branch.
          // (see fCompressedBufferRef in constructor).
-         R__zipMultipleAlgorithm(cxlevel, &bufmax, objbuf, &bufmax, bufcur, &nout, cxAlgorithm);
-#ifdef R__USE_IMT
-         sentry.lock();
-#endif  // R__USE_IMT
+         R__zipFiltered(cxlevel, &bufmax, objbuf, &bufmax, bufcur, &nout, cxAlgorithm, cxFilters, typesize);
 
          // test if buffer has really been compressed. In case of small buffers
          // when the buffer contains random data, it may happen that the compressed
          // buffer is larger than the input. In this case, we write the original uncompressed buffer
          if (nout == 0 || nout >= fObjlen) {
-            nout = fObjlen;
-            // We used to delete fBuffer here, we no longer want to since
-            // the buffer (held by fCompressedBufferRef) might be re-used later.
-            fBuffer = fBufferRef->Buffer();
-            Create(fObjlen,file);
-            fBufferRef->SetBufferOffset(0);
-
-            Streamer(*fBufferRef);         //write key itself again
             if ((nout+fKeylen)>buflen) {
                Warning("WriteBuffer","Possible memory corruption due to compression algorithm, wrote %d bytes past the end of a block of %d bytes. fNbytes=%d, fObjLen=%d, fKeylen=%d",
                   (nout+fKeylen-buflen),buflen,fNbytes,fObjlen,fKeylen);
             }
-            goto WriteFile;
+            // We used to delete fBuffer here, we no longer want to since
+            // the buffer (held by fCompressedBufferRef) might be re-used later.
+            fCompressedSize = fObjlen;
+            return fCompressedSize;
          }
          bufcur += nout;
          noutot += nout;
          objbuf += kMAXZIPBUF;
          nzip   += kMAXZIPBUF;
       }
-      nout = noutot;
-      Create(noutot,file);
+      fBuffer = fCompressedBufferRef->Buffer();
+      fCompressedSize = noutot;
+   } else {
+      fCompressedSize = fObjlen;
+   }
+   return fCompressedSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Write buffer of this basket on the current file.
+///
+/// The function returns the number of bytes committed to the memory.
+/// If a write error occurs, the number of bytes returned is -1.
+/// If no data are written, the number of bytes returned is 0.
+
+Int_t TBasket::WriteBuffer()
+{
+   const Int_t kWrite = 1;
+
+   TFile *file = fBranch->GetFile(kWrite);
+   if (!file) return 0;
+   if (!file->IsWritable()) {
+      return -1;
+   }
+   fMotherDir = file; // fBranch->GetDirectory();
+
+   // This mutex prevents multiple TBasket::WriteBuffer invocations from interacting
+   // with the underlying TFile at once - TFile is assumed to *not* be thread-safe.
+   //
+   // The only parallelism we'd like to exploit (right now!) is the compression
+   // step - everything else should be serialized at the TFile level.
+#ifdef R__USE_IMT
+   std::unique_lock<std::mutex> sentry(file->fWriteMutex);
+#endif  // R__USE_IMT
+
+   if (R__unlikely(fBufferRef->TestBit(TBufferFile::kNotDecompressed))) {
+      // Read the basket information that was saved inside the buffer.
+      Bool_t writing = fBufferRef->IsWriting();
+      fBufferRef->SetReadMode();
       fBufferRef->SetBufferOffset(0);
 
-      Streamer(*fBufferRef);         //write key itself again
-      memcpy(fBuffer,fBufferRef->Buffer(),fKeylen);
-   } else {
+      Streamer(*fBufferRef);
+      if (writing) fBufferRef->SetWriteMode();
+      Int_t nout = fNbytes - fKeylen;
+
       fBuffer = fBufferRef->Buffer();
-      Create(fObjlen,file);
+
+      Create(nout,file);
       fBufferRef->SetBufferOffset(0);
+      fHeaderOnly = kTRUE;
 
       Streamer(*fBufferRef);         //write key itself again
-      nout = fObjlen;
+      int nBytes = WriteFileKeepBuffer();
+      fHeaderOnly = kFALSE;
+      return nBytes>0 ? fKeylen+nout : -1;
+   }
+
+   Int_t nout = fCompressedSize;
+   if (nout < 0) {
+      // Note that we allow multiple TBasket compressions to occur at once for a given TFile: that's
+      // because the compression buffer when we use IMT is no longer shared amongst several threads.
+#ifdef R__USE_IMT
+      sentry.unlock();
+#endif  // R__USE_IMT
+      nout = CompressBuffer(fBranch->GetWriteBasket());
+#ifdef R__USE_IMT
+      sentry.lock();
+#endif  // R__USE_IMT
+      if (nout < 0) return -1;
    }
+   fCompressedSize = -1;
+
+   Create(nout,file);
+   fBufferRef->SetBufferOffset(0);
+
+   Streamer(*fBufferRef);         //write key itself again
+   if (fBuffer != fBufferRef->Buffer()) memcpy(fBuffer,fBufferRef->Buffer(),fKeylen);
 
-WriteFile:
    Int_t nBytes = WriteFileKeepBuffer();
    fHeaderOnly = kFALSE;
    return nBytes>0 ? fKeylen+nout : -1;
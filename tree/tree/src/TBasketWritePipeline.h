@@ -0,0 +1,110 @@
+// @(#)root/tree:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2017, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TBasketWritePipeline
+#define ROOT_TBasketWritePipeline
+
+#include "Rtypes.h"
+
+#ifdef R__USE_IMT
+#include "ROOT/TTaskGroup.hxx"
+#include "TBasket.h"
+
+#include <mutex>
+#include <vector>
+
+class TBranch;
+
+namespace ROOT {
+namespace Internal {
+
+/// Compresses in the background the full baskets of a tree with pipelined compression
+/// (see TTree::SetPipelinedCompression), while the tree is filled in new baskets.
+///
+/// The compressed baskets are collected, and written to the file, by the thread that
+/// fills the tree: only the compression runs concurrently with the user code.
+class TBasketWritePipeline {
+public:
+   struct TItem {
+      TBranch *fBranch; ///< Branch of the basket
+      Int_t fWhere;     ///< Index of the basket in the branch
+      TBasket *fBasket; ///< Compressed basket, waiting to be written
+      Long64_t fSize;   ///< Uncompressed size of the basket, accounted in the in-flight bytes until collected
+   };
+
+private:
+   using TaskGroup_t = ROOT::Experimental::TTaskGroup;
+
+   Long64_t fMaxInFlightBytes; ///< Maximum size of the baskets pushed and not collected yet
+   Long64_t fInFlightBytes{0}; ///< Size of the baskets pushed and not collected yet
+   Int_t fNPending{0};         ///< Number of baskets pushed and not collected yet
+   std::mutex fDoneMutex;      ///< Protects fDone
+   std::vector<TItem> fDone;   ///< Baskets compressed and not collected yet
+   TaskGroup_t fGroup;
+
+public:
+   explicit TBasketWritePipeline(Long64_t maxInFlightBytes) : fMaxInFlightBytes(maxInFlightBytes) {}
+
+   ~TBasketWritePipeline()
+   {
+      // The baskets that were not collected are lost, like the unwritten baskets of a deleted tree
+      fGroup.Wait();
+      for (auto &item : fDone)
+         delete item.fBasket;
+   }
+
+   Long64_t GetMaxInFlightBytes() const { return fMaxInFlightBytes; }
+   void SetMaxInFlightBytes(Long64_t maxInFlightBytes) { fMaxInFlightBytes = maxInFlightBytes; }
+   Bool_t IsEmpty() const { return fNPending == 0; }
+
+   /// Return true if pushing `basket` would exceed the maximum in-flight size: the baskets pushed so
+   /// far must then be collected, and written, first. Baskets are accounted from Push to Collect,
+   /// since they hold both their uncompressed and compressed buffers until they are written.
+   Bool_t IsFull(TBasket *basket) const
+   {
+      return fInFlightBytes > 0 && fInFlightBytes + basket->GetBufferRef()->Length() > fMaxInFlightBytes;
+   }
+
+   /// Start the compression of the basket `where` of `branch`.
+   void Push(TBranch *branch, Int_t where, TBasket *basket)
+   {
+      const Long64_t size = basket->GetBufferRef()->Length();
+      fInFlightBytes += size;
+      ++fNPending;
+      fGroup.Run([this, branch, where, basket, size]() {
+         basket->CompressBuffer(where);
+         std::lock_guard<std::mutex> lock(fDoneMutex);
+         fDone.push_back({branch, where, basket, size});
+      });
+   }
+
+   /// Return the baskets compressed since the last call, after waiting for all the pushed ones if `wait`.
+   std::vector<TItem> Collect(Bool_t wait)
+   {
+      if (wait && fNPending)
+         fGroup.Wait();
+      std::vector<TItem> done;
+      {
+         std::lock_guard<std::mutex> lock(fDoneMutex);
+         done.swap(fDone);
+      }
+      fNPending -= done.size();
+      for (const auto &item : done)
+         fInFlightBytes -= item.fSize;
+      return done;
+   }
+};
+
+} // Internal
+} // ROOT
+
+#endif // R__USE_IMT
+
+#endif
@@ -12,6 +12,7 @@
 #include "TBranch.h"
 
 #include "Compression.h"
+#include "RZip.h"
 #include "TBasket.h"
 #include "TBranchBrowsable.h"
 #include "TBrowser.h"
@@ -40,14 +41,17 @@
 #include "TVirtualMutex.h"
 #include "TVirtualPad.h"
 
+#include "TBasketWritePipeline.h"
 #include "TBranchIMTHelper.h"
 
 #include "ROOT/TIOFeatures.hxx"
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <string.h>
 #include <stdio.h>
+#include <vector>
 
 
 Int_t TBranch::fgCount = 0;
@@ -79,6 +83,7 @@ TBranch::TBranch()
 : TNamed()
 , TAttFill(0, 1001)
 , fCompress(0)
+, fCompressFilters(0)
 , fBasketSize(32000)
 , fEntryOffsetLen(1000)
 , fWriteBasket(0)
@@ -113,6 +118,7 @@ TBranch::TBranch()
 , fTransientBuffer(0)
 , fBrowsables(0)
 , fSkipZip(kFALSE)
+, fAutoCompressionDone(kFALSE)
 , fReadLeaves(&TBranch::ReadLeavesImpl)
 , fFillLeaves(&TBranch::FillLeavesImpl)
 {
@@ -182,6 +188,7 @@ TBranch::TBranch(TTree *tree, const char *name, void *address, const char *leafl
    : TNamed(name, leaflist)
 , TAttFill(0, 1001)
 , fCompress(compress)
+, fCompressFilters(0)
 , fBasketSize((basketsize < 100) ? 100 : basketsize)
 , fEntryOffsetLen(0)
 , fWriteBasket(0)
@@ -217,6 +224,7 @@ TBranch::TBranch(TTree *tree, const char *name, void *address, const char *leafl
 , fTransientBuffer(0)
 , fBrowsables(0)
 , fSkipZip(kFALSE)
+, fAutoCompressionDone(kFALSE)
 , fReadLeaves(&TBranch::ReadLeavesImpl)
 , fFillLeaves(&TBranch::FillLeavesImpl)
 {
@@ -234,6 +242,7 @@ TBranch::TBranch(TBranch *parent, const char *name, void *address, const char *l
 : TNamed(name, leaflist)
 , TAttFill(0, 1001)
 , fCompress(compress)
+, fCompressFilters(0)
 , fBasketSize((basketsize < 100) ? 100 : basketsize)
 , fEntryOffsetLen(0)
 , fWriteBasket(0)
@@ -269,6 +278,7 @@ TBranch::TBranch(TBranch *parent, const char *name, void *address, const char *l
 , fTransientBuffer(0)
 , fBrowsables(0)
 , fSkipZip(kFALSE)
+, fAutoCompressionDone(kFALSE)
 , fReadLeaves(&TBranch::ReadLeavesImpl)
 , fFillLeaves(&TBranch::FillLeavesImpl)
 {
@@ -824,6 +834,101 @@ Int_t TBranch::FillImpl(ROOT::Internal::TBranchIMTHelper *imtHelper)
    return nbytes;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Return true if many entries of this branch can be filled at once by
+/// TTree::FillBulk, i.e. if it has a single leaf of fundamental type, or
+/// fixed-size array of a fundamental type, and its address is set.
+
+Bool_t TBranch::CanFillBulk() const
+{
+   if (IsA() != TBranch::Class() || fBranches.GetEntriesFast() || fNleaves != 1) return kFALSE;
+   if (!fAddress || fEntryBuffer || fEntryOffsetLen || fSkipZip) return kFALSE;
+   TLeaf *leaf = (TLeaf *)fLeaves.UncheckedAt(0);
+   if (leaf->GetLeafCount()) return kFALSE;
+   TClass *cl = leaf->IsA();
+   return cl == TLeafB::Class() || cl == TLeafS::Class() || cl == TLeafI::Class() || cl == TLeafL::Class() ||
+          cl == TLeafF::Class() || cl == TLeafD::Class() || cl == TLeafO::Class();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Return the number of entries that FillBulkImpl can pack in the current
+/// basket before it must be written, at least 1, creating the basket if needed.
+///
+/// Returns 0 in case of error.
+
+Long64_t TBranch::GetBulkFillCapacity()
+{
+   TBasket* basket = GetBasket(fWriteBasket);
+   if (!basket) {
+      basket = fTree->CreateBasket(this); //  create a new basket
+      if (!basket) return 0;
+      ++fNBaskets;
+      fBaskets.AddAtAndExpand(basket,fWriteBasket);
+   }
+   TLeaf *leaf = (TLeaf *)fLeaves.UncheckedAt(0);
+   const Long64_t entrySize = leaf->GetLenType() * leaf->GetLenStatic();
+   if (entrySize <= 0) return 0;
+   // FillImpl writes the basket after the first entry for which lnew + nbytes >= fBasketSize
+   const Long64_t room = fBasketSize - basket->GetBufferRef()->Length() - entrySize;
+   return room <= 0 ? 1 : (room + entrySize - 1) / entrySize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Pack `nentries` entries at once in the current basket, starting at entry
+/// `first` of the array at the address of the branch, and write the basket if
+/// it is full, as `nentries` calls to FillImpl would.
+///
+/// The branch must satisfy CanFillBulk and `nentries` must not exceed
+/// GetBulkFillCapacity.
+///
+/// Returns the number of bytes committed to the basket, or -1 in case of error.
+
+Int_t TBranch::FillBulkImpl(Long64_t first, Long64_t nentries, ROOT::Internal::TBranchIMTHelper *imtHelper)
+{
+   if (TestBit(kDoNotProcess)) {
+      return 0;
+   }
+
+   TBasket* basket = GetBasket(fWriteBasket);
+   if (!basket) return -1;
+   TBuffer* buf = basket->GetBufferRef();
+
+   if (buf->IsReading()) {
+      basket->SetWriteMode();
+   }
+
+   buf->ResetMap();
+
+   TLeaf *leaf = (TLeaf *)fLeaves.UncheckedAt(0);
+   const Int_t entrySize = leaf->GetLenType() * leaf->GetLenStatic();
+   const Int_t lold = buf->Length();
+   if (!leaf->FillBasketFast(*buf, first, nentries)) {
+      Error("FillBulk", "The leaf %s cannot be filled in bulk.", leaf->GetName());
+      return -1;
+   }
+   for (Long64_t i = 0; i < nentries; ++i) {
+      basket->Update(lold + Int_t(i) * entrySize);
+   }
+   fEntries += nentries;
+   fEntryNumber += nentries;
+   const Int_t lnew = buf->Length();
+   const Int_t nbytes = lnew - lold;
+
+   if (!basket->GetNevBufSize()) {
+      basket->SetNevBufSize(entrySize);
+   }
+
+   if ((lnew + entrySize) >= fBasketSize) {
+      if (fTree->TestBit(TTree::kCircular)) {
+         return nbytes;
+      }
+      Int_t nout = WriteBasketImpl(basket, fWriteBasket, imtHelper);
+      if (nout < 0) Error("TBranch::FillBulk", "Failed to write out basket.\n");
+      return (nout >= 0) ? nbytes : -1;
+   }
+   return nbytes;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Copy the data from fEntryBuffer into the current basket.
 
@@ -1127,6 +1232,14 @@ TBasket* TBranch::GetBasket(Int_t basketnumber)
    TBasket *basket = (TBasket*)fBaskets.UncheckedAt(basketnumber);
    if (basket) return basket;
    if (basketnumber == fWriteBasket) return 0;
+#ifdef R__USE_IMT
+   if (!fBasketSeek[basketnumber] && fTree->fBasketPipeline) {
+      // The basket may still be compressed in the background.
+      fTree->WritePipelinedBaskets(kTRUE);
+      basket = (TBasket*)fBaskets.UncheckedAt(basketnumber);
+      if (basket) return basket;
+   }
+#endif
 
    // create/decode basket parameters from buffer
    TFile *file = GetFile(0);
@@ -1407,6 +1520,87 @@ Int_t TBranch::GetEntryExport(Long64_t entry, Int_t /*getall*/, TClonesArray* li
    return nbytes;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Read all the entries of the basket containing `entry`, starting from
+/// `entry` itself, into `user_buf`.
+///
+/// This is the bulk counterpart of GetEntry: rather than streaming one entry at
+/// a time into the leaf buffers, the values of consecutive entries are copied
+/// from the (decompressed) basket to the beginning of `user_buf`, contiguous
+/// and converted to the in-memory byte order. `user_buf` is expanded if needed.
+///
+/// Bulk reading is only supported for branches with a single leaf of
+/// fundamental type and fixed size (no variable-size arrays, no objects).
+///
+/// The input argument "entry" is the entry number in the current tree.
+/// The function returns the number of entries that were read, 0 if entry does
+/// not exist, and -1 if bulk reading is not supported by this branch or an I/O
+/// error occurs.
+
+Int_t TBranch::GetBulkEntries(Long64_t entry, TBuffer &user_buf)
+{
+   if (fNleaves != 1) return -1;
+   TLeaf *leaf = static_cast<TLeaf *>(fLeaves.UncheckedAt(0));
+   if (leaf->GetLeafCount()) return -1;
+
+   // Remember which entry we are reading.
+   fReadEntry = entry;
+
+   if ((entry < fFirstEntry) || (entry >= fEntryNumber)) {
+      return 0;
+   }
+   Long64_t first = fFirstBasketEntry;
+   Long64_t last = fNextBasketEntry - 1;
+   // Are we still in the same ReadBasket?
+   if ((entry < first) || (entry > last)) {
+      fReadBasket = TMath::BinarySearch(fWriteBasket + 1, fBasketEntry, entry);
+      if (fReadBasket < 0) {
+         fNextBasketEntry = -1;
+         Error("GetBulkEntries", "In the branch %s, no basket contains the entry %lld\n", GetName(), entry);
+         return -1;
+      }
+      if (fReadBasket == fWriteBasket) {
+         fNextBasketEntry = fEntryNumber;
+      } else {
+         fNextBasketEntry = fBasketEntry[fReadBasket+1];
+      }
+      first = fFirstBasketEntry = fBasketEntry[fReadBasket];
+   }
+
+   // We have found the basket containing this entry.
+   // Make sure basket buffers are in memory.
+   TBasket *basket = GetBasket(fReadBasket);
+   fCurrentBasket = basket;
+   if (!basket) {
+      fFirstBasketEntry = -1;
+      fNextBasketEntry = -1;
+      return -1;
+   }
+   TBuffer *buf = basket->GetBufferRef();
+   if (R__unlikely(!buf)) return -1;
+   if (R__unlikely(!buf->IsReading())) {
+      basket->SetReadMode();
+   }
+   // Entries of variable size cannot be laid out contiguously.
+   if (basket->GetEntryOffset()) return -1;
+
+   const Int_t entrySize = basket->GetNevBufSize();
+   const Int_t nentries = basket->GetNevBuf() - Int_t(entry - first);
+   if (nentries <= 0) return 0;
+   const Int_t bufbegin = basket->GetKeylen() + Int_t(entry - first) * entrySize;
+   const Int_t nbytes = nentries * entrySize;
+
+   if (user_buf.BufferSize() < nbytes) {
+      user_buf.Expand(nbytes, kFALSE);
+   }
+   memcpy(user_buf.Buffer(), buf->Buffer() + bufbegin, nbytes);
+   user_buf.SetBufferOffset(0);
+   if (!leaf->ReadBasketFast(user_buf, nentries)) {
+      return -1;
+   }
+   return nentries;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Fill expectedClass and expectedType with information on the data type of the
 /// object/values contained in this branch (and thus the type of pointers
@@ -2164,6 +2358,100 @@ void TBranch::ResetCount()
    fgCount = 0;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Select the compression algorithm and level of this branch for the objective
+/// of the tree (see TTree::SetAutoCompression): the content of `basket` is
+/// compressed with each candidate setting, and the compressed size and the
+/// decompression time of the result are measured.
+///
+/// The selection is postponed to a later basket if this one holds too little
+/// data to be representative.
+
+void TBranch::SelectCompressionSettings(TBasket* basket)
+{
+   struct TCandidate {
+      ROOT::ECompressionAlgorithm fAlgorithm;
+      Int_t fLevel;
+   };
+   static const TCandidate kCandidates[] = {
+      {ROOT::kLZ4, 1}, {ROOT::kLZ4, 4}, {ROOT::kZLIB, 1}, {ROOT::kZLIB, 6}, {ROOT::kLZMA, 5}};
+   const Int_t kNCandidates = sizeof(kCandidates) / sizeof(kCandidates[0]);
+   // Enough data for the measurement to be meaningful, not so much that it is expensive.
+   const Int_t kMinBytes = TMath::Min(1024, fBasketSize / 2);
+   const Int_t kMaxBytes = 256 * 1024;
+
+   TBuffer *buffer = basket->GetBufferRef();
+   Int_t nbytes = buffer->Length() - basket->GetKeylen();
+   if (nbytes < kMinBytes) {
+      return;
+   }
+   nbytes = TMath::Min(nbytes, kMaxBytes);
+   char *data = buffer->Buffer() + basket->GetKeylen();
+
+   Int_t typesize = 1;
+   if (fCompressFilters && fNleaves == 1) {
+      typesize = static_cast<TLeaf*>(fLeaves.UncheckedAt(0))->GetLenType();
+   }
+
+   // The size of each candidate, 0 if it does not compress the data, and its best decompression time.
+   std::vector<char> zipped(nbytes);
+   std::vector<unsigned char> unzipped(nbytes);
+   Int_t sizes[kNCandidates];
+   Double_t times[kNCandidates];
+   for (Int_t i = 0; i < kNCandidates; ++i) {
+      Int_t srcsize = nbytes;
+      Int_t tgtsize = nbytes;
+      Int_t nout = 0;
+      R__zipFiltered(kCandidates[i].fLevel, &srcsize, data, &tgtsize, zipped.data(), &nout,
+                     kCandidates[i].fAlgorithm, fCompressFilters, typesize);
+      sizes[i] = nout;
+      times[i] = 0;
+      for (Int_t trial = 0; nout > 0 && trial < 3; ++trial) {
+         Int_t zipsize = nout;
+         Int_t unzipsize = nbytes;
+         Int_t nunzip = 0;
+         auto start = std::chrono::steady_clock::now();
+         R__unzip(&zipsize, (unsigned char*)zipped.data(), &unzipsize, unzipped.data(), &nunzip);
+         auto end = std::chrono::steady_clock::now();
+         Double_t time = std::chrono::duration<Double_t>(end - start).count();
+         if (nunzip != nbytes) {
+            sizes[i] = 0;
+            break;
+         }
+         if (trial == 0 || time < times[i]) times[i] = time;
+      }
+   }
+
+   // Unless the objective is the size, a setting must save at least 10% to be worth decompressing.
+   const Int_t objective = fTree->GetAutoCompression();
+   const Int_t maxSize = objective == TTree::kAutoCompressionSize ? nbytes - 1 : Int_t(0.9 * nbytes);
+   Int_t smallest = -1;
+   Int_t fastest = -1;
+   for (Int_t i = 0; i < kNCandidates; ++i) {
+      if (sizes[i] <= 0 || sizes[i] > maxSize) continue;
+      if (smallest < 0 || sizes[i] < sizes[smallest]) smallest = i;
+      if (fastest < 0 || times[i] < times[fastest]) fastest = i;
+   }
+   Int_t selected = -1;
+   if (objective == TTree::kAutoCompressionSize) {
+      selected = smallest;
+   } else if (objective == TTree::kAutoCompressionSpeed) {
+      selected = fastest;
+   } else if (fastest >= 0) {
+      for (Int_t i = 0; i < kNCandidates; ++i) {
+         if (sizes[i] <= 0 || sizes[i] > maxSize || times[i] > 4 * times[fastest]) continue;
+         if (selected < 0 || sizes[i] < sizes[selected]) selected = i;
+      }
+   }
+
+   fCompress = selected < 0 ? 0 : 100 * kCandidates[selected].fAlgorithm + kCandidates[selected].fLevel;
+   fAutoCompressionDone = kTRUE;
+   if (gDebug > 0) {
+      Info("SelectCompressionSettings", "branch %s: compression settings %d (%d bytes compressed to %d)", GetName(),
+           fCompress, nbytes, selected < 0 ? nbytes : sizes[selected]);
+   }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Set address of this branch.
 
@@ -2301,6 +2589,29 @@ void TBranch::SetCompressionSettings(Int_t settings)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Set the filters applied to the content of the baskets before their compression,
+/// a combination of ROOT::ECompressionFilter values.
+///
+/// The filters rearrange the bytes of the basket so that the compression algorithm
+/// finds more redundancy: kShuffleFilter groups the bytes of the same significance
+/// of the values, kDeltaFilter stores the difference between consecutive values
+/// (suited to slowly varying integers, like counters or event numbers). They work on
+/// values of the size of the branch's leaf and are undone transparently when reading.
+/// The filters are applied to the baskets written from now on, and are recursively
+/// set on the sub-branches.
+
+void TBranch::SetCompressionFilters(Int_t filters)
+{
+   fCompressFilters = filters & ROOT::kAllCompressionFilters;
+
+   Int_t nb = fBranches.GetEntriesFast();
+   for (Int_t i=0;i<nb;i++) {
+      TBranch *branch = (TBranch*)fBranches.UncheckedAt(i);
+      branch->SetCompressionFilters(filters);
+   }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Update the default value for the branch's fEntryOffsetLen if and only if
 /// it was already non zero (and the new value is not zero)
@@ -2695,6 +3006,37 @@ Int_t TBranch::WriteBasketImpl(TBasket* basket, Int_t where, ROOT::Internal::TBr
       fEntryOffsetLen = 2*nevbuf; // assume some fluctuations.
    }
 
+   if (fTree->GetAutoCompression() && !fAutoCompressionDone &&
+       !basket->GetBufferRef()->TestBit(TBufferFile::kNotDecompressed)) {
+      SelectCompressionSettings(basket);
+   }
+
+#ifdef R__USE_IMT
+   if (fTree->fBasketPipeline && where == fWriteBasket &&
+       !basket->GetBufferRef()->TestBit(TBufferFile::kNotDecompressed)) {
+      // Hand the basket over to the background compression and continue in a new basket; the
+      // tree writes it once compressed, see TTree::SetPipelinedCompression. If the baskets not
+      // written yet would exceed the maximum in-flight size, write them first.
+      if (fTree->fBasketPipeline->IsFull(basket) && fTree->WritePipelinedBaskets(kTRUE) < 0)
+         Error("WriteBasketImpl", "Failed to write the baskets compressed in the background.");
+      fBaskets[where] = 0;
+      if (basket == fCurrentBasket) {
+         fCurrentBasket    = 0;
+         fFirstBasketEntry = -1;
+         fNextBasketEntry  = -1;
+      }
+      ++fWriteBasket;
+      if (fWriteBasket >= fMaxBaskets) {
+         ExpandBasketArrays();
+      }
+      fBaskets.AddAtAndExpand(0,fWriteBasket);
+      fBasketEntry[fWriteBasket] = fEntryNumber;
+      basket->UseOwnCompressedBuffer();
+      fTree->fBasketPipeline->Push(this, where, basket);
+      return 0;
+   }
+#endif
+
    // Note: captures `basket`, `where`, and `this` by value; modifies the TBranch and basket,
    // as we make a copy of the pointer.  We cannot capture `basket` by reference as the pointer
    // itself might be modified after `WriteBasketImpl` exits.
@@ -2753,6 +3095,38 @@ Int_t TBranch::WriteBasketImpl(TBasket* basket, Int_t where, ROOT::Internal::TBr
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Write the basket `where`, compressed in the background since WriteBasketImpl
+/// handed it over to the tree (see TTree::SetPipelinedCompression), and keep
+/// it as the next basket to fill if the branch does not have one yet.
+
+Int_t TBranch::WritePipelinedBasket(TBasket* basket, Int_t where)
+{
+   Int_t nout  = basket->WriteBuffer();    //  Write buffer
+   if (nout < 0) Error("TBranch::WritePipelinedBasket", "basket's WriteBuffer failed.\n");
+   fBasketBytes[where]  = basket->GetNbytes();
+   fBasketSeek[where]   = basket->GetSeekKey();
+   if (nout <= 0) {
+      fBaskets[where] = basket;
+      return nout;
+   }
+   Int_t addbytes = basket->GetObjlen() + basket->GetKeylen();
+   fZipBytes += nout;
+   fTotBytes += addbytes;
+   fTree->AddTotBytes(addbytes);
+   fTree->AddZipBytes(nout);
+
+   if (!fBaskets.UncheckedAt(fWriteBasket)) {
+      basket->Reset();
+      fBaskets.AddAt(basket,fWriteBasket);
+   } else {
+      --fNBaskets;
+      basket->DropBuffers();
+      delete basket;
+   }
+   return nout;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ///set the first entry number (case of TBranchSTL)
 
@@ -1496,6 +1496,9 @@ Long64_t TChain::LoadTree(Long64_t entry)
    // FIXME: We may set fDirectory to zero here!
    fDirectory = fFile;
 
+   // The cache of the tree, created or reused below, reads ahead if the chain does.
+   if (fTree) fTree->SetCacheReadAhead(fCacheDoReadAhead);
+
    // Reuse cache from previous file (if any).
    if (tpf) {
       if (fFile) {
@@ -18,11 +18,14 @@ See TBranch structure in TTree.
 
 #include "TLeaf.h"
 #include "TBranch.h"
+#include "TBuffer.h"
 #include "TTree.h"
 #include "TVirtualPad.h"
 #include "TBrowser.h"
 #include "TClass.h"
+#include "Bswapcpy.h"
 
+#include <algorithm>
 #include <ctype.h>
 
 ClassImp(TLeaf);
@@ -178,6 +181,43 @@ Int_t *TLeaf::GenerateOffsetArrayBase(Int_t base, Int_t events) const
    return retval;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Implementation of ReadBasketFast for the leaves of fixed-size basic types of `size` bytes
+/// (2, 4 or 8): convert in place the `n` entries at the current position of `b` from the file
+/// byte order to the host one.
+///
+/// The values follow the key of the basket, whose length is arbitrary, so they are not aligned:
+/// they are copied a chunk at a time to an aligned buffer and swapped back into place.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeaf::ReadBasketFastImpl(TBuffer &b, Long64_t n, Int_t size)
+{
+   if (fLeafCount) return kFALSE;
+#ifdef R__BYTESWAP
+   constexpr Long64_t kChunkSize = 4096;
+   alignas(8) char chunk[kChunkSize];
+   char *values = b.Buffer() + b.Length();
+   const Long64_t chunkValues = kChunkSize / size;
+   for (Long64_t left = n * fLen; left > 0; left -= chunkValues) {
+      const Long64_t nvalues = std::min(left, chunkValues);
+      memcpy(chunk, values, nvalues * size);
+      switch (size) {
+         case 2: bswapcpy16(values, chunk, nvalues); break;
+         case 4: bswapcpy32(values, chunk, nvalues); break;
+         case 8: bswapcpy64(values, chunk, nvalues); break;
+         default: return kFALSE;
+      }
+      values += nvalues * size;
+   }
+#else
+   (void)b;
+   (void)n;
+   (void)size;
+#endif
+   return kTRUE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Return a pointer to the counter of this leaf.
 ///
@@ -78,6 +78,21 @@ void TLeafD::FillBasket(TBuffer &b)
    b.WriteFastArray(fValue,len);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Pack `n` consecutive entries of this leaf, starting at entry `first` of the
+/// array at the address of the leaf, in Basket output buffer.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeafD::FillBasketFast(TBuffer &b, Long64_t first, Long64_t n)
+{
+   if (fLeafCount) return kFALSE;
+   if (fPointer) fValue = *fPointer;
+   const Double_t *values = fValue + first * fLen;
+   b.WriteFastArray(values, Int_t(n * fLen));
+   return kTRUE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Import element from ClonesArray into local leaf buffer.
 
@@ -144,6 +159,17 @@ void TLeafD::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Convert in place `n` consecutive entries of this leaf, stored contiguously
+/// at the current position of `b`, from the on-file to the in-memory byte order.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeafD::ReadBasketFast(TBuffer &b, Long64_t n)
+{
+   return ReadBasketFastImpl(b, n, sizeof(Double_t));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Read a double from std::istream s and store it into the branch buffer.
 
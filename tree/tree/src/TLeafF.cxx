@@ -82,6 +82,21 @@ void TLeafF::FillBasket(TBuffer &b)
    b.WriteFastArray(fValue,len);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Pack `n` consecutive entries of this leaf, starting at entry `first` of the
+/// array at the address of the leaf, in Basket output buffer.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeafF::FillBasketFast(TBuffer &b, Long64_t first, Long64_t n)
+{
+   if (fLeafCount) return kFALSE;
+   if (fPointer) fValue = *fPointer;
+   const Float_t *values = fValue + first * fLen;
+   b.WriteFastArray(values, Int_t(n * fLen));
+   return kTRUE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Import element from ClonesArray into local leaf buffer.
 
@@ -156,6 +171,17 @@ void TLeafF::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Convert in place `n` consecutive entries of this leaf, stored contiguously
+/// at the current position of `b`, from the on-file to the in-memory byte order.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeafF::ReadBasketFast(TBuffer &b, Long64_t n)
+{
+   return ReadBasketFastImpl(b, n, sizeof(Float_t));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Read a float from std::istream s and store it into the branch buffer.
 
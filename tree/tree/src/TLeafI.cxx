@@ -90,6 +90,27 @@ void TLeafI::FillBasket(TBuffer &b)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Pack `n` consecutive entries of this leaf, starting at entry `first` of the
+/// array at the address of the leaf, in Basket output buffer.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeafI::FillBasketFast(TBuffer &b, Long64_t first, Long64_t n)
+{
+   if (fLeafCount) return kFALSE;
+   if (fPointer) fValue = *fPointer;
+   const Int_t *values = fValue + first * fLen;
+   if (IsRange()) {
+      for (Long64_t i = 0; i < n; ++i) {
+         if (values[i * fLen] > fMaximum) fMaximum = values[i * fLen];
+      }
+   }
+   // unsigned values have the same representation in the buffer
+   b.WriteFastArray(values, Int_t(n * fLen));
+   return kTRUE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Returns name of leaf type.
 
@@ -188,6 +209,17 @@ void TLeafI::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Convert in place `n` consecutive entries of this leaf, stored contiguously
+/// at the current position of `b`, from the on-file to the in-memory byte order.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeafI::ReadBasketFast(TBuffer &b, Long64_t n)
+{
+   return ReadBasketFastImpl(b, n, sizeof(Int_t));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Read an integer from std::istream s and store it into the branch buffer.
 
@@ -81,6 +81,26 @@ void TLeafO::FillBasket(TBuffer &b)
    b.WriteFastArray(fValue,len);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Pack `n` consecutive entries of this leaf, starting at entry `first` of the
+/// array at the address of the leaf, in Basket output buffer.
+///
+/// Returns kFALSE if the leaf does not have a fixed size.
+
+Bool_t TLeafO::FillBasketFast(TBuffer &b, Long64_t first, Long64_t n)
+{
+   if (fLeafCount) return kFALSE;
+   if (fPointer) fValue = *fPointer;
+   const Bool_t *values = fValue + first * fLen;
+   if (IsRange()) {
+      for (Long64_t i = 0; i < n; ++i) {
+         if (values[i * fLen] > fMaximum) fMaximum = values[i * fLen];
+      }
+   }
+   b.WriteFastArray(values, Int_t(n * fLen));
+   return kTRUE;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Returns name of leaf type.
 
@@ -151,6 +171,18 @@ void TLeafO::ReadBasketExport(TBuffer &b, TClonesArray *list, Int_t n)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Prepare `n` consecutive entries of this leaf, stored contiguously at the
+/// current position of the buffer, for bulk reading.
+///
+/// Single-byte values need no conversion, so this only checks that the leaf
+/// has a fixed size.
+
+Bool_t TLeafO::ReadBasketFast(TBuffer &, Long64_t)
+{
+   return !fLeafCount;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Read a string from std::istream s and store it into the branch buffer.
 
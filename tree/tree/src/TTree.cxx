@@ -395,6 +395,7 @@ End_Macro
 #include "ROOT/StringConv.hxx"
 #include "TVirtualMutex.h"
 
+#include "TBasketWritePipeline.h"
 #include "TBranchIMTHelper.h"
 
 #include <chrono>
@@ -406,6 +407,7 @@ End_Macro
 #include <stdio.h>
 #include <limits.h>
 #include <algorithm>
+#include <vector>
 
 #ifdef R__USE_IMT
 #include "ROOT/TThreadExecutor.hxx"
@@ -743,6 +745,7 @@ TTree::TTree()
 , fTransientBuffer(0)
 , fCacheDoAutoInit(kTRUE)
 , fCacheDoClusterPrefetch(kFALSE)
+, fCacheDoReadAhead(kFALSE)
 , fCacheUserSet(kFALSE)
 , fIMTEnabled(ROOT::IsImplicitMTEnabled())
 , fNEntriesSinceSorting(0)
@@ -823,6 +826,7 @@ TTree::TTree(const char* name, const char* title, Int_t splitlevel /* = 99 */,
 , fTransientBuffer(0)
 , fCacheDoAutoInit(kTRUE)
 , fCacheDoClusterPrefetch(kFALSE)
+, fCacheDoReadAhead(kFALSE)
 , fCacheUserSet(kFALSE)
 , fIMTEnabled(ROOT::IsImplicitMTEnabled())
 , fNEntriesSinceSorting(0)
@@ -870,6 +874,10 @@ TTree::TTree(const char* name, const char* title, Int_t splitlevel /* = 99 */,
 
 TTree::~TTree()
 {
+#ifdef R__USE_IMT
+   delete fBasketPipeline;
+   fBasketPipeline = nullptr;
+#endif
    if (fDirectory) {
       // We are in a directory, which may possibly be a file.
       if (fDirectory->GetList()) {
@@ -1391,6 +1399,10 @@ Long64_t TTree::AutoSave(Option_t* option)
    TString opt = option;
    opt.ToLower();
 
+   // The header refers to the baskets compressed in the background only once they are written.
+   if (fBasketPipeline)
+      WritePipelinedBaskets(kTRUE);
+
    if (opt.Contains("flushbaskets")) {
       if (gDebug > 0) Info("AutoSave", "calling FlushBaskets \n");
       FlushBaskets();
@@ -4452,6 +4464,10 @@ Int_t TTree::Fill()
    if (fBranchRef)
       fBranchRef->Clear();
 
+   // Write the baskets compressed in the background since the previous entry.
+   if (fBasketPipeline && WritePipelinedBaskets(kFALSE) < 0)
+      ++nerror;
+
 #ifdef R__USE_IMT
    ROOT::Internal::TBranchIMTHelper imtHelper;
    if (fIMTEnabled) {
@@ -4517,6 +4533,137 @@ Int_t TTree::Fill()
       Info("TTree::Fill", " - A: %d %lld %lld %lld %lld %lld %lld \n", nbytes, fEntries, fAutoFlush, fAutoSave,
            GetZipBytes(), fFlushedBytes, fSavedBytes);
 
+   CheckFlushAndSave();
+
+   return nerror == 0 ? nbytes : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Fill `nentries` entries at once.
+///
+/// This is the bulk counterpart of Fill(): the address of each branch must
+/// point to the values of `nentries` consecutive entries, stored contiguously:
+/// ~~~ {.cpp}
+///     Float_t pt[10000];
+///     Int_t   hits[10000][3];
+///     tree->Branch("pt", pt, "pt/F");
+///     tree->Branch("hits", hits, "hits[3]/I");
+///     // ... compute the 10000 entries
+///     tree->FillBulk(10000);
+/// ~~~
+/// The values of each branch are packed in its baskets array by array rather
+/// than entry by entry. The baskets are written, and the tree flushed and
+/// saved, at the same entries as if Fill() had been called `nentries` times,
+/// so that the clusters are the same.
+///
+/// Only the trees whose active branches all have a single leaf of fundamental
+/// type, or fixed-size array of a fundamental type, can be filled in bulk.
+/// Circular trees and trees with a branch of references cannot.
+///
+/// The function returns the number of bytes committed to the individual
+/// branches, or -1 if the tree cannot be filled in bulk or if a write error
+/// occurs.
+
+Long64_t TTree::FillBulk(Long64_t nentries)
+{
+   if (nentries <= 0)
+      return 0;
+   if (TestBit(kCircular) || fBranchRef) {
+      Error("FillBulk", "Circular trees and trees with references cannot be filled in bulk.");
+      return -1;
+   }
+
+   std::vector<TBranch *> branches;
+   Int_t nbranches = fBranches.GetEntriesFast();
+   for (Int_t i = 0; i < nbranches; ++i) {
+      TBranch *branch = (TBranch *)fBranches.UncheckedAt(i);
+      if (branch->TestBit(kDoNotProcess))
+         continue;
+      if (!branch->CanFillBulk()) {
+         Error("FillBulk", "The branch %s cannot be filled in bulk: it must have its address set and a single leaf"
+                           " of fundamental type or fixed-size array of a fundamental type.",
+               branch->GetName());
+         return -1;
+      }
+      branches.push_back(branch);
+   }
+
+   Long64_t nbytes = 0;
+   Int_t nerror = 0;
+   Long64_t done = 0;
+   while (done < nentries) {
+      // Stop at the first entry for which a basket is written, the tree is
+      // flushed or saved, as Fill() does, so that the decisions are the same.
+      Long64_t n = nentries - done;
+      for (auto branch : branches) {
+         Long64_t capacity = branch->GetBulkFillCapacity();
+         if (capacity <= 0) {
+            Error("FillBulk", "Failed creating a basket for branch:%s.%s", GetName(), branch->GetName());
+            return -1;
+         }
+         n = TMath::Min(n, capacity);
+      }
+      if (fAutoFlush > 0) {
+         Long64_t first = (fFlushedBytes != 0 && fNClusterRange) ? fClusterRangeEnd[fNClusterRange - 1] : 0;
+         n = TMath::Min(n, fAutoFlush - (fEntries - first) % fAutoFlush);
+      }
+      if (fAutoSave > 0)
+         n = TMath::Min(n, fAutoSave - fEntries % fAutoSave);
+
+      if (fBasketPipeline && WritePipelinedBaskets(kFALSE) < 0)
+         ++nerror;
+
+#ifdef R__USE_IMT
+      ROOT::Internal::TBranchIMTHelper imtHelper;
+      if (fIMTEnabled) {
+         fIMTFlush = true;
+         fIMTZipBytes.store(0);
+         fIMTTotBytes.store(0);
+      }
+#endif
+
+      for (auto branch : branches) {
+#ifndef R__USE_IMT
+         Int_t nwrite = branch->FillBulkImpl(done, n, nullptr);
+#else
+         Int_t nwrite = branch->FillBulkImpl(done, n, fIMTEnabled ? &imtHelper : nullptr);
+#endif
+         if (nwrite < 0) {
+            Error("FillBulk", "Failed filling branch:%s.%s, nbytes=%d, entries=%lld-%lld", GetName(),
+                  branch->GetName(), nwrite, fEntries + 1, fEntries + n);
+            ++nerror;
+         } else {
+            nbytes += nwrite;
+         }
+      }
+
+#ifdef R__USE_IMT
+      if (fIMTFlush) {
+         imtHelper.Wait();
+         fIMTFlush = false;
+         AddTotBytes(fIMTTotBytes);
+         AddZipBytes(fIMTZipBytes);
+         nbytes += imtHelper.GetNbytes();
+         nerror += imtHelper.GetNerrors();
+      }
+#endif
+
+      fEntries += n;
+      done += n;
+
+      CheckFlushAndSave();
+   }
+
+   return nerror == 0 ? nbytes : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Flush the baskets and save the tree header if it is time to do so after
+/// the last filled entry, see Fill(), and continue on a new file if the
+/// current one is above the maximum tree size.
+
+void TTree::CheckFlushAndSave()
+{
    bool autoFlush = false;
    bool autoSave = false;
 
@@ -4590,7 +4737,13 @@ Int_t TTree::Fill()
    }
 
    if (autoFlush) {
-      FlushBaskets();
+      if (fBasketPipeline) {
+         // Hand the baskets of the cluster over to the background compression, without waiting for them.
+         for (Int_t i = 0; i < fBranches.GetEntriesFast(); ++i)
+            ((TBranch *)fBranches.UncheckedAt(i))->FlushBaskets();
+      } else {
+         FlushBaskets();
+      }
       if (gDebug > 0)
          Info("TTree::Fill", "FlushBaskets() called at entry %lld, fZipBytes=%lld, fFlushedBytes=%lld\n", fEntries,
               GetZipBytes(), fFlushedBytes);
@@ -4612,8 +4765,6 @@ Int_t TTree::Fill()
       if (TFile *file = fDirectory->GetFile())
          if ((TDirectory *)file == fDirectory && (file->GetEND() > fgMaxTreeSize))
             ChangeFile(file);
-
-   return nerror == 0 ? nbytes : -1;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -4952,6 +5103,19 @@ Int_t TTree::FlushBaskets() const
    Int_t nb = lb->GetEntriesFast();
 
 #ifdef R__USE_IMT
+   if (fBasketPipeline) {
+      // The baskets are compressed in parallel by the pipeline, and written once all are done.
+      for (Int_t j = 0; j < nb; j++) {
+         Int_t nwrite = ((TBranch *)lb->UncheckedAt(j))->FlushBaskets();
+         if (nwrite < 0) {
+            ++nerror;
+         } else {
+            nbytes += nwrite;
+         }
+      }
+      Int_t nwrite = WritePipelinedBaskets(kTRUE);
+      return (nerror || nwrite < 0) ? -1 : nbytes + nwrite;
+   }
    if (fIMTEnabled) {
       if (fSortedBranches.empty()) { const_cast<TTree*>(this)->InitializeBranchLists(false); }
 
@@ -5014,6 +5178,33 @@ Int_t TTree::FlushBaskets() const
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Write to the file the baskets compressed in the background, see
+/// SetPipelinedCompression, after waiting for all of them if `wait` is true.
+///
+/// Return the number of bytes written or -1 in case of write error.
+
+Int_t TTree::WritePipelinedBaskets(Bool_t wait) const
+{
+#ifdef R__USE_IMT
+   if (!fBasketPipeline) return 0;
+   Int_t nbytes = 0;
+   Int_t nerror = 0;
+   for (auto &item : fBasketPipeline->Collect(wait)) {
+      Int_t nwrite = item.fBranch->WritePipelinedBasket(item.fBasket, item.fWhere);
+      if (nwrite < 0) {
+         ++nerror;
+      } else {
+         nbytes += nwrite;
+      }
+   }
+   return nerror ? -1 : nbytes;
+#else
+   (void)wait;
+   return 0;
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Returns the expanded value of the alias.  Search in the friends if any.
 
@@ -7653,6 +7844,14 @@ void TTree::RemoveFriend(TTree* oldFriend)
 
 void TTree::Reset(Option_t* option)
 {
+#ifdef R__USE_IMT
+   if (fBasketPipeline) {
+      // Discard the baskets being compressed, like the baskets in memory.
+      const Long64_t maxInFlightBytes = fBasketPipeline->GetMaxInFlightBytes();
+      delete fBasketPipeline;
+      fBasketPipeline = new ROOT::Internal::TBasketWritePipeline(maxInFlightBytes);
+   }
+#endif
    fNotify        = 0;
    fEntries       = 0;
    fNClusterRange = 0;
@@ -7806,6 +8005,35 @@ Bool_t TTree::SetAlias(const char* aliasName, const char* aliasFormula)
    return kTRUE;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Let the tree select the compression algorithm and level of each branch.
+///
+/// When a branch writes its first basket, the content of the basket is
+/// compressed with each of a set of candidate settings (LZ4, ZLIB and LZMA at
+/// a few levels), and the decompression of the result is timed. The setting
+/// best fitting `objective` then becomes the compression setting of the
+/// branch, and is used for all its baskets:
+///
+///  - kAutoCompressionSize: the smallest compressed size.
+///  - kAutoCompressionSpeed: the fastest decompression.
+///  - kAutoCompressionBalanced: the smallest size among the settings that
+///    decompress at most 4 times slower than the fastest one.
+///
+/// With kAutoCompressionSpeed and kAutoCompressionBalanced, a branch whose
+/// content compresses by less than 10% is not compressed at all.
+/// The compression filters of the branches (see TBranch::SetCompressionFilters)
+/// are taken into account. kNoAutoCompression disables the selection; the
+/// branches that already selected their setting keep it.
+
+void TTree::SetAutoCompression(Int_t objective)
+{
+   if (objective < kNoAutoCompression || objective > kAutoCompressionBalanced) {
+      Error("SetAutoCompression", "Unknown objective %d", objective);
+      return;
+   }
+   fAutoCompression = objective;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// This function may be called at the start of a program to change
 /// the default value for fAutoFlush.
@@ -8244,6 +8472,37 @@ void TTree::SetBranchStyle(Int_t style)
    fgBranchStyle = style;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Enable or disable the asynchronous read-ahead of the TTreeCache.
+///
+/// When enabled, while the entries of a cluster are processed, the baskets of
+/// the next cluster are already read in the background, see
+/// TTreeCache::SetEnablePrefetching. This hides the latency of the read of
+/// each cluster, which matters most for remote files.
+/// The baskets are then unzipped by the reader: when the read-ahead is enabled
+/// before the cache is created, a TTreeCache is created even if parallel
+/// unzipping is enabled.
+///
+/// The read-ahead can also be enabled for all remote files with the rootrc
+/// variable TFile.AsyncPrefetching.
+
+void TTree::SetCacheReadAhead(Bool_t enabled /* = kTRUE */)
+{
+   fCacheDoReadAhead = enabled;
+
+   TTree *tree = GetTree();
+   if (tree && tree != this) {
+      // We are a TChain: the cache belongs to the current tree
+      tree->SetCacheReadAhead(enabled);
+      return;
+   }
+
+   TFile *file = GetCurrentFile();
+   if (!file) return;
+   TTreeCache *pf = GetReadCache(file);
+   if (pf) pf->SetEnablePrefetching(enabled);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Set maximum size of the file cache .
 //
@@ -8381,12 +8640,14 @@ Int_t TTree::SetCacheSizeAux(Bool_t autocache /* = kTRUE */, Long64_t cacheSize
       return 0;
    }
 
-   if(TTreeCacheUnzip::IsParallelUnzip() && file->GetCompressionLevel() > 0)
+   // The read-ahead is implemented by TTreeCache only
+   if(TTreeCacheUnzip::IsParallelUnzip() && file->GetCompressionLevel() > 0 && !fCacheDoReadAhead)
       pf = new TTreeCacheUnzip(this, cacheSize);
    else
       pf = new TTreeCache(this, cacheSize);
 
    pf->SetAutoCreated(autocache);
+   if (fCacheDoReadAhead) pf->SetEnablePrefetching(kTRUE);
 
    return 0;
 }
@@ -8821,6 +9082,9 @@ void TTree::SetObject(const char* name, const char* title)
 
 ////////////////////////////////////////////////////////////////////////////////
 /// Enable or disable parallel unzipping of Tree buffers.
+/// It is disabled by default. Once enabled, it is used when implicit
+/// multi-threading is enabled: the baskets in the TTreeCache are unzipped in
+/// advance by tasks of the implicit multi-threading pool.
 
 void TTree::SetParallelUnzip(Bool_t opt, Float_t RelSize)
 {
@@ -8841,6 +9105,65 @@ void TTree::SetPerfStats(TVirtualPerfStats *perf)
    fPerfStats = perf;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Return the maximum size of the baskets being compressed in the background,
+/// or 0 if pipelined compression is disabled, see SetPipelinedCompression.
+
+Long64_t TTree::GetPipelinedCompression() const
+{
+#ifdef R__USE_IMT
+   return fBasketPipeline ? fBasketPipeline->GetMaxInFlightBytes() : 0;
+#else
+   return 0;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Enable the pipelined compression of the baskets during Fill.
+///
+/// By default, when a basket is full, or when the baskets are flushed (see
+/// SetAutoFlush), Fill compresses the baskets and writes them to the file
+/// before returning, in parallel if implicit multi-threading is enabled but
+/// always waiting for the end of the flush.
+///
+/// With pipelined compression, a full basket is instead handed over to a
+/// task that compresses it in the background while the tree continues to be
+/// filled in a new basket. The compressed baskets are written to the file by
+/// the next calls to Fill, so that the file is only accessed from the thread
+/// filling the tree. The baskets handed over and not written yet, compressed or
+/// not, are bounded by `maxInFlightBytes`: a basket that would exceed it waits
+/// for the previous ones to be compressed and written, which bounds the memory used.
+///
+/// FlushBaskets, AutoSave and Write wait for all the baskets: once they
+/// return, the content of the file is the same as without pipelining.
+///
+/// Pipelined compression requires implicit multi-threading to be enabled,
+/// see ROOT::EnableImplicitMT. `maxInFlightBytes` = 0 disables it.
+
+void TTree::SetPipelinedCompression(Long64_t maxInFlightBytes)
+{
+#ifdef R__USE_IMT
+   if (maxInFlightBytes <= 0) {
+      if (fBasketPipeline) {
+         WritePipelinedBaskets(kTRUE);
+         delete fBasketPipeline;
+         fBasketPipeline = nullptr;
+      }
+   } else if (fBasketPipeline) {
+      fBasketPipeline->SetMaxInFlightBytes(maxInFlightBytes);
+   } else if (ROOT::IsImplicitMTEnabled()) {
+      fBasketPipeline = new ROOT::Internal::TBasketWritePipeline(maxInFlightBytes);
+   } else {
+      Warning("SetPipelinedCompression", "Implicit multi-threading is not enabled: the baskets are compressed"
+                                         " during Fill.");
+   }
+#else
+   if (maxInFlightBytes > 0)
+      Warning("SetPipelinedCompression", "ROOT was built without implicit multi-threading support: the baskets are"
+                                         " compressed during Fill.");
+#endif
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// The current TreeIndex is replaced by the new index.
 /// Note that this function does not delete the previous index.
@@ -911,6 +911,9 @@ Bool_t TTreeCache::FillBuffer()
          // only in reverse prefetching mode
          fFirstTime = kFALSE;
       }
+      // Start reading the baskets just registered right away rather than at
+      // the next read: they are read while the current buffer is processed.
+      TFileCacheRead::StartPrefetching();
    }
    fIsLearning = kFALSE;
    return kTRUE;
@@ -1148,6 +1151,33 @@ Int_t TTreeCache::SetBufferSize(Int_t buffersize)
    return 1;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Enable or disable the asynchronous read-ahead of the cache.
+///
+/// When enabled, the cache has two buffers: while the baskets of a cluster are
+/// read from one of them, the baskets of the next cluster are read in the
+/// background into the other one, by the thread of a TFilePrefetch. This hides
+/// the latency of the read of each cluster, in particular for remote files.
+/// The content of the cache is discarded, it is filled again at the next read.
+
+void TTreeCache::SetEnablePrefetching(Bool_t setPrefetching)
+{
+   if (setPrefetching == fEnablePrefetching) return;
+
+   TFileCacheRead::Prefetch(0,0);
+   TFileCacheRead::SecondPrefetch(0,0);
+   TFileCacheRead::SetEnablePrefetching(setPrefetching);
+
+   fFirstBuffer = kTRUE;
+   fFirstTime = kTRUE;
+   fOneTime = kFALSE;
+   fReadDirectionSet = kFALSE;
+   fEntryCurrent = -1;
+   if (!fIsLearning) {
+      fEntryNext = -1;
+   }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Set the minimum and maximum entry number to be processed
 /// this information helps to optimize the number of baskets to read
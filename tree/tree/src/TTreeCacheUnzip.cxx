@@ -20,10 +20,11 @@ Core TTree-related code borrowed from the previous version
 
 ## Parallel Unzipping
 
-TTreeCache has been specialised in order to let additional threads
-free to unzip in advance its content. In this implementation we
-support up to 10 threads, but right now it makes more sense to
-limit their number to 1-2
+TTreeCache has been specialised in order to unzip its content in advance.
+When implicit multi-threading is enabled (ROOT::EnableImplicitMT()), each
+time the cache is filled with the baskets of a cluster, one task per basket
+is submitted to the ROOT task scheduler to unzip it. Therefore the baskets
+are unzipped by as many threads as the implicit multi-threading pool has.
 
 The application reading data is carefully synchronized, in order to:
  - if the block it wants is not unzipped, it self-unzips it without
@@ -35,6 +36,9 @@ The application reading data is carefully synchronized, in order to:
 This is supposed to cancel a part of the unzipping latency, at the
 expenses of cpu time.
 
+Parallel unzipping is disabled by default. Once enabled, it is used when
+implicit multi-threading is enabled, see TTreeCacheUnzip::SetParallelUnzip.
+
 The default parameters are the same of the prev version, i.e. 20%
 of the TTreeCache cache size. To change it use
 TTreeCache::SetUnzipBufferSize(Long64_t bufferSize)
@@ -48,14 +52,14 @@ where bufferSize must be passed in bytes.
 #include "TEventList.h"
 #include "TMutex.h"
 #include "TVirtualMutex.h"
-#include "TThread.h"
-#include "TCondition.h"
 #include "TMath.h"
+#include "TROOT.h"
 #include "Bytes.h"
 
 #include "TEnv.h"
 
-#define THREADCNT 2
+#include "ROOT/TTaskGroup.hxx"
+
 extern "C" void R__unzip(Int_t *nin, UChar_t *bufin, Int_t *lout, char *bufout, Int_t *nout);
 extern "C" int R__unzip_header(Int_t *nin, UChar_t *bufin, Int_t *lout);
 
@@ -72,14 +76,10 @@ ClassImp(TTreeCacheUnzip);
 
 TTreeCacheUnzip::TTreeCacheUnzip() : TTreeCache(),
 
-   fActiveThread(kFALSE),
    fAsyncReading(kFALSE),
+   fUnzipTasksStarted(kFALSE),
    fCycle(0),
-   fLastReadPos(0),
-   fBlocksToGo(0),
-   fUnzipLen(0),
-   fUnzipChunks(0),
-   fUnzipStatus(0),
+   fNRunningTasks(0),
    fTotalUnzipBytes(0),
    fNseekMax(0),
    fUnzipBufferSize(0),
@@ -98,14 +98,10 @@ TTreeCacheUnzip::TTreeCacheUnzip() : TTreeCache(),
 /// Constructor.
 
 TTreeCacheUnzip::TTreeCacheUnzip(TTree *tree, Int_t buffersize) : TTreeCache(tree,buffersize),
-   fActiveThread(kFALSE),
    fAsyncReading(kFALSE),
+   fUnzipTasksStarted(kFALSE),
    fCycle(0),
-   fLastReadPos(0),
-   fBlocksToGo(0),
-   fUnzipLen(0),
-   fUnzipChunks(0),
-   fUnzipStatus(0),
+   fNRunningTasks(0),
    fTotalUnzipBytes(0),
    fNseekMax(0),
    fUnzipBufferSize(0),
@@ -125,32 +121,18 @@ void TTreeCacheUnzip::Init()
    fMutexList        = new TMutex(kTRUE);
    fIOMutex          = new TMutex(kTRUE);
 
-   fUnzipStartCondition   = new TCondition(fMutexList);
-   fUnzipDoneCondition   = new TCondition(fMutexList);
-
    fTotalUnzipBytes = 0;
 
-   fCompBuffer = new char[16384];
-   fCompBufferSize = 16384;
-
    if (fgParallel == kDisable) {
       fParallel = kFALSE;
    }
    else if(fgParallel == kEnable || fgParallel == kForce) {
-      SysInfo_t info;
-      gSystem->GetSysInfo(&info);
-
       fUnzipBufferSize = Long64_t(fgRelBuffSize * GetBufferSize());
 
       if(gDebug > 0)
          Info("TTreeCacheUnzip", "Enabling Parallel Unzipping");
 
       fParallel = kTRUE;
-
-      for (Int_t i = 0; i < 10; i++) fUnzipThread[i] = 0;
-
-      StartThreadUnzip(THREADCNT);
-
    }
    else {
       Warning("TTreeCacheUnzip", "Parallel Option unknown");
@@ -169,21 +151,13 @@ void TTreeCacheUnzip::Init()
 
 TTreeCacheUnzip::~TTreeCacheUnzip()
 {
+   // The tasks that did not start yet still refer to this cache: they return at once
+   fCycle++;
+   if (fUnzipTaskGroup) fUnzipTaskGroup->Wait();
    ResetCache();
 
-   if (IsActiveThread())
-      StopThreadUnzip();
-
-   delete [] fUnzipLen;
-
-   delete fUnzipStartCondition;
-   delete fUnzipDoneCondition;
-
    delete fMutexList;
    delete fIOMutex;
-
-   delete [] fUnzipStatus;
-   delete [] fUnzipChunks;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -257,6 +231,9 @@ Bool_t TTreeCacheUnzip::FillBuffer()
          }
       }
 
+      // the unzipping tasks read the baskets of the cache buffer
+      WaitUnzipTasks();
+
       //clear cache buffer
       TFileCacheRead::Prefetch(0,0);
 
@@ -315,6 +292,7 @@ Int_t TTreeCacheUnzip::SetBufferSize(Int_t buffersize)
 {
    R__LOCKGUARD(fMutexList);
 
+   WaitUnzipTasks();
    Int_t res = TTreeCache::SetBufferSize(buffersize);
    if (res < 0) {
       return res;
@@ -355,6 +333,7 @@ void TTreeCacheUnzip::UpdateBranches(TTree *tree)
 {
    R__LOCKGUARD(fMutexList);
 
+   WaitUnzipTasks();
    TTreeCache::UpdateBranches(tree);
 }
 
@@ -374,73 +353,30 @@ TTreeCacheUnzip::EParUnzipMode TTreeCacheUnzip::GetParallelUnzip()
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// Static function that tells wether the multithreading unzipping is activated
+/// Static function that tells wether the multithreading unzipping is activated.
+/// With kEnable, it is activated only when implicit multi-threading is enabled.
 
 Bool_t TTreeCacheUnzip::IsParallelUnzip()
 {
-   if (fgParallel == kEnable || fgParallel == kForce)
-      return kTRUE;
-
-   return kFALSE;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// This indicates if the thread is active in this moment...
-/// this variable is very important because if we change it from true to
-/// false the thread will stop... ( see StopThreadTreeCacheUnzip() )
-
-Bool_t TTreeCacheUnzip::IsActiveThread()
-{
-   R__LOCKGUARD(fMutexList);
-
-   return fActiveThread;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// It says if the queue is empty... useful to see if we have to process it.
-
-Bool_t TTreeCacheUnzip::IsQueueEmpty()
-{
-   R__LOCKGUARD(fMutexList);
-
-   if ( fIsLearning )
+   if (fgParallel == kForce)
       return kTRUE;
+   if (fgParallel == kEnable)
+      return ROOT::IsImplicitMTEnabled();
 
    return kFALSE;
 }
 
-void TTreeCacheUnzip::WaitUnzipStartSignal()
-{
-   // Here the threads sleep waiting for some blocks to unzip
-
-   fUnzipStartCondition->TimedWaitRelative(2000);
-
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// This will send the signal corresponfing to the queue... normally used
-/// when we want to start processing the list of buffers.
-
-void TTreeCacheUnzip::SendUnzipStartSignal(Bool_t broadcast)
-{
-   if (gDebug > 0) Info("SendSignal", " fUnzipCondition->Signal()");
-
-   if (broadcast)
-      fUnzipStartCondition->Broadcast();
-   else
-      fUnzipStartCondition->Signal();
-}
-
 ////////////////////////////////////////////////////////////////////////////////
 /// Static function that (de)activates multithreading unzipping
 ///
 /// The possible options are:
-///  - kEnable _Enable_ it, which causes an automatic detection and launches the
-///    additional thread if the number of cores in the machine is greater than
-///    one
-///  - kDisable _Disable_ will not activate the additional thread.
-///  - kForce _Force_ will start the additional thread even if there is only one
-///    core. the default will be taken as kEnable.
+///  - kEnable _Enable_ it when implicit multi-threading is enabled: the
+///    baskets are then unzipped in advance by tasks of the implicit
+///    multi-threading pool.
+///  - kDisable _Disable_ will not use a TTreeCacheUnzip. This is the default.
+///  - kForce _Force_ will use a TTreeCacheUnzip even if implicit
+///    multi-threading is not enabled. The baskets are then only unzipped in
+///    advance if it is enabled later.
 ///
 /// Returns 0 if there was an error, 1 otherwise.
 
@@ -453,135 +389,80 @@ Int_t TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::EParUnzipMode option)
    return 0;
 }
 
-class TTreeCacheUnzipData {
-public:
-   TTreeCacheUnzip *fInstance;
-   Int_t            fCount;
-};
-
 ////////////////////////////////////////////////////////////////////////////////
-/// The Thread is only a part of the TTreeCache but it is the part that
-/// waits for info in the queue and process it... unfortunatly, a Thread is
-/// not an object an we have to deal with it in the old C-Style way
-/// Returns 0 if the thread was initialized or 1 if it was already running
+/// Submit one task per basket of the cache to the implicit multi-threading
+/// pool, to unzip the baskets in advance. To be called with fMutexList held.
+/// The compressed baskets are first copied from the cache to a buffer shared by
+/// the tasks: the tasks then take none of the locks of the cache, so that the
+/// readers can wait for them while holding fMutexList or fIOMutex.
 
-Int_t TTreeCacheUnzip::StartThreadUnzip(Int_t nthreads)
+void TTreeCacheUnzip::StartUnzipTasks()
 {
-   Int_t nt = nthreads;
-   if (nt > 10) nt = 10;
-
-   if (gDebug > 0)
-      Info("StartThreadUnzip", "Going to start %d threads.", nt);
-
-   for (Int_t i = 0; i < nt; i++) {
-      if (!fUnzipThread[i]) {
-         TString nm("UnzipLoop");
-         nm += i;
-
-         if (gDebug > 0)
-            Info("StartThreadUnzip", "Going to start thread '%s'", nm.Data());
-
-         TTreeCacheUnzipData *d = new TTreeCacheUnzipData;
-         d->fInstance = this;
-         d->fCount = i;
-
-         fUnzipThread[i] = new TThread(nm.Data(), UnzipLoop, (void*)d);
-         if (!fUnzipThread[i])
-            Error("TTreeCacheUnzip::StartThreadUnzip", " Unable to create new thread.");
-
-         fUnzipThread[i]->Run();
-
-         // There is at least one active thread
-         fActiveThread=kTRUE;
-
-      }
+   if (fNseekMax < fNseek) ResetCache();
+   fUnzipTasksStarted = kTRUE;
+
+#ifdef R__USE_IMT
+   if (!ROOT::IsImplicitMTEnabled())
+      return;
+
+   std::vector<Long64_t> offsets(fNseek, -1);
+   Long64_t snapshotSize = 0;
+   for (Int_t i = 0; i < fNseek; i++) {
+      if (fSeekLen[i] <= 256)
+         continue;
+      offsets[i] = snapshotSize;
+      snapshotSize += fSeekLen[i];
+   }
+   if (snapshotSize == 0)
+      return;
+
+   // Reading the first basket transfers the cache buffer if it was not yet
+   std::shared_ptr<std::vector<char>> snapshot = std::make_shared<std::vector<char>>(snapshotSize);
+   for (Int_t i = 0; i < fNseek; i++) {
+      if (offsets[i] < 0)
+         continue;
+      Int_t loc = -1;
+      if (ReadBufferExt(snapshot->data() + offsets[i], fSeek[i], fSeekLen[i], loc) != 1)
+         offsets[i] = -1;
    }
 
-   return (fActiveThread == kTRUE);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-/// To stop the thread we only need to change the value of the variable
-/// fActiveThread to false and the loop will stop (of course, we will have)
-/// to do the cleaning after that.
-///
-/// Note: The syncronization part is important here or we will try to delete
-///       teh object while it's still processing the queue
-
-Int_t TTreeCacheUnzip::StopThreadUnzip()
-{
-   fActiveThread = kFALSE;
-
-   for (Int_t i = 0; i < 1; i++) {
-      if(fUnzipThread[i]){
-
-         SendUnzipStartSignal(kTRUE);
-
-         if (fUnzipThread[i]->Exists()) {
-            fUnzipThread[i]->Join();
-            delete fUnzipThread[i];
+   if (!fUnzipTaskGroup) fUnzipTaskGroup.reset(new ROOT::Experimental::TTaskGroup());
+   const Int_t cycle = fCycle;
+   for (Int_t i = 0; i < fNseek; i++) {
+      if (offsets[i] < 0)
+         continue;
+      const char *src = snapshot->data() + offsets[i];
+      fUnzipTaskGroup->Run([this, i, cycle, snapshot, src]() {
+         // Counted before UnzipCache checks the cycle, so that WaitUnzipTasks waits for this task if it uses the
+         // arrays of the cache
+         ++fNRunningTasks;
+         UnzipCache(i, cycle, src);
+         {
+            std::lock_guard<std::mutex> lock(fUnzipDoneMutex);
+            --fNRunningTasks;
          }
-      }
-
+         fUnzipDoneCondition.notify_all();
+      });
    }
 
-   return 1;
+   if (gDebug > 0)
+      Info("StartUnzipTasks", "Started the tasks unzipping %d baskets", fNseek);
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// This is a static function.
-///
-/// This is the call that will be executed in the Thread generated by
-/// StartThreadTreeCacheUnzip... what we want to do is to inflate the next
-/// series of buffers leaving them in the second cache.
-///
-/// Returns 0 when it finishes
+/// Tell the unzipping tasks that the content of the cache changed, so that
+/// those which did not start yet return at once without touching it, and wait
+/// for those which are running. The tasks take no lock of the cache, so the
+/// caller may hold fMutexList or fIOMutex. This does not wait on the task
+/// group: that could run other tasks in this thread, which could then read
+/// from this cache while the caller holds fMutexList.
 
-void* TTreeCacheUnzip::UnzipLoop(void *arg)
+void TTreeCacheUnzip::WaitUnzipTasks()
 {
-   TTreeCacheUnzipData *d = (TTreeCacheUnzipData *)arg;
-   TTreeCacheUnzip *unzipMng = d->fInstance;
-
-   TThread::SetCancelOn();
-   TThread::SetCancelDeferred();
-
-   Int_t thrnum = d->fCount;
-   Int_t startindex = thrnum;
-   Int_t locbuffsz = 16384;
-   char *locbuff = new char[16384];
-   Int_t res = 0;
-   Int_t myCycle = 0;
-
-   while( unzipMng->IsActiveThread() ) {
-      res = 1;
-
-      {
-         R__LOCKGUARD(unzipMng->fMutexList);
-         if (myCycle != unzipMng->fCycle) startindex = thrnum;
-         myCycle = unzipMng->fCycle;
-         if (unzipMng->fNseek) startindex = startindex % unzipMng->fNseek;
-         else startindex = -1;
-      }
-
-      if (startindex >= 0)
-         res = unzipMng->UnzipCache(startindex, locbuffsz, locbuff);
-
-      {
-         R__LOCKGUARD(unzipMng->fMutexList);
-
-         if(!unzipMng->IsActiveThread()) break;
-
-         if ((res == 1) || (!unzipMng->fIsTransferred)) {
-            unzipMng->WaitUnzipStartSignal();
-            startindex = unzipMng->fLastReadPos+3+thrnum;
-         }
-      }
-
-   }
-
-   delete d;
-   delete [] locbuff;
-   return (void *)0;
+   fCycle++;
+   std::unique_lock<std::mutex> lock(fUnzipDoneMutex);
+   fUnzipDoneCondition.wait(lock, [this]() { return fNRunningTasks == 0; });
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -642,57 +523,33 @@ Int_t TTreeCacheUnzip::GetRecordHeader(char *buf, Int_t maxbytes, Int_t &nbytes,
 
 void TTreeCacheUnzip::ResetCache()
 {
-   {
    R__LOCKGUARD(fMutexList);
 
-   if (gDebug > 0)
-      Info("ResetCache", "Thread: %ld -- Resetting the cache. fNseek:%d fNSeekMax:%d fTotalUnzipBytes:%lld", TThread::SelfId(), fNseek, fNseekMax, fTotalUnzipBytes);
-
-   // Reset all the lists and wipe all the chunks
-   fCycle++;
-   for (Int_t i = 0; i < fNseekMax; i++) {
-      if (fUnzipLen) fUnzipLen[i] = 0;
-      if (fUnzipChunks) {
-         if (fUnzipChunks[i]) delete [] fUnzipChunks[i];
-         fUnzipChunks[i] = 0;
-      }
-      if (fUnzipStatus) fUnzipStatus[i] = 0;
-
-   }
+   WaitUnzipTasks();
 
-   while (fActiveBlks.size()) fActiveBlks.pop();
+   if (gDebug > 0)
+      Info("ResetCache", "Resetting the cache. fNseek:%d fNSeekMax:%d fTotalUnzipBytes:%lld", fNseek, fNseekMax,
+           fTotalUnzipBytes.load());
 
    if(fNseekMax < fNseek){
       if (gDebug > 0)
          Info("ResetCache", "Changing fNseekMax from:%d to:%d", fNseekMax, fNseek);
 
-      Byte_t *aUnzipStatus = new Byte_t[fNseek];
-      memset(aUnzipStatus, 0, fNseek*sizeof(Byte_t));
-
-      Int_t *aUnzipLen = new Int_t[fNseek];
-      memset(aUnzipLen, 0, fNseek*sizeof(Int_t));
-
-      char **aUnzipChunks = new char *[fNseek];
-      memset(aUnzipChunks, 0, fNseek*sizeof(char *));
-
-      if (fUnzipStatus) delete [] fUnzipStatus;
-      if (fUnzipLen) delete [] fUnzipLen;
-      if (fUnzipChunks) delete [] fUnzipChunks;
-
-      fUnzipStatus  = aUnzipStatus;
-      fUnzipLen  = aUnzipLen;
-      fUnzipChunks = aUnzipChunks;
-
+      fUnzipStatus.reset(new std::atomic<Byte_t>[fNseek]);
+      fUnzipLen.resize(fNseek);
+      fUnzipChunks.resize(fNseek);
       fNseekMax  = fNseek;
    }
 
-   fLastReadPos = 0;
-   fTotalUnzipBytes = 0;
-   fBlocksToGo = fNseek;
+   // Reset all the lists and wipe all the chunks
+   for (Int_t i = 0; i < fNseekMax; i++) {
+      fUnzipLen[i] = 0;
+      fUnzipChunks[i].reset();
+      fUnzipStatus[i] = kUntouched;
    }
 
-   SendUnzipStartSignal(kTRUE);
-
+   fTotalUnzipBytes = 0;
+   fUnzipTasksStarted = kFALSE;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -707,204 +564,80 @@ void TTreeCacheUnzip::ResetCache()
 
 Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_t *free)
 {
-   Int_t res = 0;
-   Int_t loc = -1;
-
    {
+      // FillBuffer, called by the other readers, resets and reallocates the arrays of the unzipped chunks: the lock is
+      // held until the chunk is handed over. The unzipping tasks take no lock, so waiting for one here is safe.
       R__LOCKGUARD(fMutexList);
 
-      // We go straight to TTreeCache/TfileCacheRead, in order to get the info we need
-      //  pointer to the original zipped chunk
-      //  its index in the original unsorted offsets lists
-      //
-      // Actually there are situations in which copying the buffer is not
-      // useful. But the choice is among doing once more a small memcpy or a binary search in a large array. I prefer the former.
-      // Also, here we prefer not to trigger the (re)population of the chunks in the TFileCacheRead. That is
-      // better to be done in the main thread.
-
-      // And now loc is the position of the chunk in the array of the sorted chunks
-      Int_t myCycle = fCycle;
-
+      Int_t seekidx = -1;
       if (fParallel && !fIsLearning) {
+         if (fNseek > 0 && !fUnzipTasksStarted) StartUnzipTasks();
 
-         if(fNseekMax < fNseek){
-            if (gDebug > 0)
-               Info("GetUnzipBuffer", "Changing fNseekMax from:%d to:%d", fNseekMax, fNseek);
-
-            Byte_t *aUnzipStatus = new Byte_t[fNseek];
-            memset(aUnzipStatus, 0, fNseek*sizeof(Byte_t));
-
-            Int_t *aUnzipLen = new Int_t[fNseek];
-            memset(aUnzipLen, 0, fNseek*sizeof(Int_t));
-
-            char **aUnzipChunks = new char *[fNseek];
-            memset(aUnzipChunks, 0, fNseek*sizeof(char *));
+         // The buffer is, at minimum, in the file cache. We must know its index in the requests list
+         // In order to get its info
+         Int_t loc = (Int_t)TMath::BinarySearch(fNseek,fSeekSort,pos);
+         if (fIsTransferred && (loc >= 0) && (loc < fNseek) && (pos == fSeekSort[loc]) && (loc < fNseekMax))
+            seekidx = fSeekIndex[loc];
+      }
 
-            for (Int_t i = 0; i < fNseekMax; i++) {
-               aUnzipStatus[i] = fUnzipStatus[i];
-               aUnzipLen[i] = fUnzipLen[i];
-               aUnzipChunks[i] = fUnzipChunks[i];
+      if (seekidx >= 0) {
+         // If no task started to unzip the block, we take it over: no task will touch it anymore.
+         // If a task is unzipping it, we wait only for that unzip to finish.
+         Byte_t status = kUntouched;
+         if (!fUnzipStatus[seekidx].compare_exchange_strong(status, kFinished)) {
+            if (status == kProgress) {
+               std::unique_lock<std::mutex> lock(fUnzipDoneMutex);
+               fUnzipDoneCondition.wait(lock, [this, seekidx]() { return fUnzipStatus[seekidx] == kFinished; });
             }
 
-            if (fUnzipStatus) delete [] fUnzipStatus;
-            if (fUnzipLen) delete [] fUnzipLen;
-            if (fUnzipChunks) delete [] fUnzipChunks;
-
-            fUnzipStatus  = aUnzipStatus;
-            fUnzipLen  = aUnzipLen;
-            fUnzipChunks = aUnzipChunks;
-
-            fNseekMax  = fNseek;
-         }
-
-         loc = (Int_t)TMath::BinarySearch(fNseek,fSeekSort,pos);
-         if ( (fCycle == myCycle) && (loc >= 0) && (loc < fNseek) && (pos == fSeekSort[loc]) ) {
-
-            // The buffer is, at minimum, in the file cache. We must know its index in the requests list
-            // In order to get its info
-            Int_t seekidx = fSeekIndex[loc];
-
-            fLastReadPos = seekidx;
-
-            do {
-
-               // If the block is ready we get it immediately.
-               // And also we don't have to alloc the blks. This is supposed to be
-               // the main thread of the app.
-               if ((fUnzipStatus[seekidx] == 2) && (fUnzipChunks[seekidx]) && (fUnzipLen[seekidx] > 0)) {
-
-                  //if (gDebug > 0)
-                  //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheHIT Block wanted: %d  len:%d req_len:%d fNseek:%d", seekidx, fUnzipLen[seekidx], len,  fNseek);
-
-                  if(!(*buf)) {
-                     *buf = fUnzipChunks[seekidx];
-                     fUnzipChunks[seekidx] = 0;
-                     fTotalUnzipBytes -= fUnzipLen[seekidx];
-                     SendUnzipStartSignal(kFALSE);
-                     *free = kTRUE;
-                  }
-                  else {
-                     memcpy(*buf, fUnzipChunks[seekidx], fUnzipLen[seekidx]);
-                     delete fUnzipChunks[seekidx];
-                     fTotalUnzipBytes -= fUnzipLen[seekidx];
-                     fUnzipChunks[seekidx] = 0;
-                     SendUnzipStartSignal(kFALSE);
-                     *free = kFALSE;
-                  }
-
-                  fNFound++;
-
-                  return fUnzipLen[seekidx];
-               }
-
-               // If the status of the unzipped chunk is pending
-               // we wait on the condvar, hoping that the next signal is the good one
-               if ( fUnzipStatus[seekidx] == 1 ) {
-                  //fMutexList->UnLock();
-                  fUnzipDoneCondition->TimedWaitRelative(200);
-                  //fMutexList->Lock();
-
-                  if ( myCycle != fCycle ) {
-                     if (gDebug > 0)
-                        Info("GetUnzipBuffer", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                             IsActiveThread(), fNseek, fIsLearning);
-
-                     fLastReadPos = 0;
-
-                     seekidx = -1;
-                     break;
-                  }
-
-               }
-
-            } while ( fUnzipStatus[seekidx] == 1 );
-
-            //if (gDebug > 0)
-            //   Info("GetUnzipBuffer", "------- Block wanted: %d  status: %d len: %d chunk: %llx ", seekidx, fUnzipStatus[seekidx], fUnzipLen[seekidx], fUnzipChunks[seekidx]);
-
-            // Here the block is not pending. It could be done or aborted or not yet being processed.
-            if ( (seekidx >= 0) && (fUnzipStatus[seekidx] == 2) && (fUnzipChunks[seekidx]) && (fUnzipLen[seekidx] > 0) ) {
-
-               //if (gDebug > 0)
-               //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheLateHIT Block wanted: %d  len:%d fNseek:%d", seekidx, fUnzipLen[seekidx], fNseek);
-
+            if (fUnzipChunks[seekidx]) {
+               const Int_t unzipLen = fUnzipLen[seekidx];
                if(!(*buf)) {
-                  *buf = fUnzipChunks[seekidx];
-                  fUnzipChunks[seekidx] = 0;
-                  fTotalUnzipBytes -= fUnzipLen[seekidx];
-                  SendUnzipStartSignal(kFALSE);
+                  *buf = fUnzipChunks[seekidx].release();
                   *free = kTRUE;
                }
                else {
-                  memcpy(*buf, fUnzipChunks[seekidx], fUnzipLen[seekidx]);
-                  delete fUnzipChunks[seekidx];
-                  fTotalUnzipBytes -= fUnzipLen[seekidx];
-                  fUnzipChunks[seekidx] = 0;
-                  SendUnzipStartSignal(kFALSE);
+                  memcpy(*buf, fUnzipChunks[seekidx].get(), unzipLen);
+                  fUnzipChunks[seekidx].reset();
                   *free = kFALSE;
                }
+               fTotalUnzipBytes -= unzipLen;
 
-               fNStalls++;
+               if (status == kProgress) fNStalls++;
+               else fNFound++;
 
-               return fUnzipLen[seekidx];
+               return unzipLen;
             }
-            else {
-               // This is a complete miss. We want to avoid the threads
-               // to try unzipping this block in the future.
-               fUnzipStatus[seekidx] = 2;
-               fUnzipChunks[seekidx] = 0;
-
-               if ((fTotalUnzipBytes < fUnzipBufferSize) && fBlocksToGo)
-                  SendUnzipStartSignal(kFALSE);
-
-               //if (gDebug > 0)
-               //   Info("GetUnzipBuffer", "++++++++++++++++++++ CacheMISS Block wanted: %d  len:%d fNseek:%d", seekidx, len, fNseek);
-            }
-
-         } else {
-            loc = -1;
-            //fLastReadPos = 0;
-            fIsTransferred = kFALSE;
          }
-
-      } else {
-         // We need to reset it for new transferences...
-         //ResetCache();
-         //TFileCacheRead::Prefetch(0,0);
       }
 
    } // scope of the lock!
 
-   if (len > fCompBufferSize) {
-      delete [] fCompBuffer;
-      fCompBuffer = new char[len];
-      fCompBufferSize = len;
-   } else {
-      if (fCompBufferSize > len*4) {
-      delete [] fCompBuffer;
-      fCompBuffer = new char[len*2];
-      fCompBufferSize = len*2;
+   // Here we know that the async unzip of the wanted chunk
+   // was not done for some reason. We continue.
+   // Several branches may be read at the same time: each reader uses its own buffer
+   std::vector<char> compBuffer(len);
+   Int_t loc = -1;
+   Int_t res = ReadBufferExt(compBuffer.data(), pos, len, loc);
+   if (res == 0) {
+      // The block is not in the cache: move the cache to the cluster of the entry being read, whose baskets are then
+      // unzipped in advance
+      Bool_t filled;
+      {
+         R__LOCKGUARD(fMutexList);
+         filled = FillBuffer();
       }
+      if (filled) return GetUnzipBuffer(buf, pos, len, free);
    }
 
-   {
+   if (res == 0) {
       R__LOCKGUARD(fIOMutex);
-      // Here we know that the async unzip of the wanted chunk
-      // was not done for some reason. We continue.
-
-      res = 0;
-      if (!ReadBufferExt(fCompBuffer, pos, len, loc)) {
-         //Info("GetUnzipBuffer", "++++++++++++++++++++ CacheMISS %d %d", loc, fNseek);
-         fFile->Seek(pos);
-         res = fFile->ReadBuffer(fCompBuffer, len);
-      }
-
-      if (res) res = -1;
-
-   } // scope of the lock!
+      fFile->Seek(pos);
+      res = fFile->ReadBuffer(compBuffer.data(), len) ? -1 : 1;
+   }
 
-   if (!res) {
-      res = UnzipBuffer(buf, fCompBuffer);
+   if (res > 0) {
+      res = UnzipBuffer(buf, compBuffer.data());
       *free = kTRUE;
    }
 
@@ -916,6 +649,7 @@ Int_t TTreeCacheUnzip::GetUnzipBuffer(char **buf, Long64_t pos, Int_t len, Bool_
 
 }
 
+
 ////////////////////////////////////////////////////////////////////////////////
 /// static function: Sets the unzip relatibe buffer size
 
@@ -972,10 +706,11 @@ Int_t TTreeCacheUnzip::UnzipBuffer(char **dest, char *src)
    // fSeekLen[ind]; len of the zipped buffer
    // &fBuffer[fSeekPos[ind]]; memory address
 
-   // This is similar to TBasket::ReadBasketBuffers
+   // This is similar to TBasket::ReadBasketBuffers. The branches are only
+   // looked at for old files: the list may change while a task unzips.
    Bool_t oldCase = objlen==nbytes-keylen
-      && ((TBranch*)fBranches->UncheckedAt(0))->GetCompressionLevel()!=0
-      && fFile->GetVersion()<=30401;
+      && fFile->GetVersion()<=30401
+      && ((TBranch*)fBranches->UncheckedAt(0))->GetCompressionLevel()!=0;
 
    if (objlen > nbytes-keylen || oldCase) {
 
@@ -1037,218 +772,92 @@ Int_t TTreeCacheUnzip::UnzipBuffer(char **dest, char *src)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// This inflates all the buffers in the cache.. passing the data to a new
-/// buffer that will only wait there to be read...
-/// We can not inflate all the buffers in the cache so we will try to do
-/// it until the cache gets full... there is a member called fUnzipBufferSize which will
+/// This inflates the buffer with index `index` in the cache, passing the data
+/// to a new buffer that will only wait there to be read...
+/// We can not inflate all the buffers in the cache so we do it until the cache
+/// gets full... there is a member called fUnzipBufferSize which will
 /// tell us the max size we can allocate for this cache.
 ///
-/// note that we will  unzip in the order they were put into the cache not
-/// the order of the transference so it has to be read in that order or the
-/// pre-unzipping will be useless.
+/// This is the body of the tasks started by StartUnzipTasks. `cycle` is the
+/// value of fCycle when the task was started: if the content of the cache
+/// changed since, the task has nothing to do. `src` is the copy of the
+/// compressed basket made by StartUnzipTasks: the task reads nothing else from
+/// the cache buffer.
 ///
-/// startindex is used as start index to check for blks to be unzipped
+/// returns 0 in normal conditions or -1 if error, 1 if the block was skipped
 ///
-/// returns 0 in normal conditions or -1 if error, 1 if it would like to sleep
-///
-/// This func is supposed to compete among an indefinite number of threads to get a chunk to inflate
-/// in order to accommodate multiple unzippers
 /// Since everything is so async, we cannot use a fixed buffer, we are forced to keep
 /// the individual chunks as separate blocks, whose summed size does not exceed the maximum
 /// allowed. The pointers are kept globally in the array fUnzipChunks
 
-Int_t TTreeCacheUnzip::UnzipCache(Int_t &startindex, Int_t &locbuffsz, char *&locbuff)
+Int_t TTreeCacheUnzip::UnzipCache(Int_t index, Int_t cycle, const char *src)
 {
-   Int_t myCycle;
-   const Int_t hlen=128;
-   Int_t objlen=0, keylen=0;
-   Int_t nbytes=0;
-   Int_t readbuf = 0;
-
-   Int_t idxtounzip = -1;
-   Long64_t rdoffs = 0;
-   Int_t rdlen = 0;
-   {
-      R__LOCKGUARD(fMutexList);
-
-      if (!IsActiveThread() || !fNseek || fIsLearning || !fIsTransferred) {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
-         return 1;
-      }
-
-      // To synchronize with the 'paging'
-      myCycle = fCycle;
-
-      // Try to look for a blk to unzip
-      idxtounzip = -1;
-      rdoffs = 0;
-      rdlen = 0;
-      if (fTotalUnzipBytes < fUnzipBufferSize) {
-
-         if (fBlocksToGo > 0) {
-            for (Int_t ii=0; ii < fNseek; ii++) {
-               Int_t reqi = (startindex+ii) % fNseek;
-               if (!fUnzipStatus[reqi] && (fSeekLen[reqi] > 256)   ) {
-                  // We found a chunk which is not unzipped nor pending
-                  fUnzipStatus[reqi] = 1; // Set it as pending
-                  idxtounzip = reqi;
-
-                  rdoffs = fSeek[idxtounzip];
-                  rdlen = fSeekLen[idxtounzip];
-                  break;
-               }
-            }
-            if (idxtounzip < 0) fBlocksToGo = 0;
-         }
-      }
-
-   } // lock scope
-
-   if (idxtounzip < 0) {
-      if (gDebug > 0)
-         Info("UnzipCache", "Nothing to do... startindex:%d fTotalUnzipBytes:%lld fUnzipBufferSize:%lld fNseek:%d",
-              startindex, fTotalUnzipBytes, fUnzipBufferSize, fNseek );
+   if (cycle != fCycle || fTotalUnzipBytes >= fUnzipBufferSize)
       return 1;
-   }
 
-   // And here we have a new blk to unzip
-   startindex = idxtounzip+THREADCNT;
-
-   if (!IsActiveThread() || !fNseek || fIsLearning ) {
-      if (gDebug > 0)
-         Info("UnzipCache", "Sudden Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-              IsActiveThread(), fNseek, fIsLearning);
+   // The reader may have taken over the block already
+   Byte_t status = kUntouched;
+   if (!fUnzipStatus[index].compare_exchange_strong(status, kProgress))
       return 1;
-   }
-
-   Int_t loc = -1;
 
-   // Prepare a static tmp buf of adequate size
-   if(locbuffsz < rdlen) {
-      if (locbuff) delete [] locbuff;
-      locbuffsz = rdlen;
-      locbuff = new char[locbuffsz];
-      //memset(locbuff, 0, locbuffsz);
-   } else if(locbuffsz > rdlen*3) {
-      if (locbuff) delete [] locbuff;
-      locbuffsz = rdlen*2;
-      locbuff = new char[locbuffsz];
-      //memset(locbuff, 0, locbuffsz);
-   }
+   const Int_t hlen=128;
+   Int_t objlen=0, keylen=0;
+   Int_t nbytes=0;
 
    if (gDebug > 0)
-     Info("UnzipCache", "Going to unzip block %d", idxtounzip);
-
-   readbuf = ReadBufferExt(locbuff, rdoffs, rdlen, loc);
-
-   {
-      R__LOCKGUARD(fMutexList);
-
-      if ( (myCycle != fCycle) || !fIsTransferred )  {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-         fUnzipDoneCondition->Signal();
-
-         startindex = 0;
-         return 1;
-      }
-
-      if (readbuf <= 0) {
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-         if (gDebug > 0)
-            Info("UnzipCache", "Block %d not done. rdoffs=%lld rdlen=%d readbuf=%d", idxtounzip, rdoffs, rdlen, readbuf);
-         return -1;
-      }
-
-      GetRecordHeader(locbuff, hlen, nbytes, objlen, keylen);
-
-      Int_t len = (objlen > nbytes-keylen)? keylen+objlen : nbytes;
-
-      // If the single unzipped chunk is really too big, reset it to not processable
-      // I.e. mark it as done but set the pointer to 0
-      // This block will be unzipped synchronously in the main thread
-      if (len > 4*fUnzipBufferSize) {
-
-         //if (gDebug > 0)
-            Info("UnzipCache", "Block %d is too big, skipping.", idxtounzip);
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-
-         fUnzipDoneCondition->Signal();
-         return 0;
-      }
-
-   } // Scope of the lock
+     Info("UnzipCache", "Going to unzip block %d", index);
 
    // Unzip it into a new blk
    char *ptr = 0;
    Int_t loclen = 0;
 
-   loclen = UnzipBuffer(&ptr, locbuff);
+   // UnzipBuffer does not modify its source
+   char *locbuff = const_cast<char *>(src);
+   GetRecordHeader(locbuff, hlen, nbytes, objlen, keylen);
 
-   if ((loclen > 0) && (loclen == objlen+keylen)) {
-      R__LOCKGUARD(fMutexList);
+   Int_t len = (objlen > nbytes-keylen)? keylen+objlen : nbytes;
 
-      if ( (myCycle != fCycle)  || !fIsTransferred) {
-         if (gDebug > 0)
-            Info("UnzipCache", "Sudden paging Break!!! IsActiveThread(): %d, fNseek: %d, fIsLearning:%d",
-                 IsActiveThread(), fNseek, fIsLearning);
+   // If the single unzipped chunk is really too big, leave it to the reader,
+   // which will unzip it synchronously
+   if (len > 4*fUnzipBufferSize) {
+      if (gDebug > 0)
+         Info("UnzipCache", "Block %d is too big, skipping.", index);
+   } else {
+      loclen = UnzipBuffer(&ptr, locbuff);
+      if (ptr && loclen != objlen+keylen) {
          delete [] ptr;
-
-         fUnzipStatus[idxtounzip] = 2; // Set it as not done
-         fUnzipChunks[idxtounzip] = 0;
-         fUnzipLen[idxtounzip] = 0;
-
-         startindex = 0;
-         fUnzipDoneCondition->Signal();
-         return 1;
+         ptr = 0;
       }
+   }
 
-      fUnzipStatus[idxtounzip] = 2; // Set it as done
-      fUnzipChunks[idxtounzip] = ptr;
-      fUnzipLen[idxtounzip] = loclen;
+   if (ptr) {
+      fUnzipChunks[index].reset(ptr);
+      fUnzipLen[index] = loclen;
       fTotalUnzipBytes += loclen;
-
-      fActiveBlks.push(idxtounzip);
+      fNUnzip++;
 
       if (gDebug > 0)
-         Info("UnzipCache", "reqi:%d, rdoffs:%lld, rdlen: %d, loclen:%d",
-              idxtounzip, rdoffs, rdlen, loclen);
-
-      fNUnzip++;
-   }
-   else {
-      R__LOCKGUARD(fMutexList);
-      Info("argh", "loclen:%d objlen:%d loc:%d readbuf:%d", loclen, objlen, loc, readbuf);
-      fUnzipStatus[idxtounzip] = 2; // Set it as done
-      fUnzipChunks[idxtounzip] = 0;
-      fUnzipLen[idxtounzip] = 0;
+         Info("UnzipCache", "reqi:%d, loclen:%d", index, loclen);
    }
 
-   fUnzipDoneCondition->Signal();
+   {
+      std::lock_guard<std::mutex> lock(fUnzipDoneMutex);
+      fUnzipStatus[index] = kFinished;
+   }
+   fUnzipDoneCondition.notify_all();
 
-   return 0;
+   return ptr ? 0 : -1;
 }
 
+
 void  TTreeCacheUnzip::Print(Option_t* option) const {
 
    printf("******TreeCacheUnzip statistics for file: %s ******\n",fFile->GetName());
    printf("Max allowed mem for pending buffers: %lld\n", fUnzipBufferSize);
-   printf("Number of blocks unzipped by threads: %d\n", fNUnzip);
-   printf("Number of hits: %d\n", fNFound);
-   printf("Number of stalls: %d\n", fNStalls);
-   printf("Number of misses: %d\n", fNMissed);
+   printf("Number of blocks unzipped by threads: %d\n", fNUnzip.load());
+   printf("Number of hits: %d\n", fNFound.load());
+   printf("Number of stalls: %d\n", fNStalls.load());
+   printf("Number of misses: %d\n", fNMissed.load());
 
    TTreeCache::Print(option);
 }
@@ -1,14 +1,17 @@
 
+#include "Compression.h"
 #include "ROOT/TIOFeatures.hxx"
 #include "TBasket.h"
 #include "TBranch.h"
 #include "TEnum.h"
 #include "TEnumConstant.h"
 #include "TMemFile.h"
+#include "TROOT.h"
 #include "TTree.h"
 
 #include "gtest/gtest.h"
 
+#include <utility>
 #include <vector>
 
 static const Int_t gSampleEvents = 100;
@@ -403,3 +406,150 @@ TEST(TBasket, TestSettingIOBits)
    readEntryOffset = reinterpret_cast<Bool_t *>(reinterpret_cast<char *>(basket2) + offset);
    EXPECT_EQ(*readEntryOffset, kTRUE);
 }
+
+#ifdef R__USE_IMT
+TEST(TBasket, PipelinedCompression)
+{
+   const Int_t nEntries = 20000;
+   ROOT::EnableImplicitMT(2);
+   // The baskets are the same with and without pipelined compression
+   auto write = [&](TMemFile &f, Long64_t maxInFlightBytes) {
+      f.cd();
+      TTree t("t", "t");
+      Int_t i;
+      Double_t d;
+      t.Branch("i", &i, "i/I", 2000);
+      t.Branch("d", &d, "d/D", 2000);
+      t.SetAutoFlush(3000);
+      t.SetPipelinedCompression(maxInFlightBytes);
+      EXPECT_EQ(maxInFlightBytes, t.GetPipelinedCompression());
+      // Size of the data of the baskets handed over to the pipeline and not written yet
+      auto unwrittenBytes = [&t]() {
+         Long64_t bytes = 0;
+         for (auto nameAndSize : {std::make_pair("i", 4), std::make_pair("d", 8)}) {
+            TBranch *b = t.GetBranch(nameAndSize.first);
+            for (Int_t j = 0; j < b->GetWriteBasket(); ++j)
+               if (b->GetBasketSeek(j) == 0)
+                  bytes += (b->GetBasketEntry()[j + 1] - b->GetBasketEntry()[j]) * nameAndSize.second;
+         }
+         return bytes;
+      };
+      for (i = 0; i < nEntries; ++i) {
+         d = i * 0.5;
+         EXPECT_GT(t.Fill(), 0);
+         if (maxInFlightBytes > 0)
+            EXPECT_LE(unwrittenBytes(), maxInFlightBytes);
+      }
+      t.Write();
+   };
+   TMemFile f("tbasket_pipelined.root", "RECREATE");
+   write(f, 0);
+   TMemFile pf("tbasket_pipelined_on.root", "RECREATE");
+   write(pf, 4000);
+   ROOT::DisableImplicitMT();
+
+   TTree *t = (TTree *)f.Get("t");
+   TTree *pt = (TTree *)pf.Get("t");
+   ASSERT_EQ(nEntries, pt->GetEntries());
+   EXPECT_EQ(t->GetZipBytes(), pt->GetZipBytes());
+   for (auto name : {"i", "d"}) {
+      TBranch *b = t->GetBranch(name);
+      TBranch *pb = pt->GetBranch(name);
+      ASSERT_EQ(b->GetWriteBasket(), pb->GetWriteBasket());
+      for (Int_t j = 0; j < b->GetWriteBasket(); ++j) {
+         EXPECT_EQ(b->GetBasketEntry()[j], pb->GetBasketEntry()[j]);
+         EXPECT_EQ(b->GetBasketBytes()[j], pb->GetBasketBytes()[j]);
+         EXPECT_NE(0, pb->GetBasketSeek(j));
+      }
+   }
+
+   Int_t i;
+   Double_t d;
+   pt->SetBranchAddress("i", &i);
+   pt->SetBranchAddress("d", &d);
+   for (Int_t entry = 0; entry < nEntries; ++entry) {
+      pt->GetEntry(entry);
+      EXPECT_EQ(entry, i);
+      EXPECT_DOUBLE_EQ(entry * 0.5, d);
+   }
+}
+#endif
+
+TEST(TBasket, CompressionFilters)
+{
+   const Int_t nEntries = 20000;
+   auto write = [&](TMemFile &f, Int_t filters) {
+      f.cd();
+      TTree t("t", "t");
+      Long64_t evt;
+      Float_t x;
+      t.Branch("evt", &evt, "evt/L");
+      t.Branch("x", &x, "x/F");
+      t.GetBranch("evt")->SetCompressionFilters(filters & ROOT::kDeltaFilter);
+      t.GetBranch("x")->SetCompressionFilters(filters & ROOT::kShuffleFilter);
+      EXPECT_EQ(filters & ROOT::kDeltaFilter, t.GetBranch("evt")->GetCompressionFilters());
+      for (Int_t i = 0; i < nEntries; ++i) {
+         evt = 1000000000LL + 3 * i;
+         x = 100.f + (i % 1000) * 0.25f;
+         t.Fill();
+      }
+      t.Write();
+   };
+   TMemFile f("tbasket_nofilters.root", "RECREATE");
+   write(f, ROOT::kNoCompressionFilter);
+   TMemFile ff("tbasket_filters.root", "RECREATE");
+   write(ff, ROOT::kAllCompressionFilters);
+
+   TTree *t = (TTree *)f.Get("t");
+   TTree *ft = (TTree *)ff.Get("t");
+   ASSERT_EQ(nEntries, ft->GetEntries());
+   EXPECT_EQ(ROOT::kShuffleFilter, ft->GetBranch("x")->GetCompressionFilters());
+   EXPECT_LT(ft->GetBranch("evt")->GetZipBytes(), t->GetBranch("evt")->GetZipBytes());
+
+   // The filters are undone when reading
+   Long64_t evt;
+   Float_t x;
+   ft->SetBranchAddress("evt", &evt);
+   ft->SetBranchAddress("x", &x);
+   for (Int_t i = 0; i < nEntries; ++i) {
+      ft->GetEntry(i);
+      EXPECT_EQ(1000000000LL + 3 * i, evt);
+      EXPECT_FLOAT_EQ(100.f + (i % 1000) * 0.25f, x);
+   }
+}
+
+TEST(TBasket, AutoCompression)
+{
+   const Int_t nEntries = 20000;
+   TMemFile f("tbasket_autocompression.root", "RECREATE");
+   TTree t("t", "t");
+   Bool_t flag;
+   UInt_t r = 12345;
+   t.Branch("flag", &flag, "flag/O");
+   t.Branch("r", &r, "r/i");
+   t.SetAutoCompression(TTree::kAutoCompressionSpeed);
+   EXPECT_EQ(TTree::kAutoCompressionSpeed, t.GetAutoCompression());
+   for (Int_t i = 0; i < nEntries; ++i) {
+      flag = (i % 100) == 0;
+      r = r * 1664525u + 1013904223u;
+      t.Fill();
+   }
+   t.Write();
+
+   // The random numbers are not worth compressing, the flags are
+   EXPECT_EQ(0, t.GetBranch("r")->GetCompressionLevel());
+   EXPECT_LT(0, t.GetBranch("flag")->GetCompressionLevel());
+   EXPECT_LT(t.GetBranch("flag")->GetZipBytes(), t.GetBranch("flag")->GetTotBytes() / 2);
+
+   Bool_t readFlag;
+   UInt_t readR;
+   UInt_t expectedR = 12345;
+   t.SetBranchAddress("flag", &readFlag);
+   t.SetBranchAddress("r", &readR);
+   for (Int_t i = 0; i < nEntries; ++i) {
+      t.GetEntry(i);
+      expectedR = expectedR * 1664525u + 1013904223u;
+      EXPECT_EQ((i % 100) == 0, readFlag);
+      EXPECT_EQ(expectedR, readR);
+   }
+}
@@ -2,6 +2,9 @@
 #include "TTree.h"
 #include "TBranch.h"
 #include "TRandom.h"
+#include "TSystem.h"
+
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -153,3 +156,77 @@ TEST_F(TBranchTest, twoPreviousTest)
    ASSERT_TRUE(branch->GetListOfBaskets()->At(7));
    delete file;
 }
+
+TEST(TBranchBulkTest, fillBulk)
+{
+   const Int_t n = 10000;
+   std::vector<Float_t> x(n);
+   std::vector<Int_t> a(3 * n);
+   for (Int_t i = 0; i < n; ++i) {
+      x[i] = 0.5 * i;
+      for (Int_t j = 0; j < 3; ++j)
+         a[3 * i + j] = 3 * i + j;
+   }
+
+   // The same entries are filled one by one and in bulk: the trees must have the same content and clusters
+   auto write = [&](const char *filename, bool bulk) {
+      TFile file(filename, "RECREATE");
+      TTree tree("tree", "A test tree");
+      tree.SetAutoFlush(1000);
+      tree.Branch("x", x.data(), "x/F", 4000);
+      tree.Branch("a", a.data(), "a[3]/I", 4000);
+      if (bulk) {
+         // two calls, the first ends in the middle of a basket and of a cluster
+         ASSERT_GT(tree.FillBulk(2500), 0);
+         tree.SetBranchAddress("x", x.data() + 2500);
+         tree.SetBranchAddress("a", a.data() + 3 * 2500);
+         ASSERT_GT(tree.FillBulk(n - 2500), 0);
+      } else {
+         for (Int_t i = 0; i < n; ++i) {
+            tree.SetBranchAddress("x", x.data() + i);
+            tree.SetBranchAddress("a", a.data() + 3 * i);
+            ASSERT_GT(tree.Fill(), 0);
+         }
+      }
+      file.Write();
+   };
+   // remove the files also when an assertion fails, after the TFiles below are closed
+   struct FilesRemover {
+      ~FilesRemover()
+      {
+         gSystem->Unlink("TBranchFillTree.root");
+         gSystem->Unlink("TBranchFillBulkTree.root");
+      }
+   } filesRemover;
+   write("TBranchFillTree.root", false);
+   write("TBranchFillBulkTree.root", true);
+
+   TFile file("TBranchFillTree.root");
+   TFile bulkFile("TBranchFillBulkTree.root");
+   TTree *tree = (TTree *)file.Get("tree");
+   TTree *bulkTree = (TTree *)bulkFile.Get("tree");
+   ASSERT_EQ(n, bulkTree->GetEntries());
+
+   for (auto name : {"x", "a"}) {
+      TBranch *branch = tree->GetBranch(name);
+      TBranch *bulkBranch = bulkTree->GetBranch(name);
+      ASSERT_EQ(branch->GetWriteBasket(), bulkBranch->GetWriteBasket());
+      for (Int_t i = 0; i < branch->GetWriteBasket(); ++i)
+         EXPECT_EQ(branch->GetBasketEntry()[i], bulkBranch->GetBasketEntry()[i]);
+   }
+   auto clusters = tree->GetClusterIterator(0);
+   auto bulkClusters = bulkTree->GetClusterIterator(0);
+   for (Long64_t start = clusters(); start < n; start = clusters())
+      EXPECT_EQ(start, bulkClusters());
+
+   Float_t xval = 0;
+   Int_t aval[3] = {0, 0, 0};
+   bulkTree->SetBranchAddress("x", &xval);
+   bulkTree->SetBranchAddress("a", aval);
+   for (Int_t i = 0; i < n; ++i) {
+      bulkTree->GetEntry(i);
+      EXPECT_FLOAT_EQ(x[i], xval);
+      for (Int_t j = 0; j < 3; ++j)
+         EXPECT_EQ(a[3 * i + j], aval[j]);
+   }
+}
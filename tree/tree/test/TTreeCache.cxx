@@ -0,0 +1,49 @@
+#include "TFile.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "TTreeCache.h"
+
+#include "gtest/gtest.h"
+
+TEST(TTreeCache, ReadAhead)
+{
+   const auto fileName = "TTreeCache_readahead.root";
+   const Int_t nEntries = 10000;
+   {
+      TFile f(fileName, "RECREATE");
+      TTree t("t", "t");
+      Int_t i;
+      Double_t d;
+      t.Branch("i", &i);
+      t.Branch("d", &d);
+      t.SetAutoFlush(1000);
+      for (i = 0; i < nEntries; ++i) {
+         d = i * 0.5;
+         t.Fill();
+      }
+      t.Write();
+   }
+
+   TFile f(fileName);
+   auto t = static_cast<TTree *>(f.Get("t"));
+   t->SetCacheReadAhead();
+   t->SetCacheSize(100000);
+   auto cache = dynamic_cast<TTreeCache *>(f.GetCacheRead(t));
+   ASSERT_NE(nullptr, cache);
+   EXPECT_TRUE(cache->IsEnablePrefetching());
+   Int_t i = -1;
+   Double_t d = -1.;
+   t->SetBranchAddress("i", &i);
+   t->SetBranchAddress("d", &d);
+   for (Long64_t e = 0; e < nEntries; ++e) {
+      t->GetEntry(e);
+      EXPECT_EQ(e, i);
+      EXPECT_DOUBLE_EQ(e * 0.5, d);
+   }
+   // one block per cluster is read in the background
+   EXPECT_GT(cache->GetPrefetchedBlocks(), 1);
+   t->SetCacheSize(0);
+   f.Close();
+
+   gSystem->Unlink(fileName);
+}
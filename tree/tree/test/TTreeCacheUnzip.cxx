@@ -0,0 +1,156 @@
+#include "TFile.h"
+#include "TROOT.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "TTreeCacheUnzip.h"
+
+#include "gtest/gtest.h"
+
+#ifdef R__USE_IMT
+
+TEST(TTreeCacheUnzip, ParallelUnzipWithIMT)
+{
+   const auto fileName = "TTreeCacheUnzip_parallelunzip.root";
+   const Int_t nEntries = 20000;
+   {
+      TFile f(fileName, "RECREATE");
+      TTree t("t", "t");
+      Int_t i;
+      Double_t d;
+      t.Branch("i", &i);
+      t.Branch("d", &d);
+      t.SetAutoFlush(1000);
+      for (i = 0; i < nEntries; ++i) {
+         d = i * 0.5;
+         t.Fill();
+      }
+      t.Write();
+   }
+
+   const auto parallelUnzip = TTreeCacheUnzip::GetParallelUnzip();
+   TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+   ROOT::EnableImplicitMT(2);
+   {
+      TFile f(fileName);
+      auto t = static_cast<TTree *>(f.Get("t"));
+      t->SetCacheSize(10000000);
+      ASSERT_NE(nullptr, dynamic_cast<TTreeCacheUnzip *>(f.GetCacheRead(t)));
+      Int_t i = -1;
+      Double_t d = -1.;
+      t->SetBranchAddress("i", &i);
+      t->SetBranchAddress("d", &d);
+      for (Long64_t e = 0; e < nEntries; ++e) {
+         t->GetEntry(e);
+         EXPECT_EQ(e, i);
+         EXPECT_DOUBLE_EQ(e * 0.5, d);
+      }
+   }
+   ROOT::DisableImplicitMT();
+   TTreeCacheUnzip::SetParallelUnzip(parallelUnzip);
+
+   gSystem->Unlink(fileName);
+}
+
+// With implicit multi-threading, TTree::GetEntry reads the branches concurrently: many readers share the cache while
+// it moves from cluster to cluster
+TEST(TTreeCacheUnzip, ConcurrentReaders)
+{
+   const auto fileName = "TTreeCacheUnzip_concurrentreaders.root";
+   const Int_t nEntries = 20000;
+   const Int_t nBranches = 16;
+   Int_t values[nBranches];
+   {
+      TFile f(fileName, "RECREATE");
+      TTree t("t", "t");
+      for (Int_t b = 0; b < nBranches; ++b)
+         t.Branch(TString::Format("b%d", b), &values[b], TString::Format("b%d/I", b), 2000);
+      t.SetAutoFlush(1500);
+      for (Int_t e = 0; e < nEntries; ++e) {
+         for (Int_t b = 0; b < nBranches; ++b)
+            values[b] = e * nBranches + b;
+         t.Fill();
+      }
+      t.Write();
+   }
+
+   const auto parallelUnzip = TTreeCacheUnzip::GetParallelUnzip();
+   TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+   ROOT::EnableImplicitMT(4);
+   {
+      TFile f(fileName);
+      auto t = static_cast<TTree *>(f.Get("t"));
+      t->SetCacheSize(10000000);
+      ASSERT_NE(nullptr, dynamic_cast<TTreeCacheUnzip *>(f.GetCacheRead(t)));
+      for (Int_t b = 0; b < nBranches; ++b)
+         t->SetBranchAddress(TString::Format("b%d", b), &values[b]);
+      for (Long64_t e = 0; e < nEntries; ++e) {
+         t->GetEntry(e);
+         for (Int_t b = 0; b < nBranches; ++b)
+            EXPECT_EQ(e * nBranches + b, values[b]);
+      }
+   }
+   ROOT::DisableImplicitMT();
+   TTreeCacheUnzip::SetParallelUnzip(parallelUnzip);
+
+   gSystem->Unlink(fileName);
+}
+
+// The baskets of the cached branches that are not read in a cluster are unzipped by the tasks but never taken by a
+// reader: moving the cache to the next cluster waits for those tasks
+TEST(TTreeCacheUnzip, BranchesNotReadInEveryCluster)
+{
+   const auto fileName = "TTreeCacheUnzip_sparsebranches.root";
+   const Int_t nEntries = 20000;
+   const Int_t clusterSize = 1000;
+   const Int_t nBranches = 8;
+   Int_t values[nBranches];
+   {
+      TFile f(fileName, "RECREATE");
+      TTree t("t", "t");
+      for (Int_t b = 0; b < nBranches; ++b)
+         t.Branch(TString::Format("b%d", b), &values[b], TString::Format("b%d/I", b), 1000);
+      t.SetAutoFlush(clusterSize);
+      for (Int_t e = 0; e < nEntries; ++e) {
+         for (Int_t b = 0; b < nBranches; ++b)
+            values[b] = e * nBranches + b;
+         t.Fill();
+      }
+      t.Write();
+   }
+
+   const auto parallelUnzip = TTreeCacheUnzip::GetParallelUnzip();
+   TTreeCacheUnzip::SetParallelUnzip(TTreeCacheUnzip::kEnable);
+   ROOT::EnableImplicitMT(4);
+   {
+      TFile f(fileName);
+      auto t = static_cast<TTree *>(f.Get("t"));
+      t->SetCacheSize(10000000);
+      t->AddBranchToCache("*", kTRUE);
+      t->StopCacheLearningPhase();
+      ASSERT_NE(nullptr, dynamic_cast<TTreeCacheUnzip *>(f.GetCacheRead(t)));
+      for (Int_t b = 0; b < nBranches; ++b)
+         t->SetBranchAddress(TString::Format("b%d", b), &values[b]);
+      auto first = t->GetBranch("b0");
+      for (Long64_t e = 0; e < nEntries; ++e) {
+         const auto cluster = e / clusterSize;
+         if (cluster % 3 == 0) {
+            // all branches, read concurrently
+            t->GetEntry(e);
+            for (Int_t b = 0; b < nBranches; ++b)
+               EXPECT_EQ(e * nBranches + b, values[b]);
+         } else {
+            // only the first branch, and every other entry
+            if (cluster % 3 == 2 && e % 2 == 1)
+               continue;
+            first->GetEntry(e);
+            EXPECT_EQ(e * nBranches, values[0]);
+         }
+      }
+   }
+   ROOT::DisableImplicitMT();
+   TTreeCacheUnzip::SetParallelUnzip(parallelUnzip);
+
+   gSystem->Unlink(fileName);
+}
+
+#endif
@@ -118,10 +118,12 @@
 #pragma link C++ class ROOT::Experimental::TDF::TH3DModel-;
 #pragma link C++ class ROOT::Experimental::TDF::TProfile1DModel-;
 #pragma link C++ class ROOT::Experimental::TDF::TProfile2DModel-;
+#pragma link C++ class ROOT::Experimental::TDF::TProfileReport-;
 #pragma link C++ class ROOT::Internal::TDF::TIgnoreErrorLevelRAII-;
 #pragma link C++ class ROOT::Experimental::TDF::TTrivialDS-;
 #pragma link C++ class ROOT::Experimental::TDF::TRootDS-;
 #pragma link C++ class ROOT::Experimental::TDF::TCsvDS-;
+#pragma link C++ class ROOT::Experimental::TDF::TNpyDS-;
 
 #endif
 
@@ -4,7 +4,10 @@
 #include "ROOT/TDataFrame.hxx"
 #include "ROOT/TDataSource.hxx"
 
+#include <deque>
+#include <fstream>
 #include <map>
+#include <string>
 #include <vector>
 #include <TRegexp.h>
 
@@ -15,30 +18,45 @@ namespace TDF {
 class TCsvDS final : public ROOT::Experimental::TDF::TDataSource {
 
 private:
-   typedef std::vector<void *> Record;
+   enum class EColType { kLong64, kDouble, kBool, kString };
 
    unsigned int fNSlots = 0U;
    std::string fFileName;
    char fDelimiter;
+   std::ifstream fStream;
+   std::streamoff fDataOffset = 0;  ///< Position of the first record in the file
+   std::size_t fChunkSize;          ///< Number of bytes read from the file at once, per slot
    std::vector<std::string> fHeaders;
    std::map<std::string, std::string> fColTypes;
+   std::vector<EColType> fColTypesList;            // fColTypesList[column]
    std::vector<std::vector<void *>> fColAddresses; // fColAddresses[column][slot]
-   std::vector<std::pair<ULong64_t, ULong64_t>> fEntryRanges;
-   std::vector<Record> fRecords; // fRecords[entry][column]
+   std::vector<std::size_t> fRequestedColumns;     ///< Only these columns are converted to their type in SetEntry
+   // Values of the current record of each slot, fXValues[column * fNSlots + slot]. Only the vector matching the type
+   // of the column is used.
+   std::vector<Long64_t> fLong64Values;
+   std::vector<double> fDoubleValues;
+   std::deque<bool> fBoolValues; // std::vector<bool> does not allow to take the address of its elements
+   std::vector<std::string> fStringValues;
+   std::vector<std::vector<std::string>> fFields; // fFields[slot][column], fields of the current record of each slot
+   std::string fBuffer;          ///< Current chunk of the file. Might end with an incomplete line.
+   std::size_t fBufferUsed = 0U; ///< Number of bytes of fBuffer that contain complete lines
+   std::vector<std::pair<std::size_t, std::size_t>> fLines; ///< Begin and end of the records in fBuffer
+   ULong64_t fChunkFirstEntry = 0ULL; ///< Entry number of the first record in fBuffer
+   ULong64_t fNextEntry = 0ULL;       ///< Entry number of the first record of the next chunk
 
    static TRegexp intRegex, doubleRegex1, doubleRegex2, trueRegex, falseRegex;
-   
+
    void FillHeaders(const std::string &);
-   void FillRecord(const std::string &, Record &);
    void GenerateHeaders(size_t);
    std::vector<void *> GetColumnReadersImpl(std::string_view, const std::type_info &);
    void InferColTypes(std::vector<std::string> &);
    void InferType(const std::string &, unsigned int);
    std::vector<std::string> ParseColumns(const std::string &);
-   size_t ParseValue(const std::string &, std::vector<std::string> &, size_t);
+   size_t ParseLine(const char *, const char *, std::vector<std::string> &) const;
+   bool ReadNextChunk();
 
 public:
-   TCsvDS(std::string_view fileName, bool readHeaders = true, char delimiter = ',');
+   TCsvDS(std::string_view fileName, bool readHeaders = true, char delimiter = ',', std::size_t chunkSize = 8388608);
    ~TCsvDS();
    const std::vector<std::string> &GetColumnNames() const;
    std::vector<std::pair<ULong64_t, ULong64_t>> GetEntryRanges();
@@ -55,7 +73,9 @@ public:
 /// \param[in] readHeaders `true` if the CSV file contains headers as first row, `false` otherwise
 ///                        (default `true`).
 /// \param[in] delimiter Delimiter character (default ',').
-TDataFrame MakeCsvDataFrame(std::string_view fileName, bool readHeaders = true, char delimiter = ',');
+/// \param[in] chunkSize Number of bytes read from the file at once by each slot (default 8 MB).
+TDataFrame MakeCsvDataFrame(std::string_view fileName, bool readHeaders = true, char delimiter = ',',
+                            std::size_t chunkSize = 8388608);
 
 } // ns TDF
 } // ns Experimental
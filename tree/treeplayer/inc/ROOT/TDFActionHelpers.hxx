@@ -14,18 +14,41 @@
 #include "ROOT/TBufferMerger.hxx" // for SnapshotHelper
 #include "ROOT/TypeTraits.hxx"
 #include "ROOT/TDFUtils.hxx"
+#include "ROOT/TDFProfiling.hxx"
 #include "ROOT/TThreadedObject.hxx"
 #include "ROOT/TArrayBranch.hxx"
+#include "TBranchElement.h" // for SnapshotHelperMT
+#include "TBuffer.h"        // for multi-process event loops
+#include "TClass.h"
 #include "TH1.h"
 #include "TTreeReader.h" // for SnapshotHelper
 #include "TFile.h"       // for SnapshotHelper
+#include "TList.h"
+#include "TROOT.h"
+#include "TSystem.h"
 
 #include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <type_traits>
 #include <vector>
 
+namespace ROOT {
+namespace Experimental {
+namespace TDF {
+/// Set the maximum amount of memory, in bytes, that the per-slot copies of a histogram may occupy in a
+/// multi-thread event loop. Histogram-filling actions whose copies would exceed it fill a single histogram shared
+/// by all slots instead.
+void SetMaxHistoCopiesSize(ULong64_t size);
+ULong64_t GetMaxHistoCopiesSize();
+} // ns TDF
+} // ns Experimental
+} // ns ROOT
+
 /// \cond HIDDEN_SYMBOLS
 
 namespace ROOT {
@@ -36,6 +59,38 @@ using namespace ROOT::Experimental::TDF;
 
 using Hist_t = ::TH1D;
 
+// Results of the worker processes of multi-process event loops are sent to the parent process in a TBuffer.
+// Objects of class type are streamed through their dictionary.
+template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+void WriteMPObject(TBuffer &buf, const T &v)
+{
+   buf << v;
+}
+
+template <typename T, typename std::enable_if<std::is_class<T>::value, int>::type = 0>
+void WriteMPObject(TBuffer &buf, const T &obj)
+{
+   auto cl = TClass::GetClass(typeid(T));
+   if (!cl)
+      throw std::runtime_error(std::string("Cannot send results of type ") + typeid(T).name() +
+                               " between processes: no dictionary is available.");
+   buf.WriteObjectAny(&obj, cl);
+}
+
+template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+std::unique_ptr<T> ReadMPObject(TBuffer &buf)
+{
+   std::unique_ptr<T> v(new T);
+   buf >> *v;
+   return v;
+}
+
+template <typename T, typename std::enable_if<std::is_class<T>::value, int>::type = 0>
+std::unique_ptr<T> ReadMPObject(TBuffer &buf)
+{
+   return std::unique_ptr<T>(static_cast<T *>(buf.ReadObjectAny(TClass::GetClass(typeid(T)))));
+}
+
 template <typename F>
 class ForeachSlotHelper {
    F fCallable;
@@ -57,6 +112,10 @@ public:
    }
 
    void Finalize() { /* noop */}
+
+   // the side effects of the callable in worker processes are not brought back to the parent process
+   void WriteMPResult(TBuffer &) {}
+   void MergeMPResult(TBuffer &) {}
 };
 
 class CountHelper {
@@ -72,6 +131,24 @@ public:
    void Exec(unsigned int slot);
    void Finalize();
    ULong64_t &PartialUpdate(unsigned int slot);
+   void WriteMPResult(TBuffer &buf);
+   void MergeMPResult(TBuffer &buf);
+};
+
+/// Produces the report of a profiled event loop. All the work is done by the TProfiler during the event loop.
+class ProfileReportHelper {
+   const std::shared_ptr<TProfileReport> fResultReport;
+   const std::shared_ptr<TProfiler> fProfiler;
+
+public:
+   using BranchTypes_t = TypeList<>;
+   ProfileReportHelper(const std::shared_ptr<TProfileReport> &resultReport,
+                       const std::shared_ptr<TProfiler> &profiler);
+   ProfileReportHelper(ProfileReportHelper &&) = default;
+   ProfileReportHelper(const ProfileReportHelper &) = delete;
+   void InitSlot(TTreeReader *, unsigned int) {}
+   void Exec(unsigned int) {}
+   void Finalize();
 };
 
 class FillHelper {
@@ -129,6 +206,9 @@ public:
    Hist_t &PartialUpdate(unsigned int);
 
    void Finalize();
+
+   void WriteMPResult(TBuffer &buf);
+   void MergeMPResult(TBuffer &buf);
 };
 
 extern template void FillHelper::Exec(unsigned int, const std::vector<float> &);
@@ -143,16 +223,87 @@ extern template void FillHelper::Exec(unsigned int, const std::vector<int> &, co
 extern template void
 FillHelper::Exec(unsigned int, const std::vector<unsigned int> &, const std::vector<unsigned int> &);
 
+/// Size in bytes that the per-slot copies of a histogram would occupy in an event loop running on `nSlots` slots,
+/// besides the histogram itself
+ULong64_t GetHistoCopiesSize(const TH1 &h, unsigned int nSlots);
+
+/// Fills histograms in actions such as Histo2D, Histo3D and Profile1D.
+/// By default each slot fills its own copy of the histogram and the copies are merged at the end of the event loop.
+/// If those copies would occupy more memory than GetMaxHistoCopiesSize(), all slots fill the user's histogram
+/// instead: each slot buffers the values it receives and flushes them into the shared histogram, under a lock, when
+/// its buffer is full. Memory usage then does not grow with the number of slots, at the price of some contention.
 template <typename HIST = Hist_t>
 class FillTOHelper {
-   std::unique_ptr<TThreadedObject<HIST>> fTo;
+   using FillArgs_t = std::array<double, 4>;
+   using FlushFn_t = void (*)(HIST &, const std::vector<FillArgs_t> &);
+   /// The arguments of the Fill calls buffered by a slot, and the function that performs them on the shared histogram
+   struct TFillBuffer {
+      std::vector<FillArgs_t> fArgs;
+      FlushFn_t fFlush = nullptr;
+   };
+   static constexpr std::size_t fgBufSize = 1024; ///< Fill calls buffered by each slot before a flush
+
+   std::unique_ptr<TThreadedObject<HIST>> fTo;       ///< Per-slot copies of the histogram, null in shared mode
+   std::shared_ptr<HIST> fSharedHist;                 ///< The histogram filled by all slots in shared mode
+   std::unique_ptr<std::mutex> fSharedHistMutex;      ///< Serialises the flushes into fSharedHist
+   std::vector<TFillBuffer> fBuffers;                 ///< Per-slot buffers, only used in shared mode
+   std::vector<std::unique_ptr<HIST>> fPartialHists;  ///< Per-slot snapshots of fSharedHist, see PartialUpdate
+
+   template <int... S>
+   static void FlushImpl(HIST &h, const std::vector<FillArgs_t> &args, StaticSeq<S...>)
+   {
+      for (const auto &a : args)
+         h.Fill(a[S]...);
+   }
+
+   template <int N>
+   static void Flush(HIST &h, const std::vector<FillArgs_t> &args)
+   {
+      FlushImpl(h, args, GenStaticSeq_t<N>());
+   }
+
+   void FlushSlot(unsigned int slot)
+   {
+      auto &buf = fBuffers[slot];
+      if (buf.fArgs.empty())
+         return;
+      {
+         std::lock_guard<std::mutex> lock(*fSharedHistMutex);
+         buf.fFlush(*fSharedHist, buf.fArgs);
+      }
+      buf.fArgs.clear();
+   }
+
+   template <typename... Xs>
+   void Fill(unsigned int slot, Xs... xs)
+   {
+      if (fTo) {
+         fTo->GetAtSlotRaw(slot)->Fill(xs...);
+         return;
+      }
+      auto &buf = fBuffers[slot];
+      buf.fFlush = &Flush<int(sizeof...(Xs))>;
+      buf.fArgs.push_back(FillArgs_t{{double(xs)...}});
+      if (buf.fArgs.size() == fgBufSize)
+         FlushSlot(slot);
+   }
 
 public:
    FillTOHelper(FillTOHelper &&) = default;
    FillTOHelper(const FillTOHelper &) = delete;
 
-   FillTOHelper(const std::shared_ptr<HIST> &h, const unsigned int nSlots) : fTo(new TThreadedObject<HIST>(*h))
+   FillTOHelper(const std::shared_ptr<HIST> &h, const unsigned int nSlots)
    {
+      if (nSlots > 1 && GetHistoCopiesSize(*h, nSlots) > ROOT::Experimental::TDF::GetMaxHistoCopiesSize()) {
+         fSharedHist = h;
+         fSharedHistMutex.reset(new std::mutex);
+         fBuffers.resize(nSlots);
+         for (auto &buf : fBuffers)
+            buf.fArgs.reserve(fgBufSize);
+         fPartialHists.resize(nSlots);
+         return;
+      }
+      fTo.reset(new TThreadedObject<HIST>(*h));
       fTo->SetAtSlot(0, h);
       // Initialise all other slots
       for (unsigned int i = 0; i < nSlots; ++i) {
@@ -164,30 +315,29 @@ public:
 
    void Exec(unsigned int slot, double x0) // 1D histos
    {
-      fTo->GetAtSlotRaw(slot)->Fill(x0);
+      Fill(slot, x0);
    }
 
    void Exec(unsigned int slot, double x0, double x1) // 1D weighted and 2D histos
    {
-      fTo->GetAtSlotRaw(slot)->Fill(x0, x1);
+      Fill(slot, x0, x1);
    }
 
    void Exec(unsigned int slot, double x0, double x1, double x2) // 2D weighted and 3D histos
    {
-      fTo->GetAtSlotRaw(slot)->Fill(x0, x1, x2);
+      Fill(slot, x0, x1, x2);
    }
 
    void Exec(unsigned int slot, double x0, double x1, double x2, double x3) // 3D weighted histos
    {
-      fTo->GetAtSlotRaw(slot)->Fill(x0, x1, x2, x3);
+      Fill(slot, x0, x1, x2, x3);
    }
 
    template <typename X0, typename std::enable_if<IsContainer<X0>::value, int>::type = 0>
    void Exec(unsigned int slot, const X0 &x0s)
    {
-      auto thisSlotH = fTo->GetAtSlotRaw(slot);
       for (auto &x0 : x0s) {
-         thisSlotH->Fill(x0); // TODO: Can be optimised in case T == vector<double>
+         Fill(slot, x0); // TODO: Can be optimised in case T == vector<double>
       }
    }
 
@@ -195,7 +345,6 @@ public:
              typename std::enable_if<IsContainer<X0>::value && IsContainer<X1>::value, int>::type = 0>
    void Exec(unsigned int slot, const X0 &x0s, const X1 &x1s)
    {
-      auto thisSlotH = fTo->GetAtSlotRaw(slot);
       if (x0s.size() != x1s.size()) {
          throw std::runtime_error("Cannot fill histogram with values in containers of different sizes.");
       }
@@ -203,7 +352,7 @@ public:
       const auto x0sEnd = std::end(x0s);
       auto x1sIt = std::begin(x1s);
       for (; x0sIt != x0sEnd; x0sIt++, x1sIt++) {
-         thisSlotH->Fill(*x0sIt, *x1sIt); // TODO: Can be optimised in case T == vector<double>
+         Fill(slot, *x0sIt, *x1sIt); // TODO: Can be optimised in case T == vector<double>
       }
    }
 
@@ -212,7 +361,6 @@ public:
                                      int>::type = 0>
    void Exec(unsigned int slot, const X0 &x0s, const X1 &x1s, const X2 &x2s)
    {
-      auto thisSlotH = fTo->GetAtSlotRaw(slot);
       if (!(x0s.size() == x1s.size() && x1s.size() == x2s.size())) {
          throw std::runtime_error("Cannot fill histogram with values in containers of different sizes.");
       }
@@ -221,7 +369,7 @@ public:
       auto x1sIt = std::begin(x1s);
       auto x2sIt = std::begin(x2s);
       for (; x0sIt != x0sEnd; x0sIt++, x1sIt++, x2sIt++) {
-         thisSlotH->Fill(*x0sIt, *x1sIt, *x2sIt); // TODO: Can be optimised in case T == vector<double>
+         Fill(slot, *x0sIt, *x1sIt, *x2sIt); // TODO: Can be optimised in case T == vector<double>
       }
    }
    template <typename X0, typename X1, typename X2, typename X3,
@@ -230,7 +378,6 @@ public:
                                      int>::type = 0>
    void Exec(unsigned int slot, const X0 &x0s, const X1 &x1s, const X2 &x2s, const X3 &x3s)
    {
-      auto thisSlotH = fTo->GetAtSlotRaw(slot);
       if (!(x0s.size() == x1s.size() && x1s.size() == x2s.size() && x1s.size() == x3s.size())) {
          throw std::runtime_error("Cannot fill histogram with values in containers of different sizes.");
       }
@@ -240,14 +387,96 @@ public:
       auto x2sIt = std::begin(x2s);
       auto x3sIt = std::begin(x3s);
       for (; x0sIt != x0sEnd; x0sIt++, x1sIt++, x2sIt++, x3sIt++) {
-         thisSlotH->Fill(*x0sIt, *x1sIt, *x2sIt, *x3sIt); // TODO: Can be optimised in case T == vector<double>
+         Fill(slot, *x0sIt, *x1sIt, *x2sIt, *x3sIt); // TODO: Can be optimised in case T == vector<double>
       }
    }
-   void Finalize() { fTo->Merge(); }
 
-   HIST &PartialUpdate(unsigned int slot) { return *fTo->GetAtSlotRaw(slot); }
+   void Finalize()
+   {
+      if (fTo) {
+         fTo->Merge();
+         return;
+      }
+      for (auto slot = 0u; slot < fBuffers.size(); ++slot)
+         FlushSlot(slot);
+   }
+
+   /// In shared mode the other slots keep filling the shared histogram, and may rebin it, while a partial result is
+   /// being used: the partial result of a slot is therefore a snapshot of the shared histogram, taken under the lock
+   /// after the values buffered by the slot have been flushed. Snapshots are only allocated for the slots that
+   /// request partial results, e.g. only for the last slot with TResultProxy::OnPartialResult.
+   HIST &PartialUpdate(unsigned int slot)
+   {
+      if (fTo)
+         return *fTo->GetAtSlotRaw(slot);
+      FlushSlot(slot);
+      std::lock_guard<std::mutex> lock(*fSharedHistMutex);
+      auto &partialHist = fPartialHists[slot];
+      partialHist.reset(ROOT::Internal::TThreadedObjectUtils::Cloner<HIST>::Clone(fSharedHist.get()));
+      return *partialHist;
+   }
+
+   void WriteMPResult(TBuffer &buf)
+   {
+      if (fSharedHist)
+         FlushSlot(0);
+      WriteMPObject(buf, fTo ? *fTo->GetAtSlotRaw(0) : *fSharedHist);
+   }
+
+   void MergeMPResult(TBuffer &buf)
+   {
+      auto h = ReadMPObject<HIST>(buf);
+      h->SetDirectory(nullptr);
+      TList l;
+      l.Add(h.get());
+      (fTo ? fTo->GetAtSlotRaw(0) : fSharedHist.get())->Merge(&l);
+   }
 };
 
+/// Keeps track of the portions of per-slot collections that were filled by each task of a multi-thread event loop,
+/// so that the collections can be merged in the order of the entries of the dataset at the end of the event loop.
+/// Tasks that run on the same slot can be interleaved, hence a stack of running tasks is kept for each slot.
+class TOrderedChunks {
+public:
+   struct TChunk {
+      ULong64_t fTaskBegin; ///< First entry of the task that filled the chunk
+      unsigned int fSlot;   ///< The slot whose collection contains the chunk
+      std::size_t fBegin;   ///< Position of the first element of the chunk in the collection
+      std::size_t fEnd;     ///< Position past the last element of the chunk in the collection
+   };
+
+private:
+   std::vector<std::vector<ULong64_t>> fRunningTasks; ///< Per slot, first entries of the tasks being processed
+   /// Per slot, the first entry of the task that starts or resumes processing and the size of the collection
+   std::vector<std::vector<std::pair<ULong64_t, std::size_t>>> fSwitches;
+
+public:
+   TOrderedChunks(unsigned int nSlots) : fRunningTasks(nSlots), fSwitches(nSlots) {}
+   bool IsEmpty() const;
+   void InitTask(unsigned int slot, ULong64_t taskBegin, std::size_t collSize);
+   void FinalizeTask(unsigned int slot, std::size_t collSize);
+   std::vector<TChunk> GetChunks(const std::vector<std::size_t> &collSizes) const;
+};
+
+/// Move the elements of the per-slot collections `colls` to `colls[0]`, in the order of the entries they come from
+template <typename COLL>
+void MergeInEntryOrder(std::vector<std::shared_ptr<COLL>> &colls, const TOrderedChunks &chunks)
+{
+   std::vector<std::size_t> collSizes;
+   for (auto &coll : colls)
+      collSizes.emplace_back(coll->size());
+   // colls[0] is the collection returned to users: take its contents out and fill it again in the right order
+   COLL firstColl;
+   std::swap(firstColl, *colls[0]);
+   auto &rColl = *colls[0];
+   for (const auto &chunk : chunks.GetChunks(collSizes)) {
+      auto &coll = chunk.fSlot == 0 ? firstColl : *colls[chunk.fSlot];
+      auto it = std::next(coll.begin(), chunk.fBegin);
+      for (auto i = chunk.fBegin; i < chunk.fEnd; ++i, ++it)
+         rColl.emplace_back(std::move(*it));
+   }
+}
+
 // In case of the take helper we have 4 cases:
 // 1. The column is not an TArrayBranch, the collection is not a vector
 // 2. The column is not an TArrayBranch, the collection is a vector
@@ -259,10 +488,11 @@ public:
 template <typename RealT_t, typename T, typename COLL>
 class TakeHelper {
    std::vector<std::shared_ptr<COLL>> fColls;
+   TOrderedChunks fChunks; // only used if results must follow the order of the entries
 
 public:
    using BranchTypes_t = TypeList<T>;
-   TakeHelper(const std::shared_ptr<COLL> &resultColl, const unsigned int nSlots)
+   TakeHelper(const std::shared_ptr<COLL> &resultColl, const unsigned int nSlots) : fChunks(nSlots)
    {
       fColls.emplace_back(resultColl);
       for (unsigned int i = 1; i < nSlots; ++i)
@@ -273,10 +503,21 @@ public:
 
    void InitSlot(TTreeReader *, unsigned int) {}
 
+   void InitTask(unsigned int slot, ULong64_t firstEntry, ULong64_t /*endEntry*/)
+   {
+      fChunks.InitTask(slot, firstEntry, fColls[slot]->size());
+   }
+
+   void FinalizeTask(unsigned int slot) { fChunks.FinalizeTask(slot, fColls[slot]->size()); }
+
    void Exec(unsigned int slot, T &v) { fColls[slot]->emplace_back(v); }
 
    void Finalize()
    {
+      if (!fChunks.IsEmpty()) {
+         MergeInEntryOrder(fColls, fChunks);
+         return;
+      }
       auto rColl = fColls[0];
       for (unsigned int i = 1; i < fColls.size(); ++i) {
          auto &coll = fColls[i];
@@ -287,6 +528,15 @@ public:
    }
 
    COLL &PartialUpdate(unsigned int slot) { return *fColls[slot].get(); }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, *fColls[0]); }
+
+   void MergeMPResult(TBuffer &buf)
+   {
+      auto coll = ReadMPObject<COLL>(buf);
+      for (auto &v : *coll)
+         fColls[0]->emplace_back(std::move(v));
+   }
 };
 
 // Case 2.: The column is not an TArrayBranch, the collection is a vector
@@ -294,10 +544,11 @@ public:
 template <typename RealT_t, typename T>
 class TakeHelper<RealT_t, T, std::vector<T>> {
    std::vector<std::shared_ptr<std::vector<T>>> fColls;
+   TOrderedChunks fChunks; // only used if results must follow the order of the entries
 
 public:
    using BranchTypes_t = TypeList<T>;
-   TakeHelper(const std::shared_ptr<std::vector<T>> &resultColl, const unsigned int nSlots)
+   TakeHelper(const std::shared_ptr<std::vector<T>> &resultColl, const unsigned int nSlots) : fChunks(nSlots)
    {
       fColls.emplace_back(resultColl);
       for (unsigned int i = 1; i < nSlots; ++i) {
@@ -311,11 +562,22 @@ public:
 
    void InitSlot(TTreeReader *, unsigned int) {}
 
+   void InitTask(unsigned int slot, ULong64_t firstEntry, ULong64_t /*endEntry*/)
+   {
+      fChunks.InitTask(slot, firstEntry, fColls[slot]->size());
+   }
+
+   void FinalizeTask(unsigned int slot) { fChunks.FinalizeTask(slot, fColls[slot]->size()); }
+
    void Exec(unsigned int slot, T &v) { fColls[slot]->emplace_back(v); }
 
    // This is optimised to treat vectors
    void Finalize()
    {
+      if (!fChunks.IsEmpty()) {
+         MergeInEntryOrder(fColls, fChunks);
+         return;
+      }
       ULong64_t totSize = 0;
       for (auto &coll : fColls)
          totSize += coll->size();
@@ -328,6 +590,14 @@ public:
    }
 
    std::vector<T> &PartialUpdate(unsigned int slot) { return *fColls[slot]; }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, *fColls[0]); }
+
+   void MergeMPResult(TBuffer &buf)
+   {
+      auto coll = ReadMPObject<std::vector<T>>(buf);
+      fColls[0]->insert(fColls[0]->end(), std::make_move_iterator(coll->begin()), std::make_move_iterator(coll->end()));
+   }
 };
 
 // Case 3.: The column is a TArrayBranch, the collection is not a vector
@@ -335,10 +605,11 @@ public:
 template <typename RealT_t, typename COLL>
 class TakeHelper<RealT_t, TArrayBranch<RealT_t>, COLL> {
    std::vector<std::shared_ptr<COLL>> fColls;
+   TOrderedChunks fChunks; // only used if results must follow the order of the entries
 
 public:
    using BranchTypes_t = TypeList<TArrayBranch<RealT_t>>;
-   TakeHelper(const std::shared_ptr<COLL> &resultColl, const unsigned int nSlots)
+   TakeHelper(const std::shared_ptr<COLL> &resultColl, const unsigned int nSlots) : fChunks(nSlots)
    {
       fColls.emplace_back(resultColl);
       for (unsigned int i = 1; i < nSlots; ++i)
@@ -349,10 +620,21 @@ public:
 
    void InitSlot(TTreeReader *, unsigned int) {}
 
+   void InitTask(unsigned int slot, ULong64_t firstEntry, ULong64_t /*endEntry*/)
+   {
+      fChunks.InitTask(slot, firstEntry, fColls[slot]->size());
+   }
+
+   void FinalizeTask(unsigned int slot) { fChunks.FinalizeTask(slot, fColls[slot]->size()); }
+
    void Exec(unsigned int slot, TArrayBranch<RealT_t> av) { fColls[slot]->emplace_back(av.begin(), av.end()); }
 
    void Finalize()
    {
+      if (!fChunks.IsEmpty()) {
+         MergeInEntryOrder(fColls, fChunks);
+         return;
+      }
       auto rColl = fColls[0];
       for (unsigned int i = 1; i < fColls.size(); ++i) {
          auto &coll = fColls[i];
@@ -361,6 +643,15 @@ public:
          }
       }
    }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, *fColls[0]); }
+
+   void MergeMPResult(TBuffer &buf)
+   {
+      auto coll = ReadMPObject<COLL>(buf);
+      for (auto &v : *coll)
+         fColls[0]->emplace_back(std::move(v));
+   }
 };
 
 // Case 4.: The column is an TArrayBranch, the collection is a vector
@@ -368,10 +659,12 @@ public:
 template <typename RealT_t>
 class TakeHelper<RealT_t, TArrayBranch<RealT_t>, std::vector<RealT_t>> {
    std::vector<std::shared_ptr<std::vector<std::vector<RealT_t>>>> fColls;
+   TOrderedChunks fChunks; // only used if results must follow the order of the entries
 
 public:
    using BranchTypes_t = TypeList<TArrayBranch<RealT_t>>;
    TakeHelper(const std::shared_ptr<std::vector<std::vector<RealT_t>>> &resultColl, const unsigned int nSlots)
+      : fChunks(nSlots)
    {
       fColls.emplace_back(resultColl);
       for (unsigned int i = 1; i < nSlots; ++i) {
@@ -385,11 +678,22 @@ public:
 
    void InitSlot(TTreeReader *, unsigned int) {}
 
+   void InitTask(unsigned int slot, ULong64_t firstEntry, ULong64_t /*endEntry*/)
+   {
+      fChunks.InitTask(slot, firstEntry, fColls[slot]->size());
+   }
+
+   void FinalizeTask(unsigned int slot) { fChunks.FinalizeTask(slot, fColls[slot]->size()); }
+
    void Exec(unsigned int slot, TArrayBranch<RealT_t> av) { fColls[slot]->emplace_back(av.begin(), av.end()); }
 
    // This is optimised to treat vectors
    void Finalize()
    {
+      if (!fChunks.IsEmpty()) {
+         MergeInEntryOrder(fColls, fChunks);
+         return;
+      }
       ULong64_t totSize = 0;
       for (auto &coll : fColls)
          totSize += coll->size();
@@ -400,6 +704,14 @@ public:
          rColl->insert(rColl->end(), coll->begin(), coll->end());
       }
    }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, *fColls[0]); }
+
+   void MergeMPResult(TBuffer &buf)
+   {
+      auto coll = ReadMPObject<std::vector<std::vector<RealT_t>>>(buf);
+      fColls[0]->insert(fColls[0]->end(), std::make_move_iterator(coll->begin()), std::make_move_iterator(coll->end()));
+   }
 };
 
 template <typename F, typename T>
@@ -428,6 +740,10 @@ public:
    }
 
    T &PartialUpdate(unsigned int slot) { return fReduceObjs[slot]; }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, fReduceObjs[0]); }
+
+   void MergeMPResult(TBuffer &buf) { fReduceObjs[0] = fReduceFun(fReduceObjs[0], *ReadMPObject<T>(buf)); }
 };
 
 template <typename ResultType>
@@ -459,6 +775,10 @@ public:
    }
 
    ResultType &PartialUpdate(unsigned int slot) { return fMins[slot]; }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, fMins[0]); }
+
+   void MergeMPResult(TBuffer &buf) { fMins[0] = std::min(*ReadMPObject<ResultType>(buf), fMins[0]); }
 };
 
 // TODO
@@ -498,6 +818,10 @@ public:
    }
 
    ResultType &PartialUpdate(unsigned int slot) { return fMaxs[slot]; }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, fMaxs[0]); }
+
+   void MergeMPResult(TBuffer &buf) { fMaxs[0] = std::max(*ReadMPObject<ResultType>(buf), fMaxs[0]); }
 };
 
 // TODO
@@ -535,6 +859,10 @@ public:
    }
 
    ResultType &PartialUpdate(unsigned int slot) { return fSums[slot]; }
+
+   void WriteMPResult(TBuffer &buf) { WriteMPObject(buf, fSums[0]); }
+
+   void MergeMPResult(TBuffer &buf) { fSums[0] += *ReadMPObject<ResultType>(buf); }
 };
 
 class MeanHelper {
@@ -562,6 +890,9 @@ public:
    void Finalize();
 
    double &PartialUpdate(unsigned int slot);
+
+   void WriteMPResult(TBuffer &buf);
+   void MergeMPResult(TBuffer &buf);
 };
 
 extern template void MeanHelper::Exec(unsigned int, const std::vector<float> &);
@@ -584,32 +915,43 @@ template<typename T>
 using AddRefIfNotArrayBranch_t = typename AddRefIfNotArrayBranch<T>::type;
 
 /// Helper object for a single-thread Snapshot action
+///
+/// In multi-process event loops each worker process writes the entries it processes to a temporary file. The parent
+/// process then appends the trees of the temporary files to its output tree, in the order of the entries, without
+/// re-streaming their baskets.
 template <typename... BranchTypes>
 class SnapshotHelper {
    std::unique_ptr<TFile> fOutputFile;
    std::unique_ptr<TTree> fOutputTree; // must be a ptr because TTrees are not copy/move constructible
    bool fIsFirstEvent{true};
+   const std::string fDirName;
+   const std::string fTreeName;
+   const TSnapshotOptions fOptions;
    const ColumnNames_t fBranchNames;
    TTree *fInputTree = nullptr; // Current input tree. Set at initialization time (`InitSlot`)
+   std::string fWorkerFileName;  // Temporary output file, only used in the worker processes of multi-process loops
 
-public:
-   SnapshotHelper(std::string_view filename, std::string_view dirname, std::string_view treename,
-                  const ColumnNames_t &bnames, const TSnapshotOptions &options)
-      : fOutputFile(TFile::Open(std::string(filename).c_str(), options.fMode.c_str(), /*ftitle=*/"",
-                                ROOT::CompressionSettings(options.fCompressionAlgorithm, options.fCompressionLevel))),
-        fBranchNames(bnames)
+   void OpenOutput(const std::string &filename, const std::string &mode)
    {
-      if (!dirname.empty()) {
-         std::string dirnameStr(dirname);
-         fOutputFile->mkdir(dirnameStr.c_str());
-         fOutputFile->cd(dirnameStr.c_str());
+      const auto compression = ROOT::CompressionSettings(fOptions.fCompressionAlgorithm, fOptions.fCompressionLevel);
+      fOutputFile.reset(TFile::Open(filename.c_str(), mode.c_str(), /*ftitle=*/"", compression));
+      if (!fDirName.empty()) {
+         fOutputFile->mkdir(fDirName.c_str());
+         fOutputFile->cd(fDirName.c_str());
       }
-      std::string treenameStr(treename);
       fOutputTree.reset(
-         new TTree(treenameStr.c_str(), treenameStr.c_str(), options.fSplitLevel, /*dir=*/fOutputFile.get()));
+         new TTree(fTreeName.c_str(), fTreeName.c_str(), fOptions.fSplitLevel, /*dir=*/fOutputFile.get()));
+
+      if (fOptions.fAutoFlush)
+         fOutputTree->SetAutoFlush(fOptions.fAutoFlush);
+   }
 
-      if (options.fAutoFlush)
-         fOutputTree->SetAutoFlush(options.fAutoFlush);
+public:
+   SnapshotHelper(std::string_view filename, std::string_view dirname, std::string_view treename,
+                  const ColumnNames_t &bnames, const TSnapshotOptions &options)
+      : fDirName(dirname), fTreeName(treename), fOptions(options), fBranchNames(bnames)
+   {
+      OpenOutput(std::string(filename), options.fMode);
    }
 
    SnapshotHelper(const SnapshotHelper &) = delete;
@@ -657,22 +999,104 @@ public:
       fOutputTree->Branch(name.c_str(), ab->GetData(), fInputTree->GetBranch(name.c_str())->GetTitle());
    }
 
-   void Finalize() { fOutputTree->Write(); }
+   void Finalize()
+   {
+      if (fOutputTree)
+         fOutputTree->Write();
+   }
+
+   void InitMPWorker(unsigned int worker)
+   {
+      // the output file is also open in the parent process: this process must neither write nor close it
+      gROOT->GetListOfFiles()->Remove(fOutputFile.get());
+      fOutputTree.release();
+      fOutputFile.release();
+      fWorkerFileName =
+         TString::Format("%s/tdfsnapshot_%d_%u.root", gSystem->TempDirectory(), gSystem->GetPid(), worker).Data();
+      OpenOutput(fWorkerFileName, "RECREATE");
+   }
+
+   void WriteMPResult(TBuffer &buf)
+   {
+      Finalize();
+      fOutputTree.reset();
+      fOutputFile.reset();
+      WriteMPObject(buf, fWorkerFileName);
+   }
+
+   void MergeMPResult(TBuffer &buf)
+   {
+      auto fileName = ReadMPObject<std::string>(buf);
+      std::unique_ptr<TFile> inFile(TFile::Open(fileName->c_str()));
+      if (!inFile || inFile->IsZombie())
+         throw std::runtime_error("Cannot open the output of a Snapshot worker process, " + *fileName);
+      auto inTree = static_cast<TTree *>(inFile->Get(fTreeName.c_str()));
+      if (inTree && inTree->GetEntries() > 0) {
+         if (fOutputTree->GetNbranches() == 0) {
+            // no worker process wrote entries so far: the output tree gets the branches of this one
+            ::TDirectory::TContext c(fOutputTree->GetDirectory());
+            fOutputTree.reset(inTree->CloneTree(-1, "fast"));
+            inTree->GetListOfClones()->Remove(fOutputTree.get());
+            fOutputTree->ResetBranchAddresses();
+         } else {
+            fOutputTree->CopyEntries(inTree, -1, "fast");
+         }
+      }
+      inFile.reset();
+      gSystem->Unlink(fileName->c_str());
+   }
 };
 
 /// Helper object for a multi-thread Snapshot action
+///
+/// Each slot fills its own output TTree, which lives in a TBufferMergerFile and is kept across tasks: its baskets are
+/// compressed in the worker threads and flushed to the TBufferMerger, which appends them to the output file without
+/// re-streaming them, only when the tree reaches its auto-flush threshold (and at the end of the event loop).
+/// Branch addresses are checked at every entry and updated when the values move in memory, e.g. because a new
+/// task started on the slot or the input TChain moved to a different file.
+///
+/// If the output must follow the order of the entries of the dataset, each task fills an output TTree of its own
+/// instead, whose baskets are flushed to its own TBufferMergerFile at the auto-flush threshold. Completed outputs are
+/// kept in a reorder buffer and handed to the TBufferMerger as soon as the outputs of all tasks that process previous
+/// entries have been, so at any time the buffer only holds the outputs of the tasks that completed ahead of their turn.
+/// The output of the task whose turn it is is handed over already at each auto-flush. The reorder buffer holds at
+/// most two outputs per slot: a task completing when it is full waits for the task whose turn it is, if that is
+/// running on another slot.
 template <typename... BranchTypes>
 class SnapshotHelperMT {
+   /// An output TTree together with the file it is written to and the addresses its branches read values from
+   struct TOutput {
+      std::shared_ptr<ROOT::Experimental::TBufferMergerFile> fFile;
+      TTree *fTree = nullptr; // ROOT will own/manage this TTree, must not delete
+      bool fIsOrdered = false;
+      ULong64_t fTaskBegin = 0; // Range of entries of the task filling this output, only set for ordered outputs
+      ULong64_t fTaskEnd = 0;
+      bool fHasBranches = false;
+      std::vector<TBranch *> fBranches = std::vector<TBranch *>(sizeof...(BranchTypes), nullptr);
+      std::vector<void *> fAddresses = std::vector<void *>(sizeof...(BranchTypes), nullptr);
+      std::vector<void *> fObjectPtrs = std::vector<void *>(sizeof...(BranchTypes), nullptr); // see SetBranchAddress
+   };
+   using OutputPtr_t = std::unique_ptr<TOutput>;
+
+   /// Outputs of completed tasks which cannot be written before the ones of tasks processing previous entries
+   struct TReorderBuffer {
+      std::mutex fMutex;
+      std::condition_variable fOutputsWritten;     // Signalled when the outputs in order have been written
+      ULong64_t fNextEntry = 0;                    // First entry of the next output that can be written
+      std::map<ULong64_t, OutputPtr_t> fOutputs;  // Completed outputs, by first entry of their task
+      std::map<ULong64_t, unsigned int> fRunning; // Slots of the running tasks, by first entry of the task
+   };
+
    const unsigned int fNSlots;
    std::unique_ptr<ROOT::Experimental::TBufferMerger> fMerger; // must use a ptr because TBufferMerger is not movable
-   std::vector<std::shared_ptr<ROOT::Experimental::TBufferMergerFile>> fOutputFiles;
-   std::vector<TTree *> fOutputTrees; // ROOT will own/manage these TTrees, must not delete
-   std::vector<int> fIsFirstEvent;    // vector<bool> is evil
-   const std::string fDirName;        // name of TFile subdirectory in which output must be written (possibly empty)
-   const std::string fTreeName;       // name of output tree
-   const TSnapshotOptions fOptions;   // struct holding options to pass down to TFile and TTree in this action
+   const std::string fDirName;      // name of TFile subdirectory in which output must be written (possibly empty)
+   const std::string fTreeName;     // name of output tree
+   const TSnapshotOptions fOptions; // struct holding options to pass down to TFile and TTree in this action
    const ColumnNames_t fBranchNames;
    std::vector<TTree *> fInputTrees; // Current input trees. Set at initialization time (`InitSlot`)
+   // Per slot, a stack of outputs. It holds more than one output only if ordered tasks are interleaved on the slot
+   std::vector<std::vector<OutputPtr_t>> fOutputs;
+   std::unique_ptr<TReorderBuffer> fReorderBuffer; // must use a ptr because std::mutex is not movable
 
 public:
    using BranchTypes_t = TypeList<BranchTypes...>;
@@ -681,8 +1105,8 @@ public:
       : fNSlots(nSlots), fMerger(new ROOT::Experimental::TBufferMerger(
                             std::string(filename).c_str(), options.fMode.c_str(),
                             ROOT::CompressionSettings(options.fCompressionAlgorithm, options.fCompressionLevel))),
-        fOutputFiles(fNSlots), fOutputTrees(fNSlots, nullptr), fIsFirstEvent(fNSlots, 1), fDirName(dirname),
-        fTreeName(treename), fOptions(options), fBranchNames(bnames), fInputTrees(fNSlots)
+        fDirName(dirname), fTreeName(treename), fOptions(options), fBranchNames(bnames), fInputTrees(fNSlots),
+        fOutputs(fNSlots), fReorderBuffer(new TReorderBuffer)
    {
    }
    SnapshotHelperMT(const SnapshotHelperMT &) = delete;
@@ -690,76 +1114,181 @@ public:
 
    void InitSlot(TTreeReader *r, unsigned int slot)
    {
-      ::TDirectory::TContext c; // do not let tasks change the thread-local gDirectory
-      if (!fOutputTrees[slot]) {
-         // first time this thread executes something, let's create a TBufferMerger output directory
-         fOutputFiles[slot] = fMerger->GetFile();
-      } else {
-         // this thread is now re-executing the task, let's flush the current contents of the TBufferMergerFile
-         fOutputFiles[slot]->Write();
-      }
-      TDirectory *treeDirectory = fOutputFiles[slot].get();
-      if (!fDirName.empty()) {
-         treeDirectory = fOutputFiles[slot]->mkdir(fDirName.c_str());
-      }
-      // re-create output tree as we need to create its branches again, with new input variables
-      // TODO we could instead create the output tree and its branches, change addresses of input variables in each task
-      fOutputTrees[slot] = new TTree(fTreeName.c_str(), fTreeName.c_str(), fOptions.fSplitLevel, /*dir=*/treeDirectory);
-      fOutputTrees[slot]->ResetBit(kMustCleanup); // do not mingle with the thread-unsafe gListOfCleanups
-      if (fOptions.fAutoFlush)
-         fOutputTrees[slot]->SetAutoFlush(fOptions.fAutoFlush);
-      if (r) {
-         // not an empty-source TDF
+      // not an empty-source TDF: the input tree is needed to retrieve the titles of branches of c-style arrays
+      if (r)
          fInputTrees[slot] = r->GetTree();
-         // AddClone guarantees that if the input file changes the branches of the output tree are updated with the new
-         // addresses of the branch values
-         fInputTrees[slot]->AddClone(fOutputTrees[slot]);
+   }
+
+   /// Only called if the output must follow the order of the entries: this task gets an output of its own
+   void InitTask(unsigned int slot, ULong64_t firstEntry, ULong64_t endEntry)
+   {
+      auto output = MakeOutput();
+      output->fIsOrdered = true;
+      output->fTaskBegin = firstEntry;
+      output->fTaskEnd = endEntry;
+      fOutputs[slot].emplace_back(std::move(output));
+      std::lock_guard<std::mutex> lock(fReorderBuffer->fMutex);
+      fReorderBuffer->fRunning[firstEntry] = slot;
+   }
+
+   /// Only called if the output must follow the order of the entries: write all outputs that are now in order.
+   /// If the reorder buffer is full, wait until the task whose turn it is completes. Only a task running on another
+   /// slot is waited for: tasks interleaved on this slot are suspended until this one returns, and a task that did not
+   /// start yet might need this thread to run.
+   void FinalizeTask(unsigned int slot)
+   {
+      auto output = std::move(fOutputs[slot].back());
+      fOutputs[slot].pop_back();
+
+      std::unique_lock<std::mutex> lock(fReorderBuffer->fMutex);
+      auto &outputs = fReorderBuffer->fOutputs;
+      auto &running = fReorderBuffer->fRunning;
+      auto &nextEntry = fReorderBuffer->fNextEntry;
+      running.erase(output->fTaskBegin);
+      outputs.emplace(output->fTaskBegin, std::move(output));
+      if (outputs.begin()->first == nextEntry) {
+         while (!outputs.empty() && outputs.begin()->first == nextEntry) {
+            nextEntry = outputs.begin()->second->fTaskEnd;
+            outputs.begin()->second->fFile->Write();
+            outputs.erase(outputs.begin());
+         }
+         fReorderBuffer->fOutputsWritten.notify_all();
       }
-      fIsFirstEvent[slot] = 1; // reset first event flag for this slot
+      const auto maxOutputs = 2 * fNSlots;
+      fReorderBuffer->fOutputsWritten.wait(lock, [&] {
+         const auto head = running.find(nextEntry);
+         return outputs.size() <= maxOutputs || head == running.end() || head->second == slot;
+      });
    }
 
    void Exec(unsigned int slot, AddRefIfNotArrayBranch_t<BranchTypes>... values)
    {
-      if (fIsFirstEvent[slot]) {
-         using ind_t = GenStaticSeq_t<sizeof...(BranchTypes)>;
-         SetBranches(slot, values..., ind_t());
-         fIsFirstEvent[slot] = 0;
+      if (fOutputs[slot].empty()) {
+         // first time this slot executes something: let's create the output tree it will fill from now on
+         fOutputs[slot].emplace_back(MakeOutput());
+      }
+      auto &output = *fOutputs[slot].back();
+
+      using ind_t = GenStaticSeq_t<sizeof...(BranchTypes)>;
+      if (!output.fHasBranches) {
+         SetBranches(output, slot, values..., ind_t());
+         output.fHasBranches = true;
+      } else {
+         UpdateBranchAddresses(output, values..., ind_t());
+      }
+      output.fTree->Fill();
+
+      auto entries = output.fTree->GetEntries();
+      auto autoFlush = output.fTree->GetAutoFlush();
+      if ((autoFlush > 0) && (entries % autoFlush == 0)) {
+         if (output.fIsOrdered) {
+            // TTree::Fill flushed the baskets to the file of this task. It is handed to the TBufferMerger only if this
+            // is the task whose turn it is: the outputs of the other tasks are written when all previous tasks' are
+            std::lock_guard<std::mutex> lock(fReorderBuffer->fMutex);
+            if (output.fTaskBegin == fReorderBuffer->fNextEntry)
+               output.fFile->Write();
+         } else {
+            output.fFile->Write();
+         }
       }
-      fOutputTrees[slot]->Fill();
-      auto entries = fOutputTrees[slot]->GetEntries();
-      auto autoFlush = fOutputTrees[slot]->GetAutoFlush();
-      if ((autoFlush > 0) && (entries % autoFlush == 0))
-         fOutputFiles[slot]->Write();
+   }
+
+   OutputPtr_t MakeOutput()
+   {
+      ::TDirectory::TContext c; // do not let tasks change the thread-local gDirectory
+      OutputPtr_t output(new TOutput);
+      output->fFile = fMerger->GetFile();
+      TDirectory *treeDirectory = output->fFile.get();
+      if (!fDirName.empty()) {
+         treeDirectory = output->fFile->mkdir(fDirName.c_str());
+      }
+      output->fTree = new TTree(fTreeName.c_str(), fTreeName.c_str(), fOptions.fSplitLevel, /*dir=*/treeDirectory);
+      output->fTree->ResetBit(kMustCleanup); // do not mingle with the thread-unsafe gListOfCleanups
+      if (fOptions.fAutoFlush)
+         output->fTree->SetAutoFlush(fOptions.fAutoFlush);
+      return output;
    }
 
    template <int... S>
-   void SetBranches(unsigned int slot, AddRefIfNotArrayBranch_t<BranchTypes>... values, StaticSeq<S...> /*dummy*/)
+   void SetBranches(TOutput &output, unsigned int slot, AddRefIfNotArrayBranch_t<BranchTypes>... values,
+                    StaticSeq<S...> /*dummy*/)
    {
       // hack to call TTree::Branch on all variadic template arguments
-      int expander[] = {(SetBranchesHelper(*fOutputTrees[slot], *fInputTrees[slot], fBranchNames[S], &values), 0)...,
-                        0};
+      int expander[] = {(SetBranchesHelper(output, slot, S, &values), 0)..., 0};
       (void)expander; // avoid unused variable warnings for older compilers such as gcc 4.9
    }
 
    template <typename T>
-   void SetBranchesHelper(TTree &t, TTree &, const std::string &name, T *address)
+   void SetBranchesHelper(TOutput &output, unsigned int, int idx, T *address)
    {
-      t.Branch(name.c_str(), address);
+      output.fBranches[idx] = output.fTree->Branch(fBranchNames[idx].c_str(), address);
+      output.fAddresses[idx] = address;
    }
 
    // This overload is called for columns of type `TArrayBranch<T>`. For TDF, these represent c-style arrays in ROOT
    // files, so we are sure that there are input trees to which we can ask the correct branch title
    template <typename T>
-   void SetBranchesHelper(TTree &outputTree, TTree &inputTree, const std::string &name, TArrayBranch<T> *ab)
+   void SetBranchesHelper(TOutput &output, unsigned int slot, int idx, TArrayBranch<T> *ab)
+   {
+      const auto &name = fBranchNames[idx];
+      output.fBranches[idx] =
+         output.fTree->Branch(name.c_str(), ab->GetData(), fInputTrees[slot]->GetBranch(name.c_str())->GetTitle());
+      output.fAddresses[idx] = ab->GetData();
+   }
+
+   template <int... S>
+   void UpdateBranchAddresses(TOutput &output, AddRefIfNotArrayBranch_t<BranchTypes>... values, StaticSeq<S...>)
    {
-      outputTree.Branch(name.c_str(), ab->GetData(), inputTree.GetBranch(name.c_str())->GetTitle());
+      int expander[] = {(SetBranchAddress(output, S, GetValueAddress(&values)), 0)..., 0};
+      (void)expander; // avoid unused variable warnings for older compilers such as gcc 4.9
+   }
+
+   template <typename T>
+   static void *GetValueAddress(T *address)
+   {
+      return address;
+   }
+
+   template <typename T>
+   static void *GetValueAddress(TArrayBranch<T> *ab)
+   {
+      return ab->GetData();
+   }
+
+   static void SetBranchAddress(TOutput &output, int idx, void *address)
+   {
+      if (address == output.fAddresses[idx])
+         return;
+      auto branch = output.fBranches[idx];
+      if (auto branchElement = dynamic_cast<TBranchElement *>(branch)) {
+         branchElement->SetObject(address);
+      } else if (branch->IsA() == TBranch::Class()) {
+         branch->SetAddress(address);
+      } else {
+         // e.g. TBranchObject: the branch expects the address of a pointer to the object
+         output.fObjectPtrs[idx] = address;
+         branch->SetAddress(&output.fObjectPtrs[idx]);
+      }
+      output.fAddresses[idx] = address;
    }
 
    void Finalize()
    {
-      for (auto &file : fOutputFiles) {
-         if (file)
-            file->Write();
+      const auto noOutputs = fReorderBuffer->fNextEntry == 0 && fReorderBuffer->fOutputs.empty() &&
+                             std::all_of(fOutputs.begin(), fOutputs.end(),
+                                         [](const std::vector<OutputPtr_t> &outputs) { return outputs.empty(); });
+      if (noOutputs) {
+         // no entry was processed: write an empty output tree all the same
+         fOutputs[0].emplace_back(MakeOutput());
+      }
+      // outputs still in the reorder buffer (e.g. if ranges of entries were not contiguous) are written in order
+      for (auto &output : fReorderBuffer->fOutputs)
+         output.second->fFile->Write();
+      fReorderBuffer->fOutputs.clear();
+      for (auto &slotOutputs : fOutputs) {
+         for (auto &output : slotOutputs)
+            output->fFile->Write();
+         slotOutputs.clear();
       }
    }
 };
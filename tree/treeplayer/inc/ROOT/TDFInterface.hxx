@@ -162,17 +162,20 @@ std::vector<std::string> FindUsedColumnNames(std::string_view, TObjArray *, cons
 
 using TmpBranchBasePtr_t = std::shared_ptr<TCustomColumnBase>;
 
-Long_t JitTransformation(void *thisPtr, std::string_view methodName, std::string_view interfaceTypeName,
-                         std::string_view name, std::string_view expression,
-                         const std::map<std::string, std::string> &aliasMap, const ColumnNames_t &branches,
-                         const std::vector<std::string> &customColumns,
-                         const std::map<std::string, TmpBranchBasePtr_t> &tmpBookedBranches, TTree *tree,
-                         std::string_view returnTypeName, TDataSource *ds);
-
-std::string JitBuildAndBook(const ColumnNames_t &bl, const std::string &prevNodeTypename, void *prevNode,
-                            const std::type_info &art, const std::type_info &at, const void *r, TTree *tree,
-                            const unsigned int nSlots, const std::map<std::string, TmpBranchBasePtr_t> &customColumns,
-                            TDataSource *ds, const std::shared_ptr<TActionBase *> *const actionPtrPtr);
+void JitTransformation(void *thisPtr, void *resultPtr, std::string_view methodName,
+                       std::string_view interfaceTypeName, std::string_view name, std::string_view expression,
+                       const std::map<std::string, std::string> &aliasMap, const ColumnNames_t &branches,
+                       const std::vector<std::string> &customColumns,
+                       const std::map<std::string, TmpBranchBasePtr_t> &tmpBookedBranches, TTree *tree,
+                       std::string_view returnTypeName, TDataSource *ds);
+
+std::string GetJittedFilterKey(const void *prevNode, const ColumnNames_t &validCustomColumns,
+                               std::string_view expression);
+
+TJitCall JitBuildAndBook(const ColumnNames_t &bl, const std::string &prevNodeTypename, void *prevNode,
+                         const std::type_info &art, const std::type_info &at, const void *r, TTree *tree,
+                         const unsigned int nSlots, const std::map<std::string, TmpBranchBasePtr_t> &customColumns,
+                         TDataSource *ds, const std::shared_ptr<TActionBase *> *const actionPtrPtr);
 
 // allocate a shared_ptr on the heap, return a reference to it. the user is responsible of deleting the shared_ptr*.
 // this function is meant to only be used by TInterface's action methods, and should be deprecated as soon as we find
@@ -198,6 +201,17 @@ std::shared_ptr<TLoopManager> UpcastNode(const std::shared_ptr<TLoopManager> ptr
 ColumnNames_t GetValidatedColumnNames(TLoopManager &lm, const unsigned int nColumns, const ColumnNames_t &columns,
                                       const ColumnNames_t &validCustomColumns, TDataSource *ds);
 
+/// Name of the TTree in which `Cache` persistently stores columns
+constexpr auto kPersistentCacheTreeName = "TDFCache";
+
+std::string GetPersistentCacheFingerprint(TLoopManager &lm, const std::string &graphFingerprint,
+                                          const ColumnNames_t &validCustomColumns, const ColumnNames_t &columns,
+                                          const std::vector<std::string> &columnTypeIds);
+
+bool IsPersistentCacheValid(std::string_view fileName, const std::string &fingerprint);
+
+void WritePersistentCacheFingerprint(std::string_view fileName, const std::string &fingerprint);
+
 std::vector<bool> FindUndefinedDSColumns(const ColumnNames_t &requestedCols, const ColumnNames_t &definedDSCols);
 
 /// Helper function to be used by `DefineDataSourceColumns`
@@ -448,12 +462,27 @@ public:
    /// The expression is just-in-time compiled and used to filter entries. It must
    /// be valid C++ syntax in which variable names are substituted with the names
    /// of branches/columns.
+   /// Unnamed filters with the same expression, booked on the same node, select the same entries: they are only
+   /// jitted and booked once, and subsequent calls return the existing filter. The expression is therefore expected
+   /// not to have side effects.
    ///
    /// Refer to the first overload of this method for the full documentation.
    TInterface<TFilterBase> Filter(std::string_view expression, std::string_view name = "")
    {
-      auto retVal = CallJitTransformation("Filter", name, expression, "ROOT::Detail::TDF::TFilterBase");
-      return *(TInterface<TFilterBase> *)retVal;
+      auto df = GetDataFrameChecked();
+      std::string filterKey;
+      if (name.empty()) {
+         filterKey = TDFInternal::GetJittedFilterKey(TDFInternal::UpcastNode(fProxiedPtr).get(), fValidCustomColumns,
+                                                     expression);
+         if (auto filter = df->GetJittedFilter(filterKey))
+            return TInterface<TFilterBase>(filter, fImplWeakPtr, fValidCustomColumns, fDataSource);
+      }
+      auto retInterface =
+         CallJitTransformation<TInterface<TFilterBase>>("Filter", name, expression, "ROOT::Detail::TDF::TFilterBase");
+      retInterface.fProxiedPtr->SetJittedExpression(expression);
+      if (name.empty())
+         df->AddJittedFilter(filterKey, retInterface.fProxiedPtr);
+      return retInterface;
    }
 
    // clang-format off
@@ -556,9 +585,10 @@ public:
       // this check must be done before jitting lest we throw exceptions in jitted code
       TDFInternal::CheckCustomColumn(name, loopManager->GetTree(), loopManager->GetCustomColumnNames(),
                                      fDataSource ? fDataSource->GetColumnNames() : ColumnNames_t{});
-      auto retVal = CallJitTransformation("Define", name, expression, TInterfaceJittedDefine::GetNodeTypeName());
-      auto retInterface = reinterpret_cast<TInterfaceJittedDefine *>(retVal);
-      return *retInterface;
+      auto retInterface = CallJitTransformation<TInterfaceJittedDefine>("Define", name, expression,
+                                                                        TInterfaceJittedDefine::GetNodeTypeName());
+      loopManager->GetBookedBranch(std::string(name))->SetJittedExpression(expression);
+      return retInterface;
    }
 
    ////////////////////////////////////////////////////////////////////////////
@@ -735,6 +765,96 @@ public:
       return *reinterpret_cast<TInterface<TLoopManager> *>(newTDFPtr);
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   /// \brief Save selected columns in a file, to be reused across processes
+   /// \tparam BranchTypes variadic list of branch/column types
+   /// \param[in] columnList The list of names of the columns to be cached
+   /// \param[in] fileName The name of the file in which the columns are cached
+   ///
+   /// The selected columns are written, uncompressed, to a TTree in file `fileName`: reading them back requires
+   /// neither decompression nor re-evaluation of the computation graph upstream of this node.
+   /// The file also stores a fingerprint of the cached columns, of the computation graph upstream of this node
+   /// (the expressions of Filters and Defines, the aliases and the Ranges) and of the input dataset (names, sizes and
+   /// modification times of the input files, including friends). If `fileName` already exists and its fingerprint
+   /// matches, no event loop is run and the returned TDataFrame reads the cached columns from it. Otherwise the
+   /// cache is (re)generated.
+   ///
+   /// Only Filters and Defines expressed as strings can be fingerprinted: if the graph contains compiled callables,
+   /// as well as for data-sources and in-memory trees, the cache is always regenerated.
+   /// An exception is thrown if `columnList` is empty.
+   template <typename... BranchTypes>
+   TInterface<TLoopManager> Cache(const ColumnNames_t &columnList, std::string_view fileName)
+   {
+      if (columnList.empty())
+         throw std::runtime_error("Cannot store an empty list of columns in persistent cache " +
+                                  std::string(fileName) + ".");
+      auto lm = GetDataFrameChecked();
+      std::string graphFingerprint;
+      std::string fingerprint; // an empty fingerprint never matches, so the cache is regenerated
+      if (fProxiedPtr->AppendFingerprint(graphFingerprint))
+         fingerprint = TDFInternal::GetPersistentCacheFingerprint(*lm, graphFingerprint, fValidCustomColumns,
+                                                                  columnList, {typeid(BranchTypes).name()...});
+      if (!TDFInternal::IsPersistentCacheValid(fileName, fingerprint)) {
+         TSnapshotOptions options;
+         options.fCompressionLevel = 0;
+         auto cachedTDF =
+            SnapshotImpl<BranchTypes...>(TDFInternal::kPersistentCacheTreeName, fileName, columnList, options);
+         TDFInternal::WritePersistentCacheFingerprint(fileName, fingerprint);
+         return cachedTDF;
+      }
+
+      ::TDirectory::TContext ctxt;
+      // Mimic a constructor for the TDataFrame, as SnapshotImpl does
+      TInterface<TLoopManager> cachedTDF(std::make_shared<TLoopManager>(nullptr, columnList));
+      auto chain = std::make_shared<TChain>(TDFInternal::kPersistentCacheTreeName);
+      chain->Add(std::string(fileName).c_str());
+      cachedTDF.fProxiedPtr->SetTree(chain);
+      return cachedTDF;
+   }
+
+   ////////////////////////////////////////////////////////////////////////////
+   /// \brief Save selected columns in a file, to be reused across processes
+   /// \param[in] columnList The list of names of the columns to be cached
+   /// \param[in] fileName The name of the file in which the columns are cached
+   ///
+   /// The types of the columns are automatically inferred and do not need to be specified.
+   /// See the documentation of the templated overload for more details.
+   TInterface<TLoopManager> Cache(const ColumnNames_t &columnList, std::string_view fileName)
+   {
+      if (columnList.empty())
+         throw std::runtime_error("Cannot store an empty list of columns in persistent cache " +
+                                  std::string(fileName) + ".");
+
+      auto df = GetDataFrameChecked();
+      auto tree = df->GetTree();
+      const std::string fileNameStr(fileName);
+      std::stringstream cacheCall;
+      auto upcastNode = TDFInternal::UpcastNode(fProxiedPtr);
+      TInterface<TTraits::TakeFirstParameter_t<decltype(upcastNode)>> upcastInterface(fProxiedPtr, fImplWeakPtr,
+                                                                                      fValidCustomColumns, fDataSource);
+      // build a string equivalent to
+      // "(TInterface<nodetype*>*)(this)->Cache<Ts...>(*(ColumnNames_t*)(&columnList), *(std::string*)(&fileNameStr))"
+      cacheCall << "reinterpret_cast<ROOT::Experimental::TDF::TInterface<" << upcastInterface.GetNodeTypeName()
+                << ">*>(" << &upcastInterface << ")->Cache<";
+      bool first = true;
+      for (auto &b : columnList) {
+         if (!first)
+            cacheCall << ", ";
+         cacheCall << TDFInternal::ColumnName2ColumnTypeName(b, tree, df->GetBookedBranch(b), fDataSource);
+         first = false;
+      };
+      cacheCall << ">(*reinterpret_cast<std::vector<std::string>*>(" // vector<string> should be ColumnNames_t
+                << &columnList << "), *reinterpret_cast<const std::string*>(" << &fileNameStr << "));";
+      // jit cacheCall, return result
+      TInterpreter::EErrorCode errorCode;
+      auto newTDFPtr = gInterpreter->Calc(cacheCall.str().c_str(), &errorCode);
+      if (TInterpreter::EErrorCode::kNoError != errorCode) {
+         std::string msg = "Cannot jit Cache call. Interpreter error code is " + std::to_string(errorCode) + ".";
+         throw std::runtime_error(msg);
+      }
+      return *reinterpret_cast<TInterface<TLoopManager> *>(newTDFPtr);
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    /// \brief Save selected columns in memory
    /// \param[in] a regular expression to select the columns
@@ -753,16 +873,19 @@ public:
    /// \param[in] stop Total number of entries that will be processed before stopping. 0 means "never stop".
    /// \param[in] stride Process one entry every `stride` entries. Must be strictly greater than 0.
    ///
-   /// Ranges are only available if EnableImplicitMT has _not_ been called. Multi-thread ranges are not supported.
+   /// If EnableImplicitMT has been called, ranges can only be applied to the whole dataset, i.e. not to the entries
+   /// that pass a filter or another range: entries are then selected according to their entry number, and the event
+   /// loop does not process entries past the `stop` of the ranges if nothing else needs them.
    TInterface<TDFDetail::TRange<Proxied>> Range(unsigned int start, unsigned int stop, unsigned int stride = 1)
    {
       // check invariants
       if (stride == 0 || (stop != 0 && stop < start))
          throw std::runtime_error("Range: stride must be strictly greater than 0 and stop must be greater than start.");
-      if (ROOT::IsImplicitMTEnabled())
-         throw std::runtime_error("Range was called with ImplicitMT enabled. Multi-thread ranges are not supported.");
 
       auto df = GetDataFrameChecked();
+      if (df->IsMultiThreaded() && !std::is_same<Proxied, TLoopManager>::value)
+         throw std::runtime_error("Range was called with ImplicitMT enabled after a Filter or another Range. "
+                                  "Multi-thread ranges can only act on all the entries of the dataset.");
       using Range_t = TDFDetail::TRange<Proxied>;
       auto RangePtr = std::make_shared<Range_t>(start, stop, stride, *fProxiedPtr);
       df->Book(RangePtr);
@@ -923,6 +1046,38 @@ public:
       return MakeResultProxy(cSPtr, df, action.get());
    }
 
+   ////////////////////////////////////////////////////////////////////////////
+   /// \brief Return the cost of each node of the functional graph during the next event loop (*lazy action*)
+   ///
+   /// The event loop that produces this result is profiled: for every column read, Define, Filter and action the
+   /// report contains the number of evaluations, the exclusive wall time, the bytes read from files and the time
+   /// spent reading and decompressing them. Per-slot statistics show how evenly work was spread among threads.
+   /// The report covers the whole functional graph, irrespective of the node this method is called on: calling it
+   /// on the TDataFrame object itself avoids adding a dependency on any filter.
+   /// See TProfileReport for more details, e.g. on how I/O is accounted to nodes.
+   ///
+   /// Profiling adds a small overhead to every node evaluation. It is only active during the event loop in which
+   /// the report is produced.
+   /// ~~~{.cpp}
+   /// auto profile = tdf.Filter("x > 0").Define("y", "x*x").ProfileReport();
+   /// profile->Print();
+   /// std::string json = profile->AsJSON();
+   /// ~~~
+   ///
+   /// This action is *lazy*: upon invocation of this method the calculation is
+   /// booked but not executed. See TResultProxy documentation.
+   TResultProxy<TProfileReport> ProfileReport()
+   {
+      auto df = GetDataFrameChecked();
+      auto reportPtr = std::make_shared<TProfileReport>();
+      using Helper_t = TDFInternal::ProfileReportHelper;
+      using Action_t = TDFInternal::TAction<Helper_t, Proxied>;
+      auto action =
+         std::make_shared<Action_t>(Helper_t(reportPtr, df->EnableProfiling()), ColumnNames_t({}), *fProxiedPtr);
+      df->Book(action);
+      return MakeResultProxy(reportPtr, df, action.get());
+   }
+
    ////////////////////////////////////////////////////////////////////////////
    /// \brief Return a collection of values of a column (*lazy action*, returns a std::vector by default)
    /// \tparam T The type of the column.
@@ -1530,6 +1685,8 @@ public:
          return;
 
       auto df = GetDataFrameChecked();
+      // the filters might be run by an event loop started with RunAsync
+      df->WaitAsyncRun();
       // TODO: we could do better and check if the Report was asked for Filters that have already run
       // and in that case skip the event-loop
       if (df->MustRunNamedFilters())
@@ -1568,6 +1725,105 @@ public:
       return allColumns;
    }
 
+   /////////////////////////////////////////////////////////////////////////////
+   /// \brief Produce the results of multi-thread event loops in the order of the entries of the dataset
+   /// \param[in] ordered Whether results must follow the order of the entries.
+   ///
+   /// In multi-thread event loops, entries are processed in tasks that can complete in any order. With this option
+   /// enabled, the collections returned by `Take` and the trees written by `Snapshot` contain values in the same order
+   /// as in a single-thread event loop. Processing still happens in parallel: the results of each task are kept apart
+   /// and re-assembled in order, either at the end of the event loop (`Take`) or as soon as the results of the tasks
+   /// processing previous entries are available (`Snapshot`). To bound the memory used by `Snapshot`, a task that
+   /// completes too far ahead of its turn waits for the tasks processing previous entries. The side effects of
+   /// `Foreach` and the order in which results are merged by the other actions are not affected.
+   /// The option applies to the whole functional graph, starting from the next event loop.
+   void SetOrderedOutput(bool ordered = true) { GetDataFrameChecked()->SetOrderedOutput(ordered); }
+
+#ifdef R__USE_IMT
+   /////////////////////////////////////////////////////////////////////////////
+   /// \brief Start the event loop without waiting for its end
+   /// \return A future that becomes ready when the event loop is over, and re-throws the exceptions it raised.
+   ///
+   /// The event loop that produces the results booked so far runs in a task of the ROOT thread pool, while this
+   /// method returns immediately. Event loops of different TDataFrames started this way run concurrently, sharing
+   /// the threads of the pool. Waiting on the future makes the calling thread take part in the processing.
+   /// Accessing a result of the event loop waits for its end, as does booking new transformations or actions
+   /// on the same functional graph, which must therefore happen in the thread that called RunAsync.
+   /// If ImplicitMT is not enabled, the event loop runs in the calling thread before this method returns.
+   ///
+   /// ~~~{.cpp}
+   /// ROOT::EnableImplicitMT();
+   /// TDataFrame d1("t", "sample1.root"), d2("t", "sample2.root");
+   /// auto h1 = d1.Histo1D("x");
+   /// auto h2 = d2.Histo1D("x");
+   /// auto f1 = d1.RunAsync();
+   /// auto f2 = d2.RunAsync();
+   /// h1->Draw(); // waits for the event loop of d1, the one of d2 might still be running
+   /// f2.get();
+   /// ~~~
+   ROOT::Experimental::TFuture<void> RunAsync() { return GetDataFrameChecked()->RunAsync(); }
+#endif
+
+   /////////////////////////////////////////////////////////////////////////////
+   /// \brief Process the same dataset as another TDataFrame in a single event loop
+   /// \param[in] other Any node of the functional graph of the other TDataFrame, e.g. the TDataFrame itself.
+   ///
+   /// From now on, whenever the event loop of either TDataFrame is triggered, the results booked on both are produced
+   /// by one pass over the data: each entry is read once and then processed by both functional graphs. The same holds
+   /// for all the TDataFrames that already share their event loop with either of the two, e.g.
+   /// ~~~{.cpp}
+   /// TDataFrame nominal("t", files), up("t", files), down("t", files);
+   /// nominal.ShareEventLoop(up);
+   /// nominal.ShareEventLoop(down);
+   /// auto hNom = nominal.Histo1D("pt");
+   /// auto hUp = up.Define("ptUp", "pt * 1.01").Histo1D("ptUp");
+   /// auto hDown = down.Define("ptDown", "pt * 0.99").Histo1D("ptDown");
+   /// hUp->Draw(); // runs the event loop that fills the three histograms
+   /// ~~~
+   /// The two TDataFrames must read the same tree, from the same files and with the same friends, or have the same
+   /// number of entries if they do not read from files, and must have been created with the same ImplicitMT settings.
+   /// TDataFrames reading from a data source cannot share their event loops. Ranges that would stop the event loop of
+   /// one of the TDataFrames early only do so if those of the others also reached their end.
+   template <typename T>
+   void ShareEventLoop(const TInterface<T> &other)
+   {
+      auto otherLm = other.fImplWeakPtr.lock();
+      if (!otherLm)
+         throw std::runtime_error("The main TDataFrame is not reachable: did it go out of scope?");
+      GetDataFrameChecked()->ShareEventLoop(*otherLm);
+   }
+
+   /////////////////////////////////////////////////////////////////////////////
+   /// \brief Run the next event loops in several processes
+   /// \param[in] nWorkers Number of worker processes. If 0, as many as the cores of the machine.
+   ///
+   /// Each event loop forks `nWorkers` processes, each of which processes a contiguous range of entries. Entries read
+   /// from a TTree are split at cluster boundaries. The partial results of the workers are then merged in this
+   /// process, in the order of the entries: Take returns the values in the same order as a sequential event loop, and
+   /// Snapshot writes the entries in the same order, copying the baskets written by the workers to the output file.
+   /// This allows to process the dataset in parallel when the functional graph cannot run in several threads, e.g.
+   /// because it calls code that is not thread-safe.
+   /// ~~~{.cpp}
+   /// TDataFrame d("t", files);
+   /// d.EnableMultiProcess(8);
+   /// auto h = d.Filter(notThreadSafeSelection, {"muons"}).Histo1D("pt");
+   /// h->Draw(); // runs the event loop in 8 processes
+   /// ~~~
+   /// Caveats:
+   /// - the TDataFrame must have been created with ImplicitMT disabled, and cannot read from a data source or share
+   ///   its event loop with other TDataFrames
+   /// - the side effects of Foreach, ForeachSlot and of the callbacks of OnPartialResult happen in the workers and
+   ///   are lost; Report does not include the entries processed by the workers
+   /// - Range and Profile are not supported
+   /// - Define and Filter expressions, as well as all results, must be usable in a forked process; the results of
+   ///   Reduce, Min, Max, Sum and Take are sent to this process through their dictionaries, which must be available
+   /// - not available on Windows
+   void EnableMultiProcess(unsigned int nWorkers = 0) { GetDataFrameChecked()->EnableMultiProcess(nWorkers); }
+
+   /////////////////////////////////////////////////////////////////////////////
+   /// \brief Run the next event loops in this process, see EnableMultiProcess
+   void DisableMultiProcess() { GetDataFrameChecked()->DisableMultiProcess(); }
+
 private:
    void AddDefaultColumns()
    {
@@ -1638,8 +1894,10 @@ private:
       return selectedColumns;
    }
 
-   Long_t CallJitTransformation(std::string_view transformation, std::string_view nodeName, std::string_view expression,
-                                std::string_view returnTypeName)
+   /// Jit the Filter or Define call `transformation`, which returns a RetInterface
+   template <typename RetInterface>
+   RetInterface CallJitTransformation(std::string_view transformation, std::string_view nodeName,
+                                      std::string_view expression, std::string_view returnTypeName)
    {
       auto df = GetDataFrameChecked();
       auto &aliasMap = df->GetAliasMap();
@@ -1651,9 +1909,11 @@ private:
       TInterface<TypeTraits::TakeFirstParameter_t<decltype(upcastNode)>> upcastInterface(
          upcastNode, fImplWeakPtr, fValidCustomColumns, fDataSource);
       const auto thisTypeName = "ROOT::Experimental::TDF::TInterface<" + upcastInterface.GetNodeTypeName() + ">";
-      return TDFInternal::JitTransformation(&upcastInterface, transformation, thisTypeName, nodeName, expression,
-                                            aliasMap, branches, customColumns, tmpBookedBranches, tree, returnTypeName,
-                                            fDataSource);
+      std::unique_ptr<RetInterface> ret;
+      TDFInternal::JitTransformation(&upcastInterface, &ret, transformation, thisTypeName, nodeName, expression,
+                                     aliasMap, branches, customColumns, tmpBookedBranches, tree, returnTypeName,
+                                     fDataSource);
+      return *ret;
    }
 
    /// Return string containing fully qualified type name of the node pointed by fProxied.
@@ -1704,7 +1964,7 @@ private:
       auto toJit = TDFInternal::JitBuildAndBook(validColumnNames, upcastInterface.GetNodeTypeName(), upcastNode.get(),
                                                 typeid(std::shared_ptr<ActionResultType>), typeid(ActionType), rOnHeap,
                                                 tree, nSlots, customColumns, fDataSource, actionPtrPtrOnHeap);
-      lm->Jit(toJit);
+      lm->Jit(toJit.fBody, toJit.fArgs);
       return resultProxy;
    }
 
@@ -0,0 +1,60 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2017, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TDFJITCACHE
+#define ROOT_TDFJITCACHE
+
+#include "RStringView.h"
+#include "RtypesCore.h"
+
+#include <string>
+#include <vector>
+
+namespace ROOT {
+namespace Experimental {
+namespace TDF {
+/// Set the directory where the code jitted by TDataFrame is cached as compiled shared libraries, to be reused by
+/// later processes. An empty string disables the cache. The default is the value of `TDataFrame.JitCacheDir` in
+/// the ROOT configuration (.rootrc), empty if not set.
+void SetJitCacheDir(std::string_view dir);
+std::string GetJitCacheDir();
+} // ns TDF
+} // ns Experimental
+
+namespace Internal {
+namespace TDF {
+
+/// The functions jitted by TDataFrame receive the addresses of the objects they act on, so that their code does not
+/// depend on them and can be reused by other TDataFrames and other processes.
+using JitFunction_t = Long_t (*)(void **args);
+
+/// A call to a function jitted by TDataFrame, e.g. to book an action whose column types are only known at runtime
+struct TJitCall {
+   std::string fBody;         ///< Body of the function, refers to the objects it acts on as `args[i]`
+   std::vector<void *> fArgs; ///< Addresses of the objects the function acts on
+};
+
+std::vector<JitFunction_t> GetJitFunctions(const std::vector<std::string> &bodies);
+
+/// Number of functions returned by GetJitFunctions so far, by origin. Functions available in the process are not
+/// counted again.
+struct TJitCounts {
+   unsigned int fNLoaded = 0;      ///< Loaded from libraries found in the jit cache
+   unsigned int fNCompiled = 0;    ///< Compiled in the jit cache, then loaded
+   unsigned int fNInterpreted = 0; ///< Jitted by the interpreter
+};
+TJitCounts GetJitCounts();
+void ClearJitFunctions();
+
+} // ns TDF
+} // ns Internal
+} // ns ROOT
+
+#endif // ROOT_TDFJITCACHE
@@ -11,23 +11,37 @@
 #ifndef ROOT_TDFNODES
 #define ROOT_TDFNODES
 
+#include "RConfigure.h" // R__USE_IMT
 #include "ROOT/TypeTraits.hxx"
 #include "ROOT/TDataSource.hxx"
 #include "ROOT/TDFUtils.hxx"
+#include "ROOT/TDFJitCache.hxx"
 #include "ROOT/TArrayBranch.hxx"
 #include "ROOT/TSpinMutex.hxx"
 #include "TTreeReaderArray.h"
 #include "TTreeReaderValue.h"
 #include "TError.h"
+#ifdef R__USE_IMT
+#include "ROOT/TFuture.hxx"
+#endif
 
+#include <algorithm> // std::all_of
 #include <map>
 #include <numeric> // std::accumulate (PrintReport), std::iota (TSlotStack)
 #include <string>
 #include <tuple>
 #include <cassert>
 #include <climits>
+#include <cstring> // std::memcpy
 #include <deque> // std::vector substitute in case of vector<bool>
 #include <functional>
+#include <future>
+#include <limits>
+#include <thread>
+#include <typeinfo>
+
+class TBuffer;
+class TBufferFile;
 
 namespace ROOT {
 
@@ -35,24 +49,18 @@ namespace Internal {
 namespace TDF {
 class TActionBase;
 
-// This is an helper class to allow to pick a slot without resorting to a map
-// indexed by thread ids.
+// This is an helper class to assign a slot to each thread working on an event loop.
+// A thread keeps its slot as long as it runs at least one task of the event loop (tasks can interleave).
+// The slot of each thread is stored in the instance rather than in thread-local storage, so that a thread can
+// work on the event loops of different TDataFrames at the same time, e.g. when they run asynchronously.
 // WARNING: this class does not work as a regular stack. The size is
 // fixed at construction time and no blocking is foreseen.
 class TSlotStack {
 private:
-   unsigned int &GetCount()
-   {
-      TTHREAD_TLS(unsigned int) count = 0U;
-      return count;
-   }
-   unsigned int &GetIndex()
-   {
-      TTHREAD_TLS(unsigned int) index = UINT_MAX;
-      return index;
-   }
    unsigned int fCursor;
    std::vector<unsigned int> fBuf;
+   /// Slot of each thread currently running tasks of this event loop, and number of such tasks
+   std::map<std::thread::id, std::pair<unsigned int, unsigned int>> fThreadSlots;
    ROOT::TSpinMutex fMutex;
 
 public:
@@ -140,12 +148,32 @@ class TLoopManager : public std::enable_shared_from_this<TLoopManager> {
    unsigned int fNChildren{0};      ///< Number of nodes of the functional graph hanging from this object
    unsigned int fNStopsReceived{0}; ///< Number of times that a children node signaled to stop processing entries.
    const ELoopType fLoopType; ///< The kind of event loop that is going to be run (e.g. on ROOT files, on no files)
-   std::string fToJit;        ///< string containing all `BuildAndBook` actions that should be jitted before running
+   std::vector<TDFInternal::TJitCall> fToJit; ///< Jitted `BuildAndBook` calls of the actions, to be performed before running
    const std::unique_ptr<TDataSource> fDataSource; ///< Owning pointer to a data-source object. Null if no data-source
    ColumnNames_t fDefinedDataSourceColumns;        ///< List of data-source columns that have been `Define`d so far
    std::map<std::string, std::string> fAliasColumnNameMap; ///< ColumnNameAlias-columnName pairs
    std::vector<TCallback> fCallbacks; ///< Registered callbacks
    std::vector<TOneTimeCallback> fCallbacksOnce; ///< Registered callbacks to invoke just once before running the loop
+   /// Unnamed jitted filters, by node they hang from, columns in scope and expression. See TInterface::Filter
+   std::map<std::string, FilterBasePtr_t> fJittedFilters;
+   bool fOrderedOutput{false}; ///< Whether results of multi-thread actions must follow the order of the entries
+   /// Per slot, the range of entries processed by the current task, or by the whole event loop if sequential
+   std::vector<std::pair<ULong64_t, ULong64_t>> fTaskRanges;
+   std::shared_ptr<TDFInternal::TProfiler> fProfiler; ///< Collects the costs of the nodes. Null unless profiling
+   /// Entries [first, second) are processed by the event loop. Narrower than the whole dataset only if all the nodes
+   /// hanging from this one are ranges, see EvalEntryWindow
+   std::pair<ULong64_t, ULong64_t> fEntryWindow{0ull, std::numeric_limits<ULong64_t>::max()};
+   unsigned int fNWorkerProcesses{0}; ///< Number of processes running the event loop, 0 unless multi-process
+   /// Loop managers over the same dataset whose event loops run together with the ones of this object
+   std::vector<std::weak_ptr<TLoopManager>> fSharedLoops;
+   /// The loop managers of fSharedLoops whose nodes are run by the current event loop of this object
+   std::vector<TLoopManager *> fFusedLoops;
+#ifdef R__USE_IMT
+   std::shared_ptr<ROOT::Experimental::TTaskGroup> fAsyncTask; ///< Runs the event loop started by RunAsync, if any
+   std::shared_future<void> fAsyncDone; ///< Ready when that event loop is over, holds the exception it threw if any
+   /// Readiness flags of the results produced by that event loop, set when the loop is waited for
+   std::vector<std::shared_ptr<bool>> fAsyncResProxyReadiness;
+#endif
 
    void RunEmptySourceMT();
    void RunEmptySource();
@@ -160,6 +188,17 @@ class TLoopManager : public std::enable_shared_from_this<TLoopManager> {
    void CleanUpTask(unsigned int slot);
    void JitActions();
    void EvalChildrenCounts();
+   void EvalEntryWindow();
+   void RunEventLoop();
+   std::vector<std::shared_ptr<TLoopManager>> FuseSharedLoops();
+   std::vector<std::shared_ptr<TLoopManager>> GetSharedLoopGroup();
+   bool NeedsEventLoop() const;
+   bool HaveAllStopped() const;
+   void StopProfilingTask(unsigned int slot);
+   void CheckSameDataset(const TLoopManager &other) const;
+   void RunMultiProcess();
+   std::vector<std::pair<ULong64_t, ULong64_t>> MakeWorkerRanges() const;
+   std::string RunWorker(unsigned int worker, const std::pair<ULong64_t, ULong64_t> &range);
 
 public:
    TLoopManager(TTree *tree, const ColumnNames_t &defaultBranches);
@@ -167,8 +206,16 @@ public:
    TLoopManager(std::unique_ptr<TDataSource> ds, const ColumnNames_t &defaultBranches);
    TLoopManager(const TLoopManager &) = delete;
    TLoopManager &operator=(const TLoopManager &) = delete;
+   ~TLoopManager();
 
    void Run();
+#ifdef R__USE_IMT
+   ROOT::Experimental::TFuture<void> RunAsync();
+#endif
+   bool WaitAsyncRun();
+   void ShareEventLoop(TLoopManager &other);
+   void EnableMultiProcess(unsigned int nWorkers);
+   void DisableMultiProcess();
    TLoopManager *GetImplPtr();
    std::shared_ptr<TLoopManager> GetSharedPtr() { return shared_from_this(); }
    const ColumnNames_t &GetDefaultColumnNames() const;
@@ -186,19 +233,44 @@ public:
    void Book(const RangeBasePtr_t &rangePtr);
    bool CheckFilters(int, unsigned int);
    unsigned int GetNSlots() const { return fNSlots; }
+   bool IsMultiThreaded() const
+   {
+      return fLoopType == ELoopType::kROOTFilesMT || fLoopType == ELoopType::kNoFilesMT ||
+             fLoopType == ELoopType::kDataSourceMT;
+   }
    bool MustRunNamedFilters() const { return fMustRunNamedFilters; }
    void Report() const;
    /// End of recursive chain of calls, does nothing
    void PartialReport() const {}
+   /// End of recursive chain of calls: the input dataset is fingerprinted separately, see TInterface::Cache
+   bool AppendFingerprint(std::string &) const { return true; }
    void SetTree(const std::shared_ptr<TTree> &tree) { fTree = tree; }
    void IncrChildrenCount() { ++fNChildren; }
    void StopProcessing() { ++fNStopsReceived; }
-   void Jit(const std::string &s) { fToJit.append(s); }
+   void Jit(const std::string &body, const std::vector<void *> &args = {})
+   {
+      WaitAsyncRun();
+      fToJit.push_back({body, args});
+   }
    const ColumnNames_t &GetDefinedDataSourceColumns() const { return fDefinedDataSourceColumns; }
    void AddDataSourceColumn(std::string_view name) { fDefinedDataSourceColumns.emplace_back(name); }
    void AddColumnAlias(const std::string &alias, const std::string &colName) { fAliasColumnNameMap[alias] = colName; }
    const std::map<std::string, std::string> &GetAliasMap() const { return fAliasColumnNameMap; }
    void RegisterCallback(ULong64_t everyNEvents, std::function<void(unsigned int)> &&f);
+   FilterBasePtr_t GetJittedFilter(const std::string &key) const;
+   void AddJittedFilter(const std::string &key, const FilterBasePtr_t &filter) { fJittedFilters[key] = filter; }
+   void SetOrderedOutput(bool ordered)
+   {
+      WaitAsyncRun();
+      fOrderedOutput = ordered;
+   }
+   bool HasOrderedOutput() const;
+   /// Return the range of entries processed by the task currently running on `slot`
+   const std::pair<ULong64_t, ULong64_t> &GetTaskRange(unsigned int slot) const { return fTaskRanges[slot]; }
+   const std::pair<ULong64_t, ULong64_t> &GetEntryWindow() const { return fEntryWindow; }
+   ULong64_t GetMaxBatchSize() const;
+   std::shared_ptr<TDFInternal::TProfiler> EnableProfiling();
+   TDFInternal::TProfiler *GetProfiler() const { return fProfiler.get(); }
 };
 } // end ns TDF
 } // end ns Detail
@@ -207,6 +279,66 @@ namespace Internal {
 namespace TDF {
 using namespace ROOT::Detail::TDF;
 
+/**
+\class ROOT::Internal::TDF::TBulkBranchReader
+\ingroup dataframe
+\brief Reads the values of a TTree branch of fundamental type one basket at a time
+
+Values are read via TBranch::GetBulkEntries, which copies all entries of a basket, already converted to the
+in-memory byte order, in a contiguous buffer. Accessing the value of an entry of that basket then only costs an
+array access, rather than a call to TBranch::GetEntry through the TTreeReader machinery.
+Entry numbers are the ones of the TTreeReader driving the event loop, i.e. global entry numbers in case of a TChain.
+The trees of a chain might store the branch differently: every new tree is checked again, and the entries of the
+trees that cannot be read in bulk must be read otherwise, see LoadEntry.
+**/
+class TBulkBranchReader {
+   TTreeReader *fReader;                 ///< The reader driving the event loop. Used to retrieve the current TTree
+   const std::string fBranchName;        ///< Name of the branch, used to look it up again when the current TTree changes
+   const std::type_info &fType;          ///< Type of the values, checked against the branch of every new tree
+   Int_t fCheckedTreeNumber = -1;        ///< Number in the chain of the last tree checked by LoadBasket
+   bool fCanReadCheckedTree = false;     ///< Whether that tree stores the branch in a way that can be read in bulk
+   std::unique_ptr<TBufferFile> fBuffer; ///< Holds the values of entries [fFirstEntry, fFirstEntry + fNEntries)
+   char *fValues = nullptr;              ///< Start of the values in fBuffer
+   Long64_t fFirstEntry = -1;            ///< Entry number of the first value stored in fBuffer
+   Long64_t fNEntries = 0;               ///< Number of values stored in fBuffer
+   /// Copy of the value returned by the last call to Get. Unlike the values in fBuffer, which move at every basket,
+   /// its address is stable during the whole event loop, like the one of the value of a TTreeReaderValue.
+   alignas(8) char fValue[8];
+
+   bool LoadBasket(Long64_t entry);
+   static bool CanRead(TTree &tree, const std::string &branchName, const std::type_info &type);
+
+public:
+   TBulkBranchReader(TTreeReader &r, const std::string &branchName, const std::type_info &type);
+   ~TBulkBranchReader();
+   static bool CanRead(TTreeReader &r, const std::string &branchName, const std::type_info &type);
+
+   /// Make the value of `entry` available to Get and GetBatch, loading its basket if needed. Return false if the
+   /// current tree of the chain does not store the branch in a way that can be read in bulk.
+   bool LoadEntry(Long64_t entry)
+   {
+      return (entry >= fFirstEntry && entry < fFirstEntry + fNEntries) || LoadBasket(entry);
+   }
+
+   /// Return the value of `entry`, which must have been made available by LoadEntry
+   template <typename T>
+   T &Get(Long64_t entry)
+   {
+      static_assert(sizeof(T) <= sizeof(fValue), "TBulkBranchReader only reads values of fundamental type");
+      std::memcpy(fValue, fValues + (entry - fFirstEntry) * sizeof(T), sizeof(T));
+      return *reinterpret_cast<T *>(fValue);
+   }
+
+   /// Return a pointer to the value of `entry`, which must have been made available by LoadEntry, followed by the
+   /// values of the next entries of its basket. `n` is lowered to the number of values available, if smaller.
+   template <typename T>
+   T *GetBatch(Long64_t entry, Long64_t &n)
+   {
+      n = std::min(n, fFirstEntry + fNEntries - entry);
+      return reinterpret_cast<T *>(fValues) + (entry - fFirstEntry);
+   }
+};
+
 /**
 \class ROOT::Internal::TDF::TColumnValue
 \ingroup dataframe
@@ -237,7 +369,7 @@ class TColumnValue {
 
    /// TColumnValue has a slightly different behaviour whether the column comes from a TTreeReader, a TDataFrame Define
    /// or a TDataSource. It stores which it is as an enum.
-   enum class EColumnKind { kTreeValue, kTreeArray, kCustomColumn, kDataSource, kInvalid };
+   enum class EColumnKind { kTreeValue, kTreeArray, kTreeBulk, kCustomColumn, kDataSource, kInvalid };
    // Set to the correct value by MakeProxy or SetTmpColumn
    EColumnKind fColumnKind = EColumnKind::kInvalid;
    /// The slot this value belongs to. Only needed when querying custom column values, it is set in `SetTmpColumn`.
@@ -251,6 +383,10 @@ class TColumnValue {
    std::vector<std::unique_ptr<TTreeReaderValue<T>>> fReaderValues;
    /// Owning ptrs to a TTreeReaderArray. Used for non-temporary columns when T == TArrayBranch<U>.
    std::vector<std::unique_ptr<TTreeReaderArray<ProxyParam_t>>> fReaderArrays;
+   /// Owning ptrs to a TBulkBranchReader. Used instead of TTreeReaderValues for branches of fundamental type.
+   /// In case of a TChain, a TTreeReaderValue is also pushed to fReaderValues (a null one otherwise): it reads the
+   /// entries of the trees of the chain that do not store the branch in a way that can be read in bulk.
+   std::vector<std::unique_ptr<TBulkBranchReader>> fBulkReaders;
    /// Non-owning ptrs to the value of a custom column.
    std::vector<T *> fCustomValuePtrs;
    /// Non-owning ptrs to the value of a data-source column.
@@ -260,6 +396,9 @@ class TColumnValue {
    /// Signal whether we ever checked that the branch we are reading with a TTreeReaderArray stores array elements
    /// in contiguous memory. Only used when T == TArrayBranch<U>.
    bool fArrayHasBeenChecked = false;
+   /// Non-null if reads of this column are being profiled. Only set for columns read from a TTree.
+   TProfiler *fProfiler = nullptr;
+   unsigned int fProfileId = 0;
 
 public:
    TColumnValue() = default;
@@ -269,7 +408,12 @@ public:
    void MakeProxy(TTreeReader *r, const std::string &bn)
    {
       constexpr bool useReaderValue = std::is_same<ProxyParam_t, T>::value;
-      if (useReaderValue) {
+      if (useReaderValue && std::is_arithmetic<T>::value && TBulkBranchReader::CanRead(*r, bn, typeid(T))) {
+         fColumnKind = EColumnKind::kTreeBulk;
+         fBulkReaders.emplace_back(new TBulkBranchReader(*r, bn, typeid(T)));
+         const bool isChain = r->GetTree()->GetTree() != r->GetTree();
+         fReaderValues.emplace_back(isChain ? new TTreeReaderValue<T>(*r, bn.c_str()) : nullptr);
+      } else if (useReaderValue) {
          fColumnKind = EColumnKind::kTreeValue;
          fReaderValues.emplace_back(new TTreeReaderValue<T>(*r, bn.c_str()));
       } else {
@@ -278,6 +422,17 @@ public:
       }
    }
 
+   /// Account the reads of this column to the profiler, if it is a column of a TTree
+   void SetProfiler(unsigned int slot, TProfiler *profiler, const std::string &bn)
+   {
+      if (fColumnKind != EColumnKind::kTreeValue && fColumnKind != EColumnKind::kTreeArray &&
+          fColumnKind != EColumnKind::kTreeBulk)
+         return;
+      fSlot = slot;
+      fProfiler = profiler;
+      fProfileId = GetColumnProfileId(*profiler, bn);
+   }
+
    template <typename U = T,
              typename std::enable_if<std::is_same<typename TColumnValue<U>::ProxyParam_t, U>::value, int>::type = 0>
    T &Get(Long64_t entry);
@@ -285,6 +440,7 @@ public:
    template <typename U = T, typename std::enable_if<!std::is_same<ProxyParam_t, U>::value, int>::type = 0>
    TArrayBranch<ProxyParam_t> Get(Long64_t)
    {
+      TProfileScope scope(fProfiler, fSlot, fProfileId);
       auto &readerArray = *fReaderArrays.back();
       // We only use TTreeReaderArrays to read columns that users flagged as type `TArrayBranch`, so we need to check
       // that the branch stores the array as contiguous memory that we can actually wrap in an `TArrayBranch`.
@@ -307,11 +463,46 @@ public:
       return TArrayBranch<ProxyParam_t>(readerArray);
    }
 
+   /// Only columns of fundamental type are read in bulk: the overload for the other types is never called.
+   T &GetBulk(Long64_t entry, std::true_type)
+   {
+      auto &bulkReader = *fBulkReaders.back();
+      if (bulkReader.LoadEntry(entry))
+         return bulkReader.template Get<T>(entry);
+      auto &readerValue = fReaderValues.back();
+      if (!readerValue)
+         throw std::runtime_error("TColumnValue: the current tree cannot be read in bulk");
+      return *readerValue->Get();
+   }
+   T &GetBulk(Long64_t, std::false_type)
+   {
+      throw std::runtime_error("TColumnValue: bulk read of a column of non-fundamental type");
+   }
+
+   /// Whether the values of this column are read in bulk, one basket at a time, by a TBulkBranchReader
+   bool IsBulk() const { return fColumnKind == EColumnKind::kTreeBulk; }
+
+   /// Return a pointer to the contiguous values of `entry` and of the following entries. Only valid for bulk columns.
+   /// `n` is lowered to the number of values available, if smaller, and to 0 if the current tree of the chain cannot
+   /// be read in bulk.
+   T *GetBatch(Long64_t entry, Long64_t &n)
+   {
+      auto &bulkReader = *fBulkReaders.back();
+      if (bulkReader.LoadEntry(entry))
+         return bulkReader.template GetBatch<T>(entry, n);
+      n = 0;
+      return nullptr;
+   }
+
    void Reset()
    {
       switch (fColumnKind) {
       case EColumnKind::kTreeValue: fReaderValues.pop_back(); break;
       case EColumnKind::kTreeArray: fReaderArrays.pop_back(); break;
+      case EColumnKind::kTreeBulk:
+         fBulkReaders.pop_back();
+         fReaderValues.pop_back();
+         break;
       case EColumnKind::kCustomColumn:
          fCustomColumns.pop_back();
          fCustomValuePtrs.pop_back();
@@ -352,6 +543,8 @@ protected:
                                /// graph. It is only guaranteed to contain a valid address during an
                                /// event loop.
    const unsigned int fNSlots; ///< Number of thread slots used by this node.
+   TProfiler *fProfiler = nullptr; ///< Non-null if the event loop is being profiled
+   unsigned int fProfileId = 0;
 
 public:
    TActionBase(TLoopManager *implPtr, const unsigned int nSlots);
@@ -363,7 +556,20 @@ public:
    virtual void InitSlot(TTreeReader *r, unsigned int slot) = 0;
    virtual void TriggerChildrenCount() = 0;
    virtual void ClearValueReaders(unsigned int slot) = 0;
+   virtual void FinalizeTask(unsigned int slot) = 0;
+   /// Whether the action can be run by the worker processes of a multi-process event loop
+   virtual bool CanRunInWorkers() const = 0;
+   /// Prepare the action to run in worker process number `worker`. Called in the worker process.
+   virtual void InitWorker(unsigned int worker) = 0;
+   /// Write the partial result of the entries processed by this worker process. Called in the worker process.
+   virtual void WriteWorkerResult(TBuffer &buf) = 0;
+   /// Merge the partial result of a worker process, as written by WriteWorkerResult, in the parent process. Partial
+   /// results are merged in the order of the entries processed by the workers, before the action is finalized.
+   virtual void MergeWorkerResult(TBuffer &buf) = 0;
+   /// Return the name under which this action appears in profiling reports
+   virtual std::string GetProfileName() const = 0;
    unsigned int GetNSlots() const { return fNSlots; }
+   void InitNode();
    /// This method is invoked to update a partial result during the event loop, right before passing the result to a
    /// user-defined callback registered via TResultProxy::RegisterCallback
    virtual void *PartialUpdate(unsigned int slot) = 0;
@@ -392,15 +598,19 @@ public:
    void InitSlot(TTreeReader *r, unsigned int slot) final
    {
       InitTDFValues(slot, fValues[slot], r, fBranches, fImplPtr->GetCustomColumnNames(), fImplPtr->GetBookedColumns(),
-                    TypeInd_t());
+                    fImplPtr->GetProfiler(), TypeInd_t());
       fHelper.InitSlot(r, slot);
+      if (fImplPtr->HasOrderedOutput())
+         InitTaskImpl(slot, fImplPtr->GetTaskRange(slot));
    }
 
    void Run(unsigned int slot, Long64_t entry) final
    {
       // check if entry passes all filters
-      if (fPrevData.CheckFilters(slot, entry))
+      if (fPrevData.CheckFilters(slot, entry)) {
+         TProfileScope scope(fProfiler, slot, fProfileId);
          Exec(slot, entry, TypeInd_t());
+      }
    }
 
    template <int... S>
@@ -414,11 +624,25 @@ public:
 
    virtual void ClearValueReaders(unsigned int slot) final { ResetTDFValueTuple(fValues[slot], TypeInd_t()); }
 
+   std::string GetProfileName() const final { return GetActionProfileName(typeid(Helper), fBranches); }
+
+   /// This method is invoked at the end of each task. Helpers that produce results in entry order are notified
+   void FinalizeTask(unsigned int slot) final
+   {
+      if (fImplPtr->HasOrderedOutput())
+         FinalizeTaskImpl(slot);
+   }
+
    /// This method is invoked to update a partial result during the event loop, right before passing the result to a
    /// user-defined callback registered via TResultProxy::RegisterCallback
    /// TODO the PartialUpdateImpl trick can go away once all action helpers will implement PartialUpdate
    void *PartialUpdate(unsigned int slot) final { return PartialUpdateImpl(slot); }
 
+   bool CanRunInWorkers() const final { return CanRunInWorkersImpl(0); }
+   void InitWorker(unsigned int worker) final { InitWorkerImpl(worker); }
+   void WriteWorkerResult(TBuffer &buf) final { WriteWorkerResultImpl(buf, 0); }
+   void MergeWorkerResult(TBuffer &buf) final { MergeWorkerResultImpl(buf, 0); }
+
 private:
    // this overload is SFINAE'd out if Helper does not implement `PartialUpdate`
    // the template parameter is required to defer instantiation of the method to SFINAE time
@@ -431,6 +655,60 @@ private:
    void *PartialUpdateImpl(...) {
       throw std::runtime_error("This action does not support callbacks yet!");
    }
+
+   // these overloads are SFINAE'd out if Helper does not implement `InitTask` and `FinalizeTask`, i.e. if the
+   // results of the action do not depend on the order in which entries are processed
+   template <typename H = Helper>
+   auto InitTaskImpl(unsigned int slot, const std::pair<ULong64_t, ULong64_t> &range)
+      -> decltype(std::declval<H>().InitTask(slot, range.first, range.second), void())
+   {
+      fHelper.InitTask(slot, range.first, range.second);
+   }
+   void InitTaskImpl(...) {}
+
+   template <typename H = Helper>
+   auto FinalizeTaskImpl(unsigned int slot) -> decltype(std::declval<H>().FinalizeTask(slot), void())
+   {
+      fHelper.FinalizeTask(slot);
+   }
+   void FinalizeTaskImpl(...) {}
+
+   // these overloads are SFINAE'd out if Helper cannot send its partial results from worker processes to the parent
+   // process, i.e. if it does not implement `WriteMPResult` and `MergeMPResult`. `InitMPWorker` is optional.
+   template <typename H = Helper>
+   static constexpr auto CanRunInWorkersImpl(int)
+      -> decltype(std::declval<H>().MergeMPResult(std::declval<TBuffer &>()), bool())
+   {
+      return true;
+   }
+   static constexpr bool CanRunInWorkersImpl(...) { return false; }
+
+   template <typename H = Helper>
+   auto InitWorkerImpl(unsigned int worker) -> decltype(std::declval<H>().InitMPWorker(worker), void())
+   {
+      fHelper.InitMPWorker(worker);
+   }
+   void InitWorkerImpl(...) {}
+
+   template <typename H = Helper>
+   auto WriteWorkerResultImpl(TBuffer &buf, int) -> decltype(std::declval<H>().WriteMPResult(buf), void())
+   {
+      fHelper.WriteMPResult(buf);
+   }
+   void WriteWorkerResultImpl(TBuffer &, ...)
+   {
+      throw std::runtime_error("This action cannot run in worker processes!");
+   }
+
+   template <typename H = Helper>
+   auto MergeWorkerResultImpl(TBuffer &buf, int) -> decltype(std::declval<H>().MergeMPResult(buf), void())
+   {
+      fHelper.MergeMPResult(buf);
+   }
+   void MergeWorkerResultImpl(TBuffer &, ...)
+   {
+      throw std::runtime_error("This action cannot run in worker processes!");
+   }
 };
 
 } // end NS TDF
@@ -448,7 +726,10 @@ protected:
    unsigned int fNStopsReceived{0}; ///< number of times that a children node signaled to stop processing entries.
    const unsigned int fNSlots;      ///< number of thread slots used by this node, inherited from parent node.
    const bool fIsDataSourceColumn; ///< does the custom column refer to a data-source column? (or a user-define column?)
+   std::string fJittedExpression;  ///< The expression of a column defined by a string, empty otherwise
    std::vector<Long64_t> fLastCheckedEntry;
+   TDFInternal::TProfiler *fProfiler = nullptr; ///< Non-null if the event loop is being profiled
+   unsigned int fProfileId = 0;
 
 public:
    TCustomColumnBase(TLoopManager *df, std::string_view name, const unsigned int nSlots, const bool isDSColumn);
@@ -464,6 +745,8 @@ public:
    virtual void ClearValueReaders(unsigned int slot) = 0;
    unsigned int GetNSlots() const { return fNSlots; }
    bool IsDataSourceColumn() const { return fIsDataSourceColumn; }
+   void SetJittedExpression(std::string_view expression) { fJittedExpression = std::string(expression); }
+   bool AppendFingerprint(std::string &fingerprint) const;
    void InitNode();
 };
 
@@ -515,7 +798,7 @@ public:
    void InitSlot(TTreeReader *r, unsigned int slot) final
    {
       TDFInternal::InitTDFValues(slot, fValues[slot], r, fBranches, fImplPtr->GetCustomColumnNames(),
-                                 fImplPtr->GetBookedColumns(), TypeInd_t());
+                                 fImplPtr->GetBookedColumns(), fImplPtr->GetProfiler(), TypeInd_t());
    }
 
    void *GetValuePtr(unsigned int slot) final { return static_cast<void *>(&fLastResults[slot]); }
@@ -523,6 +806,7 @@ public:
    void Update(unsigned int slot, Long64_t entry) final
    {
       if (entry != fLastCheckedEntry[slot]) {
+         TDFInternal::TProfileScope scope(fProfiler, slot, fProfileId);
          // evaluate this filter, cache the result
          UpdateHelper(slot, entry, TypeInd_t(), BranchTypes_t(), (UPDATE_HELPER_TYPE *)nullptr);
          fLastCheckedEntry[slot] = entry;
@@ -576,9 +860,14 @@ protected:
    std::vector<ULong64_t> fAccepted = {0};
    std::vector<ULong64_t> fRejected = {0};
    const std::string fName;
+   std::string fJittedExpression;   ///< The expression of a filter defined by a string, empty otherwise
    unsigned int fNChildren{0};      ///< Number of nodes of the functional graph hanging from this object
    unsigned int fNStopsReceived{0}; ///< Number of times that a children node signaled to stop processing entries.
    const unsigned int fNSlots;      ///< Number of thread slots used by this node, inherited from parent node.
+   TDFInternal::TProfiler *fProfiler = nullptr; ///< Non-null if the event loop is being profiled
+   unsigned int fProfileId = 0;
+
+   bool AppendNodeFingerprint(std::string &fingerprint) const;
 
 public:
    TFilterBase(TLoopManager *df, std::string_view name, const unsigned int nSlots);
@@ -609,6 +898,11 @@ public:
       std::fill(fRejected.begin(), fRejected.end(), 0);
    }
    virtual void ClearValueReaders(unsigned int slot) = 0;
+   virtual const ColumnNames_t &GetColumnNames() const = 0;
+   void SetJittedExpression(std::string_view expression) { fJittedExpression = std::string(expression); }
+   /// Append a description of this filter and of the filters and ranges upstream of it to `fingerprint`.
+   /// Return false if they cannot be described, e.g. because they are compiled callables.
+   virtual bool AppendFingerprint(std::string &fingerprint) const = 0;
    void InitNode();
 };
 
@@ -617,15 +911,24 @@ class TFilter final : public TFilterBase {
    using BranchTypes_t = typename CallableTraits<FilterF>::arg_types;
    using TypeInd_t = TDFInternal::GenStaticSeq_t<BranchTypes_t::list_size>;
 
+   /// Filters that hang directly from the TLoopManager and only read columns of fundamental type can be evaluated on
+   /// batches of consecutive entries, when all their columns are read in bulk
+   using CanBatch_t = std::integral_constant<bool, std::is_same<PrevDataFrame, TLoopManager>::value &&
+                                                      (BranchTypes_t::list_size > 0) &&
+                                                      TDFInternal::TAreArithmetic<BranchTypes_t>::value>;
+
    FilterF fFilter;
    const ColumnNames_t fBranches;
    PrevDataFrame &fPrevData;
    std::vector<TDFInternal::TDFValueTuple_t<BranchTypes_t>> fValues;
+   std::vector<int> fUseBatches;                    ///< Whether, per slot, all columns are currently read in bulk
+   std::vector<Long64_t> fBatchFirstEntry;          ///< Per slot, first entry of the batch stored in fBatchResults
+   std::vector<std::vector<char>> fBatchResults;    ///< Per slot, filter results for a batch of consecutive entries
 
 public:
    TFilter(FilterF &&f, const ColumnNames_t &bl, PrevDataFrame &pd, std::string_view name = "")
       : TFilterBase(pd.GetImplPtr(), name, pd.GetNSlots()), fFilter(std::move(f)), fBranches(bl), fPrevData(pd),
-        fValues(fNSlots)
+        fValues(fNSlots), fUseBatches(fNSlots, 0), fBatchFirstEntry(fNSlots, -1), fBatchResults(fNSlots)
    {
    }
 
@@ -640,7 +943,8 @@ public:
             fLastResult[slot] = false;
          } else {
             // evaluate this filter, cache the result
-            auto passed = CheckFilterHelper(slot, entry, TypeInd_t());
+            TDFInternal::TProfileScope scope(fProfiler, slot, fProfileId);
+            auto passed = EvalFilter(slot, entry, CanBatch_t());
             passed ? ++fAccepted[slot] : ++fRejected[slot];
             fLastResult[slot] = passed;
          }
@@ -658,10 +962,66 @@ public:
       (void)entry;
    }
 
+   bool EvalFilter(unsigned int slot, Long64_t entry, std::false_type /*canBatch*/)
+   {
+      return CheckFilterHelper(slot, entry, TypeInd_t());
+   }
+
+   /// Return the result of the filter for `entry`. If possible, rather than invoking the filter on this entry only,
+   /// evaluate it on all consecutive entries for which the values of all columns are available in contiguous memory
+   /// and cache the results. This tight loop over plain arrays can be auto-vectorized by the compiler.
+   /// Evaluating the filter on entries that are not processed yet is safe because nothing is upstream of this filter:
+   /// all entries that are read will be checked against it. Batches never extend past the entries of the current task
+   /// (or of the whole event loop, if sequential) nor past the window of entries processed, so that each entry is
+   /// evaluated once, by the task that owns it. Batches are also never longer than the number of entries that the
+   /// ranges of a sequential event loop can still let through, so that a filter upstream of a Range is not invoked on
+   /// entries after the end of the range.
+   bool EvalFilter(unsigned int slot, Long64_t entry, std::true_type /*canBatch*/)
+   {
+      if (!fUseBatches[slot])
+         return CheckFilterHelper(slot, entry, TypeInd_t());
+      auto &results = fBatchResults[slot];
+      if (entry < fBatchFirstEntry[slot] || entry >= fBatchFirstEntry[slot] + Long64_t(results.size()))
+         EvalBatch(slot, entry, TypeInd_t());
+      return results[entry - fBatchFirstEntry[slot]];
+   }
+
+   template <int... S>
+   void EvalBatch(unsigned int slot, Long64_t entry, TDFInternal::StaticSeq<S...>)
+   {
+      auto &values = fValues[slot];
+      const auto end = std::min(fImplPtr->GetTaskRange(slot).second, fImplPtr->GetEntryWindow().second);
+      const auto maxN = ULong64_t(std::numeric_limits<Long64_t>::max());
+      const auto maxBatchSize = std::min(maxN, fImplPtr->GetMaxBatchSize());
+      Long64_t n = end - entry < maxBatchSize ? Long64_t(end - entry) : Long64_t(maxBatchSize);
+      const auto valuePtrs = std::make_tuple(std::get<S>(values).GetBatch(entry, n)...);
+      auto &results = fBatchResults[slot];
+      fBatchFirstEntry[slot] = entry;
+      if (n == 0) {
+         // the current tree of the chain cannot be read in bulk: evaluate this entry only
+         results.assign(1, CheckFilterHelper(slot, entry, TDFInternal::StaticSeq<S...>()));
+         return;
+      }
+      results.resize(n);
+      for (Long64_t i = 0; i < n; ++i)
+         results[i] = fFilter(std::get<S>(valuePtrs)[i]...);
+   }
+
+   template <int... S>
+   bool AreBulkColumns(unsigned int slot, TDFInternal::StaticSeq<S...>)
+   {
+      std::initializer_list<bool> isBulk{std::get<S>(fValues[slot]).IsBulk()...};
+      return std::all_of(isBulk.begin(), isBulk.end(), [](bool b) { return b; });
+      (void)slot; // silence "unused parameter" warnings in gcc
+   }
+
    void InitSlot(TTreeReader *r, unsigned int slot) final
    {
       TDFInternal::InitTDFValues(slot, fValues[slot], r, fBranches, fImplPtr->GetCustomColumnNames(),
-                                 fImplPtr->GetBookedColumns(), TypeInd_t());
+                                 fImplPtr->GetBookedColumns(), fImplPtr->GetProfiler(), TypeInd_t());
+      fUseBatches[slot] = CanBatch_t::value && AreBulkColumns(slot, TypeInd_t());
+      fBatchFirstEntry[slot] = -1;
+      fBatchResults[slot].clear();
    }
 
    // recursive chain of `Report`s
@@ -695,6 +1055,14 @@ public:
    }
 
    virtual void ClearValueReaders(unsigned int slot) final { ResetTDFValueTuple(fValues[slot], TypeInd_t()); }
+
+   const ColumnNames_t &GetColumnNames() const final { return fBranches; }
+
+   // recursive chain of `AppendFingerprint`s
+   bool AppendFingerprint(std::string &fingerprint) const final
+   {
+      return fPrevData.AppendFingerprint(fingerprint) && AppendNodeFingerprint(fingerprint);
+   }
 };
 
 class TRangeBase {
@@ -711,10 +1079,15 @@ protected:
    unsigned int fNStopsReceived{0}; ///< Number of times that a children node signaled to stop processing entries.
    bool fHasStopped{false};         ///< True if the end of the range has been reached
    const unsigned int fNSlots;      ///< Number of thread slots used by this node, inherited from parent node.
+   /// True if entries are selected according to their entry number rather than to the number of entries that reached
+   /// this node so far. Used in multi-thread event loops, where entries are not processed in order.
+   const bool fByEntryNumber;
+
+   void AppendNodeFingerprint(std::string &fingerprint) const;
 
 public:
    TRangeBase(TLoopManager *implPtr, unsigned int start, unsigned int stop, unsigned int stride,
-              const unsigned int nSlots);
+              const unsigned int nSlots, bool byEntryNumber);
    TRangeBase &operator=(const TRangeBase &) = delete;
    virtual ~TRangeBase() = default;
 
@@ -730,6 +1103,13 @@ public:
       fNStopsReceived = 0;
    }
    unsigned int GetNSlots() const { return fNSlots; }
+   bool SelectsByEntryNumber() const { return fByEntryNumber; }
+   bool HasChildren() const { return fNChildren > 0; }
+   std::pair<ULong64_t, ULong64_t> GetEntryWindow() const;
+   ULong64_t GetNRemainingEntries() const;
+   /// Append a description of this range and of the filters and ranges upstream of it to `fingerprint`.
+   /// Return false if they cannot be described, e.g. because they are compiled callables.
+   virtual bool AppendFingerprint(std::string &fingerprint) const = 0;
 };
 
 template <typename PrevData>
@@ -738,7 +1118,9 @@ class TRange final : public TRangeBase {
 
 public:
    TRange(unsigned int start, unsigned int stop, unsigned int stride, PrevData &pd)
-      : TRangeBase(pd.GetImplPtr(), start, stop, stride, pd.GetNSlots()), fPrevData(pd)
+      : TRangeBase(pd.GetImplPtr(), start, stop, stride, pd.GetNSlots(),
+                   std::is_same<PrevData, TLoopManager>::value && pd.GetImplPtr()->IsMultiThreaded()),
+        fPrevData(pd)
    {
    }
 
@@ -748,6 +1130,12 @@ public:
    /// Ranges act as filters when it comes to selecting entries that downstream nodes should process
    bool CheckFilters(unsigned int slot, Long64_t entry) final
    {
+      if (fByEntryNumber) {
+         // all entries reach this node, in no particular order: in a sequential event loop the number of entries
+         // processed so far would be the entry number plus one. No state is kept, so there is no need to synchronise.
+         const ULong64_t n = entry + 1;
+         return n > fStart && (fStop == 0 || n <= fStop) && (fStride == 1 || n % fStride == 0);
+      }
       if (fHasStopped) {
          return false;
       } else if (entry != fLastCheckedEntry) {
@@ -792,6 +1180,15 @@ public:
       if (fNChildren == 1)
          fPrevData.IncrChildrenCount();
    }
+
+   // recursive chain of `AppendFingerprint`s
+   bool AppendFingerprint(std::string &fingerprint) const final
+   {
+      if (!fPrevData.AppendFingerprint(fingerprint))
+         return false;
+      AppendNodeFingerprint(fingerprint);
+      return true;
+   }
 };
 
 } // namespace TDF
@@ -830,7 +1227,11 @@ template <typename U,
 T &TColumnValue<T>::Get(Long64_t entry)
 {
    if (fColumnKind == EColumnKind::kTreeValue) {
+      TProfileScope scope(fProfiler, fSlot, fProfileId);
       return *(fReaderValues.back()->Get());
+   } else if (fColumnKind == EColumnKind::kTreeBulk) {
+      TProfileScope scope(fProfiler, fSlot, fProfileId);
+      return GetBulk(entry, std::is_arithmetic<T>());
    } else {
       fCustomColumns.back()->Update(fSlot, entry);
       return fColumnKind == EColumnKind::kCustomColumn ? *fCustomValuePtrs.back() : **fDSValuePtrs.back();
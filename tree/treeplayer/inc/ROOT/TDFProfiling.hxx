@@ -0,0 +1,188 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2017, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#ifndef ROOT_TDFPROFILING
+#define ROOT_TDFPROFILING
+
+#include "RtypesCore.h"
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+class TVirtualPerfStats;
+
+namespace ROOT {
+namespace Experimental {
+namespace TDF {
+
+/**
+\class ROOT::Experimental::TDF::TProfileReport
+\ingroup dataframe
+\brief The cost of each node of a functional graph during one event loop, as returned by TInterface::ProfileReport
+
+Each record describes a node: a TTree or data-source column, a Define, a Filter or an action. Times are exclusive:
+the time spent evaluating a filter does not include the time spent reading or computing the columns it needs,
+which is accounted to those columns instead. Bytes read from files and decompression times are accounted to the
+node whose evaluation triggered the read, i.e. typically to the column being read. When a TTreeCache is in use,
+a read fills the cache for all cached branches at once: the bytes are accounted to the column that caused the fill.
+
+The `(event loop)` record collects the time spent outside of all nodes, e.g. advancing the readers to the next
+entry, and the I/O that happened meanwhile. Per-slot records allow to assess how evenly the work was distributed
+among threads.
+**/
+class TProfileReport {
+public:
+   enum class ENodeKind { kEventLoop, kColumn, kDefine, kFilter, kAction };
+
+   struct TNodeRecord {
+      std::string fName;
+      ENodeKind fKind = ENodeKind::kEventLoop;
+      ULong64_t fCalls = 0;            ///< Number of evaluations, summed over all slots
+      double fTime = 0.;               ///< Exclusive wall time in seconds, summed over all slots
+      Long64_t fBytesRead = 0;         ///< Bytes read from files while evaluating this node
+      double fReadTime = 0.;           ///< Wall time in seconds spent waiting for those reads
+      double fUnzipTime = 0.;          ///< Wall time in seconds spent decompressing baskets for this node
+      std::vector<double> fSlotTimes;  ///< Exclusive wall time in seconds, per slot
+   };
+
+   struct TSlotRecord {
+      ULong64_t fEntries = 0; ///< Number of entries processed by the slot
+      unsigned int fTasks = 0; ///< Number of tasks (or ranges of entries) processed by the slot
+      double fBusyTime = 0.;   ///< Wall time in seconds spent processing those tasks
+   };
+
+private:
+   std::vector<TNodeRecord> fNodes;
+   std::vector<TSlotRecord> fSlots;
+   double fWallTime = 0.;
+
+public:
+   TProfileReport() = default;
+   TProfileReport(std::vector<TNodeRecord> &&nodes, std::vector<TSlotRecord> &&slots, double wallTime);
+
+   const std::vector<TNodeRecord> &GetNodes() const { return fNodes; }
+   const TNodeRecord *GetNode(const std::string &name) const;
+   const std::vector<TSlotRecord> &GetSlots() const { return fSlots; }
+   double GetWallTime() const { return fWallTime; }
+   double GetImbalance() const;
+   void Print() const;
+   void Print(std::ostream &os) const;
+   std::string AsJSON() const;
+};
+
+} // ns TDF
+} // ns Experimental
+
+namespace Internal {
+namespace TDF {
+
+/**
+\class ROOT::Internal::TDF::TProfiler
+\ingroup dataframe
+\brief Collects the per-node costs of an event loop, see TInterface::ProfileReport
+
+Nodes register once per event loop and receive an id. During the event loop each slot keeps a stack of the nodes
+currently being evaluated, so that the time spent in a node can be separated from the time spent in the nodes it
+depends on. Statistics are kept per slot and only touched by the thread owning the slot, so no locking is needed
+during the event loop. File reads and decompressions are intercepted by setting, for the duration of each task, a
+per-slot TVirtualPerfStats as the thread's gPerfStats (unless the input TTree has its own).
+**/
+class TProfiler {
+public:
+   using ENodeKind = ROOT::Experimental::TDF::TProfileReport::ENodeKind;
+
+private:
+   using Clock_t = std::chrono::steady_clock;
+
+   struct TNodeStats {
+      ULong64_t fCalls = 0;
+      double fTime = 0.;
+      Long64_t fBytesRead = 0;
+      double fReadTime = 0.;
+      double fUnzipTime = 0.;
+   };
+
+   struct TFrame {
+      unsigned int fNodeId;
+      Clock_t::time_point fStart;
+      double fChildrenTime;
+   };
+
+   struct TSlotData {
+      std::vector<TNodeStats> fStats;               ///< Indexed by node id, grown on demand
+      std::vector<TFrame> fFrames;                  ///< Nodes currently being evaluated, innermost last
+      std::vector<Clock_t::time_point> fTaskStarts; ///< More than one in case of interleaved tasks
+      std::vector<TVirtualPerfStats *> fPrevPerfStats;
+      std::unique_ptr<TVirtualPerfStats> fPerfStats;
+      ULong64_t fEntries = 0;
+      unsigned int fTasks = 0;
+      double fBusyTime = 0.;
+   };
+
+   std::mutex fNodesMutex;
+   std::vector<std::pair<ENodeKind, std::string>> fNodes;              ///< Kind and name of the nodes, by id
+   std::map<std::pair<const void *, std::string>, unsigned int> fIds; ///< Ids by node address and name
+   std::vector<TSlotData> fSlots;
+   Clock_t::time_point fLoopStart;
+   double fWallTime = 0.;
+
+   TNodeStats &GetStats(unsigned int slot, unsigned int id)
+   {
+      auto &stats = fSlots[slot].fStats;
+      if (id >= stats.size())
+         stats.resize(id + 1);
+      return stats[id];
+   }
+
+public:
+   TProfiler(unsigned int nSlots);
+   TProfiler(const TProfiler &) = delete;
+   TProfiler &operator=(const TProfiler &) = delete;
+   ~TProfiler();
+
+   unsigned int GetNodeId(const void *node, ENodeKind kind, const std::string &name);
+   static std::string GetActionName(const std::type_info &helperType, const std::vector<std::string> &columns);
+   void StartLoop();
+   void StopLoop();
+   void StartTask(unsigned int slot);
+   void StopTask(unsigned int slot);
+   void CountEntry(unsigned int slot) { ++fSlots[slot].fEntries; }
+   void AddRead(unsigned int slot, Long64_t bytes, double time);
+   void AddUnzip(unsigned int slot, double time);
+   ROOT::Experimental::TDF::TProfileReport MakeReport() const;
+
+   void Start(unsigned int slot, unsigned int id) { fSlots[slot].fFrames.push_back({id, Clock_t::now(), 0.}); }
+
+   void Stop(unsigned int slot)
+   {
+      auto &frames = fSlots[slot].fFrames;
+      const auto &frame = frames.back();
+      const auto elapsed = std::chrono::duration<double>(Clock_t::now() - frame.fStart).count();
+      auto &stats = GetStats(slot, frame.fNodeId);
+      ++stats.fCalls;
+      stats.fTime += elapsed - frame.fChildrenTime;
+      frames.pop_back();
+      if (!frames.empty())
+         frames.back().fChildrenTime += elapsed;
+   }
+};
+
+} // ns TDF
+} // ns Internal
+} // ns ROOT
+
+#endif // ROOT_TDFPROFILING
@@ -26,6 +26,7 @@
 #include <memory>
 #include <string>
 #include <type_traits> // std::decay
+#include <typeinfo>
 #include <vector>
 
 class TTree;
@@ -88,6 +89,35 @@ using namespace ROOT::TypeTraits;
 using namespace ROOT::Detail::TDF;
 using namespace ROOT::Experimental::TDF;
 
+class TProfiler;
+
+unsigned int GetColumnProfileId(TProfiler &profiler, const std::string &columnName);
+
+std::string GetActionProfileName(const std::type_info &helperType, const ColumnNames_t &columns);
+
+/// Accounts the lifetime of the object to a node, if profiling is active
+class TProfileScope {
+   TProfiler *const fProfiler;
+   const unsigned int fSlot;
+
+   void Start(unsigned int id);
+   void Stop();
+
+public:
+   TProfileScope(TProfiler *profiler, unsigned int slot, unsigned int id) : fProfiler(profiler), fSlot(slot)
+   {
+      if (fProfiler)
+         Start(id);
+   }
+   TProfileScope(const TProfileScope &) = delete;
+   TProfileScope &operator=(const TProfileScope &) = delete;
+   ~TProfileScope()
+   {
+      if (fProfiler)
+         Stop();
+   }
+};
+
 class TIgnoreErrorLevelRAII {
 private:
    int fCurIgnoreErrorLevel = gErrorIgnoreLevel;
@@ -170,11 +200,12 @@ using ReaderValueOrArray_t = typename TReaderValueOrArray<T>::Proxy_t;
 /// Initialize a tuple of TColumnValues.
 /// For real TTree branches a TTreeReader{Array,Value} is built and passed to the
 /// TColumnValue. For temporary columns a pointer to the corresponding variable
-/// is passed instead.
+/// is passed instead. If the event loop is being profiled, reads of real branches are accounted to the profiler.
 template <typename TDFValueTuple, int... S>
 void InitTDFValues(unsigned int slot, TDFValueTuple &valueTuple, TTreeReader *r, const ColumnNames_t &bn,
                    const ColumnNames_t &tmpbn,
-                   const std::map<std::string, std::shared_ptr<TCustomColumnBase>> &customCols, StaticSeq<S...>)
+                   const std::map<std::string, std::shared_ptr<TCustomColumnBase>> &customCols, TProfiler *profiler,
+                   StaticSeq<S...>)
 {
    // isTmpBranch has length bn.size(). Elements are true if the corresponding
    // branch is a temporary branch created with Define, false if they are
@@ -191,6 +222,10 @@ void InitTDFValues(unsigned int slot, TDFValueTuple &valueTuple, TTreeReader *r,
                                            : std::get<S>(valueTuple).MakeProxy(r, bn.at(S)),
                                         0)...};
    (void)expander; // avoid "unused variable" warnings for expander on gcc4.9
+   if (profiler) {
+      std::initializer_list<int> profExpander{(std::get<S>(valueTuple).SetProfiler(slot, profiler, bn.at(S)), 0)...};
+      (void)profExpander;
+   }
    (void)slot;     // avoid _bogus_ "unused variable" warnings for slot on gcc 4.9
    (void)r;        // avoid "unused variable" warnings for r on gcc5.2
 }
@@ -311,6 +346,8 @@ struct RemoveFirstTwoParametersIf<true, TypeList> {
 
 bool IsInternalColumn(std::string_view colName);
 
+std::vector<Long64_t> GetClusterBoundaries(TTree &tree);
+
 // Check if a condition is true for all types
 template <bool...>
 struct TBoolPack;
@@ -322,6 +359,15 @@ struct TEvalAnd {
    static constexpr bool value = IsTrueForAllImpl_t<Conditions...>::value;
 };
 
+// Check if all types of a TypeList are arithmetic types
+template <typename TypeList>
+struct TAreArithmetic;
+
+template <typename... Types>
+struct TAreArithmetic<TypeList<Types...>> {
+   static constexpr bool value = TEvalAnd<std::is_arithmetic<Types>::value...>::value;
+};
+
 // Check if a class is a specialisation of stl containers templates
 
 template <typename>
@@ -0,0 +1,71 @@
+#ifndef ROOT_TNPYTDS
+#define ROOT_TNPYTDS
+
+#include "ROOT/TDataFrame.hxx"
+#include "ROOT/TDataSource.hxx"
+
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace ROOT {
+namespace Experimental {
+namespace TDF {
+
+class TNpyDS final : public ROOT::Experimental::TDF::TDataSource {
+private:
+   /// A column is a strided view of the memory of a mapped file
+   struct TColumn {
+      std::string fName;
+      std::string fTypeName;
+      const std::type_info *fType;
+      const char *fData;       ///< Value of the first entry
+      std::size_t fStride;     ///< Distance in bytes between the values of two consecutive entries
+      std::size_t fValueSize;  ///< Size in bytes of a value
+      bool fAligned;           ///< Whether all values can be read in place, i.e. are suitably aligned
+   };
+
+   unsigned int fNSlots = 0U;
+   std::string fPath;
+   std::vector<std::pair<char *, std::size_t>> fMappings; ///< Memory where the files are mapped, and its size
+   std::vector<TColumn> fColumns;
+   std::vector<std::string> fColumnNames;
+   ULong64_t fNEntries = 0ULL;
+   bool fNEntriesSet = false;
+   std::vector<std::pair<ULong64_t, ULong64_t>> fEntryRanges;
+   std::vector<std::vector<void *>> fColAddresses; // fColAddresses[column][slot]
+   std::vector<std::size_t> fRequestedColumns;     ///< Only the cursors of these columns are moved in SetEntry
+   /// Copies of the current values of the columns that cannot be read in place, fValueCopies[column * fNSlots + slot]
+   std::vector<ULong64_t> fValueCopies;
+
+   void AddArray(const char *begin, std::size_t size, const std::string &arrayName, const std::string &where);
+   std::pair<const char *, std::size_t> MapFile(const std::string &fileName);
+   void UnmapFiles();
+   void AddNpyFile(const std::string &fileName);
+   void AddNpzFile(const std::string &fileName);
+   const TColumn &GetColumn(std::string_view colName) const;
+   std::vector<void *> GetColumnReadersImpl(std::string_view name, const std::type_info &);
+
+public:
+   TNpyDS(std::string_view path);
+   ~TNpyDS();
+   const std::vector<std::string> &GetColumnNames() const;
+   std::vector<std::pair<ULong64_t, ULong64_t>> GetEntryRanges();
+   std::string GetTypeName(std::string_view colName) const;
+   bool HasColumn(std::string_view colName) const;
+   void SetEntry(unsigned int slot, ULong64_t entry);
+   void SetNSlots(unsigned int nSlots);
+   void Initialise();
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+/// \brief Factory method to create a TDataFrame reading NumPy arrays.
+/// \param[in] path Path of a `.npy` file, of a `.npz` archive or of a directory containing `.npy` files.
+TDataFrame MakeNpyDataFrame(std::string_view path);
+
+} // ns TDF
+} // ns Experimental
+} // ns ROOT
+
+#endif
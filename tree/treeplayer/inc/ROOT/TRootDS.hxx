@@ -19,11 +19,16 @@ private:
    mutable TChain fModelChain; // Mutable needed for getting the column type name
    std::vector<double *> fAddressesToFree;
    std::vector<std::string> fListOfBranches;
+   std::vector<std::size_t> fRequestedColumns; // indices in fListOfBranches of the columns that must be read
    std::vector<std::pair<ULong64_t, ULong64_t>> fEntryRanges;
+   std::vector<std::pair<ULong64_t, ULong64_t>> fLoopEntryRanges; ///< All entry ranges of the current event loop
+   /// Entries in the range of the read cache of each slot: the part of the entry range of the slot in its current tree
+   std::vector<std::pair<ULong64_t, ULong64_t>> fCacheRanges;
    std::vector<std::vector<void *>> fBranchAddresses; // first container-> slot, second -> column;
    std::vector<std::unique_ptr<TChain>> fChains;
 
    std::vector<void *> GetColumnReadersImpl(std::string_view, const std::type_info &);
+   void SetCacheRange(unsigned int slot, ULong64_t entry);
 
 public:
    TRootDS(std::string_view treeName, std::string_view fileNameGlob);
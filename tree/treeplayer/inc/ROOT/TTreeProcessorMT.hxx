@@ -24,6 +24,7 @@
 
 #include <string.h>
 #include <functional>
+#include <limits>
 #include <vector>
 
 
@@ -59,6 +60,7 @@ namespace ROOT {
 
          std::unique_ptr<TChain> fChain;         ///< Chain on which to operate
          std::vector<std::string> fFileNames;    ///< Names of the files
+         std::vector<Long64_t> fEntriesPerFile;  ///< Number of entries of each file, empty if not known
          std::string fTreeName;                  ///< Name of the tree
          TEntryList fEntryList;                  ///< Entry numbers to be processed
          std::vector<Long64_t> fLoadedEntries;   ///<! Per-task loaded entries (for task interleaving)
@@ -89,8 +91,16 @@ namespace ROOT {
             }
 
             fChain.reset(new TChain(fTreeName.c_str()));
-            for (auto &fn : fFileNames) {
-               fChain->Add(fn.c_str());
+            const auto nFiles = fFileNames.size();
+            for (auto i = 0u; i < nFiles; ++i) {
+               if (fEntriesPerFile.empty()) {
+                  fChain->Add(fFileNames[i].c_str());
+               } else if (fEntriesPerFile[i] > 0) {
+                  // With a known number of entries the chain does not need to open this file, and all the files
+                  // that precede it, to compute the offset of its entries: only the file being read gets opened.
+                  // Files without entries are skipped, they would be opened just to be discarded.
+                  fChain->Add(fFileNames[i].c_str(), fEntriesPerFile[i]);
+               }
             }
             fChain->ResetBit(TObject::kMustCleanup);
 
@@ -228,7 +238,8 @@ namespace ROOT {
          //////////////////////////////////////////////////////////////////////////
          /// Copy constructor.
          /// \param[in] view Object to copy.
-         TTreeView(const TTreeView &view) : fTreeName(view.fTreeName), fEntryList(view.fEntryList)
+         TTreeView(const TTreeView &view)
+            : fEntriesPerFile(view.fEntriesPerFile), fTreeName(view.fTreeName), fEntryList(view.fEntryList)
          {
             for (auto& fn : view.fFileNames)
                fFileNames.emplace_back(fn);
@@ -247,6 +258,22 @@ namespace ROOT {
             Init();
          }
 
+         //////////////////////////////////////////////////////////////////////////
+         /// Provide the number of entries of each file of the view, so that the chain can jump to any entry by
+         /// opening only the file that contains it. The chain is rebuilt the first time this is called, unless a
+         /// reader of this view is in use (i.e. with interleaved tasks), in which case nothing happens.
+         /// \param[in] entries Number of entries of each file, in the same order as the file names.
+         void SetEntriesPerFile(const std::vector<Long64_t> &entries)
+         {
+            if (!fEntriesPerFile.empty() || !fLoadedEntries.empty() || entries.size() != fFileNames.size())
+               return;
+            fEntriesPerFile = entries;
+            // the chain refers to its friends, destroy it first
+            fChain.reset();
+            fFriends.clear();
+            Init();
+         }
+
          //////////////////////////////////////////////////////////////////////////
          /// Get a TTreeReader for the current tree of this view.
          using TreeReaderEntryListPair = std::pair<std::unique_ptr<TTreeReader>, std::unique_ptr<TEntryList>>;
@@ -310,8 +337,11 @@ namespace ROOT {
    class TTreeProcessorMT {
    private:
       ROOT::TThreadedObject<ROOT::Internal::TTreeView> treeView; ///<! Thread-local TreeViews
+      static unsigned int fgTasksPerWorkerHint; ///< Number of tasks per worker thread that clusters are split into
+      Long64_t fBeginEntry = 0;                                  ///< First entry to process
+      Long64_t fEndEntry = std::numeric_limits<Long64_t>::max(); ///< Entry at which processing stops
 
-      std::vector<ROOT::Internal::TreeViewCluster> MakeClusters();
+      std::vector<ROOT::Internal::TreeViewCluster> MakeClusters(std::vector<Long64_t> &entriesPerFile);
    public:
       TTreeProcessorMT(std::string_view filename, std::string_view treename = "");
       TTreeProcessorMT(const std::vector<std::string_view>& filenames, std::string_view treename = "");
@@ -319,6 +349,10 @@ namespace ROOT {
       TTreeProcessorMT(TTree& tree, TEntryList& entries);
  
       void Process(std::function<void(TTreeReader&)> func);
+      void SetEntriesRange(Long64_t beginEntry, Long64_t endEntry);
+
+      static void SetTasksPerWorkerHint(unsigned int m);
+      static unsigned int GetTasksPerWorkerHint();
 
    };
 
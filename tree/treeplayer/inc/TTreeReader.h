@@ -28,6 +28,7 @@
 
 #include <deque>
 #include <iterator>
+#include <utility>
 
 class TDictionary;
 class TDirectory;
@@ -195,6 +196,11 @@ public:
    ///   load anymore).
    EEntryStatus SetEntriesRange(Long64_t beginEntry, Long64_t endEntry);
 
+   /// Get the begin and end entry numbers set via SetEntriesRange().
+   ///
+   /// \return a pair with the first entry that `Next()` loads and the entry it stops on, or -1 if not set.
+   std::pair<Long64_t, Long64_t> GetEntriesRange() const { return std::make_pair(fBeginEntry, fEndEntry); }
+
    /// Restart a Next() loop from entry 0 (of TEntryList index 0 of fEntryList is set).
    void Restart();
 
@@ -252,6 +258,7 @@ private:
    /// to stop looping over the TTree when we reach a certain entry: Next()
    /// returns kFALSE when GetCurrentEntry() reaches fEndEntry.
    Long64_t fEndEntry = -1;
+   Long64_t fBeginEntry = -1; ///< The first entry loaded by Next() after a call to SetEntriesRange(), if any.
    Bool_t fProxiesSet = kFALSE; ///< True if the proxies have been set, false otherwise
 
    friend class ROOT::Internal::TTreeReaderValueBase;
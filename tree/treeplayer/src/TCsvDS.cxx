@@ -65,9 +65,11 @@ double-quote characters must be represented by a pair of double-quote characters
     2000,Mercury,Cougar
 ~~~
 
-The current implementation of TCsvDS reads the entire CSV file content into memory before
-TDataFrame starts processing it. Therefore, before creating a CSV TDataFrame, it is
-important to check both how much memory is available and the size of the CSV file.
+The types of the columns are inferred from the first record, which is read when the data source is
+constructed. The records themselves are read during the event loop: the file is read in chunks of
+a configurable number of bytes per slot, split at line boundaries, and each slot parses the records
+of its part of the chunk. Only the chunk being processed is kept in memory, and only the columns that
+are actually used are converted to their type.
 */
 // clang-format on
 
@@ -100,32 +102,6 @@ void TCsvDS::FillHeaders(const std::string &line)
    }
 }
 
-void TCsvDS::FillRecord(const std::string &line, Record &record)
-{
-   std::istringstream lineStream(line);
-   auto i = 0U;
-
-   auto columns = ParseColumns(line);
-
-   for (auto &col : columns) {
-      auto &colType = fColTypes[fHeaders[i]];
-
-      if (colType == "Long64_t") {
-         record.emplace_back(new Long64_t(std::stoll(col)));
-      } else if (colType == "double") {
-         record.emplace_back(new double(std::stod(col)));
-      } else if (colType == "bool") {
-         bool *b = new bool();
-         record.emplace_back(b);
-         std::istringstream is(col);
-         is >> std::boolalpha >> *b;
-      } else {
-         record.emplace_back(new std::string(col));
-      }
-      ++i;
-   }
-}
-
 void TCsvDS::GenerateHeaders(size_t size)
 {
    for (size_t i = 0; i < size; ++i) {
@@ -136,7 +112,9 @@ void TCsvDS::GenerateHeaders(size_t size)
 std::vector<void *> TCsvDS::GetColumnReadersImpl(std::string_view colName, const std::type_info &)
 {
    const auto &colNames = GetColumnNames();
-   const auto index = std::distance(colNames.begin(), std::find(colNames.begin(), colNames.end(), colName));
+   const std::size_t index = std::distance(colNames.begin(), std::find(colNames.begin(), colNames.end(), colName));
+   if (std::find(fRequestedColumns.begin(), fRequestedColumns.end(), index) == fRequestedColumns.end())
+      fRequestedColumns.emplace_back(index);
    std::vector<void *> ret(fNSlots);
    for (auto slot : ROOT::TSeqU(fNSlots)) {
       ret[slot] = (void *)&fColAddresses[index][slot];
@@ -158,54 +136,96 @@ void TCsvDS::InferType(const std::string &col, unsigned int idxCol)
    std::string type;
    int dummy;
 
+   EColType colType;
+
    if (intRegex.Index(col, &dummy) != -1) {
       type = "Long64_t";
+      colType = EColType::kLong64;
    } else if (doubleRegex1.Index(col, &dummy) != -1 || doubleRegex2.Index(col, &dummy) != -1) {
       type = "double";
+      colType = EColType::kDouble;
    } else if (trueRegex.Index(col, &dummy) != -1 || falseRegex.Index(col, &dummy) != -1) {
       type = "bool";
+      colType = EColType::kBool;
    } else { // everything else is a string
       type = "std::string";
+      colType = EColType::kString;
    }
    // TODO: Date
 
    fColTypes[fHeaders[idxCol]] = type;
+   fColTypesList.emplace_back(colType);
 }
 
 std::vector<std::string> TCsvDS::ParseColumns(const std::string &line)
 {
    std::vector<std::string> columns;
-
-   for (size_t i = 0; i < line.size(); ++i) {
-      i = ParseValue(line, columns, i);
-   }
-
+   columns.resize(ParseLine(line.data(), line.data() + line.size(), columns));
    return columns;
 }
 
-size_t TCsvDS::ParseValue(const std::string &line, std::vector<std::string> &columns, size_t i)
+////////////////////////////////////////////////////////////////////////
+/// Split the line [begin, end) in fields, which are stored in `fields`. The strings already in `fields` are reused to
+/// avoid memory allocations, and `fields` is only grown if needed: the number of fields of the line is returned.
+size_t TCsvDS::ParseLine(const char *begin, const char *end, std::vector<std::string> &fields) const
 {
-   std::stringstream val;
-   bool quoted = false;
-
-   for (; i < line.size(); ++i) {
-      if (line[i] == fDelimiter && !quoted) {
-         break;
-      } else if (line[i] == '"') {
-         // Keep just one quote for escaped quotes, none for the normal quotes
-         if (line[i + 1] != '"') {
-            quoted = !quoted;
+   size_t nFields = 0;
+   for (auto c = begin; c < end; ++c) {
+      if (nFields == fields.size())
+         fields.emplace_back();
+      auto &val = fields[nFields++];
+      val.clear();
+      bool quoted = false;
+      for (; c < end; ++c) {
+         if (*c == fDelimiter && !quoted) {
+            break;
+         } else if (*c == '"') {
+            // Keep just one quote for escaped quotes, none for the normal quotes
+            if (c + 1 < end && c[1] == '"') {
+               val += *++c;
+            } else {
+               quoted = !quoted;
+            }
          } else {
-            val << line[++i];
+            val += *c;
          }
-      } else {
-         val << line[i];
       }
    }
+   return nFields;
+}
 
-   columns.emplace_back(val.str());
-
-   return i;
+////////////////////////////////////////////////////////////////////////
+/// Read the next chunk of the file into fBuffer, keeping the incomplete line at the end of the previous chunk, and
+/// find the non-empty lines it contains. Return false if the end of the file had already been reached.
+bool TCsvDS::ReadNextChunk()
+{
+   fBuffer.erase(0, fBufferUsed);
+   fBufferUsed = 0U;
+   fLines.clear();
+
+   const auto chunkSize = fChunkSize * std::max(fNSlots, 1U);
+   auto lastNewLine = std::string::npos;
+   // keep reading if a single line is longer than a chunk
+   while (fStream.good() && lastNewLine == std::string::npos) {
+      const auto oldSize = fBuffer.size();
+      fBuffer.resize(oldSize + chunkSize);
+      fStream.read(&fBuffer[oldSize], chunkSize);
+      fBuffer.resize(oldSize + fStream.gcount());
+      lastNewLine = fBuffer.rfind('\n');
+   }
+   // at the end of the file, the last line might not be terminated by a new line
+   fBufferUsed = fStream.good() ? lastNewLine + 1 : fBuffer.size();
+   if (fBufferUsed == 0U)
+      return false;
+
+   std::size_t lineBegin = 0U;
+   while (lineBegin < fBufferUsed) {
+      auto lineEnd = std::min(fBuffer.find('\n', lineBegin), fBufferUsed);
+      if (lineEnd > lineBegin)
+         fLines.emplace_back(lineBegin, lineEnd);
+      lineBegin = lineEnd + 1;
+   }
+   return true;
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -214,17 +234,22 @@ size_t TCsvDS::ParseValue(const std::string &line, std::vector<std::string> &col
 /// \param[in] readHeaders `true` if the CSV file contains headers as first row, `false` otherwise
 ///                        (default `true`).
 /// \param[in] delimiter Delimiter character (default ',').
-TCsvDS::TCsvDS(std::string_view fileName, bool readHeaders, char delimiter) // TODO: Let users specify types?
+/// \param[in] chunkSize Number of bytes read from the file at once by each slot (default 8 MB).
+TCsvDS::TCsvDS(std::string_view fileName, bool readHeaders, char delimiter,
+               std::size_t chunkSize) // TODO: Let users specify types?
    : fFileName(fileName),
-     fDelimiter(delimiter)
+     fDelimiter(delimiter),
+     fStream(fFileName, std::ios::binary),
+     fChunkSize(std::max<std::size_t>(chunkSize, 1U))
 {
-   std::ifstream stream(fFileName);
+   auto &stream = fStream;
    std::string line;
 
    // Read the headers if present
    if (readHeaders) {
       if (std::getline(stream, line)) {
          FillHeaders(line);
+         fDataOffset = line.size() + 1;
       } else {
          std::string msg = "Error reading headers of CSV file ";
          msg += fileName;
@@ -242,12 +267,6 @@ TCsvDS::TCsvDS(std::string_view fileName, bool readHeaders, char delimiter) // T
 
       // Infer types of columns with first record
       InferColTypes(columns);
-
-      // Read all records and store them in memory
-      do {
-         fRecords.emplace_back();
-         FillRecord(line, fRecords.back());
-      } while (std::getline(stream, line));
    }
 }
 
@@ -255,22 +274,6 @@ TCsvDS::TCsvDS(std::string_view fileName, bool readHeaders, char delimiter) // T
 /// Destructor.
 TCsvDS::~TCsvDS()
 {
-   for (auto &record : fRecords) {
-      for (size_t i = 0; i < record.size(); ++i) {
-         void *p = record[i];
-         auto &colType = fColTypes[fHeaders[i]];
-
-         if (colType == "Long64_t") {
-            delete static_cast<Long64_t *>(p);
-         } else if (colType == "double") {
-            delete static_cast<double *>(p);
-         } else if (colType == "bool") {
-            delete static_cast<bool *>(p);
-         } else {
-            delete static_cast<std::string *>(p);
-         }
-      }
-   }
 }
 
 const std::vector<std::string> &TCsvDS::GetColumnNames() const
@@ -278,9 +281,36 @@ const std::vector<std::string> &TCsvDS::GetColumnNames() const
    return fHeaders;
 }
 
+////////////////////////////////////////////////////////////////////////
+/// Read the next chunk of the file and split its records in (at most) one range of entries per slot.
+/// The records of the previous chunk can no longer be accessed afterwards.
 std::vector<std::pair<ULong64_t, ULong64_t>> TCsvDS::GetEntryRanges()
 {
-   auto entryRanges(std::move(fEntryRanges)); // empty fEntryRanges
+   std::vector<std::pair<ULong64_t, ULong64_t>> entryRanges;
+   fChunkFirstEntry = fNextEntry;
+   // skip chunks made only of empty lines
+   while (ReadNextChunk() && fLines.empty()) {
+   }
+
+   const auto nRecords = fLines.size();
+   const auto chunkSize = nRecords / fNSlots;
+   const auto remainder = 1U == fNSlots ? 0 : nRecords % fNSlots;
+   auto start = fChunkFirstEntry;
+   auto end = fChunkFirstEntry;
+
+   for (auto i : ROOT::TSeqU(fNSlots)) {
+      start = end;
+      end += chunkSize;
+      entryRanges.emplace_back(start, end);
+      (void)i;
+   }
+   entryRanges.back().second += remainder;
+   fNextEntry = entryRanges.back().second;
+
+   // with few records, some of the slots might have nothing to do
+   entryRanges.erase(std::remove_if(entryRanges.begin(), entryRanges.end(),
+                                    [](const std::pair<ULong64_t, ULong64_t> &r) { return r.first == r.second; }),
+                     entryRanges.end());
    return entryRanges;
 }
 
@@ -300,13 +330,29 @@ bool TCsvDS::HasColumn(std::string_view colName) const
    return fHeaders.end() != std::find(fHeaders.begin(), fHeaders.end(), colName);
 }
 
+////////////////////////////////////////////////////////////////////////
+/// Parse the record `entry`, which must belong to the current chunk, and update the values of the requested columns
+/// for `slot`. Different slots can parse their records concurrently.
 void TCsvDS::SetEntry(unsigned int slot, ULong64_t entry)
 {
-   auto nColumns = fHeaders.size();
+   const auto &line = fLines[entry - fChunkFirstEntry];
+   auto &fields = fFields[slot];
+   const auto nFields = ParseLine(fBuffer.data() + line.first, fBuffer.data() + line.second, fields);
+   if (nFields != fHeaders.size()) {
+      std::string msg = "Record " + std::to_string(entry) + " of CSV file " + fFileName + " has " +
+                        std::to_string(nFields) + " fields instead of " + std::to_string(fHeaders.size());
+      throw std::runtime_error(msg);
+   }
 
-   for (auto i : ROOT::TSeqU(nColumns)) {
-      // Update the address of every column of the slot to point to the record
-      fColAddresses[i][slot] = fRecords[entry][i];
+   for (auto col : fRequestedColumns) {
+      const auto &field = fields[col];
+      const auto index = col * fNSlots + slot;
+      switch (fColTypesList[col]) {
+      case EColType::kLong64: fLong64Values[index] = std::stoll(field); break;
+      case EColType::kDouble: fDoubleValues[index] = std::stod(field); break;
+      case EColType::kBool: fBoolValues[index] = field == "true"; break;
+      case EColType::kString: fStringValues[index] = field; break;
+      }
    }
 }
 
@@ -317,30 +363,43 @@ void TCsvDS::SetNSlots(unsigned int nSlots)
    fNSlots = nSlots;
 
    const auto nColumns = fHeaders.size();
-   // Initialise the entire set of addresses
+   fLong64Values.resize(nColumns * fNSlots);
+   fDoubleValues.resize(nColumns * fNSlots);
+   fBoolValues.resize(nColumns * fNSlots);
+   fStringValues.resize(nColumns * fNSlots);
+   fFields.resize(fNSlots, std::vector<std::string>(nColumns));
+
+   // Initialise the entire set of addresses: values are stored in place, so these never change
    fColAddresses.resize(nColumns, std::vector<void *>(fNSlots, nullptr));
+   for (auto col : ROOT::TSeqU(fColTypesList.size())) {
+      for (auto slot : ROOT::TSeqU(fNSlots)) {
+         const auto index = col * fNSlots + slot;
+         switch (fColTypesList[col]) {
+         case EColType::kLong64: fColAddresses[col][slot] = &fLong64Values[index]; break;
+         case EColType::kDouble: fColAddresses[col][slot] = &fDoubleValues[index]; break;
+         case EColType::kBool: fColAddresses[col][slot] = &fBoolValues[index]; break;
+         case EColType::kString: fColAddresses[col][slot] = &fStringValues[index]; break;
+         }
+      }
+   }
 }
 
+////////////////////////////////////////////////////////////////////////
+/// Rewind the file to its first record: each event loop reads it again.
 void TCsvDS::Initialise()
 {
-   const auto nRecords = fRecords.size();
-   const auto chunkSize = nRecords / fNSlots;
-   const auto remainder = 1U == fNSlots ? 0 : nRecords % fNSlots;
-   auto start = 0UL;
-   auto end = 0UL;
-
-   for (auto i : ROOT::TSeqU(fNSlots)) {
-      start = end;
-      end += chunkSize;
-      fEntryRanges.emplace_back(start, end);
-      (void)i;
-   }
-   fEntryRanges.back().second += remainder;
+   fStream.clear();
+   fStream.seekg(fDataOffset);
+   fBuffer.clear();
+   fBufferUsed = 0U;
+   fLines.clear();
+   fChunkFirstEntry = 0ULL;
+   fNextEntry = 0ULL;
 }
 
-TDataFrame MakeCsvDataFrame(std::string_view fileName, bool readHeaders, char delimiter)
+TDataFrame MakeCsvDataFrame(std::string_view fileName, bool readHeaders, char delimiter, std::size_t chunkSize)
 {
-   ROOT::Experimental::TDataFrame tdf(std::make_unique<TCsvDS>(fileName, readHeaders, delimiter));
+   ROOT::Experimental::TDataFrame tdf(std::make_unique<TCsvDS>(fileName, readHeaders, delimiter, chunkSize));
    return tdf;
 }
 
@@ -10,10 +10,40 @@
 
 #include "ROOT/TDFActionHelpers.hxx"
 
+#include <atomic>
+
 namespace ROOT {
+namespace Experimental {
+namespace TDF {
+
+namespace {
+std::atomic<ULong64_t> gMaxHistoCopiesSize(256 * 1024 * 1024);
+}
+
+void SetMaxHistoCopiesSize(ULong64_t size)
+{
+   gMaxHistoCopiesSize = size;
+}
+
+ULong64_t GetMaxHistoCopiesSize()
+{
+   return gMaxHistoCopiesSize;
+}
+
+} // ns TDF
+} // ns Experimental
+
 namespace Internal {
 namespace TDF {
 
+ULong64_t GetHistoCopiesSize(const TH1 &h, unsigned int nSlots)
+{
+   // bin contents, plus the sums of squares of weights if they are stored. Bin contents are assumed to be doubles,
+   // which overestimates the size of e.g. TH2F but is exact for the TH*D that TDataFrame fills by default.
+   const ULong64_t cellSize = sizeof(Double_t) * (h.GetSumw2N() > 0 ? 2 : 1);
+   return cellSize * h.GetNcells() * (nSlots - 1);
+}
+
 CountHelper::CountHelper(const std::shared_ptr<ULong64_t> &resultCount, const unsigned int nSlots)
    : fResultCount(resultCount), fCounts(nSlots, 0)
 {
@@ -37,6 +67,27 @@ ULong64_t &CountHelper::PartialUpdate(unsigned int slot)
    return fCounts[slot];
 }
 
+void CountHelper::WriteMPResult(TBuffer &buf)
+{
+   WriteMPObject(buf, fCounts[0]);
+}
+
+void CountHelper::MergeMPResult(TBuffer &buf)
+{
+   fCounts[0] += *ReadMPObject<ULong64_t>(buf);
+}
+
+ProfileReportHelper::ProfileReportHelper(const std::shared_ptr<TProfileReport> &resultReport,
+                                         const std::shared_ptr<TProfiler> &profiler)
+   : fResultReport(resultReport), fProfiler(profiler)
+{
+}
+
+void ProfileReportHelper::Finalize()
+{
+   *fResultReport = fProfiler->MakeReport();
+}
+
 void FillHelper::UpdateMinMax(unsigned int slot, double v)
 {
    auto &thisMin = fMin[slot];
@@ -105,6 +156,25 @@ void FillHelper::Finalize()
    }
 }
 
+// the values themselves are sent, so that the binning is computed on all of them as in a single-process event loop
+void FillHelper::WriteMPResult(TBuffer &buf)
+{
+   WriteMPObject(buf, fMin[0]);
+   WriteMPObject(buf, fMax[0]);
+   WriteMPObject(buf, fBuffers[0]);
+   WriteMPObject(buf, fWBuffers[0]);
+}
+
+void FillHelper::MergeMPResult(TBuffer &buf)
+{
+   fMin[0] = std::min(fMin[0], *ReadMPObject<BufEl_t>(buf));
+   fMax[0] = std::max(fMax[0], *ReadMPObject<BufEl_t>(buf));
+   auto values = ReadMPObject<Buf_t>(buf);
+   auto weights = ReadMPObject<Buf_t>(buf);
+   fBuffers[0].insert(fBuffers[0].end(), values->begin(), values->end());
+   fWBuffers[0].insert(fWBuffers[0].end(), weights->begin(), weights->end());
+}
+
 template void FillHelper::Exec(unsigned int, const std::vector<float> &);
 template void FillHelper::Exec(unsigned int, const std::vector<double> &);
 template void FillHelper::Exec(unsigned int, const std::vector<char> &);
@@ -155,12 +225,67 @@ double &MeanHelper::PartialUpdate(unsigned int slot)
    return fPartialMeans[slot];
 }
 
+void MeanHelper::WriteMPResult(TBuffer &buf)
+{
+   WriteMPObject(buf, fSums[0]);
+   WriteMPObject(buf, fCounts[0]);
+}
+
+void MeanHelper::MergeMPResult(TBuffer &buf)
+{
+   fSums[0] += *ReadMPObject<double>(buf);
+   fCounts[0] += *ReadMPObject<ULong64_t>(buf);
+}
+
 template void MeanHelper::Exec(unsigned int, const std::vector<float> &);
 template void MeanHelper::Exec(unsigned int, const std::vector<double> &);
 template void MeanHelper::Exec(unsigned int, const std::vector<char> &);
 template void MeanHelper::Exec(unsigned int, const std::vector<int> &);
 template void MeanHelper::Exec(unsigned int, const std::vector<unsigned int> &);
 
+bool TOrderedChunks::IsEmpty() const
+{
+   return std::all_of(fSwitches.begin(), fSwitches.end(), [](const decltype(fSwitches)::value_type &switches) {
+      return switches.empty();
+   });
+}
+
+void TOrderedChunks::InitTask(unsigned int slot, ULong64_t taskBegin, std::size_t collSize)
+{
+   fRunningTasks[slot].emplace_back(taskBegin);
+   fSwitches[slot].emplace_back(taskBegin, collSize);
+}
+
+void TOrderedChunks::FinalizeTask(unsigned int slot, std::size_t collSize)
+{
+   auto &runningTasks = fRunningTasks[slot];
+   runningTasks.pop_back();
+   // if this task interrupted another one on the same slot, the interrupted task now resumes filling the collection
+   if (!runningTasks.empty())
+      fSwitches[slot].emplace_back(runningTasks.back(), collSize);
+}
+
+/// Return the chunks of the per-slot collections, sorted in the order of the entries they were filled from.
+/// \param[in] collSizes The final sizes of the per-slot collections.
+std::vector<TOrderedChunks::TChunk> TOrderedChunks::GetChunks(const std::vector<std::size_t> &collSizes) const
+{
+   std::vector<TChunk> chunks;
+   const auto nSlots = fSwitches.size();
+   for (auto slot = 0u; slot < nSlots; ++slot) {
+      const auto &switches = fSwitches[slot];
+      const auto nSwitches = switches.size();
+      for (auto i = 0u; i < nSwitches; ++i) {
+         const auto end = i + 1 < nSwitches ? switches[i + 1].second : collSizes[slot];
+         if (end > switches[i].second)
+            chunks.emplace_back(TChunk{switches[i].first, slot, switches[i].second, end});
+      }
+   }
+   // tasks process disjoint ranges of entries, and the chunks of a task are already in order within each slot
+   std::stable_sort(chunks.begin(), chunks.end(),
+                    [](const TChunk &a, const TChunk &b) { return a.fTaskBegin < b.fTaskBegin; });
+   return chunks;
+}
+
 } // end NS TDF
 } // end NS Internal
 } // end NS ROOT
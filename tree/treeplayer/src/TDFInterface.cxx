@@ -8,8 +8,13 @@
  * For the list of contributors see $ROOTSYS/README/CREDITS.             *
  *************************************************************************/
 
+#include "TChainElement.h"
 #include "TClass.h"
+#include "TFile.h"
+#include "TFriendElement.h"
+#include "TNamed.h"
 #include "TRegexp.h"
+#include "TSystem.h"
 
 #include "ROOT/TDFInterface.hxx"
 #include "ROOT/TSeq.hxx"
@@ -89,61 +94,37 @@ std::vector<std::string> FindUsedColumnNames(std::string_view expression, const
 }
 
 // Jit a string filter or a string temporary column, call this->Define or this->Filter as needed
-// Return pointer to the new functional chain node returned by the call, cast to Long_t
-Long_t JitTransformation(void *thisPtr, std::string_view methodName, std::string_view interfaceTypeName,
-                         std::string_view name, std::string_view expression,
-                         const std::map<std::string, std::string> &aliasMap, const ColumnNames_t &branches,
-                         const std::vector<std::string> &customColumns,
-                         const std::map<std::string, TmpBranchBasePtr_t> &tmpBookedBranches, TTree *tree,
-                         std::string_view returnTypeName, TDataSource *ds)
+// The TInterface to the new functional chain node returned by the call is stored in *resultPtr, a
+// std::unique_ptr<TInterface<returnTypeName>>
+void JitTransformation(void *thisPtr, void *resultPtr, std::string_view methodName,
+                       std::string_view interfaceTypeName, std::string_view name, std::string_view expression,
+                       const std::map<std::string, std::string> &aliasMap, const ColumnNames_t &branches,
+                       const std::vector<std::string> &customColumns,
+                       const std::map<std::string, TmpBranchBasePtr_t> &tmpBookedBranches, TTree *tree,
+                       std::string_view returnTypeName, TDataSource *ds)
 {
    const auto &dsColumns = ds ? ds->GetColumnNames() : ColumnNames_t{};
    auto usedBranches = FindUsedColumnNames(expression, branches, customColumns, dsColumns, aliasMap);
    auto exprNeedsVariables = !usedBranches.empty();
 
-   // Move to the preparation of the jitting
-   // We put all of the jitted entities in function f in namespace __tdf_N, where N is a monotonically increasing index
-   // and then try to declare that function to make sure column names, types and expression are proper C++
+   // Retrieve the types of the columns used by the expression
    std::vector<std::string> usedBranchesTypes;
-   static unsigned int iNs = 0U;
-   std::stringstream dummyDecl;
-   dummyDecl << "namespace __tdf_" << std::to_string(iNs++) << "{ auto __tdf_lambda = []() {";
-
-   // Declare variables with the same name as the column used by this transformation
    auto aliasMapEnd = aliasMap.end();
-   if (exprNeedsVariables) {
-      for (auto &brName : usedBranches) {
-         // Here we replace on the fly the brName with the real one in case brName it's an alias
-         // This is then used to get the type. The variable name will be brName;
-         auto aliasMapIt = aliasMap.find(brName);
-         auto &realBrName = aliasMapEnd == aliasMapIt ? brName : aliasMapIt->second;
-         // The map is a const reference, so no operator[]
-         auto tmpBrIt = tmpBookedBranches.find(realBrName);
-         auto tmpBr = tmpBrIt == tmpBookedBranches.end() ? nullptr : tmpBrIt->second.get();
-         auto brTypeName = ColumnName2ColumnTypeName(realBrName, tree, tmpBr, ds);
-         dummyDecl << brTypeName << " " << brName << ";\n";
-         usedBranchesTypes.emplace_back(brTypeName);
-      }
+   for (auto &brName : usedBranches) {
+      // Here we replace on the fly the brName with the real one in case brName it's an alias
+      // This is then used to get the type. The variable name will be brName;
+      auto aliasMapIt = aliasMap.find(brName);
+      auto &realBrName = aliasMapEnd == aliasMapIt ? brName : aliasMapIt->second;
+      // The map is a const reference, so no operator[]
+      auto tmpBrIt = tmpBookedBranches.find(realBrName);
+      auto tmpBr = tmpBrIt == tmpBookedBranches.end() ? nullptr : tmpBrIt->second.get();
+      usedBranchesTypes.emplace_back(ColumnName2ColumnTypeName(realBrName, tree, tmpBr, ds));
    }
 
    TRegexp re("[^a-zA-Z0-9_]return[^a-zA-Z0-9_]");
    int exprSize = expression.size();
    bool hasReturnStmt = re.Index(std::string(expression), &exprSize) != -1;
 
-   // Now that branches are declared as variables, put the body of the
-   // lambda in dummyDecl and close scopes of f and namespace __tdf_N
-   if (hasReturnStmt)
-      dummyDecl << expression << "\n;};}";
-   else
-      dummyDecl << "return " << expression << "\n;};}";
-
-   // Try to declare the dummy lambda, error out if it does not compile
-   if (!gInterpreter->Declare(dummyDecl.str().c_str())) {
-      auto msg =
-         "Cannot interpret the following expression:\n" + std::string(expression) + "\n\nMake sure it is valid C++.";
-      throw std::runtime_error(msg);
-   }
-
    // Now we build the lambda and we invoke the method with it in the jitted world
    std::stringstream ss;
    ss << "[](";
@@ -174,8 +155,12 @@ Long_t JitTransformation(void *thisPtr, std::string_view methodName, std::string
    const auto targetTypeName = "ROOT::Experimental::TDF::TInterface<" + std::string(returnTypeName) + ">";
 
    // Here we have two cases: filter and column
+   // The jitted function invokes the method on the TInterface it receives as first argument and stores the result in
+   // the std::unique_ptr it receives as second argument. Its code does not depend on their addresses, so that it can be
+   // reused, and it does not keep the new node alive.
    ss.str("");
-   ss << targetTypeName << "(((" << interfaceTypeName << "*)" << thisPtr << ")->" << methodName << "(";
+   ss << "reinterpret_cast<std::unique_ptr<" << targetTypeName << ">*>(args[1])->reset(new " << targetTypeName
+      << "(reinterpret_cast<" << interfaceTypeName << "*>(args[0])->" << methodName << "(";
    if (methodName == "Define") {
       ss << "\"" << name << "\", ";
    }
@@ -194,27 +179,25 @@ Long_t JitTransformation(void *thisPtr, std::string_view methodName, std::string
       ss << ", \"" << name << "\"";
    }
 
-   ss << "));";
+   ss << ")));\nreturn 0;";
 
-   TInterpreter::EErrorCode interpErrCode;
-   auto retVal = gInterpreter->Calc(ss.str().c_str(), &interpErrCode);
-   if (TInterpreter::EErrorCode::kNoError != interpErrCode || !retVal) {
-      std::string msg = "Cannot interpret the invocation to " + std::string(methodName) + ":  ";
-      msg += ss.str();
-      if (TInterpreter::EErrorCode::kNoError != interpErrCode) {
-         msg += "\nInterpreter error code is " + std::to_string(interpErrCode) + ".";
-      }
+   // The same code is jitted once per process, or loaded from the jit cache
+   const auto jitted = GetJitFunctions({ss.str()})[0];
+   if (!jitted) {
+      auto msg =
+         "Cannot interpret the following expression:\n" + std::string(expression) + "\n\nMake sure it is valid C++.";
       throw std::runtime_error(msg);
    }
-   return retVal;
+   void *args[] = {thisPtr, resultPtr};
+   jitted(args);
 }
 
-// Jit and call something equivalent to "this->BuildAndBook<BranchTypes...>(params...)"
+// Return the call to be jitted to do something equivalent to "this->BuildAndBook<BranchTypes...>(params...)"
 // (see comments in the body for actual jitted code)
-std::string JitBuildAndBook(const ColumnNames_t &bl, const std::string &prevNodeTypename, void *prevNode,
-                            const std::type_info &art, const std::type_info &at, const void *rOnHeap, TTree *tree,
-                            const unsigned int nSlots, const std::map<std::string, TmpBranchBasePtr_t> &customColumns,
-                            TDataSource *ds, const std::shared_ptr<TActionBase *> *const actionPtrPtr)
+TJitCall JitBuildAndBook(const ColumnNames_t &bl, const std::string &prevNodeTypename, void *prevNode,
+                         const std::type_info &art, const std::type_info &at, const void *rOnHeap, TTree *tree,
+                         const unsigned int nSlots, const std::map<std::string, TmpBranchBasePtr_t> &customColumns,
+                         TDataSource *ds, const std::shared_ptr<TActionBase *> *const actionPtrPtr)
 {
    auto nBranches = bl.size();
 
@@ -255,25 +238,28 @@ std::string JitBuildAndBook(const ColumnNames_t &bl, const std::string &prevNode
    }
    const auto actionTypeName = actionTypeClass->GetName();
 
-   // createAction_str will contain the following:
+   // the body of the jitted function will contain the following:
    // ROOT::Internal::TDF::CallBuildAndBook<actionType, branchType1, branchType2...>(
-   //   *reinterpret_cast<PrevNodeType*>(prevNode), { bl[0], bl[1], ... }, reinterpret_cast<actionResultType*>(rOnHeap),
-   //   reinterpret_cast<shared_ptr<TActionBase*>*>(actionPtrPtr))
+   //   *reinterpret_cast<PrevNodeType*>(args[0]), { bl[0], bl[1], ... }, nSlots,
+   //   reinterpret_cast<actionResultType*>(args[1]), reinterpret_cast<shared_ptr<TActionBase*>*>(args[2]));
+   // It does not depend on the addresses of the nodes and of the result, so that it can be reused.
    std::stringstream createAction_str;
    createAction_str << "ROOT::Internal::TDF::CallBuildAndBook"
                     << "<" << actionTypeName;
    for (auto &colType : columnTypeNames)
       createAction_str << ", " << colType;
-   createAction_str << ">(*reinterpret_cast<" << prevNodeTypename << "*>(" << prevNode << "), {";
+   createAction_str << ">(*reinterpret_cast<" << prevNodeTypename << "*>(args[0]), {";
    for (auto i = 0u; i < bl.size(); ++i) {
       if (i != 0u)
          createAction_str << ", ";
       createAction_str << '"' << bl[i] << '"';
    }
-   createAction_str << "}, " << nSlots << ", reinterpret_cast<" << actionResultTypeName << "*>(" << rOnHeap << ")"
-                    << ", reinterpret_cast<const std::shared_ptr<ROOT::Internal::TDF::TActionBase*>*>(" << actionPtrPtr
-                    << "));";
-   return createAction_str.str();
+   createAction_str << "}, " << nSlots << ", reinterpret_cast<" << actionResultTypeName << "*>(args[1])"
+                    << ", reinterpret_cast<const std::shared_ptr<ROOT::Internal::TDF::TActionBase*>*>(args[2]));\n"
+                    << "return 0;";
+   return {createAction_str.str(),
+           {prevNode, const_cast<void *>(rOnHeap),
+            const_cast<void *>(static_cast<const void *>(actionPtrPtr))}};
 }
 
 bool AtLeastOneEmptyString(const std::vector<std::string_view> strings)
@@ -343,6 +329,19 @@ ColumnNames_t GetValidatedColumnNames(TLoopManager &lm, const unsigned int nColu
    return selectedColumns;
 }
 
+/// Return the key under which an unnamed jitted filter is registered in the TLoopManager: filters with the same key
+/// hang from the same node, see the same columns and evaluate the same expression.
+std::string GetJittedFilterKey(const void *prevNode, const ColumnNames_t &validCustomColumns,
+                               std::string_view expression)
+{
+   std::stringstream key;
+   key << prevNode << '\n';
+   for (const auto &column : validCustomColumns)
+      key << column << ',';
+   key << '\n' << expression;
+   return key.str();
+}
+
 /// Return a bitset each element of which indicates whether the corresponding element in `selectedColumns` is the
 /// name of a column that must be defined via datasource. All elements of the returned vector are false if no
 /// data-source is present.
@@ -355,6 +354,113 @@ std::vector<bool> FindUndefinedDSColumns(const ColumnNames_t &requestedCols, con
    return mustBeDefined;
 }
 
+/// Name of the TNamed that stores the fingerprint of a persistent cache, see `TInterface::Cache`
+static const char *const kPersistentCacheFingerprintName = "TDFCacheFingerprint";
+
+/// Append name, size and modification time of the files `tree` reads from, and of those of its friends.
+/// Return false if the tree is not backed by files.
+static bool AppendInputFilesFingerprint(TTree &tree, std::string &fingerprint)
+{
+   std::vector<std::string> fileNames;
+   if (auto chain = dynamic_cast<TChain *>(&tree)) {
+      for (auto element : *chain->GetListOfFiles())
+         fileNames.emplace_back(element->GetTitle());
+   } else if (auto file = tree.GetCurrentFile()) {
+      fileNames.emplace_back(file->GetName());
+   } else {
+      return false;
+   }
+
+   fingerprint += "tree:";
+   fingerprint += tree.GetName();
+   fingerprint += ';';
+   for (const auto &fileName : fileNames) {
+      fingerprint += "file:" + fileName;
+      FileStat_t fileStat;
+      if (gSystem->GetPathInfo(fileName.c_str(), fileStat) == 0)
+         fingerprint += ',' + std::to_string(fileStat.fSize) + ',' + std::to_string(fileStat.fMtime);
+      fingerprint += ';';
+   }
+
+   if (auto friends = tree.GetListOfFriends()) {
+      for (auto friendObj : *friends) {
+         auto friendTree = static_cast<TFriendElement *>(friendObj)->GetTree();
+         if (!friendTree || !AppendInputFilesFingerprint(*friendTree, fingerprint))
+            return false;
+      }
+   }
+   return true;
+}
+
+/// Return a string that identifies the columns cached by `TInterface::Cache`, the computation graph that produces
+/// them and the dataset they come from. `graphFingerprint` describes the filters and ranges upstream of the cached
+/// node, the custom columns and aliases in `validCustomColumns` are described here.
+/// An empty string is returned if the dataset or a custom column cannot be identified, e.g. for data-sources,
+/// in-memory trees and columns defined by compiled callables.
+std::string GetPersistentCacheFingerprint(TLoopManager &lm, const std::string &graphFingerprint,
+                                          const ColumnNames_t &validCustomColumns, const ColumnNames_t &columns,
+                                          const std::vector<std::string> &columnTypeIds)
+{
+   std::string fingerprint;
+   if (lm.GetDataSource()) {
+      return fingerprint;
+   } else if (auto tree = lm.GetTree()) {
+      if (!AppendInputFilesFingerprint(*tree, fingerprint))
+         return std::string();
+   } else {
+      fingerprint += "entries:" + std::to_string(lm.GetNEmptyEntries()) + ';';
+   }
+
+   fingerprint += graphFingerprint;
+   const auto &aliasMap = lm.GetAliasMap();
+   for (const auto &customColumn : validCustomColumns) {
+      if (IsInternalColumn(customColumn))
+         continue;
+      const auto alias = aliasMap.find(customColumn);
+      if (alias != aliasMap.end()) {
+         fingerprint += "alias:" + customColumn + ',' + alias->second + ';';
+         continue;
+      }
+      const auto column = lm.GetBookedBranch(customColumn);
+      if (!column || !column->AppendFingerprint(fingerprint))
+         return std::string();
+   }
+
+   for (auto i : ROOT::TSeqU(columns.size()))
+      fingerprint += "column:" + columns[i] + ',' + columnTypeIds[i] + ';';
+   return fingerprint;
+}
+
+/// Return true if `fileName` exists and contains a persistent cache with the given fingerprint.
+bool IsPersistentCacheValid(std::string_view fileName, const std::string &fingerprint)
+{
+   const std::string fileNameStr(fileName);
+   if (fingerprint.empty() || gSystem->AccessPathName(fileNameStr.c_str()))
+      return false;
+
+   TIgnoreErrorLevelRAII iel(kFatal); // a corrupted or foreign file just means that the cache is invalid
+   std::unique_ptr<TFile> file(TFile::Open(fileNameStr.c_str(), "READ"));
+   if (!file || file->IsZombie())
+      return false;
+   TNamed *storedFingerprintPtr = nullptr;
+   file->GetObject(kPersistentCacheFingerprintName, storedFingerprintPtr);
+   std::unique_ptr<TNamed> storedFingerprint(storedFingerprintPtr);
+   return storedFingerprint && fingerprint == storedFingerprint->GetTitle() &&
+          file->GetKey(kPersistentCacheTreeName) != nullptr;
+}
+
+/// Store the fingerprint of a persistent cache in the file that contains it.
+void WritePersistentCacheFingerprint(std::string_view fileName, const std::string &fingerprint)
+{
+   const std::string fileNameStr(fileName);
+   std::unique_ptr<TFile> file(TFile::Open(fileNameStr.c_str(), "UPDATE"));
+   if (!file || file->IsZombie()) {
+      throw std::runtime_error("Cannot open persistent cache file " + fileNameStr + " to store its fingerprint.");
+   }
+   TNamed storedFingerprint(kPersistentCacheFingerprintName, fingerprint.c_str());
+   storedFingerprint.Write();
+}
+
 } // end ns TDF
 } // end ns Internal
 } // end ns ROOT
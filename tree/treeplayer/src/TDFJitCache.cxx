@@ -0,0 +1,248 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2017, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#include "ROOT/TDFJitCache.hxx"
+#include "TEnv.h"
+#include "TInterpreter.h"
+#include "TMD5.h"
+#include "TROOT.h"
+#include "TSystem.h"
+
+#include <fstream>
+#include <map>
+#include <mutex>
+
+using ROOT::Internal::TDF::JitFunction_t;
+
+namespace {
+std::mutex gJitMutex;
+bool gJitCacheDirSet = false;
+std::string gJitCacheDir;
+/// Functions available in this process, by key
+std::map<std::string, JitFunction_t> gJitFunctions;
+ROOT::Internal::TDF::TJitCounts gJitCounts;
+
+/// To be called with gJitMutex locked
+const std::string &GetJitCacheDirImpl()
+{
+   if (!gJitCacheDirSet) {
+      gJitCacheDir = gEnv->GetValue("TDataFrame.JitCacheDir", "");
+      gJitCacheDirSet = true;
+   }
+   return gJitCacheDir;
+}
+
+/// Identify the code of a function across processes. Libraries compiled against a different ROOT are not reused.
+std::string GetJitKey(const std::string &body)
+{
+   const auto text = body + '\n' + gROOT->GetVersion() + ' ' + gROOT->GetGitCommit();
+   TMD5 md5;
+   md5.Update(reinterpret_cast<const UChar_t *>(text.data()), text.size());
+   md5.Final();
+   return md5.AsString();
+}
+
+std::string GetJitFunctionName(const std::string &key)
+{
+   return "__tdf_jit_" + key;
+}
+
+std::string MakeJitSource(const std::string &key, const std::string &body)
+{
+   return "extern \"C\" Long_t " + GetJitFunctionName(key) + "(void **args)\n{\n" + body + "\n}\n";
+}
+
+/// Whether ACLiC can compile code in `dir` at all, e.g. a compiler is available and the headers of TDataFrame can be
+/// found. Checked once per process, only when a compilation fails, to tell whether the failure comes from the code.
+bool CanCompileJitCode(const std::string &dir)
+{
+   static int canCompile = -1;
+   if (canCompile < 0) {
+      const auto base = dir + "/tdfjit_probe_" + std::to_string(gSystem->GetPid());
+      const auto source = base + ".C";
+      std::ofstream out(source);
+      out << "#include \"ROOT/TDataFrame.hxx\"\n"
+          << "extern \"C\" Long_t __tdf_jit_probe(void **) { return 0; }\n";
+      out.close();
+      canCompile = !out.fail() && gSystem->CompileMacro(source.c_str(), "kOsc-", base.c_str(), dir.c_str());
+      gSystem->Unlink(source.c_str());
+      gSystem->Unlink((base + "." + gSystem->GetSoExt()).c_str());
+   }
+   return canCompile;
+}
+
+/// Load the functions with the given keys and bodies from the library compiled from their code in the cache
+/// directory, compiling the library first if needed. All the functions requested at once are compiled in one library.
+/// Code that cannot be compiled, e.g. because it uses types only known to the interpreter, is flagged as such so that
+/// later processes do not try again: it is jitted by the interpreter instead. Failures that do not come from the code,
+/// e.g. because no compiler is available, are not flagged.
+/// \return The functions, in the same order as the keys, or an empty vector if the library is not available.
+std::vector<JitFunction_t> LoadCachedJitFunctions(const std::string &dir, const std::vector<std::string> &keys,
+                                                  const std::vector<std::string> &bodies, bool &compiled)
+{
+   std::string libraryKey = keys[0];
+   if (keys.size() > 1) {
+      std::string allKeys;
+      for (const auto &key : keys)
+         allKeys += key;
+      libraryKey = GetJitKey(allKeys);
+   }
+   const auto base = dir + "/tdfjit_" + libraryKey;
+   const auto failedFile = base + ".failed";
+   // AccessPathName returns false if the file exists
+   if (!gSystem->AccessPathName(failedFile.c_str()))
+      return {};
+   const auto library = base + "." + gSystem->GetSoExt();
+   if (gSystem->AccessPathName(library.c_str())) {
+      if (gSystem->AccessPathName(dir.c_str()) && gSystem->mkdir(dir.c_str(), kTRUE) != 0)
+         return {};
+      // several processes might share the cache: each one builds the library under its own name, then moves it
+      const auto tmpBase = base + "_" + std::to_string(gSystem->GetPid());
+      const auto tmpSource = tmpBase + ".C";
+      const auto tmpLibrary = tmpBase + "." + gSystem->GetSoExt();
+      std::ofstream out(tmpSource);
+      out << "#include \"ROOT/TDataFrame.hxx\"\n";
+      for (auto i = 0u; i < keys.size(); ++i)
+         out << MakeJitSource(keys[i], bodies[i]);
+      out.close();
+      if (out.fail()) {
+         gSystem->Unlink(tmpSource.c_str());
+         return {};
+      }
+      // compile only: the library is loaded under its final name
+      const bool built = gSystem->CompileMacro(tmpSource.c_str(), "kOsc-", tmpBase.c_str(), dir.c_str());
+      gSystem->Unlink(tmpSource.c_str());
+      if (!built || gSystem->Rename(tmpLibrary.c_str(), library.c_str()) != 0) {
+         gSystem->Unlink(tmpLibrary.c_str());
+         // another process might have moved its library in place meanwhile
+         if (!gSystem->AccessPathName(library.c_str()))
+            return LoadCachedJitFunctions(dir, keys, bodies, compiled);
+         if (!built && CanCompileJitCode(dir))
+            std::ofstream failed(failedFile);
+         return {};
+      }
+      compiled = true;
+   }
+   if (gSystem->Load(library.c_str()) < 0)
+      return {};
+   std::vector<JitFunction_t> functions;
+   for (const auto &key : keys) {
+      auto f = reinterpret_cast<JitFunction_t>(gSystem->DynFindSymbol("*", GetJitFunctionName(key).c_str()));
+      if (!f)
+         return {};
+      functions.emplace_back(f);
+   }
+   return functions;
+}
+} // anonymous namespace
+
+namespace ROOT {
+namespace Experimental {
+namespace TDF {
+
+void SetJitCacheDir(std::string_view dir)
+{
+   std::lock_guard<std::mutex> lock(gJitMutex);
+   gJitCacheDir = std::string(dir);
+   gJitCacheDirSet = true;
+}
+
+std::string GetJitCacheDir()
+{
+   std::lock_guard<std::mutex> lock(gJitMutex);
+   return GetJitCacheDirImpl();
+}
+
+} // ns TDF
+} // ns Experimental
+
+namespace Internal {
+namespace TDF {
+
+/// Return the functions with the given bodies, see JitFunction_t. Functions with the same body are only jitted once
+/// per process. If the jit cache is enabled (see ROOT::Experimental::TDF::SetJitCacheDir) they are loaded from the
+/// cache, where the functions not available yet in this process are compiled together as one shared library if not
+/// found; otherwise, or if they cannot be compiled, they are jitted by the interpreter, all together.
+/// \return The functions, in the same order as the bodies. The ones that cannot be compiled are null.
+std::vector<JitFunction_t> GetJitFunctions(const std::vector<std::string> &bodies)
+{
+   std::lock_guard<std::mutex> lock(gJitMutex);
+   const auto &cacheDir = GetJitCacheDirImpl();
+   std::vector<JitFunction_t> functions(bodies.size(), nullptr);
+   // functions not available in this process, by key, with the indices of their bodies
+   std::map<std::string, std::vector<std::size_t>> missing;
+   for (auto i = 0u; i < bodies.size(); ++i) {
+      const auto key = GetJitKey(bodies[i]);
+      auto available = gJitFunctions.find(key);
+      if (available != gJitFunctions.end())
+         functions[i] = available->second;
+      else
+         missing[key].emplace_back(i);
+   }
+   if (missing.empty())
+      return functions;
+
+   std::vector<std::string> keys;
+   std::vector<std::string> missingBodies;
+   for (const auto &keyAndIndices : missing) {
+      keys.emplace_back(keyAndIndices.first);
+      missingBodies.emplace_back(bodies[keyAndIndices.second[0]]);
+   }
+   std::vector<JitFunction_t> missingFunctions;
+   if (!cacheDir.empty()) {
+      bool compiled = false;
+      missingFunctions = LoadCachedJitFunctions(cacheDir, keys, missingBodies, compiled);
+      if (!missingFunctions.empty())
+         (compiled ? gJitCounts.fNCompiled : gJitCounts.fNLoaded) += missingFunctions.size();
+   }
+   if (missingFunctions.empty()) {
+      std::string declarations;
+      for (auto i = 0u; i < keys.size(); ++i)
+         declarations += MakeJitSource(keys[i], missingBodies[i]);
+      if (!gInterpreter->Declare(declarations.c_str()))
+         return functions;
+      for (const auto &key : keys) {
+         const auto name = GetJitFunctionName(key);
+         auto f = reinterpret_cast<JitFunction_t>(gInterpreter->FindSym(name.c_str()));
+         if (!f)
+            f = reinterpret_cast<JitFunction_t>(gInterpreter->Calc(("(Long_t)&" + name).c_str()));
+         missingFunctions.emplace_back(f);
+         if (f)
+            ++gJitCounts.fNInterpreted;
+      }
+   }
+
+   for (auto k = 0u; k < keys.size(); ++k) {
+      if (!missingFunctions[k])
+         continue;
+      gJitFunctions[keys[k]] = missingFunctions[k];
+      for (auto i : missing[keys[k]])
+         functions[i] = missingFunctions[k];
+   }
+   return functions;
+}
+
+TJitCounts GetJitCounts()
+{
+   std::lock_guard<std::mutex> lock(gJitMutex);
+   return gJitCounts;
+}
+
+/// Forget the functions available in this process, so that they are looked up in the jit cache again as if by a new
+/// process. Only meant for tests: the libraries loaded stay loaded, and the interpreter keeps the jitted functions.
+void ClearJitFunctions()
+{
+   std::lock_guard<std::mutex> lock(gJitMutex);
+   gJitFunctions.clear();
+}
+
+} // ns TDF
+} // ns Internal
+} // ns ROOT
@@ -10,16 +10,31 @@
 
 #include "RConfigure.h" // R__USE_IMT
 #include "ROOT/TDFNodes.hxx"
+#include "ROOT/TDFProfiling.hxx"
 #include "ROOT/TSpinMutex.hxx"
 #include "ROOT/TTreeProcessorMT.hxx"
 #ifdef R__USE_IMT
 #include "ROOT/TThreadExecutor.hxx"
 #endif
+#ifndef R__WIN32
+#include "ROOT/TProcessExecutor.hxx"
+#endif
+#include "ROOT/TSeq.hxx"
 #include "RtypesCore.h" // Long64_t
+#include "TBranch.h"
+#include "TBufferFile.h"
+#include "TChain.h"
+#include "TDataType.h"
+#include "TFile.h"
 #include "TInterpreter.h"
+#include "TLeaf.h"
 #include "TROOT.h" // IsImplicitMTEnabled
+#include "TString.h"
+#include "TSystem.h"
+#include "TTree.h"
 #include "TTreeReader.h"
 
+#include <algorithm>
 #include <cassert>
 #include <mutex>
 #include <string>
@@ -36,6 +51,84 @@ TActionBase::TActionBase(TLoopManager *implPtr, const unsigned int nSlots) : fIm
 {
 }
 
+void TActionBase::InitNode()
+{
+   fProfiler = fImplPtr->GetProfiler();
+   if (fProfiler)
+      fProfileId = fProfiler->GetNodeId(this, TProfiler::ENodeKind::kAction, GetProfileName());
+}
+
+TBulkBranchReader::TBulkBranchReader(TTreeReader &r, const std::string &branchName, const std::type_info &type)
+   : fReader(&r), fBranchName(branchName), fType(type), fBuffer(new TBufferFile(TBuffer::kRead, 10000))
+{
+}
+
+TBulkBranchReader::~TBulkBranchReader() = default;
+
+/// Return true if the branch can be read in bulk as values of the given type in the current tree of the reader.
+/// The other trees of a chain are checked when they are loaded, see LoadBasket.
+bool TBulkBranchReader::CanRead(TTreeReader &r, const std::string &branchName, const std::type_info &type)
+{
+   // with an entry list, the entry numbers of the reader are not entry numbers in the tree
+   if (r.GetEntryList())
+      return false;
+   auto tree = r.GetTree();
+   // in case of a TChain, GetBranch also loads the first tree if needed
+   if (!tree || !tree->GetBranch(branchName.c_str()) || !tree->GetTree())
+      return false;
+   return CanRead(*tree->GetTree(), branchName, type);
+}
+
+/// Return true if `tree` stores the branch in a way that can be read in bulk as values of the given type: it must be
+/// a branch of the tree (not of one of its friends) with a single leaf, storing a single value of that very type per
+/// entry.
+bool TBulkBranchReader::CanRead(TTree &tree, const std::string &branchName, const std::type_info &type)
+{
+   auto branch = tree.GetBranch(branchName.c_str());
+   // TBranchElements and TBranchObjects are not eligible, as well as branches of friend trees, which might be aligned
+   // to the entries of the main tree through an index
+   if (!branch || branch->IsA() != TBranch::Class() || branch->GetTree() != &tree)
+      return false;
+   if (branch->GetNleaves() != 1)
+      return false;
+   auto leaf = static_cast<TLeaf *>(branch->GetListOfLeaves()->UncheckedAt(0));
+   if (leaf->GetLeafCount() || leaf->GetLenStatic() != 1)
+      return false;
+   auto dataType = gROOT->GetType(leaf->GetTypeName());
+   return dataType && dataType->GetType() == TDataType::GetType(type);
+}
+
+/// Read the basket containing `entry` into fBuffer, starting from `entry` itself. Return false, without reading,
+/// if the current tree does not store the branch in a way that can be read in bulk.
+// The branch is looked up every time a basket is loaded because, in case of a TChain, the current TTree (and all its
+// branches) change every time the reader moves to a different file.
+bool TBulkBranchReader::LoadBasket(Long64_t entry)
+{
+   auto tree = fReader->GetTree()->GetTree();
+   if (!tree) {
+      const auto msg = "TBulkBranchReader: no tree loaded to read branch \"" + fBranchName + "\".";
+      throw std::runtime_error(msg);
+   }
+   const auto treeNumber = fReader->GetTree()->GetTreeNumber();
+   if (treeNumber != fCheckedTreeNumber) {
+      fCheckedTreeNumber = treeNumber;
+      fCanReadCheckedTree = CanRead(*tree, fBranchName, fType);
+   }
+   if (!fCanReadCheckedTree)
+      return false;
+   auto branch = tree->GetBranch(fBranchName.c_str());
+   const auto nEntries = branch->GetBulkEntries(entry - tree->GetChainOffset(), *fBuffer);
+   if (nEntries <= 0) {
+      const auto msg = "TBulkBranchReader: could not read entry " + std::to_string(entry) + " of branch \"" +
+                       fBranchName + "\".";
+      throw std::runtime_error(msg);
+   }
+   fValues = fBuffer->Buffer();
+   fFirstEntry = entry;
+   fNEntries = nEntries;
+   return true;
+}
+
 } // end NS TDF
 } // end NS Internal
 } // end NS ROOT
@@ -56,9 +149,24 @@ TLoopManager *TCustomColumnBase::GetImplPtr() const
    return fImplPtr;
 }
 
+/// Append the name, type and expression of this column to `fingerprint`.
+/// Return false for columns defined by compiled callables, which cannot be described.
+bool TCustomColumnBase::AppendFingerprint(std::string &fingerprint) const
+{
+   if (fJittedExpression.empty())
+      return false;
+   fingerprint += "define:" + fName + ',' + GetTypeId().name() + ',' + fJittedExpression + ';';
+   return true;
+}
+
 void TCustomColumnBase::InitNode()
 {
    fLastCheckedEntry = std::vector<Long64_t>(fNSlots, -1);
+   fProfiler = fImplPtr->GetProfiler();
+   if (fProfiler) {
+      const auto kind = fIsDataSourceColumn ? TProfiler::ENodeKind::kColumn : TProfiler::ENodeKind::kDefine;
+      fProfileId = fProfiler->GetNodeId(this, kind, fName);
+   }
 }
 
 TFilterBase::TFilterBase(TLoopManager *implPtr, std::string_view name, const unsigned int nSlots)
@@ -76,6 +184,19 @@ bool TFilterBase::HasName() const
    return !fName.empty();
 };
 
+/// Append the name, expression and columns of this filter to `fingerprint`.
+/// Return false for filters defined by compiled callables, which cannot be described.
+bool TFilterBase::AppendNodeFingerprint(std::string &fingerprint) const
+{
+   if (fJittedExpression.empty())
+      return false;
+   fingerprint += "filter:" + fName + ',' + fJittedExpression;
+   for (const auto &column : GetColumnNames())
+      fingerprint += ',' + column;
+   fingerprint += ';';
+   return true;
+}
+
 void TFilterBase::PrintReport() const
 {
    if (fName.empty()) // PrintReport is no-op for unnamed filters
@@ -94,17 +215,57 @@ void TFilterBase::InitNode()
    fLastCheckedEntry = std::vector<Long64_t>(fNSlots, -1);
    if (!fName.empty()) // if this is a named filter we care about its report count
       ResetReportCount();
+   fProfiler = fImplPtr->GetProfiler();
+   if (fProfiler) {
+      // unnamed filters are identified by the columns they read
+      auto name = fName;
+      if (name.empty()) {
+         const auto &columns = GetColumnNames();
+         name = "Filter(";
+         for (auto i = 0u; i < columns.size(); ++i)
+            name += (i ? ", " : "") + columns[i];
+         name += ')';
+      }
+      fProfileId = fProfiler->GetNodeId(this, TProfiler::ENodeKind::kFilter, name);
+   }
 }
 
+namespace {
+/// Return the names of the files a tree or chain reads from
+std::vector<std::string> GetFileNames(TTree &tree)
+{
+   std::vector<std::string> fileNames;
+   if (auto chain = dynamic_cast<TChain *>(&tree)) {
+      for (auto file : *chain->GetListOfFiles())
+         fileNames.emplace_back(file->GetTitle());
+   } else if (auto file = tree.GetCurrentFile()) {
+      fileNames.emplace_back(file->GetName());
+   }
+   return fileNames;
+}
+
+/// Return the names of the friends of a tree or chain
+std::vector<std::string> GetFriendNames(TTree &tree)
+{
+   std::vector<std::string> friendNames;
+   if (auto friends = tree.GetListOfFriends()) {
+      for (auto fr : *friends)
+         friendNames.emplace_back(fr->GetName());
+   }
+   return friendNames;
+}
+} // anonymous namespace
+
 void TSlotStack::ReturnSlot(unsigned int slotNumber)
 {
-   auto &index = GetIndex();
-   auto &count = GetCount();
-   assert(count > 0U && "TSlotStack has a reference count relative to an index which will become negative.");
+   std::lock_guard<ROOT::TSpinMutex> guard(fMutex);
+   auto threadSlot = fThreadSlots.find(std::this_thread::get_id());
+   assert(threadSlot != fThreadSlots.end() && threadSlot->second.second > 0U &&
+          "TSlotStack has a reference count relative to an index which will become negative.");
+   auto &count = threadSlot->second.second;
    count--;
    if (0U == count) {
-      index = UINT_MAX;
-      std::lock_guard<ROOT::TSpinMutex> guard(fMutex);
+      fThreadSlots.erase(threadSlot);
       fBuf[fCursor++] = slotNumber;
       assert(fCursor <= fBuf.size() && "TSlotStack assumes that at most a fixed number of values can be present in the "
                                        "stack. fCursor is greater than the size of the internal buffer. This violates "
@@ -114,16 +275,15 @@ void TSlotStack::ReturnSlot(unsigned int slotNumber)
 
 unsigned int TSlotStack::GetSlot()
 {
-   auto &index = GetIndex();
-   auto &count = GetCount();
-   count++;
-   if (UINT_MAX != index)
-      return index;
    std::lock_guard<ROOT::TSpinMutex> guard(fMutex);
+   auto &threadSlot = fThreadSlots[std::this_thread::get_id()];
+   auto &count = threadSlot.second;
+   if (count++ > 0U)
+      return threadSlot.first;
    assert(fCursor > 0 && "TSlotStack assumes that a value can be always obtained. In this case fCursor is <=0 and this "
                          "violates such assumption.");
-   index = fBuf[--fCursor];
-   return index;
+   threadSlot.first = fBuf[--fCursor];
+   return threadSlot.first;
 }
 
 TLoopManager::TLoopManager(TTree *tree, const ColumnNames_t &defaultBranches)
@@ -154,11 +314,14 @@ void TLoopManager::RunEmptySourceMT()
    TSlotStack slotStack(fNSlots);
    // Working with an empty tree.
    // Evenly partition the entries according to fNSlots. Produce around 2 tasks per slot.
-   const auto nEntriesPerSlot = fNEmptyEntries / (fNSlots * 2);
-   auto remainder = fNEmptyEntries % (fNSlots * 2);
+   const auto firstEntry = std::min(fEntryWindow.first, fNEmptyEntries);
+   const auto endEntry = std::min(fEntryWindow.second, fNEmptyEntries);
+   const auto nEntries = endEntry - firstEntry;
+   const auto nEntriesPerSlot = nEntries / (fNSlots * 2);
+   auto remainder = nEntries % (fNSlots * 2);
    std::vector<std::pair<ULong64_t, ULong64_t>> entryRanges;
-   ULong64_t start = 0;
-   while (start < fNEmptyEntries) {
+   ULong64_t start = firstEntry;
+   while (start < endEntry) {
       ULong64_t end = start + nEntriesPerSlot;
       if (remainder > 0) {
          ++end;
@@ -171,6 +334,7 @@ void TLoopManager::RunEmptySourceMT()
    // Each task will generate a subrange of entries
    auto genFunction = [this, &slotStack](const std::pair<ULong64_t, ULong64_t> &range) {
       auto slot = slotStack.GetSlot();
+      fTaskRanges[slot] = range;
       InitNodeSlots(nullptr, slot);
       for (auto currEntry = range.first; currEntry < range.second; ++currEntry) {
          RunAndCheckFilters(slot, currEntry);
@@ -189,9 +353,10 @@ void TLoopManager::RunEmptySourceMT()
 void TLoopManager::RunEmptySource()
 {
    InitNodeSlots(nullptr, 0);
-   for (ULong64_t currEntry = 0; currEntry < fNEmptyEntries && fNStopsReceived < fNChildren; ++currEntry) {
+   for (ULong64_t currEntry = 0; currEntry < fNEmptyEntries && !HaveAllStopped(); ++currEntry) {
       RunAndCheckFilters(0, currEntry);
    }
+   StopProfilingTask(0);
 }
 
 /// Run event loop over one or multiple ROOT files, in parallel.
@@ -202,9 +367,13 @@ void TLoopManager::RunTreeProcessorMT()
    using ttpmt_t = ROOT::TTreeProcessorMT;
    std::unique_ptr<ttpmt_t> tp;
    tp.reset(new ttpmt_t(*fTree));
+   const auto maxEntry = ULong64_t(std::numeric_limits<Long64_t>::max());
+   tp->SetEntriesRange(std::min(fEntryWindow.first, maxEntry), std::min(fEntryWindow.second, maxEntry));
 
    tp->Process([this, &slotStack](TTreeReader &r) -> void {
       auto slot = slotStack.GetSlot();
+      const auto range = r.GetEntriesRange();
+      fTaskRanges[slot] = std::make_pair(ULong64_t(range.first), ULong64_t(range.second));
       InitNodeSlots(&r, slot);
       // recursive call to check filters and conditionally execute actions
       while (r.Next()) {
@@ -221,13 +390,15 @@ void TLoopManager::RunTreeReader()
 {
    TTreeReader r(fTree.get());
    if (0 == fTree->GetEntriesFast()) return;
+   fTaskRanges[0] = std::make_pair(0ull, std::numeric_limits<ULong64_t>::max());
    InitNodeSlots(&r, 0);
 
    // recursive call to check filters and conditionally execute actions
    // in the non-MT case processing can be stopped early by ranges, hence the check on fNStopsReceived
-   while (r.Next() && fNStopsReceived < fNChildren) {
+   while (r.Next() && !HaveAllStopped()) {
       RunAndCheckFilters(0, r.GetCurrentEntry());
    }
+   StopProfilingTask(0);
    fTree->GetEntry(0);
 }
 
@@ -247,6 +418,7 @@ void TLoopManager::RunDataSource()
             RunAndCheckFilters(0u, entry);
          }
       }
+      StopProfilingTask(0u);
       fDataSource->FinaliseSlot(0u);
       ranges = fDataSource->GetEntryRanges();
    }
@@ -264,6 +436,7 @@ void TLoopManager::RunDataSourceMT()
    // Each task works on a subrange of entries
    auto runOnRange = [this, &slotStack](const std::pair<ULong64_t, ULong64_t> &range) {
       const auto slot = slotStack.GetSlot();
+      fTaskRanges[slot] = range;
       InitNodeSlots(nullptr, slot);
       fDataSource->InitSlot(slot, range.first);
       const auto end = range.second;
@@ -276,9 +449,26 @@ void TLoopManager::RunDataSourceMT()
       slotStack.ReturnSlot(slot);
    };
 
+   // Only keep the parts of the ranges that are within the entry window. Once all ranges start past its end, no more
+   // ranges are requested, which spares the data-source the preparation of data that would not be processed.
+   auto clipRanges = [this](std::vector<std::pair<ULong64_t, ULong64_t>> &ranges) {
+      bool windowEnded = true;
+      std::vector<std::pair<ULong64_t, ULong64_t>> clippedRanges;
+      for (const auto &range : ranges) {
+         const auto start = std::max(range.first, fEntryWindow.first);
+         const auto end = std::min(range.second, fEntryWindow.second);
+         if (start < end)
+            clippedRanges.emplace_back(start, end);
+         if (range.first < fEntryWindow.second)
+            windowEnded = false;
+      }
+      ranges = std::move(clippedRanges);
+      return !windowEnded;
+   };
+
    fDataSource->Initialise();
    auto ranges = fDataSource->GetEntryRanges();
-   while (!ranges.empty()) {
+   while (!ranges.empty() && clipRanges(ranges)) {
       pool.Foreach(runOnRange, ranges);
       ranges = fDataSource->GetEntryRanges();
    }
@@ -290,9 +480,12 @@ void TLoopManager::RunDataSourceMT()
 /// Named filters must be called even if the analysis logic would not require it, lest they report confusing results.
 void TLoopManager::RunAndCheckFilters(unsigned int slot, Long64_t entry)
 {
+   if (fProfiler)
+      fProfiler->CountEntry(slot);
    for (auto &actionPtr : fBookedActions) actionPtr->Run(slot, entry);
    for (auto &namedFilterPtr : fBookedNamedFilters) namedFilterPtr->CheckFilters(slot, entry);
    for (auto &callback : fCallbacks) callback(slot);
+   for (auto loop : fFusedLoops) loop->RunAndCheckFilters(slot, entry);
 }
 
 /// Build TTreeReaderValues for all nodes
@@ -302,11 +495,17 @@ void TLoopManager::RunAndCheckFilters(unsigned int slot, Long64_t entry)
 /// a particular slot will be using.
 void TLoopManager::InitNodeSlots(TTreeReader *r, unsigned int slot)
 {
+   if (fProfiler)
+      fProfiler->StartTask(slot);
    // booked branches must be initialized first because other nodes might need to point to the values they encapsulate
    for (auto &bookedBranch : fBookedCustomColumns) bookedBranch.second->InitSlot(r, slot);
    for (auto &ptr : fBookedActions) ptr->InitSlot(r, slot);
    for (auto &ptr : fBookedFilters) ptr->InitSlot(r, slot);
    for (auto &callback : fCallbacksOnce) callback(slot);
+   for (auto loop : fFusedLoops) {
+      loop->fTaskRanges[slot] = fTaskRanges[slot];
+      loop->InitNodeSlots(r, slot);
+   }
 }
 
 /// Initialize all nodes of the functional graph before running the event loop.
@@ -316,8 +515,11 @@ void TLoopManager::InitNodeSlots(TTreeReader *r, unsigned int slot)
 void TLoopManager::InitNodes()
 {
    EvalChildrenCounts();
+   EvalEntryWindow();
+   fTaskRanges.resize(fNSlots);
    for (auto &filter : fBookedFilters) filter->InitNode();
    for (auto &customColumn : fBookedCustomColumns) customColumn.second->InitNode();
+   for (auto &action : fBookedActions) action->InitNode();
 }
 
 /// Perform clean-up operations. To be called at the end of each event loop.
@@ -345,22 +547,48 @@ void TLoopManager::CleanUpNodes()
 /// Perform clean-up operations. To be called at the end of each task execution.
 void TLoopManager::CleanUpTask(unsigned int slot)
 {
+   for (auto &ptr : fBookedActions) ptr->FinalizeTask(slot);
    for (auto &ptr : fBookedActions) ptr->ClearValueReaders(slot);
    for (auto &ptr : fBookedFilters) ptr->ClearValueReaders(slot);
    for (auto &pair : fBookedCustomColumns) pair.second->ClearValueReaders(slot);
+   if (fProfiler)
+      fProfiler->StopTask(slot);
+   for (auto loop : fFusedLoops) loop->CleanUpTask(slot);
+}
+
+/// Stop timing the task running on `slot`, for all the graphs run by the event loop. Only needed by the single-thread
+/// event loops, which do not call CleanUpTask.
+void TLoopManager::StopProfilingTask(unsigned int slot)
+{
+   if (fProfiler)
+      fProfiler->StopTask(slot);
+   for (auto loop : fFusedLoops) loop->StopProfilingTask(slot);
+}
+
+/// Whether all the branches of execution of the graphs run by the event loop reached the end of their ranges
+bool TLoopManager::HaveAllStopped() const
+{
+   return fNStopsReceived >= fNChildren &&
+          std::all_of(fFusedLoops.begin(), fFusedLoops.end(), [](TLoopManager *l) { return l->HaveAllStopped(); });
 }
 
 /// Jit all actions that required runtime column type inference, and clean the `fToJit` member variable.
+/// The jitted code might come from the jit cache, see GetJitFunctions.
 void TLoopManager::JitActions()
 {
-   auto error = TInterpreter::EErrorCode::kNoError;
-   gInterpreter->Calc(fToJit.c_str(), &error);
-   if (TInterpreter::EErrorCode::kNoError != error) {
+   std::vector<std::string> bodies;
+   for (const auto &call : fToJit)
+      bodies.emplace_back(call.fBody);
+   const auto functions = GetJitFunctions(bodies);
+   if (std::find(functions.begin(), functions.end(), nullptr) != functions.end()) {
       std::string exceptionText =
          "An error occurred while jitting. The lines above might indicate the cause of the crash\n";
       throw std::runtime_error(exceptionText.c_str());
    }
+   auto toJit = std::move(fToJit);
    fToJit.clear();
+   for (auto i = 0u; i < toJit.size(); ++i)
+      functions[i](toJit[i].fArgs.data());
 }
 
 /// Trigger counting of number of children nodes for each node of the functional graph.
@@ -375,25 +603,438 @@ void TLoopManager::EvalChildrenCounts()
    for (auto &namedFilterPtr : fBookedNamedFilters) namedFilterPtr->TriggerChildrenCount();
 }
 
+/// Compute the window of entries processed by the event loop.
+/// Ranges cannot stop multi-thread event loops early, as entries are not processed in order. Instead, if all the nodes
+/// hanging from this one are ranges, the entries that no range lets through are not processed at all.
+/// Sequential event loops are stopped by the ranges themselves: there the window only bounds the batches of entries
+/// evaluated at once by filters, see TFilter::EvalBatch.
+/// To be called after EvalChildrenCounts.
+void TLoopManager::EvalEntryWindow()
+{
+   fEntryWindow = {0ull, std::numeric_limits<ULong64_t>::max()};
+   auto window = std::make_pair(std::numeric_limits<ULong64_t>::max(), 0ull);
+   unsigned int nRanges = 0;
+   for (const auto &range : fBookedRanges) {
+      if (!range->SelectsByEntryNumber() || !range->HasChildren())
+         continue;
+      ++nRanges;
+      const auto rangeWindow = range->GetEntryWindow();
+      window.first = std::min(window.first, rangeWindow.first);
+      window.second = std::max(window.second, rangeWindow.second);
+   }
+   if (nRanges > 0 && nRanges == fNChildren)
+      fEntryWindow = window;
+}
+
+/// Return the maximum number of entries that filters can evaluate in one batch: the number of entries that the booked
+/// ranges can still let through. Reading more entries could invoke filters upstream of a range on entries that come
+/// after the end of the range, and that the event loop would not process.
+ULong64_t TLoopManager::GetMaxBatchSize() const
+{
+   auto maxSize = std::numeric_limits<ULong64_t>::max();
+   for (const auto &range : fBookedRanges)
+      maxSize = std::min(maxSize, range->GetNRemainingEntries());
+   return maxSize;
+}
+
+/// Wait for the event loop started by RunAsync, if it is still running.
+TLoopManager::~TLoopManager()
+{
+#ifdef R__USE_IMT
+   // an event loop started by RunAsync might still be using this object
+   if (fAsyncTask)
+      fAsyncTask->Wait();
+#endif
+}
+
+/// Run the event loop, unless an event loop started by RunAsync has just produced the booked results.
+void TLoopManager::Run()
+{
+   // nothing can be booked while an asynchronous event loop runs: if there was one, it produced all booked results
+   if (WaitAsyncRun())
+      return;
+   const auto fusedLoops = FuseSharedLoops();
+   RunEventLoop();
+}
+
+#ifdef R__USE_IMT
+/// Start the event loop in a task of the ROOT thread pool and return immediately, see TInterface::RunAsync.
+/// Without ImplicitMT, the event loop is run synchronously.
+ROOT::Experimental::TFuture<void> TLoopManager::RunAsync()
+{
+   WaitAsyncRun();
+   // the loop managers run together with this one are kept alive by their destructor, which waits for the task
+   FuseSharedLoops();
+   if (!ROOT::IsImplicitMTEnabled()) {
+      std::promise<void> done;
+      try {
+         RunEventLoop();
+         done.set_value();
+      } catch (...) {
+         done.set_exception(std::current_exception());
+      }
+      return ROOT::Experimental::TFuture<void>(done.get_future());
+   }
+
+   // jitting involves the interpreter: do it in the calling thread rather than in the task
+   if (!fToJit.empty())
+      JitActions();
+   // the results are flagged as ready by the thread that waits for the event loop, which then owns them
+   fAsyncResProxyReadiness = std::move(fResProxyReadiness);
+   fResProxyReadiness.clear();
+
+   auto done = std::make_shared<std::promise<void>>();
+   fAsyncDone = done->get_future().share();
+   fAsyncTask = std::make_shared<ROOT::Experimental::TTaskGroup>();
+   for (auto loop : fFusedLoops) {
+      loop->fAsyncTask = fAsyncTask;
+      loop->fAsyncDone = fAsyncDone;
+      loop->fAsyncResProxyReadiness = std::move(loop->fResProxyReadiness);
+      loop->fResProxyReadiness.clear();
+   }
+   fAsyncTask->Run([this, done]() {
+      try {
+         RunEventLoop();
+         done->set_value();
+      } catch (...) {
+         done->set_exception(std::current_exception());
+      }
+   });
+
+   auto task = fAsyncTask;
+   auto asyncDone = fAsyncDone;
+   return ROOT::Experimental::TFuture<void>(std::async(std::launch::deferred, [task, asyncDone]() {
+      // waiting on the task group, rather than on the future, lets this thread take part in the processing
+      task->Wait();
+      asyncDone.get();
+   }));
+}
+#endif
+
+/// Wait for the end of the event loop started by RunAsync, if any, and flag its results as ready.
+/// Exceptions thrown during that event loop are re-thrown here.
+/// \return Whether there was such an event loop to wait for.
+bool TLoopManager::WaitAsyncRun()
+{
+#ifdef R__USE_IMT
+   if (!fAsyncTask)
+      return false;
+   fAsyncTask->Wait();
+   fAsyncTask.reset();
+   auto done = std::move(fAsyncDone);
+   fAsyncDone = std::shared_future<void>();
+   auto readiness = std::move(fAsyncResProxyReadiness);
+   fAsyncResProxyReadiness.clear();
+   done.get();
+   for (auto &r : readiness)
+      *r = true;
+   return true;
+#else
+   return false;
+#endif
+}
+
 /// Start the event loop with a different mechanism depending on IMT/no IMT, data source/no data source.
 /// Also perform a few setup and clean-up operations (jit actions if necessary, clear booked actions after the loop...).
-void TLoopManager::Run()
+/// The event loop runs in the calling thread.
+void TLoopManager::RunEventLoop()
 {
    if (!fToJit.empty())
       JitActions();
 
    InitNodes();
+   for (auto loop : fFusedLoops) {
+      loop->InitNodes();
+      // the event loop must cover the entries needed by all the graphs it runs
+      fEntryWindow.first = std::min(fEntryWindow.first, loop->fEntryWindow.first);
+      fEntryWindow.second = std::max(fEntryWindow.second, loop->fEntryWindow.second);
+   }
+   if (fProfiler)
+      fProfiler->StartLoop();
+   for (auto loop : fFusedLoops)
+      if (loop->fProfiler)
+         loop->fProfiler->StartLoop();
 
-   switch (fLoopType) {
-   case ELoopType::kNoFilesMT: RunEmptySourceMT(); break;
-   case ELoopType::kROOTFilesMT: RunTreeProcessorMT(); break;
-   case ELoopType::kDataSourceMT: RunDataSourceMT(); break;
-   case ELoopType::kNoFiles: RunEmptySource(); break;
-   case ELoopType::kROOTFiles: RunTreeReader(); break;
-   case ELoopType::kDataSource: RunDataSource(); break;
+   if (fNWorkerProcesses > 0) {
+      RunMultiProcess();
+   } else {
+      switch (fLoopType) {
+      case ELoopType::kNoFilesMT: RunEmptySourceMT(); break;
+      case ELoopType::kROOTFilesMT: RunTreeProcessorMT(); break;
+      case ELoopType::kDataSourceMT: RunDataSourceMT(); break;
+      case ELoopType::kNoFiles: RunEmptySource(); break;
+      case ELoopType::kROOTFiles: RunTreeReader(); break;
+      case ELoopType::kDataSource: RunDataSource(); break;
+      }
    }
 
+   if (fProfiler)
+      fProfiler->StopLoop();
    CleanUpNodes();
+   // profiling only applies to the event loop during which the profile was requested
+   fProfiler.reset();
+   for (auto loop : fFusedLoops) {
+      if (loop->fProfiler)
+         loop->fProfiler->StopLoop();
+      loop->CleanUpNodes();
+      loop->fProfiler.reset();
+   }
+   fFusedLoops.clear();
+}
+
+/// Whether some results booked on this object are still to be produced by an event loop
+bool TLoopManager::NeedsEventLoop() const
+{
+   return !fBookedActions.empty() || !fToJit.empty() || (fMustRunNamedFilters && !fBookedNamedFilters.empty());
+}
+
+/// Select the loop managers sharing the event loop of this object that have results to produce, to be run by the
+/// next event loop of this object. Their jitted actions are compiled at this point.
+/// \return Owning pointers to the selected loop managers.
+std::vector<std::shared_ptr<TLoopManager>> TLoopManager::FuseSharedLoops()
+{
+   std::vector<std::shared_ptr<TLoopManager>> loops;
+   fFusedLoops.clear();
+   for (const auto &weakLoop : fSharedLoops) {
+      auto loop = weakLoop.lock();
+      if (!loop)
+         continue;
+      loop->WaitAsyncRun();
+      if (!loop->NeedsEventLoop())
+         continue;
+      if (!loop->fToJit.empty())
+         loop->JitActions();
+      fFusedLoops.emplace_back(loop.get());
+      loops.emplace_back(std::move(loop));
+   }
+   return loops;
+}
+
+/// Return this object and the loop managers that share its event loop
+std::vector<std::shared_ptr<TLoopManager>> TLoopManager::GetSharedLoopGroup()
+{
+   std::vector<std::shared_ptr<TLoopManager>> group{shared_from_this()};
+   for (const auto &weakLoop : fSharedLoops)
+      if (auto loop = weakLoop.lock())
+         group.emplace_back(std::move(loop));
+   return group;
+}
+
+/// Throw if the event loop of `other` does not process the same entries as the one of this object
+void TLoopManager::CheckSameDataset(const TLoopManager &other) const
+{
+   if (fLoopType != other.fLoopType || fNSlots != other.fNSlots)
+      throw std::runtime_error("ShareEventLoop: the two TDataFrames were created with different ImplicitMT settings.");
+   switch (fLoopType) {
+   case ELoopType::kDataSource:
+   case ELoopType::kDataSourceMT:
+      throw std::runtime_error("ShareEventLoop: TDataFrames reading from a data source cannot share an event loop.");
+   case ELoopType::kNoFiles:
+   case ELoopType::kNoFilesMT:
+      if (fNEmptyEntries != other.fNEmptyEntries)
+         throw std::runtime_error("ShareEventLoop: the two TDataFrames have different numbers of entries.");
+      break;
+   case ELoopType::kROOTFiles:
+   case ELoopType::kROOTFilesMT:
+      if (std::string(fTree->GetName()) != other.fTree->GetName() || GetFileNames(*fTree) != GetFileNames(*other.fTree) ||
+          GetFriendNames(*fTree) != GetFriendNames(*other.fTree))
+         throw std::runtime_error("ShareEventLoop: the two TDataFrames do not read the same trees, files and friends.");
+      break;
+   }
+}
+
+/// Run the event loops of this object and of `other`, and of the ones they already share their event loops with,
+/// together from now on. Both must process the same dataset.
+void TLoopManager::ShareEventLoop(TLoopManager &other)
+{
+   CheckSameDataset(other);
+   if (fNWorkerProcesses > 0 || other.fNWorkerProcesses > 0)
+      throw std::runtime_error("ShareEventLoop: TDataFrames running multi-process event loops cannot share them.");
+   WaitAsyncRun();
+   other.WaitAsyncRun();
+   auto group = GetSharedLoopGroup();
+   if (std::find_if(group.begin(), group.end(), [&other](const std::shared_ptr<TLoopManager> &l) {
+          return l.get() == &other;
+       }) != group.end())
+      return;
+   const auto otherGroup = other.GetSharedLoopGroup();
+   for (auto &loop : group) {
+      for (auto &otherLoop : otherGroup) {
+         loop->fSharedLoops.emplace_back(otherLoop);
+         otherLoop->fSharedLoops.emplace_back(loop);
+      }
+   }
+}
+
+/// Run the next event loops in `nWorkers` processes, or in as many processes as cores if `nWorkers` is 0.
+/// See TInterface::EnableMultiProcess.
+void TLoopManager::EnableMultiProcess(unsigned int nWorkers)
+{
+#ifdef R__WIN32
+   (void)nWorkers;
+   throw std::runtime_error("EnableMultiProcess: multi-process event loops are not supported on this platform.");
+#else
+   WaitAsyncRun();
+   if (IsMultiThreaded())
+      throw std::runtime_error(
+         "EnableMultiProcess: the TDataFrame was created with ImplicitMT enabled, it runs multi-thread event loops.");
+   if (fDataSource)
+      throw std::runtime_error("EnableMultiProcess: TDataFrames reading from a data source cannot run multi-process "
+                               "event loops.");
+   if (GetSharedLoopGroup().size() > 1)
+      throw std::runtime_error("EnableMultiProcess: the TDataFrame shares its event loop with other TDataFrames.");
+   if (nWorkers == 0) {
+      SysInfo_t info;
+      gSystem->GetSysInfo(&info);
+      nWorkers = info.fCpus > 0 ? info.fCpus : 1;
+   }
+   fNWorkerProcesses = nWorkers;
+#endif
+}
+
+/// Run the next event loops in this process again
+void TLoopManager::DisableMultiProcess()
+{
+   WaitAsyncRun();
+   fNWorkerProcesses = 0;
+}
+
+/// Split the entries in one contiguous range per worker process. The ranges of entries read from a TTree start at
+/// cluster boundaries, so that no cluster is read by two processes, and might therefore be fewer than the workers.
+std::vector<std::pair<ULong64_t, ULong64_t>> TLoopManager::MakeWorkerRanges() const
+{
+   std::vector<Long64_t> boundaries;
+   if (fTree)
+      boundaries = GetClusterBoundaries(*fTree);
+   const ULong64_t nEntries = fTree ? boundaries.back() : fNEmptyEntries;
+   std::vector<std::pair<ULong64_t, ULong64_t>> ranges;
+   ULong64_t begin = 0;
+   for (auto i = 1ull; i <= fNWorkerProcesses; ++i) {
+      auto end = nEntries / fNWorkerProcesses * i + std::min(i, nEntries % fNWorkerProcesses);
+      if (fTree)
+         end = *std::lower_bound(boundaries.begin(), boundaries.end(), Long64_t(end));
+      if (end > begin) {
+         ranges.emplace_back(begin, end);
+         begin = end;
+      }
+   }
+   return ranges;
+}
+
+/// Process the entries of `range` in worker process number `worker` of a multi-process event loop.
+/// \return The worker number, whether processing succeeded and either the partial results of the booked actions or
+/// the error message, serialized in a buffer.
+std::string TLoopManager::RunWorker(unsigned int worker, const std::pair<ULong64_t, ULong64_t> &range)
+{
+   TBufferFile buf(TBuffer::kWrite);
+   auto process = [this, &range](TTreeReader *r) {
+      fTaskRanges[0] = range;
+      InitNodeSlots(r, 0);
+      if (r) {
+         while (r->Next())
+            RunAndCheckFilters(0, r->GetCurrentEntry());
+      } else {
+         for (auto entry = range.first; entry < range.second; ++entry)
+            RunAndCheckFilters(0, entry);
+      }
+      CleanUpTask(0);
+   };
+
+   std::string error;
+   try {
+      for (auto &action : fBookedActions)
+         action->InitWorker(worker);
+      if (!fTree) {
+         process(nullptr);
+      } else if (fTree->GetCurrentFile()) {
+         // the files opened by the parent process share their offsets with it: read through a new chain
+         ROOT::Internal::TTreeView view(*fTree);
+         auto readerAndEntryList = view.GetTreeReader(range.first, range.second);
+         process(readerAndEntryList.first.get());
+      } else {
+         // in-memory trees are copied in the address space of the worker process
+         TTreeReader r(fTree.get());
+         r.SetEntriesRange(range.first, range.second);
+         process(&r);
+      }
+      buf << worker << kTRUE;
+      for (auto &action : fBookedActions)
+         action->WriteWorkerResult(buf);
+   } catch (const std::exception &e) {
+      error = e.what();
+   } catch (...) {
+      error = "unknown exception";
+   }
+
+   if (!error.empty()) {
+      buf.SetBufferOffset(0);
+      buf.ResetMap();
+      buf << worker << kFALSE;
+      TString(error.c_str()).Streamer(buf);
+   }
+   return std::string(buf.Buffer(), buf.Length());
+}
+
+/// Run the event loop in fNWorkerProcesses forked processes, each processing a contiguous range of entries, and merge
+/// their partial results into the booked actions, in the order of the entries.
+void TLoopManager::RunMultiProcess()
+{
+#ifndef R__WIN32
+   if (fProfiler)
+      throw std::runtime_error("Multi-process event loops cannot be profiled.");
+   for (const auto &range : fBookedRanges)
+      if (range->HasChildren())
+         throw std::runtime_error("Range is not supported by multi-process event loops.");
+   for (const auto &action : fBookedActions)
+      if (!action->CanRunInWorkers())
+         throw std::runtime_error("Action " + action->GetProfileName() +
+                                  " does not support multi-process event loops.");
+
+   const auto ranges = MakeWorkerRanges();
+   if (ranges.empty())
+      return;
+   ROOT::TProcessExecutor pool(ranges.size());
+   auto results = pool.Map([this, &ranges](unsigned int worker) { return RunWorker(worker, ranges[worker]); },
+                           ROOT::TSeqU(ranges.size()));
+   if (results.size() != ranges.size())
+      throw std::runtime_error("Multi-process event loop: some worker processes did not send their results.");
+
+   // results arrive in no particular order: sort them by worker, i.e. by entries
+   std::vector<std::unique_ptr<TBufferFile>> buffers(ranges.size());
+   for (auto &result : results) {
+      std::unique_ptr<TBufferFile> buf(new TBufferFile(TBuffer::kRead, result.size(), &result[0], kFALSE));
+      unsigned int worker = 0;
+      Bool_t ok = kFALSE;
+      *buf >> worker >> ok;
+      if (!ok) {
+         TString msg;
+         msg.Streamer(*buf);
+         throw std::runtime_error("Multi-process event loop: worker process " + std::to_string(worker) +
+                                  " failed, " + msg.Data());
+      }
+      buffers.at(worker) = std::move(buf);
+   }
+   for (auto &buf : buffers)
+      for (auto &action : fBookedActions)
+         action->MergeWorkerResult(*buf);
+#endif
+}
+
+/// Request that the next event loop is profiled, see TInterface::ProfileReport
+std::shared_ptr<TProfiler> TLoopManager::EnableProfiling()
+{
+   WaitAsyncRun();
+   if (!fProfiler)
+      fProfiler = std::make_shared<TProfiler>(fNSlots);
+   return fProfiler;
+}
+
+/// Whether multi-thread actions that support it must produce their results in the order of the entries of the
+/// dataset, as a single-thread event loop would. Only meaningful for multi-thread event loops.
+bool TLoopManager::HasOrderedOutput() const
+{
+   return fOrderedOutput && (fLoopType == ELoopType::kROOTFilesMT || fLoopType == ELoopType::kNoFilesMT ||
+                             fLoopType == ELoopType::kDataSourceMT);
 }
 
 TLoopManager *TLoopManager::GetImplPtr()
@@ -412,6 +1053,13 @@ TTree *TLoopManager::GetTree() const
    return fTree.get();
 }
 
+/// Return the unnamed jitted filter registered with `key`, or a null pointer if there is none
+FilterBasePtr_t TLoopManager::GetJittedFilter(const std::string &key) const
+{
+   auto it = fJittedFilters.find(key);
+   return it == fJittedFilters.end() ? nullptr : it->second;
+}
+
 TCustomColumnBase *TLoopManager::GetBookedBranch(const std::string &name) const
 {
    auto it = fBookedCustomColumns.find(name);
@@ -425,11 +1073,13 @@ TDirectory *TLoopManager::GetDirectory() const
 
 void TLoopManager::Book(const ActionBasePtr_t &actionPtr)
 {
+   WaitAsyncRun();
    fBookedActions.emplace_back(actionPtr);
 }
 
 void TLoopManager::Book(const FilterBasePtr_t &filterPtr)
 {
+   WaitAsyncRun();
    fBookedFilters.emplace_back(filterPtr);
    if (filterPtr->HasName()) {
       fBookedNamedFilters.emplace_back(filterPtr);
@@ -439,6 +1089,7 @@ void TLoopManager::Book(const FilterBasePtr_t &filterPtr)
 
 void TLoopManager::Book(const TCustomColumnBasePtr_t &columnPtr)
 {
+   WaitAsyncRun();
    const auto &name = columnPtr->GetName();
    fBookedCustomColumns[name] = columnPtr;
    fCustomColumnNames.emplace_back(name);
@@ -446,11 +1097,13 @@ void TLoopManager::Book(const TCustomColumnBasePtr_t &columnPtr)
 
 void TLoopManager::Book(const std::shared_ptr<bool> &readinessPtr)
 {
+   WaitAsyncRun();
    fResProxyReadiness.emplace_back(readinessPtr);
 }
 
 void TLoopManager::Book(const RangeBasePtr_t &rangePtr)
 {
+   WaitAsyncRun();
    fBookedRanges.emplace_back(rangePtr);
 }
 
@@ -468,6 +1121,7 @@ void TLoopManager::Report() const
 
 void TLoopManager::RegisterCallback(ULong64_t everyNEvents, std::function<void(unsigned int)> &&f)
 {
+   WaitAsyncRun();
    if (everyNEvents == 0ull)
       fCallbacksOnce.emplace_back(std::move(f), fNSlots);
    else
@@ -475,12 +1129,33 @@ void TLoopManager::RegisterCallback(ULong64_t everyNEvents, std::function<void(u
 }
 
 TRangeBase::TRangeBase(TLoopManager *implPtr, unsigned int start, unsigned int stop, unsigned int stride,
-                       const unsigned int nSlots)
-   : fImplPtr(implPtr), fStart(start), fStop(stop), fStride(stride), fNSlots(nSlots)
+                       const unsigned int nSlots, bool byEntryNumber)
+   : fImplPtr(implPtr), fStart(start), fStop(stop), fStride(stride), fNSlots(nSlots), fByEntryNumber(byEntryNumber)
+{
+}
+
+/// Return the entries [first, second) that this range can let through when selecting by entry number
+std::pair<ULong64_t, ULong64_t> TRangeBase::GetEntryWindow() const
+{
+   return std::make_pair(ULong64_t(fStart), fStop == 0 ? std::numeric_limits<ULong64_t>::max() : ULong64_t(fStop));
+}
+
+/// Return how many more entries can reach this range before it stops, or the maximum ULong64_t if it never stops
+/// because it has no end, selects entries by entry number or has already stopped.
+ULong64_t TRangeBase::GetNRemainingEntries() const
 {
+   if (fStop == 0 || fByEntryNumber || fHasStopped || !HasChildren())
+      return std::numeric_limits<ULong64_t>::max();
+   return fStop - fNProcessedEntries;
 }
 
 TLoopManager *TRangeBase::GetImplPtr() const
 {
    return fImplPtr;
 }
+
+void TRangeBase::AppendNodeFingerprint(std::string &fingerprint) const
+{
+   fingerprint += "range:" + std::to_string(fStart) + ',' + std::to_string(fStop) + ',' + std::to_string(fStride);
+   fingerprint += fByEntryNumber ? ",entry;" : ";";
+}
@@ -0,0 +1,327 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2017, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+#include "ROOT/TDFProfiling.hxx"
+#include "ROOT/TDFUtils.hxx"
+#include "TClassEdit.h"
+#include "TString.h"
+#include "TTimeStamp.h"
+#include "TVirtualPerfStats.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace ROOT {
+namespace Experimental {
+namespace TDF {
+
+namespace {
+const char *GetKindName(TProfileReport::ENodeKind kind)
+{
+   switch (kind) {
+   case TProfileReport::ENodeKind::kEventLoop: return "loop";
+   case TProfileReport::ENodeKind::kColumn: return "column";
+   case TProfileReport::ENodeKind::kDefine: return "define";
+   case TProfileReport::ENodeKind::kFilter: return "filter";
+   case TProfileReport::ENodeKind::kAction: return "action";
+   }
+   return "";
+}
+
+std::string EscapeJSON(const std::string &s)
+{
+   std::string escaped;
+   for (const auto c : s) {
+      if (c == '"' || c == '\\')
+         escaped += '\\';
+      if (static_cast<unsigned char>(c) < 0x20)
+         escaped += TString::Format("\\u%04x", c).Data();
+      else
+         escaped += c;
+   }
+   return escaped;
+}
+} // anonymous namespace
+
+TProfileReport::TProfileReport(std::vector<TNodeRecord> &&nodes, std::vector<TSlotRecord> &&slots, double wallTime)
+   : fNodes(std::move(nodes)), fSlots(std::move(slots)), fWallTime(wallTime)
+{
+}
+
+/// Return the record of the first node with the given name, or nullptr if there is none
+const TProfileReport::TNodeRecord *TProfileReport::GetNode(const std::string &name) const
+{
+   auto it = std::find_if(fNodes.begin(), fNodes.end(), [&name](const TNodeRecord &n) { return n.fName == name; });
+   return it == fNodes.end() ? nullptr : &*it;
+}
+
+/// Return the ratio between the largest and the average busy time of the slots that processed at least one task.
+/// A perfectly balanced event loop has an imbalance of 1.
+double TProfileReport::GetImbalance() const
+{
+   double maxTime = 0.;
+   double sumTime = 0.;
+   unsigned int nBusySlots = 0;
+   for (const auto &slot : fSlots) {
+      if (slot.fTasks == 0)
+         continue;
+      maxTime = std::max(maxTime, slot.fBusyTime);
+      sumTime += slot.fBusyTime;
+      ++nBusySlots;
+   }
+   return sumTime > 0. ? maxTime * nBusySlots / sumTime : 1.;
+}
+
+/// Print the report to std::cout
+void TProfileReport::Print() const
+{
+   Print(std::cout);
+}
+
+/// Print the report as two tables, one with a row per node and one with a row per slot
+void TProfileReport::Print(std::ostream &os) const
+{
+   double totTime = 0.;
+   for (const auto &node : fNodes)
+      totTime += node.fTime;
+
+   os << TString::Format("%-32s %-7s %12s %10s %6s %10s %10s %10s\n", "Node", "Kind", "Calls", "Time[s]", "Time%",
+                         "Read[MB]", "Read[s]", "Unzip[s]");
+   for (const auto &node : fNodes) {
+      os << TString::Format("%-32s %-7s %12llu %10.4f %6.1f %10.3f %10.4f %10.4f\n", node.fName.c_str(),
+                            GetKindName(node.fKind), node.fCalls, node.fTime,
+                            totTime > 0. ? 100. * node.fTime / totTime : 0., node.fBytesRead / 1048576.,
+                            node.fReadTime, node.fUnzipTime);
+   }
+   os << TString::Format("\n%-6s %12s %8s %10s\n", "Slot", "Entries", "Tasks", "Busy[s]");
+   for (auto slot = 0u; slot < fSlots.size(); ++slot) {
+      const auto &s = fSlots[slot];
+      os << TString::Format("%-6u %12llu %8u %10.4f\n", slot, s.fEntries, s.fTasks, s.fBusyTime);
+   }
+   os << TString::Format("\nWall time: %.4f s, slot imbalance (max/mean busy time): %.3f\n", fWallTime,
+                         GetImbalance());
+}
+
+/// Return the report as a JSON string, with a `nodes` and a `slots` array
+std::string TProfileReport::AsJSON() const
+{
+   std::ostringstream json;
+   json << "{\"wallTime\": " << fWallTime << ", \"imbalance\": " << GetImbalance() << ", \"nodes\": [";
+   for (auto i = 0u; i < fNodes.size(); ++i) {
+      const auto &node = fNodes[i];
+      json << (i ? ", " : "") << "{\"name\": \"" << EscapeJSON(node.fName) << "\", \"kind\": \""
+           << GetKindName(node.fKind) << "\", \"calls\": " << node.fCalls << ", \"time\": " << node.fTime
+           << ", \"bytesRead\": " << node.fBytesRead << ", \"readTime\": " << node.fReadTime
+           << ", \"unzipTime\": " << node.fUnzipTime << ", \"slotTimes\": [";
+      for (auto slot = 0u; slot < node.fSlotTimes.size(); ++slot)
+         json << (slot ? ", " : "") << node.fSlotTimes[slot];
+      json << "]}";
+   }
+   json << "], \"slots\": [";
+   for (auto slot = 0u; slot < fSlots.size(); ++slot) {
+      const auto &s = fSlots[slot];
+      json << (slot ? ", " : "") << "{\"entries\": " << s.fEntries << ", \"tasks\": " << s.fTasks
+           << ", \"busyTime\": " << s.fBusyTime << "}";
+   }
+   json << "]}";
+   return json.str();
+}
+
+} // ns TDF
+} // ns Experimental
+
+namespace Internal {
+namespace TDF {
+
+namespace {
+/// Forwards the file reads and basket decompressions of a slot to the profiler
+class TProfilerPerfStats final : public TVirtualPerfStats {
+   TProfiler &fProfiler;
+   const unsigned int fSlot;
+
+public:
+   TProfilerPerfStats(TProfiler &profiler, unsigned int slot) : fProfiler(profiler), fSlot(slot) {}
+
+   void FileReadEvent(TFile *, Int_t len, Double_t start) final
+   {
+      fProfiler.AddRead(fSlot, len, double(TTimeStamp()) - start);
+   }
+   void UnzipEvent(TObject *, Long64_t, Double_t start, Int_t, Int_t) final
+   {
+      fProfiler.AddUnzip(fSlot, double(TTimeStamp()) - start);
+   }
+
+   void SimpleEvent(EEventType) final {}
+   void PacketEvent(const char *, const char *, const char *, Long64_t, Double_t, Double_t, Double_t, Long64_t) final
+   {
+   }
+   void FileEvent(const char *, const char *, const char *, const char *, Bool_t) final {}
+   void FileOpenEvent(TFile *, const char *, Double_t) final {}
+   void RateEvent(Double_t, Double_t, Long64_t, Long64_t) final {}
+   void SetBytesRead(Long64_t) final {}
+   Long64_t GetBytesRead() const final { return 0; }
+   void SetNumEvents(Long64_t) final {}
+   Long64_t GetNumEvents() const final { return 0; }
+};
+} // anonymous namespace
+
+TProfiler::TProfiler(unsigned int nSlots) : fSlots(nSlots)
+{
+   // id 0 collects what happens outside of all nodes
+   GetNodeId(nullptr, ENodeKind::kEventLoop, "(event loop)");
+}
+
+TProfiler::~TProfiler() = default;
+
+/// Return the id of a node, registering it if needed. Thread-safe.
+/// Nodes are identified by their address and name. Columns read from a TTree or a data-source, which are not nodes
+/// of the functional graph, are registered with a null address.
+unsigned int TProfiler::GetNodeId(const void *node, ENodeKind kind, const std::string &name)
+{
+   std::lock_guard<std::mutex> lock(fNodesMutex);
+   auto it = fIds.find(std::make_pair(node, name));
+   if (it != fIds.end())
+      return it->second;
+   const unsigned int id = fNodes.size();
+   fNodes.emplace_back(kind, name);
+   fIds.emplace(std::make_pair(node, name), id);
+   return id;
+}
+
+/// Return the name under which an action is profiled: the name of its helper followed by the columns it reads
+std::string TProfiler::GetActionName(const std::type_info &helperType, const std::vector<std::string> &columns)
+{
+   int err = 0;
+   char *demangled = TClassEdit::DemangleTypeIdName(helperType, err);
+   std::string name = demangled ? demangled : helperType.name();
+   free(demangled);
+   const std::string prefix = "ROOT::Internal::TDF::";
+   if (name.compare(0, prefix.size(), prefix) == 0)
+      name.erase(0, prefix.size());
+   // drop template arguments, which can be very long
+   name = name.substr(0, name.find('<'));
+   name += '(';
+   for (auto i = 0u; i < columns.size(); ++i)
+      name += (i ? ", " : "") + columns[i];
+   return name + ')';
+}
+
+void TProfiler::StartLoop()
+{
+   fLoopStart = Clock_t::now();
+}
+
+void TProfiler::StopLoop()
+{
+   fWallTime += std::chrono::duration<double>(Clock_t::now() - fLoopStart).count();
+}
+
+/// Start timing a task on `slot` and intercept the file reads of the current thread
+void TProfiler::StartTask(unsigned int slot)
+{
+   auto &s = fSlots[slot];
+   if (!s.fPerfStats)
+      s.fPerfStats.reset(new TProfilerPerfStats(*this, slot));
+   s.fPrevPerfStats.push_back(gPerfStats);
+   gPerfStats = s.fPerfStats.get();
+   ++s.fTasks;
+   s.fTaskStarts.push_back(Clock_t::now());
+}
+
+void TProfiler::StopTask(unsigned int slot)
+{
+   auto &s = fSlots[slot];
+   s.fBusyTime += std::chrono::duration<double>(Clock_t::now() - s.fTaskStarts.back()).count();
+   s.fTaskStarts.pop_back();
+   gPerfStats = s.fPrevPerfStats.back();
+   s.fPrevPerfStats.pop_back();
+}
+
+/// Account a file read to the node currently being evaluated on `slot`
+void TProfiler::AddRead(unsigned int slot, Long64_t bytes, double time)
+{
+   const auto &frames = fSlots[slot].fFrames;
+   auto &stats = GetStats(slot, frames.empty() ? 0u : frames.back().fNodeId);
+   stats.fBytesRead += bytes;
+   stats.fReadTime += time;
+}
+
+/// Account a basket decompression to the node currently being evaluated on `slot`
+void TProfiler::AddUnzip(unsigned int slot, double time)
+{
+   const auto &frames = fSlots[slot].fFrames;
+   GetStats(slot, frames.empty() ? 0u : frames.back().fNodeId).fUnzipTime += time;
+}
+
+/// Merge the statistics of all slots. To be called after the event loop.
+ROOT::Experimental::TDF::TProfileReport TProfiler::MakeReport() const
+{
+   using ROOT::Experimental::TDF::TProfileReport;
+   const auto nSlots = fSlots.size();
+   std::vector<TProfileReport::TNodeRecord> nodes(fNodes.size());
+   for (auto id = 0u; id < fNodes.size(); ++id) {
+      nodes[id].fKind = fNodes[id].first;
+      nodes[id].fName = fNodes[id].second;
+      nodes[id].fSlotTimes.resize(nSlots, 0.);
+   }
+
+   std::vector<TProfileReport::TSlotRecord> slots(nSlots);
+   for (auto slot = 0u; slot < nSlots; ++slot) {
+      const auto &s = fSlots[slot];
+      double nodesTime = 0.;
+      for (auto id = 0u; id < s.fStats.size(); ++id) {
+         const auto &stats = s.fStats[id];
+         auto &node = nodes[id];
+         node.fCalls += stats.fCalls;
+         node.fTime += stats.fTime;
+         node.fSlotTimes[slot] += stats.fTime;
+         node.fBytesRead += stats.fBytesRead;
+         node.fReadTime += stats.fReadTime;
+         node.fUnzipTime += stats.fUnzipTime;
+         nodesTime += stats.fTime;
+      }
+      // the event loop itself gets what was not spent in any node
+      const auto loopTime = std::max(0., s.fBusyTime - nodesTime);
+      nodes[0].fTime += loopTime;
+      nodes[0].fSlotTimes[slot] += loopTime;
+      nodes[0].fCalls += s.fEntries;
+      slots[slot].fEntries = s.fEntries;
+      slots[slot].fTasks = s.fTasks;
+      slots[slot].fBusyTime = s.fBusyTime;
+   }
+
+   return TProfileReport(std::move(nodes), std::move(slots), fWallTime);
+}
+
+/// Register a column of a TTree with the profiler and return its id
+unsigned int GetColumnProfileId(TProfiler &profiler, const std::string &columnName)
+{
+   return profiler.GetNodeId(nullptr, TProfiler::ENodeKind::kColumn, columnName);
+}
+
+std::string GetActionProfileName(const std::type_info &helperType, const ColumnNames_t &columns)
+{
+   return TProfiler::GetActionName(helperType, columns);
+}
+
+void TProfileScope::Start(unsigned int id)
+{
+   fProfiler->Start(fSlot, id);
+}
+
+void TProfileScope::Stop()
+{
+   fProfiler->Stop(fSlot);
+}
+
+} // ns TDF
+} // ns Internal
+} // ns ROOT
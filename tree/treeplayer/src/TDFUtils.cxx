@@ -13,6 +13,7 @@
 #include "ROOT/TDFUtils.hxx"
 #include "TBranch.h"
 #include "TBranchElement.h"
+#include "TChain.h"
 #include "TClassRef.h"
 #include "TFriendElement.h"
 #include "TROOT.h" // IsImplicitMTEnabled, GetImplicitMTPoolSize
@@ -283,6 +284,33 @@ bool IsInternalColumn(std::string_view colName)
    return 0 == colName.find("tdf") && '_' == colName.back();
 }
 
+/// Return the first entry of each cluster of a tree or chain, followed by its total number of entries
+std::vector<Long64_t> GetClusterBoundaries(TTree &tree)
+{
+   std::vector<Long64_t> boundaries;
+   // for chains, this also computes the offsets of the trees
+   const auto nEntries = tree.GetEntries();
+   auto chain = dynamic_cast<TChain *>(&tree);
+   const auto nTrees = chain ? chain->GetNtrees() : 1;
+   for (auto i = 0; i < nTrees; ++i) {
+      const auto offset = chain ? chain->GetTreeOffset()[i] : 0ll;
+      const auto treeEntries = (chain ? chain->GetTreeOffset()[i + 1] : nEntries) - offset;
+      if (treeEntries == 0)
+         continue;
+      auto t = &tree;
+      if (chain) {
+         chain->LoadTree(offset);
+         t = chain->GetTree();
+      }
+      auto clusterIt = t->GetClusterIterator(0);
+      Long64_t start;
+      while ((start = clusterIt()) < treeEntries)
+         boundaries.emplace_back(offset + start);
+   }
+   boundaries.emplace_back(nEntries);
+   return boundaries;
+}
+
 } // end NS TDF
 } // end NS Internal
 } // end NS ROOT
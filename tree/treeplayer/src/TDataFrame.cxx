@@ -276,8 +276,8 @@ auto d15on = d.Range(15, 0);
 // We can specify a stride too, in this case we pick an event every 3
 auto d15each3 = d.Range(0, 15, 3);
 ~~~
-Note that ranges are not available when multi-threading is enabled. More information on ranges is available
-[here](#ranges).
+Note that when multi-threading is enabled ranges can only be applied to the whole dataset, not after filters or other
+ranges. More information on ranges is available [here](#ranges).
 
 ### Executing multiple actions in the same event loop
 As a final example let us apply two different cuts on branch "MET" and fill two different histograms with the "pt\_v" of
@@ -296,7 +296,8 @@ accessed through the smart pointer. At that time, the event loop is triggered an
 simultaneously.
 
 It is therefore good practice to declare all your transformations and actions *before* accessing their results, allowing
-`TDataFrame` to run the loop once and produce all results in one go.
+`TDataFrame` to run the loop once and produce all results in one go. Results booked on different `TDataFrame`s that
+read the same dataset can be produced by a single event loop as well, see `ShareEventLoop`.
 
 ### Going parallel
 Let's say we would like to run the previous examples in parallel on several cores, dividing events fairly between cores.
@@ -456,6 +457,19 @@ Objects read from each column are **built once and never copied**, for maximum e
 When "upstream" filters are not passed, subsequent filters, temporary column expressions and actions are not evaluated,
 so it might be advisable to put the strictest filters first in the chain.
 
+### Caching jitted code
+Filters and columns defined through strings, as well as actions whose column types are inferred, are compiled at
+runtime by the interpreter. The same code is only compiled once per process. Setting a cache directory, through
+`ROOT::Experimental::TDF::SetJitCacheDir` or `TDataFrame.JitCacheDir` in `.rootrc`, makes this code be compiled with
+ACLiC into shared libraries stored in that directory, which later processes load instead of invoking the interpreter:
+this reduces the start-up time of short jobs that run the same analysis. Code that cannot be compiled outside of the
+interpreter, e.g. because it refers to functions declared with `gInterpreter->Declare`, is still jitted.
+~~~{.cpp}
+ROOT::Experimental::TDF::SetJitCacheDir("/scratch/tdfcache");
+TDataFrame d("t", "file.root");
+auto h = d.Filter("pt > 20").Histo1D("pt"); // the first job compiles the code, later ones load it
+~~~
+
 ##  <a name="transformations"></a>Transformations
 ### <a name="Filters"></a> Filters
 A filter is defined through a call to `Filter(f, columnList)`. `f` can be a function, a lambda expression, a functor
@@ -484,9 +498,8 @@ that has been run using the relevant `TDataFrame`. If `Report` is called before
 once, a run is triggered.
 
 ### <a name="ranges"></a>Ranges
-When `TDataFrame` is not being used in a multi-thread environment (i.e. no call to `EnableImplicitMT` was made),
-`Range` transformations are available. These act very much like filters but instead of basing their decision on
-a filter expression, they rely on `start`,`stop` and `stride` parameters.
+`Range` transformations act very much like filters but instead of basing their decision on a filter expression, they
+rely on `start`,`stop` and `stride` parameters.
 
 - `start`: number of entries that will be skipped before starting processing again
 - `stop`: maximum number of entries that will be processed
@@ -503,6 +516,11 @@ preceding filter*.
 Ranges allow "early quitting": if all branches of execution of a functional graph reached their `stop` value of
 processed entries, the event-loop is immediately interrupted. This is useful for debugging and quick data explorations.
 
+In multi-thread event loops (i.e. after a call to `EnableImplicitMT`) entries are not processed in order, so ranges can
+only act on the whole dataset: a `Range` can be applied to a `TDataFrame`, possibly after `Define`s, but not to a
+filter or another range. `Range(10, 50)` then selects entries 10 to 49 of the dataset. If all the nodes hanging from
+the `TDataFrame` are ranges, only the entries between the smallest `start` and the largest `stop` are processed.
+
 ### <a name="custom-columns"></a> Custom columns
 Custom columns are created by invoking `Define(name, f, columnList)`. As usual, `f` can be any callable object
 (function, lambda expression, functor class...); it takes the values of the columns listed in `columnList` (a list of
@@ -561,6 +579,7 @@ note that all actions are only executed for events that pass all preceding filte
 | Mean | Return the mean of processed branch values. |
 | Min | Return the minimum of processed branch values. |
 | Profile{1D,2D} | Fill a {one,two}-dimensional profile with the branch values that passed all filters. |
+| Profile | Profile the event loop: return the cost of each node of the functional graph (wall time, entries processed, bytes read and decompression time) and per-thread statistics, printable as a table or exportable as JSON. |
 | Reduce | Reduce (e.g. sum, merge) entries using the function (lambda, functor...) passed as argument. The function must have signature `T(T,T)` where `T` is the type of the branch. Return the final result of the reduction operation. An optional parameter allows initialization of the result object to non-default values. |
 | Take | Build a collection of values of a branch. |
 
@@ -589,6 +608,27 @@ Most `Filter`/`Define` functions will in fact be pure in the functional programm
 All actions are built to be thread-safe with the exception of `Foreach`, in which case users are responsible of
 thread-safety, see [here](#generic-actions).
 
+### Memory usage of histograms
+Histogram-filling actions normally give each worker thread its own copy of the histogram and merge the copies at the
+end of the event loop. When the copies of a histogram would occupy more than a configurable amount of memory (256 MB by
+default, see `ROOT::Experimental::TDF::SetMaxHistoCopiesSize`), all threads fill the same histogram instead, buffering
+their values and flushing them under a lock. Large TH2 and TH3 histograms then take the same amount of memory
+regardless of the number of threads. The limit is checked when the action is booked. The partial results of such
+histograms (see `OnPartialResult`) are snapshots of the shared histogram, copied under the lock: each thread that
+receives partial results, i.e. all of them with `OnPartialResultSlot`, holds one such copy.
+
+### Concurrent event loops
+`RunAsync` starts the event loop of a `TDataFrame` in a task of the thread pool and returns a `TFuture` immediately.
+The event loops of several `TDataFrame`s, e.g. over different samples, can then run at the same time, sharing the worker
+threads, while the calling thread goes on: accessing a result waits for the end of the event loop that produces it.
+
+### Multi-process event loops
+When the functional graph calls code that is not thread-safe, `EnableMultiProcess` makes the event loops of a
+`TDataFrame` created without ImplicitMT run in several forked processes instead of threads. Each process handles a
+contiguous range of entries, starting at a cluster boundary, and sends its partial results back to be merged in the
+order of the entries. Side effects of `Foreach` are lost and `Range` is not supported, see
+`TInterface::EnableMultiProcess`.
+
 <a name="reference"></a>
 */
 // clang-format on
@@ -0,0 +1,589 @@
+// @(#)root/treeplayer:$Id$
+
+/*************************************************************************
+ * Copyright (C) 1995-2017, Rene Brun and Fons Rademakers.               *
+ * All rights reserved.                                                  *
+ *                                                                       *
+ * For the licensing terms see $ROOTSYS/LICENSE.                         *
+ * For the list of contributors see $ROOTSYS/README/CREDITS.             *
+ *************************************************************************/
+
+// clang-format off
+/** \class ROOT::Experimental::TDF::TNpyDS
+    \ingroup dataframe
+    \brief TDataFrame data source class for reading NumPy arrays in place.
+
+The TNpyDS class reads the arrays written by NumPy's `save` and `savez` functions, without copying them: the files
+are mapped in memory and the column readers point directly to the values stored in the mapped files.
+
+A TDataFrame that reads NumPy arrays can be constructed using the factory method
+ROOT::Experimental::TDF::MakeNpyDataFrame, which accepts the path of:
+- a `.npy` file;
+- a `.npz` archive, written by `numpy.savez`. Compressed archives, written by `numpy.savez_compressed`, cannot be read
+in place and are not supported;
+- a directory containing `.npy` files, e.g. one file per column. Columns are sorted by file name.
+
+Each array provides one or more columns:
+- a one-dimensional array of N values provides one column, named as the array (i.e. as the `.npy` file without
+extension, or as the member of the `.npz` archive);
+- a two-dimensional array of N rows of K values provides K columns, named `<array>_0` to `<array>_<K-1>`. Both C and
+Fortran orders are supported;
+- a one-dimensional structured array, i.e. an array of records, provides one column per field, named as the field.
+
+All arrays must have the same number of entries N. The supported types are booleans, signed and unsigned integers of
+1, 2, 4 and 8 bytes and floating point numbers of 4 and 8 bytes, in the byte order of the machine. Values that are not
+suitably aligned in the file, e.g. the fields of packed structured arrays, are copied before being passed to the
+functional graph.
+
+The entries are split in one range per slot.
+*/
+// clang-format on
+
+#include <ROOT/TDFUtils.hxx>
+#include <ROOT/TSeq.hxx>
+#include <ROOT/TNpyDS.hxx>
+#include <ROOT/RMakeUnique.hxx>
+#include "RConfig.h" // R__BYTESWAP, R__WIN32
+#include "TSystem.h"
+
+#ifndef R__WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+ULong64_t ReadLittleEndian(const char *p, unsigned int nBytes)
+{
+   ULong64_t value = 0;
+   for (auto i = nBytes; i > 0; --i)
+      value = (value << 8) | static_cast<unsigned char>(p[i - 1]);
+   return value;
+}
+
+bool EndsWith(const std::string &s, const std::string &suffix)
+{
+   return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// The type of the values of an array, as described by a NumPy type string such as `<f8`
+struct TNpyType {
+   std::string fTypeName;
+   const std::type_info *fType; ///< Null for the padding of structured arrays
+   std::size_t fSize;
+};
+
+TNpyType GetNpyType(const std::string &descr, const std::string &where)
+{
+   std::size_t size = 0;
+   if (descr.size() >= 3)
+      size = std::strtoul(descr.c_str() + 2, nullptr, 10);
+   if (size == 0)
+      throw std::runtime_error("Unsupported type " + descr + " in NumPy array " + where);
+#ifdef R__BYTESWAP
+   const char nonNativeOrder = '>';
+#else
+   const char nonNativeOrder = '<';
+#endif
+   if (descr[0] == nonNativeOrder && size > 1)
+      throw std::runtime_error("NumPy array " + where + " is not in the byte order of this machine: values of type " +
+                               descr + " cannot be read in place");
+
+   switch (descr[1]) {
+   case 'b':
+      if (size == 1)
+         return {"bool", &typeid(bool), size};
+      break;
+   case 'i':
+      switch (size) {
+      case 1: return {"Char_t", &typeid(Char_t), size};
+      case 2: return {"Short_t", &typeid(Short_t), size};
+      case 4: return {"Int_t", &typeid(Int_t), size};
+      case 8: return {"Long64_t", &typeid(Long64_t), size};
+      }
+      break;
+   case 'u':
+      switch (size) {
+      case 1: return {"UChar_t", &typeid(UChar_t), size};
+      case 2: return {"UShort_t", &typeid(UShort_t), size};
+      case 4: return {"UInt_t", &typeid(UInt_t), size};
+      case 8: return {"ULong64_t", &typeid(ULong64_t), size};
+      }
+      break;
+   case 'f':
+      switch (size) {
+      case 4: return {"float", &typeid(float), size};
+      case 8: return {"double", &typeid(double), size};
+      }
+      break;
+   case 'V': return {"", nullptr, size};
+   }
+   throw std::runtime_error("Unsupported type " + descr + " in NumPy array " + where);
+}
+
+/// Return the text of the value of `key` in the Python dictionary literal `dict`: a quoted string without quotes, a
+/// list or tuple with its brackets, or anything else up to the next comma.
+std::string GetDictValue(const std::string &dict, const std::string &key, const std::string &where)
+{
+   auto pos = dict.find("'" + key + "'");
+   if (pos != std::string::npos)
+      pos = dict.find(':', pos);
+   if (pos == std::string::npos)
+      throw std::runtime_error("Invalid header of NumPy array " + where + ": no " + key);
+   pos = dict.find_first_not_of(" ", pos + 1);
+   if (pos == std::string::npos)
+      throw std::runtime_error("Invalid header of NumPy array " + where);
+   if (dict[pos] == '\'') {
+      const auto end = dict.find('\'', pos + 1);
+      return dict.substr(pos + 1, end - pos - 1);
+   }
+   if (dict[pos] == '[' || dict[pos] == '(') {
+      int depth = 0;
+      for (auto end = pos; end < dict.size(); ++end) {
+         if (dict[end] == '[' || dict[end] == '(')
+            ++depth;
+         else if ((dict[end] == ']' || dict[end] == ')') && --depth == 0)
+            return dict.substr(pos, end - pos + 1);
+      }
+      throw std::runtime_error("Invalid header of NumPy array " + where);
+   }
+   return dict.substr(pos, dict.find_first_of(",}", pos) - pos);
+}
+
+/// Return the quoted strings of `text`, without quotes
+std::vector<std::string> GetQuotedStrings(const std::string &text)
+{
+   std::vector<std::string> strings;
+   for (auto begin = text.find('\''); begin != std::string::npos; begin = text.find('\'', begin)) {
+      const auto end = text.find('\'', begin + 1);
+      if (end == std::string::npos)
+         break;
+      strings.emplace_back(text.substr(begin + 1, end - begin - 1));
+      begin = end + 1;
+   }
+   return strings;
+}
+
+/// The fields of the values of an array. Arrays that are not structured have a single field, with no name.
+struct TNpyField {
+   std::string fName;
+   TNpyType fType;
+   std::size_t fOffset;
+};
+
+struct TNpyHeader {
+   std::vector<TNpyField> fFields;
+   bool fStructured = false;
+   std::size_t fItemSize = 0;
+   bool fFortranOrder = false;
+   std::vector<ULong64_t> fShape;
+   std::size_t fDataOffset = 0;
+};
+
+/// Parse the header of an array in the `.npy` format, at the beginning of the `size` bytes at `begin`
+TNpyHeader ParseNpyHeader(const char *begin, std::size_t size, const std::string &where)
+{
+   if (size < 10 || std::memcmp(begin, "\x93NUMPY", 6) != 0)
+      throw std::runtime_error(where + " is not a NumPy array");
+   const auto major = static_cast<unsigned char>(begin[6]);
+   if (major < 1 || major > 3)
+      throw std::runtime_error("Unsupported version " + std::to_string(major) + " of the format of NumPy array " +
+                               where);
+   const unsigned int lengthSize = major == 1 ? 2 : 4;
+   TNpyHeader header;
+   const auto dictSize = ReadLittleEndian(begin + 8, lengthSize);
+   header.fDataOffset = 8 + lengthSize + dictSize;
+   if (header.fDataOffset > size)
+      throw std::runtime_error("Truncated NumPy array " + where);
+   const std::string dict(begin + 8 + lengthSize, dictSize);
+
+   const auto descr = GetDictValue(dict, "descr", where);
+   if (descr.empty() || descr[0] != '[') {
+      header.fFields.push_back({"", GetNpyType(descr, where), 0});
+      header.fItemSize = header.fFields[0].fType.fSize;
+   } else {
+      header.fStructured = true;
+      // a list of (name, type) tuples. Nested records and fields that are arrays are not supported.
+      const auto list = descr.substr(1, descr.size() - 2);
+      for (auto begin = list.find('('); begin != std::string::npos; begin = list.find('(', begin)) {
+         const auto end = list.find(')', begin);
+         const auto tuple = list.substr(begin, end - begin + 1);
+         const auto strings = GetQuotedStrings(tuple);
+         if (end == std::string::npos || strings.size() != 2 || tuple.find_first_of("[(", 1) != std::string::npos)
+            throw std::runtime_error("Unsupported structured type " + descr + " of NumPy array " + where);
+         header.fFields.push_back({strings[0], GetNpyType(strings[1], where), header.fItemSize});
+         header.fItemSize += header.fFields.back().fType.fSize;
+         begin = end + 1;
+      }
+   }
+   if (!header.fStructured && !header.fFields[0].fType.fType)
+      throw std::runtime_error("Unsupported type " + descr + " of NumPy array " + where);
+
+   header.fFortranOrder = GetDictValue(dict, "fortran_order", where) == "True";
+
+   const auto shape = GetDictValue(dict, "shape", where);
+   for (auto pos = shape.find_first_of("0123456789"); pos != std::string::npos;
+        pos = shape.find_first_of("0123456789", pos)) {
+      std::size_t nDigits = 0;
+      header.fShape.emplace_back(std::stoull(shape.substr(pos), &nDigits));
+      pos += nDigits;
+   }
+   return header;
+}
+
+} // anonymous namespace
+
+namespace ROOT {
+namespace Experimental {
+namespace TDF {
+
+////////////////////////////////////////////////////////////////////////
+/// Add the columns of the array in the `.npy` format stored in the `size` bytes at `begin`
+void TNpyDS::AddArray(const char *begin, std::size_t size, const std::string &arrayName, const std::string &where)
+{
+   const auto header = ParseNpyHeader(begin, size, where);
+   const auto &shape = header.fShape;
+   if (shape.empty() || shape.size() > 2 || (header.fStructured && shape.size() != 1))
+      throw std::runtime_error("NumPy array " + where + " has " + std::to_string(shape.size()) +
+                               " dimensions: only arrays of one dimension, or two if not structured, are supported");
+   const auto nEntries = shape[0];
+   const auto nValues = shape.size() == 2 ? shape[1] : 1ULL;
+   if (header.fDataOffset + nEntries * nValues * header.fItemSize > size)
+      throw std::runtime_error("Truncated NumPy array " + where);
+   if (fNEntriesSet && nEntries != fNEntries)
+      throw std::runtime_error("NumPy array " + where + " has " + std::to_string(nEntries) + " entries instead of " +
+                               std::to_string(fNEntries));
+   fNEntries = nEntries;
+   fNEntriesSet = true;
+
+   const auto data = begin + header.fDataOffset;
+   auto addColumn = [this, &where](const std::string &name, const TNpyType &type, const char *first,
+                                   std::size_t stride) {
+      if (HasColumn(name))
+         throw std::runtime_error("Column " + name + " of NumPy array " + where + " is defined more than once");
+      const bool aligned = reinterpret_cast<std::uintptr_t>(first) % type.fSize == 0 && stride % type.fSize == 0;
+      fColumns.push_back({name, type.fTypeName, type.fType, first, stride, type.fSize, aligned});
+      fColumnNames.emplace_back(name);
+   };
+
+   if (header.fStructured) {
+      for (const auto &field : header.fFields) {
+         // skip the padding between fields
+         if (field.fType.fType)
+            addColumn(field.fName, field.fType, data + field.fOffset, header.fItemSize);
+      }
+   } else {
+      const auto &type = header.fFields[0].fType;
+      for (auto i = 0ULL; i < nValues; ++i) {
+         const auto name = shape.size() == 1 ? arrayName : arrayName + "_" + std::to_string(i);
+         if (header.fFortranOrder)
+            addColumn(name, type, data + i * nEntries * type.fSize, type.fSize);
+         else
+            addColumn(name, type, data + i * type.fSize, nValues * type.fSize);
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////
+/// Map the whole file in memory, read-only. Where memory mapping is not available, the file is read in memory.
+std::pair<const char *, std::size_t> TNpyDS::MapFile(const std::string &fileName)
+{
+#ifndef R__WIN32
+   const auto fd = open(fileName.c_str(), O_RDONLY);
+   if (fd < 0)
+      throw std::runtime_error("Cannot open file " + fileName);
+   struct stat st;
+   if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw std::runtime_error("Cannot open file " + fileName);
+   }
+   const std::size_t size = st.st_size;
+   char *data = nullptr;
+   if (size > 0) {
+      auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped == MAP_FAILED) {
+         close(fd);
+         throw std::runtime_error("Cannot map file " + fileName + " in memory");
+      }
+      data = static_cast<char *>(mapped);
+   }
+   // the mapping stays valid after the file is closed
+   close(fd);
+#else
+   std::ifstream stream(fileName, std::ios::binary | std::ios::ate);
+   if (!stream)
+      throw std::runtime_error("Cannot open file " + fileName);
+   const std::size_t size = stream.tellg();
+   char *data = new char[size];
+   stream.seekg(0);
+   stream.read(data, size);
+#endif
+   fMappings.emplace_back(data, size);
+   return {data, size};
+}
+
+void TNpyDS::UnmapFiles()
+{
+   for (auto &mapping : fMappings) {
+#ifndef R__WIN32
+      if (mapping.first)
+         munmap(mapping.first, mapping.second);
+#else
+      delete[] mapping.first;
+#endif
+   }
+   fMappings.clear();
+}
+
+void TNpyDS::AddNpyFile(const std::string &fileName)
+{
+   const auto file = MapFile(fileName);
+   std::string arrayName = gSystem->BaseName(fileName.c_str());
+   if (EndsWith(arrayName, ".npy"))
+      arrayName.resize(arrayName.size() - 4);
+   AddArray(file.first, file.second, arrayName, fileName);
+}
+
+////////////////////////////////////////////////////////////////////////
+/// Add the arrays of a `.npz` archive, i.e. a zip archive of `.npy` files. The members of the archive must be stored
+/// without compression, so that they can be read in place. Large archives use the ZIP64 extensions.
+void TNpyDS::AddNpzFile(const std::string &fileName)
+{
+   const auto file = MapFile(fileName);
+   const auto begin = file.first;
+   const auto size = file.second;
+   const auto corrupted = "Invalid or corrupted npz archive " + fileName;
+
+   // the end of central directory record is at the end of the archive, followed by a comment of up to 64 kB
+   const std::size_t eocdSize = 22;
+   if (size < eocdSize)
+      throw std::runtime_error(corrupted);
+   const std::size_t minEocd = size > eocdSize + 65535 ? size - eocdSize - 65535 : 0;
+   auto eocd = size - eocdSize;
+   while (ReadLittleEndian(begin + eocd, 4) != 0x06054b50) {
+      if (eocd == minEocd)
+         throw std::runtime_error(corrupted);
+      --eocd;
+   }
+   auto nMembers = ReadLittleEndian(begin + eocd + 10, 2);
+   auto member = ReadLittleEndian(begin + eocd + 16, 4);
+   if ((nMembers == 0xFFFF || member == 0xFFFFFFFF) && eocd >= 20 &&
+       ReadLittleEndian(begin + eocd - 20, 4) == 0x07064b50) {
+      const auto zip64Eocd = ReadLittleEndian(begin + eocd - 20 + 8, 8);
+      if (zip64Eocd + 56 > size || ReadLittleEndian(begin + zip64Eocd, 4) != 0x06064b50)
+         throw std::runtime_error(corrupted);
+      nMembers = ReadLittleEndian(begin + zip64Eocd + 32, 8);
+      member = ReadLittleEndian(begin + zip64Eocd + 48, 8);
+   }
+
+   for (auto i = 0ULL; i < nMembers; ++i) {
+      // central directory header of the member
+      if (member + 46 > size || ReadLittleEndian(begin + member, 4) != 0x02014b50)
+         throw std::runtime_error(corrupted);
+      const auto entry = begin + member;
+      const auto method = ReadLittleEndian(entry + 10, 2);
+      auto dataSize = ReadLittleEndian(entry + 24, 4);
+      auto compressedSize = ReadLittleEndian(entry + 20, 4);
+      const auto nameSize = ReadLittleEndian(entry + 28, 2);
+      const auto extraSize = ReadLittleEndian(entry + 30, 2);
+      const auto commentSize = ReadLittleEndian(entry + 32, 2);
+      auto localHeader = ReadLittleEndian(entry + 42, 4);
+      member += 46 + nameSize + extraSize + commentSize;
+      if (member > size)
+         throw std::runtime_error(corrupted);
+      const std::string name(entry + 46, nameSize);
+
+      // the ZIP64 extended information holds the 64-bit values of the fields set to 0xFFFFFFFF, in this order
+      for (auto extra = entry + 46 + nameSize; extra + 4 <= entry + 46 + nameSize + extraSize;) {
+         const auto id = ReadLittleEndian(extra, 2);
+         const auto extraFieldSize = ReadLittleEndian(extra + 2, 2);
+         auto value = extra + 4;
+         if (id == 1) {
+            if (dataSize == 0xFFFFFFFF) {
+               dataSize = ReadLittleEndian(value, 8);
+               value += 8;
+            }
+            if (compressedSize == 0xFFFFFFFF) {
+               compressedSize = ReadLittleEndian(value, 8);
+               value += 8;
+            }
+            if (localHeader == 0xFFFFFFFF)
+               localHeader = ReadLittleEndian(value, 8);
+         }
+         extra += 4 + extraFieldSize;
+      }
+
+      if (!EndsWith(name, ".npy"))
+         continue;
+      const auto where = fileName + ":" + name;
+      if (method != 0 || compressedSize != dataSize)
+         throw std::runtime_error("NumPy array " + where + " is compressed and cannot be read in place: the " +
+                                  "archive must be written by numpy.savez, not numpy.savez_compressed");
+      if (localHeader + 30 > size || ReadLittleEndian(begin + localHeader, 4) != 0x04034b50)
+         throw std::runtime_error(corrupted);
+      const auto localNameSize = ReadLittleEndian(begin + localHeader + 26, 2);
+      const auto localExtraSize = ReadLittleEndian(begin + localHeader + 28, 2);
+      const auto dataOffset = localHeader + 30 + localNameSize + localExtraSize;
+      if (dataOffset + dataSize > size)
+         throw std::runtime_error(corrupted);
+      AddArray(begin + dataOffset, dataSize, name.substr(0, name.size() - 4), where);
+   }
+}
+
+const TNpyDS::TColumn &TNpyDS::GetColumn(std::string_view colName) const
+{
+   const auto it =
+      std::find_if(fColumns.begin(), fColumns.end(), [&colName](const TColumn &c) { return c.fName == colName; });
+   if (it == fColumns.end()) {
+      std::string msg = "The dataset does not have column ";
+      msg += colName;
+      throw std::runtime_error(msg);
+   }
+   return *it;
+}
+
+std::vector<void *> TNpyDS::GetColumnReadersImpl(std::string_view colName, const std::type_info &type)
+{
+   const auto &column = GetColumn(colName);
+   if (type != *column.fType) {
+      std::string msg = "Column ";
+      msg += colName;
+      msg += " holds values of type " + column.fTypeName + ", which cannot be read as a different type";
+      throw std::runtime_error(msg);
+   }
+   const std::size_t index = &column - fColumns.data();
+   if (std::find(fRequestedColumns.begin(), fRequestedColumns.end(), index) == fRequestedColumns.end())
+      fRequestedColumns.emplace_back(index);
+   std::vector<void *> ret(fNSlots);
+   for (auto slot : ROOT::TSeqU(fNSlots)) {
+      ret[slot] = (void *)&fColAddresses[index][slot];
+   }
+   return ret;
+}
+
+TNpyDS::TNpyDS(std::string_view path) : fPath(path)
+{
+   try {
+      FileStat_t stat;
+      if (gSystem->GetPathInfo(fPath.c_str(), stat) != 0)
+         throw std::runtime_error("Cannot access " + fPath);
+      if (R_ISDIR(stat.fMode)) {
+         std::vector<std::string> fileNames;
+         auto dir = gSystem->OpenDirectory(fPath.c_str());
+         while (auto entry = gSystem->GetDirEntry(dir)) {
+            if (EndsWith(entry, ".npy"))
+               fileNames.emplace_back(entry);
+         }
+         gSystem->FreeDirectory(dir);
+         std::sort(fileNames.begin(), fileNames.end());
+         for (const auto &fileName : fileNames)
+            AddNpyFile(fPath + "/" + fileName);
+      } else if (EndsWith(fPath, ".npz")) {
+         AddNpzFile(fPath);
+      } else {
+         AddNpyFile(fPath);
+      }
+      if (fColumns.empty())
+         throw std::runtime_error("No NumPy arrays found in " + fPath);
+   } catch (...) {
+      UnmapFiles();
+      throw;
+   }
+}
+
+TNpyDS::~TNpyDS()
+{
+   UnmapFiles();
+}
+
+const std::vector<std::string> &TNpyDS::GetColumnNames() const
+{
+   return fColumnNames;
+}
+
+std::vector<std::pair<ULong64_t, ULong64_t>> TNpyDS::GetEntryRanges()
+{
+   auto ranges(std::move(fEntryRanges)); // empty fEntryRanges
+   fEntryRanges.clear();
+   return ranges;
+}
+
+std::string TNpyDS::GetTypeName(std::string_view colName) const
+{
+   return GetColumn(colName).fTypeName;
+}
+
+bool TNpyDS::HasColumn(std::string_view colName) const
+{
+   return fColumnNames.end() != std::find(fColumnNames.begin(), fColumnNames.end(), colName);
+}
+
+////////////////////////////////////////////////////////////////////////
+/// Point the readers of the requested columns for `slot` to the values of `entry`, in the mapped files. Values that
+/// are not suitably aligned are copied instead.
+void TNpyDS::SetEntry(unsigned int slot, ULong64_t entry)
+{
+   for (auto col : fRequestedColumns) {
+      const auto &column = fColumns[col];
+      const auto value = column.fData + entry * column.fStride;
+      if (column.fAligned)
+         fColAddresses[col][slot] = const_cast<char *>(value);
+      else
+         std::memcpy(&fValueCopies[col * fNSlots + slot], value, column.fValueSize);
+   }
+}
+
+void TNpyDS::SetNSlots(unsigned int nSlots)
+{
+   assert(0U == fNSlots && "Setting the number of slots even if the number of slots is different from zero.");
+
+   fNSlots = nSlots;
+   const auto nColumns = fColumns.size();
+   fValueCopies.resize(nColumns * fNSlots);
+   fColAddresses.resize(nColumns, std::vector<void *>(fNSlots, nullptr));
+   // the readers of the columns that are copied always point to the copies
+   for (auto col : ROOT::TSeqU(nColumns)) {
+      if (!fColumns[col].fAligned) {
+         for (auto slot : ROOT::TSeqU(fNSlots))
+            fColAddresses[col][slot] = &fValueCopies[col * fNSlots + slot];
+      }
+   }
+}
+
+////////////////////////////////////////////////////////////////////////
+/// Split the entries in one range per slot
+void TNpyDS::Initialise()
+{
+   fEntryRanges.clear();
+   const auto nEntriesPerSlot = fNEntries / fNSlots;
+   auto remainder = fNEntries % fNSlots;
+   ULong64_t start = 0ULL;
+   while (start < fNEntries) {
+      auto end = start + nEntriesPerSlot;
+      if (remainder > 0) {
+         ++end;
+         --remainder;
+      }
+      fEntryRanges.emplace_back(start, end);
+      start = end;
+   }
+}
+
+TDataFrame MakeNpyDataFrame(std::string_view path)
+{
+   ROOT::Experimental::TDataFrame tdf(std::make_unique<TNpyDS>(path));
+   return tdf;
+}
+
+} // ns TDF
+} // ns Experimental
+} // ns ROOT
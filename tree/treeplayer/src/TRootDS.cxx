@@ -1,6 +1,7 @@
 #include <ROOT/TDFUtils.hxx>
 #include <ROOT/TRootDS.hxx>
 #include <ROOT/TSeq.hxx>
+#include <TChainElement.h>
 #include <TClass.h>
 #include <TROOT.h>         // For the gROOTMutex
 #include <TVirtualMutex.h> // For the R__LOCKGUARD
@@ -15,8 +16,10 @@ namespace TDF {
 
 std::vector<void *> TRootDS::GetColumnReadersImpl(std::string_view name, const std::type_info &)
 {
-   const auto index =
+   const std::size_t index =
       std::distance(fListOfBranches.begin(), std::find(fListOfBranches.begin(), fListOfBranches.end(), name));
+   if (fRequestedColumns.end() == std::find(fRequestedColumns.begin(), fRequestedColumns.end(), index))
+      fRequestedColumns.emplace_back(index);
    std::vector<void *> ret(fNSlots);
    for (auto slot : ROOT::TSeqU(fNSlots)) {
       ret[slot] = (void *)&fBranchAddresses[index][slot];
@@ -78,10 +81,21 @@ void TRootDS::InitSlot(unsigned int slot, ULong64_t firstEntry)
       chain = new TChain(fTreeName.c_str());
    }
    chain->ResetBit(kMustCleanup);
-   chain->Add(fFileNameGlob.c_str());
+   // the numbers of entries of the files are known after Initialise: the chain does not need to open the files that
+   // precede the entries of the slot to find them
+   for (auto element : *fModelChain.GetListOfFiles()) {
+      const auto entries = static_cast<TChainElement *>(element)->GetEntries();
+      if (entries < TTree::kMaxEntries)
+         chain->Add(element->GetTitle(), entries);
+      else
+         chain->Add(element->GetTitle());
+   }
+   // only the branches of the columns that are actually used are read
+   chain->SetBranchStatus("*", 0);
+   for (auto i : fRequestedColumns)
+      chain->SetBranchStatus(fListOfBranches[i].c_str(), 1);
    chain->GetEntry(firstEntry);
-   TString setBranches;
-   for (auto i : ROOT::TSeqU(fListOfBranches.size())) {
+   for (auto i : fRequestedColumns) {
       auto colName = fListOfBranches[i].c_str();
       auto &addr = fBranchAddresses[i][slot];
       auto typeName = GetTypeName(colName);
@@ -96,6 +110,14 @@ void TRootDS::InitSlot(unsigned int slot, ULong64_t firstEntry)
          chain->SetBranchAddress(colName, addr);
       }
    }
+   // the read cache of the slot only holds the baskets of the requested columns, which are known: it does not need a
+   // learning phase. Its entry range is set at the first SetEntry.
+   if (chain->GetCurrentFile()) {
+      for (auto i : fRequestedColumns)
+         chain->AddBranchToCache(fListOfBranches[i].c_str(), kTRUE);
+      chain->StopCacheLearningPhase();
+   }
+   fCacheRanges[slot] = {0ULL, 0ULL};
    fChains[slot].reset(chain);
 }
 
@@ -105,8 +127,33 @@ std::vector<std::pair<ULong64_t, ULong64_t>> TRootDS::GetEntryRanges()
    return entryRanges;
 }
 
+////////////////////////////////////////////////////////////////////////
+/// Restrict the read cache of the slot to the part of the entry range that contains `entry` in the tree that contains
+/// `entry`. Slots then only read and decompress the baskets of their own ranges.
+void TRootDS::SetCacheRange(unsigned int slot, ULong64_t entry)
+{
+   auto &chain = *fChains[slot];
+   if (chain.LoadTree(entry) < 0 || !chain.GetCurrentFile())
+      return;
+   const ULong64_t treeStart = chain.GetTreeOffset()[chain.GetTreeNumber()];
+   auto start = treeStart;
+   auto end = treeStart + chain.GetTree()->GetEntries();
+   const auto range =
+      std::upper_bound(fLoopEntryRanges.begin(), fLoopEntryRanges.end(), entry,
+                       [](ULong64_t e, const std::pair<ULong64_t, ULong64_t> &r) { return e < r.second; });
+   if (range != fLoopEntryRanges.end() && range->first <= entry) {
+      start = std::max(start, range->first);
+      end = std::min(end, range->second);
+   }
+   fCacheRanges[slot] = {start, end};
+   chain.SetCacheEntryRange(start - treeStart, end - treeStart);
+}
+
 void TRootDS::SetEntry(unsigned int slot, ULong64_t entry)
 {
+   const auto &cacheRange = fCacheRanges[slot];
+   if (entry < cacheRange.first || entry >= cacheRange.second)
+      SetCacheRange(slot, entry);
    fChains[slot]->GetEntry(entry);
 }
 
@@ -121,22 +168,27 @@ void TRootDS::SetNSlots(unsigned int nSlots)
    fBranchAddresses.resize(nColumns, std::vector<void *>(fNSlots, nullptr));
 
    fChains.resize(fNSlots);
+   fCacheRanges.resize(fNSlots);
 }
 
+////////////////////////////////////////////////////////////////////////
+/// Split the entries in one range per slot. Ranges start at cluster boundaries, so that no basket is read by more than
+/// one slot.
 void TRootDS::Initialise()
 {
-   const auto nentries = fModelChain.GetEntries();
-   const auto chunkSize = nentries / fNSlots;
-   const auto reminder = 1U == fNSlots ? 0 : nentries % fNSlots;
-   auto start = 0UL;
-   auto end = 0UL;
-   for (auto i : ROOT::TSeqU(fNSlots)) {
-      start = end;
-      end += chunkSize;
-      fEntryRanges.emplace_back(start, end);
-      (void)i;
+   const auto boundaries = ROOT::Internal::TDF::GetClusterBoundaries(fModelChain);
+   const ULong64_t nEntries = boundaries.back();
+   fEntryRanges.clear();
+   auto start = 0ULL;
+   for (auto i = 1ULL; i <= fNSlots; ++i) {
+      ULong64_t end = nEntries / fNSlots * i + std::min(i, nEntries % fNSlots);
+      end = *std::lower_bound(boundaries.begin(), boundaries.end(), Long64_t(end));
+      if (end > start) {
+         fEntryRanges.emplace_back(start, end);
+         start = end;
+      }
    }
-   fEntryRanges.back().second += reminder;
+   fLoopEntryRanges = fEntryRanges;
 }
 
 TDataFrame MakeRootDataFrame(std::string_view treeName, std::string_view fileNameGlob)
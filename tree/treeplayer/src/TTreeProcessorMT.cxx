@@ -22,14 +22,29 @@ The implementation of ROOT::TTreeProcessorMT parallelizes the processing of the
 each corresponding to a cluster in the TTree. This is possible thanks to the use
 of a ROOT::TThreadedObject, so that each thread works with its own TFile and TTree
 objects.
+
+Clusters of all files are processed by a single pool of tasks, which idle workers pick up
+regardless of the file they belong to. Clusters much larger than the average workload of a
+task are split in several subranges, so that a few big clusters do not leave most workers idle
+at the end of the processing: see TTreeProcessorMT::SetTasksPerWorkerHint.
+
+The files are inspected in parallel before the processing starts. Their numbers of entries are then
+passed to the chain of each thread, which therefore opens a file only when one of its tasks reads
+from it, and keeps it open for the following tasks of the thread.
 */
 
 #include "TROOT.h"
 #include "ROOT/TTreeProcessorMT.hxx"
+#include "ROOT/TSeq.hxx"
 #include "ROOT/TThreadExecutor.hxx"
 
+#include <algorithm>
+#include <utility>
+
 using namespace ROOT;
 
+unsigned int TTreeProcessorMT::fgTasksPerWorkerHint = 10U;
+
 ////////////////////////////////////////////////////////////////////////
 /// Constructor based on a file name.
 /// \param[in] filename Name of the file containing the tree to process.
@@ -58,28 +73,77 @@ TTreeProcessorMT::TTreeProcessorMT(TTree &tree) : treeView(tree) {}
 TTreeProcessorMT::TTreeProcessorMT(TTree &tree, TEntryList &entries) : treeView(tree, entries) {}
 
 ////////////////////////////////////////////////////////////////////////
-/// Divide input data in clusters, i.e. the workloads to distribute to tasks
-std::vector<ROOT::Internal::TreeViewCluster> TTreeProcessorMT::MakeClusters()
+/// Divide input data in clusters, i.e. the workloads to distribute to tasks.
+/// The files are inspected in parallel, each by a different task.
+/// \param[out] entriesPerFile Number of entries of each file
+std::vector<ROOT::Internal::TreeViewCluster> TTreeProcessorMT::MakeClusters(std::vector<Long64_t> &entriesPerFile)
 {
-   std::vector<ROOT::Internal::TreeViewCluster> clusters;
+   using ClustersAndEntries = std::pair<std::vector<ROOT::Internal::TreeViewCluster>, Long64_t>;
    const auto &fileNames = treeView->GetFileNames();
    const auto nFileNames = fileNames.size();
    const auto &treeName = treeView->GetTreeName();
-   Long64_t offset = 0;
-   for (auto i = 0u; i < nFileNames; ++i) { // TTreeViewCluster requires the index of the file the cluster belongs to
+
+   // Retrieve the clusters of a file, with entry numbers local to the file, and its number of entries
+   auto getFileClusters = [&fileNames, &treeName](unsigned int i) {
+      ::TDirectory::TContext ctxt(gDirectory);
       std::unique_ptr<TFile> f(TFile::Open(fileNames[i].c_str())); // need TFile::Open to load plugins if need be
       TTree *t = nullptr;                                          // not a leak, t will be deleted by f
       f->GetObject(treeName.c_str(), t);
       auto clusterIter = t->GetClusterIterator(0);
       Long64_t start = 0, end = 0;
       const Long64_t entries = t->GetEntries();
+      std::vector<ROOT::Internal::TreeViewCluster> clusters;
       // Iterate over the clusters in the current file and generate a task for each of them
       while ((start = clusterIter()) < entries) {
          end = clusterIter.GetNextEntry();
-         // Add the current file's offset to start and end to make them (chain) global
-         clusters.emplace_back(ROOT::Internal::TreeViewCluster{start + offset, end + offset});
+         clusters.emplace_back(ROOT::Internal::TreeViewCluster{start, end});
+      }
+      return ClustersAndEntries(std::move(clusters), entries);
+   };
+
+   std::vector<ClustersAndEntries> clustersAndEntries;
+   if (nFileNames == 1) {
+      clustersAndEntries.emplace_back(getFileClusters(0));
+   } else {
+      // Opening a file and reading the header of its tree mostly means waiting for I/O: do it for all files at once
+      TThreadExecutor pool;
+      clustersAndEntries = pool.Map(getFileClusters, ROOT::TSeqU(nFileNames));
+   }
+
+   std::vector<ROOT::Internal::TreeViewCluster> fileClusters;
+   entriesPerFile.clear();
+   Long64_t offset = 0;
+   Long64_t nEntriesToProcess = 0;
+   for (auto &ce : clustersAndEntries) {
+      for (auto &c : ce.first) {
+         // Add the current file's offset to start and end to make them (chain) global, and only keep the entries
+         // within the range to process
+         const auto start = std::max(c.startEntry + offset, fBeginEntry);
+         const auto end = std::min(c.endEntry + offset, fEndEntry);
+         if (start < end) {
+            fileClusters.emplace_back(ROOT::Internal::TreeViewCluster{start, end});
+            nEntriesToProcess += end - start;
+         }
+      }
+      entriesPerFile.emplace_back(ce.second);
+      offset += ce.second;
+   }
+
+   // Split the clusters that are larger than the workload we aim at for a single task. Subranges of the same cluster
+   // share the same baskets, which are then read by more than one task: clusters are only split when needed.
+   const Long64_t nTasks = fgTasksPerWorkerHint * ROOT::GetImplicitMTPoolSize();
+   if (nTasks == 0)
+      return fileClusters;
+   const Long64_t maxTaskSize = std::max(1LL, (nEntriesToProcess + nTasks - 1) / nTasks);
+   std::vector<ROOT::Internal::TreeViewCluster> clusters;
+   for (const auto &c : fileClusters) {
+      const auto clusterSize = c.endEntry - c.startEntry;
+      const auto nSplits = (clusterSize + maxTaskSize - 1) / maxTaskSize;
+      for (Long64_t i = 0; i < nSplits; ++i) {
+         // split evenly: sizes of the subranges differ by one entry at most
+         clusters.emplace_back(ROOT::Internal::TreeViewCluster{c.startEntry + i * clusterSize / nSplits,
+                                                               c.startEntry + (i + 1) * clusterSize / nSplits});
       }
-      offset += entries;
    }
    return clusters;
 }
@@ -106,9 +170,14 @@ void TTreeProcessorMT::Process(std::function<void(TTreeReader &)> func)
    // Enable this IMT use case (activate its locks)
    Internal::TParTreeProcessingRAII ptpRAII;
 
-   auto clusters = MakeClusters();
+   std::vector<Long64_t> entriesPerFile;
+   auto clusters = MakeClusters(entriesPerFile);
+
+   auto mapFunction = [this, &func, &entriesPerFile](const ROOT::Internal::TreeViewCluster &c) {
+      // Let the chain of this thread know where each file starts, so that it only opens the files it reads.
+      // This is a no-op after the first task of the thread.
+      treeView->SetEntriesPerFile(entriesPerFile);
 
-   auto mapFunction = [this, &func](const ROOT::Internal::TreeViewCluster &c) {
       // This task will operate with the tree that contains startEntry
       treeView->PushLoadedEntry(c.startEntry);
 
@@ -124,3 +193,38 @@ void TTreeProcessorMT::Process(std::function<void(TTreeReader &)> func)
    TThreadExecutor pool;
    pool.Foreach(mapFunction, clusters);
 }
+
+////////////////////////////////////////////////////////////////////////
+/// \brief Restricts the processing to a range of entries.
+/// \param[in] beginEntry First entry to process.
+/// \param[in] endEntry Entry at which processing stops, not processed itself.
+///
+/// Entry numbers are global, i.e. they count the entries of all files in case of a chain. Only the clusters that
+/// overlap with the range give rise to tasks, and those tasks only read the entries within the range.
+/// The input files are still all opened before processing starts, to compute the global entry numbers.
+void TTreeProcessorMT::SetEntriesRange(Long64_t beginEntry, Long64_t endEntry)
+{
+   fBeginEntry = beginEntry;
+   fEndEntry = endEntry;
+}
+
+////////////////////////////////////////////////////////////////////////
+/// \brief Sets the hint for the number of tasks created per worker thread.
+/// \param[in] m Desired number of tasks per worker thread.
+///
+/// The input is split in about `m` tasks per worker thread: clusters with more entries than the total number of
+/// entries divided by the number of tasks are split in subranges, which are processed by separate tasks.
+/// The default is 10. More tasks improve the load balancing at the end of the processing, at the price of
+/// reading the baskets of a split cluster in more than one task. A value of 0 produces exactly one task per cluster.
+void TTreeProcessorMT::SetTasksPerWorkerHint(unsigned int m)
+{
+   fgTasksPerWorkerHint = m;
+}
+
+////////////////////////////////////////////////////////////////////////
+/// \brief Retrieves the current value of the hint for the number of tasks created per worker thread.
+/// \return The desired number of tasks per worker thread, see SetTasksPerWorkerHint.
+unsigned int TTreeProcessorMT::GetTasksPerWorkerHint()
+{
+   return fgTasksPerWorkerHint;
+}
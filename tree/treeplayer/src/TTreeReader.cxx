@@ -261,6 +261,7 @@ TTreeReader::EEntryStatus TTreeReader::SetEntriesRange(Long64_t beginEntry, Long
       fEndEntry = endEntry;
    else
       fEndEntry = -1;
+   fBeginEntry = beginEntry;
    if (beginEntry - 1 < 0)
       Restart();
    else {
@@ -258,3 +258,109 @@ TEST(Cache, Carrays)
 }
 
 #endif // R__B64
+
+TEST(Cache, Persistent)
+{
+   auto treeName = "t";
+   auto fileName = "dataframe_cache_persistent_input.root";
+   auto cacheFileName = "dataframe_cache_persistent.root";
+   gSystem->Unlink(cacheFileName);
+   auto writeInput = [&](int nEntries) {
+      TFile f(fileName, "RECREATE");
+      TTree t(treeName, treeName);
+      int x;
+      t.Branch("x", &x);
+      for (auto i : ROOT::TSeqI(nEntries)) {
+         x = i;
+         t.Fill();
+      }
+      t.Write();
+   };
+   writeInput(10);
+
+   // jitted Defines can be fingerprinted: count their evaluations with a variable known to the interpreter
+   gInterpreter->Declare("int dataframe_cache_persistent_ncalls = 0;");
+   auto nJittedCalls = []() { return gInterpreter->ProcessLine("dataframe_cache_persistent_ncalls;"); };
+   const auto doubleXExpr = "++dataframe_cache_persistent_ncalls, 2 * x";
+   auto sumCached = [&](TInterface<ROOT::Detail::TDF::TLoopManager> cached) { return *cached.Sum<int>("y"); };
+
+   // the first call generates the cache
+   {
+      TDataFrame tdf(treeName, fileName);
+      EXPECT_EQ(90, sumCached(tdf.Define("y", doubleXExpr).Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(10, nJittedCalls());
+   }
+
+   // following calls, also jitted, read the cache back without running the computation graph
+   {
+      TDataFrame tdf(treeName, fileName);
+      auto y = tdf.Define("y", doubleXExpr);
+      EXPECT_EQ(90, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(90, sumCached(y.Cache({"y"}, cacheFileName)));
+      EXPECT_EQ(10, nJittedCalls());
+   }
+
+   // a change in the computation graph upstream of the cached node invalidates the cache
+   {
+      TDataFrame tdf(treeName, fileName);
+      EXPECT_EQ(70, sumCached(tdf.Filter("x > 4").Define("y", doubleXExpr).Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(15, nJittedCalls());
+   }
+   {
+      TDataFrame tdf(treeName, fileName);
+      auto y = tdf.Filter("x > 5").Define("y", doubleXExpr);
+      EXPECT_EQ(60, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(19, nJittedCalls());
+      EXPECT_EQ(60, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(19, nJittedCalls());
+   }
+   {
+      TDataFrame tdf(treeName, fileName);
+      auto y = tdf.Filter("x > 5").Range(2).Define("y", doubleXExpr);
+      EXPECT_EQ(26, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(21, nJittedCalls());
+   }
+
+   // compiled callables cannot be fingerprinted, the cache is always regenerated
+   {
+      int nCalls = 0;
+      auto doubleX = [&nCalls](int x) {
+         ++nCalls;
+         return 2 * x;
+      };
+      TDataFrame tdf(treeName, fileName);
+      auto y = tdf.Define("y", doubleX, {"x"});
+      EXPECT_EQ(90, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(90, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(20, nCalls);
+   }
+   {
+      TDataFrame tdf(treeName, fileName);
+      auto y = tdf.Filter([](int x) { return x > 5; }, {"x"}).Define("y", doubleXExpr);
+      EXPECT_EQ(60, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(60, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(29, nJittedCalls());
+   }
+
+   // a change in the input or in the selected columns invalidates the cache
+   writeInput(11);
+   {
+      TDataFrame tdf(treeName, fileName);
+      auto y = tdf.Define("y", doubleXExpr);
+      EXPECT_EQ(110, sumCached(y.Cache<int>({"y"}, cacheFileName)));
+      EXPECT_EQ(40, nJittedCalls());
+      auto cached = y.Cache<int, int>({"y", "x"}, cacheFileName);
+      EXPECT_EQ(110, sumCached(cached));
+      EXPECT_EQ(55, *cached.Sum<int>("x"));
+      EXPECT_EQ(51, nJittedCalls());
+   }
+
+   // an empty selection of columns cannot be cached
+   {
+      TDataFrame tdf(treeName, fileName);
+      EXPECT_THROW(tdf.Cache(std::vector<std::string>{}, cacheFileName), std::runtime_error);
+   }
+
+   gSystem->Unlink(fileName);
+   gSystem->Unlink(cacheFileName);
+}
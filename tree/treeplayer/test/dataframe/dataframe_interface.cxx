@@ -1,6 +1,8 @@
 #include "ROOT/TDataFrame.hxx"
 #include "ROOT/TTrivialDS.hxx"
+#include "TInterpreter.h"
 #include "TMemFile.h"
+#include "TSystem.h"
 #include "TTree.h"
 
 #include "gtest/gtest.h"
@@ -168,3 +170,94 @@ TEST(TDataFrameInterface, JitDefaultColumns)
    auto minEntry = f.Min("tdfentry_");
    EXPECT_EQ(*maxEntry, *minEntry);
 }
+
+TEST(TDataFrameInterface, SharedJittedFilters)
+{
+   gInterpreter->Declare("unsigned int TDataFrameInterface_SharedJittedFilters_nCalls = 0;");
+   TDataFrame tdf(8);
+   const auto expression = "++TDataFrameInterface_SharedJittedFilters_nCalls > 0 && tdfentry_ % 2 == 0";
+   auto c1 = tdf.Filter(expression).Count();
+   auto c2 = tdf.Filter(expression).Count();
+   auto c3 = tdf.Filter(expression, "named").Count();
+   EXPECT_EQ(*c1, 4ull);
+   EXPECT_EQ(*c2, 4ull);
+   EXPECT_EQ(*c3, 4ull);
+   // the two unnamed filters are one and the same node, the named one is booked separately
+   EXPECT_EQ(gInterpreter->Calc("TDataFrameInterface_SharedJittedFilters_nCalls"), 16);
+}
+
+TEST(TDataFrameInterface, Profile)
+{
+   TDataFrame tdf(10);
+   auto d = tdf.Define("x", [](ULong64_t e) { return double(e); }, {"tdfentry_"});
+   auto f = d.Filter([](double x) { return x > 4.; }, {"x"}, "xcut");
+   auto sum = f.Sum<double>("x");
+   auto profile = tdf.ProfileReport();
+   EXPECT_DOUBLE_EQ(*sum, 35.);
+
+   const auto x = profile->GetNode("x");
+   ASSERT_NE(nullptr, x);
+   EXPECT_EQ(TProfileReport::ENodeKind::kDefine, x->fKind);
+   EXPECT_EQ(10ull, x->fCalls);
+   const auto xcut = profile->GetNode("xcut");
+   ASSERT_NE(nullptr, xcut);
+   EXPECT_EQ(TProfileReport::ENodeKind::kFilter, xcut->fKind);
+   EXPECT_EQ(10ull, xcut->fCalls);
+   const auto sumNode = profile->GetNode("SumHelper(x)");
+   ASSERT_NE(nullptr, sumNode);
+   EXPECT_EQ(5ull, sumNode->fCalls);
+
+   ULong64_t nEntries = 0ull;
+   for (const auto &slot : profile->GetSlots())
+      nEntries += slot.fEntries;
+   EXPECT_EQ(10ull, nEntries);
+   EXPECT_NE(std::string::npos, profile->AsJSON().find("{\"name\": \"xcut\", \"kind\": \"filter\", \"calls\": 10,"));
+
+   // the next event loop is not profiled
+   EXPECT_EQ(5ull, *f.Count());
+}
+
+TEST(TDataFrameInterface, JitCache)
+{
+   const auto oldCacheDir = GetJitCacheDir();
+   const std::string cacheDir = "dataframe_interface_jitcache";
+   gSystem->Exec(("rm -rf " + cacheDir).c_str());
+   SetJitCacheDir(cacheDir);
+   EXPECT_EQ(cacheDir, GetJitCacheDir());
+
+   // the second TDataFrame reuses the code compiled for the first one: the functions available in this process are
+   // forgotten before each one, as if it ran in a new process, so that they are loaded from the cache
+   std::vector<ROOT::Internal::TDF::TJitCounts> counts{ROOT::Internal::TDF::GetJitCounts()};
+   for (auto i = 0; i < 2; ++i) {
+      ROOT::Internal::TDF::ClearJitFunctions();
+      TDataFrame tdf(10);
+      auto d = tdf.Define("x", [](ULong64_t e) { return double(e); }, {"tdfentry_"});
+      auto sum = d.Filter("x > 4").Define("y", "x * 2").Sum("y");
+      EXPECT_DOUBLE_EQ(70., *sum);
+      counts.emplace_back(ROOT::Internal::TDF::GetJitCounts());
+   }
+   EXPECT_EQ(counts[0].fNInterpreted, counts[2].fNInterpreted);
+   EXPECT_LT(counts[0].fNCompiled, counts[1].fNCompiled);
+   EXPECT_EQ(counts[1].fNCompiled, counts[2].fNCompiled);
+   EXPECT_EQ(counts[1].fNCompiled - counts[0].fNCompiled, counts[2].fNLoaded - counts[1].fNLoaded);
+
+   // the code was compiled: only the libraries, under their final name, are left in the cache
+   const std::string soExt = std::string(".") + gSystem->GetSoExt();
+   auto nLibraries = 0;
+   auto dir = gSystem->OpenDirectory(cacheDir.c_str());
+   ASSERT_NE(nullptr, dir);
+   while (const char *entry = gSystem->GetDirEntry(dir)) {
+      const std::string fileName(entry);
+      EXPECT_EQ(std::string::npos, fileName.find(".failed")) << fileName;
+      const auto extPos = fileName.size() > soExt.size() ? fileName.size() - soExt.size() : 0;
+      if (extPos > 0 && fileName.compare(extPos, soExt.size(), soExt) == 0) {
+         EXPECT_EQ(std::string::npos, fileName.find('_', 7)) << fileName; // no temporary "_<pid>" suffix
+         ++nLibraries;
+      }
+   }
+   gSystem->FreeDirectory(dir);
+   EXPECT_LT(0, nLibraries);
+
+   SetJitCacheDir(oldCacheDir);
+   gSystem->Exec(("rm -rf " + cacheDir).c_str());
+}
@@ -0,0 +1,161 @@
+#include "ROOT/TDataFrame.hxx"
+#include "TFile.h"
+#include "TROOT.h"
+#include "TSystem.h"
+#include "TTree.h"
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace ROOT::Experimental;
+
+// fixture that writes a tree with several clusters, and removes the file at the end
+class TDFMultiProcess : public ::testing::Test {
+protected:
+   const char *fFileName = "dataframe_multiprocess.root";
+   const char *fTreeName = "t";
+   const int fNEntries = 1000;
+
+   TDFMultiProcess()
+   {
+      TFile f(fFileName, "RECREATE");
+      TTree t(fTreeName, fTreeName);
+      t.SetAutoFlush(64);
+      int x = 0;
+      double y = 0.;
+      t.Branch("x", &x);
+      t.Branch("y", &y);
+      for (x = 0; x < fNEntries; ++x) {
+         y = 0.5 * x;
+         t.Fill();
+      }
+      t.Write();
+   }
+   ~TDFMultiProcess() { gSystem->Unlink(fFileName); }
+};
+
+TEST(TDFMultiProcessEmpty, Actions)
+{
+   TDataFrame d(100);
+   d.EnableMultiProcess(3);
+   auto dd = d.Define("x", [](ULong64_t e) { return double(e); }, {"tdfentry_"});
+   auto count = dd.Filter("x > 9").Count();
+   auto sum = dd.Sum<double>("x");
+   auto mean = dd.Mean<double>("x");
+   auto min = dd.Min<double>("x");
+   auto max = dd.Max<double>("x");
+   auto take = dd.Take<double>("x");
+   auto reduced = dd.Reduce([](double a, double b) { return a + b; }, "x", 0.);
+   auto h = dd.Histo1D<double>({"h", "h", 10, 0., 100.}, "x");
+
+   EXPECT_EQ(90ull, *count);
+   EXPECT_DOUBLE_EQ(4950., *sum);
+   EXPECT_DOUBLE_EQ(49.5, *mean);
+   EXPECT_DOUBLE_EQ(0., *min);
+   EXPECT_DOUBLE_EQ(99., *max);
+   EXPECT_DOUBLE_EQ(4950., *reduced);
+   ASSERT_EQ(100u, take->size());
+   for (auto i = 0u; i < take->size(); ++i)
+      EXPECT_DOUBLE_EQ(double(i), take->at(i));
+   EXPECT_EQ(100, h->GetEntries());
+   EXPECT_DOUBLE_EQ(10., h->GetBinContent(1));
+   EXPECT_DOUBLE_EQ(49.5, h->GetMean());
+}
+
+TEST(TDFMultiProcessEmpty, MoreWorkersThanEntries)
+{
+   TDataFrame d(2);
+   d.EnableMultiProcess(4);
+   EXPECT_EQ(2ull, *d.Count());
+}
+
+TEST(TDFMultiProcessEmpty, WorkerError)
+{
+   TDataFrame d(10);
+   d.EnableMultiProcess(2);
+   auto throwOn7 = [](ULong64_t e) {
+      if (e == 7)
+         throw std::runtime_error("entry 7");
+      return true;
+   };
+   auto c = d.Filter(throwOn7, {"tdfentry_"}).Count();
+   EXPECT_THROW(*c, std::runtime_error);
+}
+
+TEST(TDFMultiProcessEmpty, UnsupportedGraphs)
+{
+   TDataFrame d(10);
+   d.EnableMultiProcess(2);
+   auto c = d.Range(5).Count();
+   EXPECT_THROW(*c, std::runtime_error);
+
+   TDataFrame d2(10);
+   TDataFrame d3(10);
+   d2.ShareEventLoop(d3);
+   EXPECT_THROW(d2.EnableMultiProcess(2), std::runtime_error);
+   EXPECT_THROW(d3.EnableMultiProcess(2), std::runtime_error);
+}
+
+TEST(TDFMultiProcessEmpty, Disable)
+{
+   TDataFrame d(10);
+   d.EnableMultiProcess(2);
+   d.DisableMultiProcess();
+   // ranges are supported by single-process event loops again
+   EXPECT_EQ(5ull, *d.Range(5).Count());
+}
+
+#ifdef R__USE_IMT
+TEST(TDFMultiProcessEmpty, ImplicitMT)
+{
+   ROOT::EnableImplicitMT(2);
+   TDataFrame d(10);
+   EXPECT_THROW(d.EnableMultiProcess(2), std::runtime_error);
+   ROOT::DisableImplicitMT();
+}
+#endif
+
+TEST_F(TDFMultiProcess, SameResultsAsSequential)
+{
+   TDataFrame seq(fTreeName, fFileName);
+   auto seqF = seq.Filter("x % 3 == 0");
+   auto seqCount = seqF.Count();
+   auto seqSum = seqF.Sum<double>("y");
+   auto seqMean = seqF.Mean<int>("x");
+   auto seqTake = seqF.Take<int>("x");
+   auto seqH = seqF.Histo1D<double>({"h", "h", 50, 0., 500.}, "y");
+
+   TDataFrame mp(fTreeName, fFileName);
+   mp.EnableMultiProcess(4);
+   auto mpF = mp.Filter("x % 3 == 0");
+   auto mpCount = mpF.Count();
+   auto mpSum = mpF.Sum<double>("y");
+   auto mpMean = mpF.Mean<int>("x");
+   auto mpTake = mpF.Take<int>("x");
+   auto mpH = mpF.Histo1D<double>({"h", "h", 50, 0., 500.}, "y");
+
+   EXPECT_EQ(*seqCount, *mpCount);
+   EXPECT_DOUBLE_EQ(*seqSum, *mpSum);
+   EXPECT_DOUBLE_EQ(*seqMean, *mpMean);
+   EXPECT_EQ(*seqTake, *mpTake);
+   for (auto bin = 0; bin <= seqH->GetNbinsX() + 1; ++bin)
+      EXPECT_DOUBLE_EQ(seqH->GetBinContent(bin), mpH->GetBinContent(bin));
+}
+
+TEST_F(TDFMultiProcess, Snapshot)
+{
+   const auto outFileName = "dataframe_multiprocess_snapshot.root";
+   TDataFrame d(fTreeName, fFileName);
+   d.EnableMultiProcess(3);
+   auto snap = d.Filter("x % 2 == 1").Define("z", "y * 2").Snapshot<int, double>("s", outFileName, {"x", "z"});
+
+   auto xs = snap.Take<int>("x");
+   auto zs = snap.Take<double>("z");
+   ASSERT_EQ(std::size_t(fNEntries / 2), xs->size());
+   for (auto i = 0u; i < xs->size(); ++i) {
+      EXPECT_EQ(int(2 * i + 1), xs->at(i));
+      EXPECT_DOUBLE_EQ(double(2 * i + 1), zs->at(i));
+   }
+   gSystem->Unlink(outFileName);
+}
@@ -93,6 +93,41 @@ TEST(TEST_CATEGORY, Ranges)
 }
 #endif
 
+TEST(TEST_CATEGORY, RangesOnAllEntries)
+{
+   auto fileName = "dataframe_regression_1.root";
+   auto treeName = "t";
+#ifndef dataframe_regression_1_CREATED
+#define dataframe_regression_1_CREATED
+   TEST_CATEGORY::FillTree(fileName, treeName, 100);
+#endif
+   // in multi-thread event loops only the first 50 entries should be processed
+   TDataFrame d(treeName, fileName, {"b1"});
+   auto min = d.Range(10, 50).Min();
+   auto max = d.Range(10, 50).Max();
+   auto strided = d.Range(0, 30, 3).Count();
+   auto sum = d.Range(5).Sum();
+   EXPECT_DOUBLE_EQ(*min, 10);
+   EXPECT_DOUBLE_EQ(*max, 49);
+   EXPECT_EQ(*strided, 10ull);
+   EXPECT_DOUBLE_EQ(*sum, 10);
+
+   // a range and an action on all entries in the same event loop
+   auto count = d.Count();
+   auto last = d.Range(90, 0).Min();
+   EXPECT_EQ(*count, 100ull);
+   EXPECT_DOUBLE_EQ(*last, 90);
+
+   TDataFrame empty(100);
+   auto emptyCount = empty.Define("x", []() { return 1; }).Range(20, 30).Sum<int>("x");
+   EXPECT_EQ(*emptyCount, 10);
+
+   if (ROOT::IsImplicitMTEnabled()) {
+      auto f = d.Filter([](int b) { return b > 10; });
+      EXPECT_THROW(f.Range(10), std::runtime_error);
+   }
+}
+
 TEST(TEST_CATEGORY, EmptyTree)
 {
    auto fileName = "dataframe_regression_2.root";
@@ -1,15 +1,21 @@
 #include "Compression.h"
 #include "ROOT/TDataFrame.hxx"
 #include "ROOT/TSeq.hxx"
+#include "TChain.h"
 #include "TInterpreter.h"
 #include "TFile.h"
 #include "TRandom.h"
 #include "TSystem.h"
+#ifdef R__USE_IMT
+#include "ROOT/TTreeProcessorMT.hxx"
+#endif
 
 #include "gtest/gtest.h"
 
 #include <algorithm> // std::sort
+#include <atomic>
 #include <chrono>
+#include <mutex>
 #include <thread>
 #include <set>
 
@@ -410,3 +416,318 @@ TEST(TEST_CATEGORY, TakeCarrays)
 
    gSystem->Unlink(fileName);
 }
+
+// Scalar branches of fundamental type are read one basket at a time
+TEST(TEST_CATEGORY, BulkReadFundamentalTypes)
+{
+   auto treeName = "t";
+   auto fileName = "dataframe_simple_bulk.root";
+#ifndef testTDF_simple_bulk_CREATED
+#define testTDF_simple_bulk_CREATED
+   {
+      TFile f(fileName, "RECREATE");
+      TTree t(treeName, treeName);
+      t.SetAutoFlush(7); // several baskets per branch, with a number of entries that does not divide the total
+      double d;
+      float fl;
+      int i;
+      unsigned int u;
+      Long64_t l;
+      short s;
+      bool b;
+      t.Branch("d", &d);
+      t.Branch("f", &fl);
+      t.Branch("i", &i);
+      t.Branch("u", &u);
+      t.Branch("l", &l);
+      t.Branch("s", &s);
+      t.Branch("b", &b);
+      for (auto e : ROOT::TSeqI(100)) {
+         d = e * 0.5;
+         fl = -e;
+         i = -e * 1000;
+         u = e * 1000;
+         l = e * 1000000000ll;
+         s = e;
+         b = e % 3 == 0;
+         t.Fill();
+      }
+      t.Write();
+   }
+#endif
+
+   TChain c(treeName);
+   c.Add(fileName);
+   c.Add(fileName); // the second file checks that entry numbers are correctly translated when the tree changes
+   TDataFrame tdf(c);
+   auto check = [](std::vector<double> v, double scale) {
+      ASSERT_EQ(200U, v.size());
+      std::sort(v.begin(), v.end());
+      for (auto e : ROOT::TSeqI(100)) {
+         EXPECT_DOUBLE_EQ(scale * e, v[2 * e]);
+         EXPECT_DOUBLE_EQ(scale * e, v[2 * e + 1]);
+      }
+   };
+   auto ds = tdf.Take<double>("d");
+   auto fs = tdf.Define("fd", [](float x) { return -double(x); }, {"f"}).Take<double>("fd");
+   auto is = tdf.Define("id", [](int x) { return -double(x); }, {"i"}).Take<double>("id");
+   auto us = tdf.Define("ud", [](unsigned int x) { return double(x); }, {"u"}).Take<double>("ud");
+   auto ls = tdf.Define("ld", [](Long64_t x) { return double(x); }, {"l"}).Take<double>("ld");
+   auto ss = tdf.Define("sd", [](short x) { return double(x); }, {"s"}).Take<double>("sd");
+   // filters that only read bulk columns are evaluated on whole batches of entries
+   auto nTrue = tdf.Filter([](bool b) { return b; }, {"b"}).Count();
+   auto nJitted = tdf.Filter("d > 24.75 && s < 80 && b").Count();
+
+   check(*ds, 0.5);
+   check(*fs, 1.);
+   check(*is, 1000.);
+   check(*us, 1000.);
+   check(*ls, 1000000000.);
+   check(*ss, 1.);
+   EXPECT_EQ(68U, *nTrue);
+   EXPECT_EQ(20U, *nJitted);
+}
+
+// In multi-thread event loops, large clusters are split in several tasks
+TEST(TEST_CATEGORY, SingleLargeCluster)
+{
+   auto treeName = "t";
+   auto fileName = "dataframe_simple_largecluster.root";
+#ifndef testTDF_simple_largecluster_CREATED
+#define testTDF_simple_largecluster_CREATED
+   {
+      TFile f(fileName, "RECREATE");
+      TTree t(treeName, treeName);
+      int i;
+      t.Branch("i", &i);
+      for (i = 0; i < 1000; ++i)
+         t.Fill();
+      t.Write();
+   }
+#endif
+
+#ifdef R__USE_IMT
+   // 4 tasks per worker thread: the single cluster must be split in 4 * NSLOTS contiguous ranges of entries
+   const auto tasksPerWorkerHint = ROOT::TTreeProcessorMT::GetTasksPerWorkerHint();
+   ROOT::TTreeProcessorMT::SetTasksPerWorkerHint(4);
+   if (ROOT::IsImplicitMTEnabled()) {
+      std::mutex rangesMutex;
+      std::vector<std::pair<Long64_t, Long64_t>> ranges;
+      ROOT::TTreeProcessorMT tp(fileName, treeName);
+      tp.Process([&](TTreeReader &r) {
+         std::lock_guard<std::mutex> lock(rangesMutex);
+         ranges.emplace_back(r.GetEntriesRange());
+      });
+      std::sort(ranges.begin(), ranges.end());
+      EXPECT_EQ(4 * NSLOTS, ranges.size());
+      Long64_t expectedStart = 0;
+      for (const auto &range : ranges) {
+         EXPECT_EQ(expectedStart, range.first);
+         expectedStart = range.second;
+      }
+      EXPECT_EQ(1000, expectedStart);
+   }
+#endif
+
+   TDataFrame tdf(treeName, fileName);
+   auto c = tdf.Count();
+   auto is = tdf.Take<int>("i");
+   EXPECT_EQ(1000U, *c);
+   auto v = *is;
+   std::sort(v.begin(), v.end());
+   for (auto e : ROOT::TSeqI(1000))
+      EXPECT_EQ(e, v[e]);
+
+#ifdef R__USE_IMT
+   ROOT::TTreeProcessorMT::SetTasksPerWorkerHint(tasksPerWorkerHint);
+#endif
+}
+
+// Filters evaluated on batches of entries read in bulk are called exactly once per entry, also when tasks split
+// clusters and baskets in multi-thread event loops
+TEST(TEST_CATEGORY, BatchedFilterCalls)
+{
+   auto treeName = "t";
+   auto fileName = "dataframe_simple_batchedfilter.root";
+#ifndef testTDF_simple_batchedfilter_CREATED
+#define testTDF_simple_batchedfilter_CREATED
+   {
+      TFile f(fileName, "RECREATE");
+      TTree t(treeName, treeName);
+      int i;
+      t.Branch("i", &i, "i/I", 1000);
+      t.SetAutoFlush(3000);
+      for (i = 0; i < 10000; ++i)
+         t.Fill();
+      t.Write();
+   }
+#endif
+
+   TDataFrame tdf(treeName, fileName);
+   std::atomic<int> nCalls(0);
+   auto c = tdf.Filter([&nCalls](int i) {
+                  ++nCalls;
+                  return i % 2 == 0;
+               },
+               {"i"})
+               .Count();
+   EXPECT_EQ(5000U, *c);
+   EXPECT_EQ(10000, nCalls.load());
+
+   // a filter upstream of a range is not invoked on the entries after the end of the range
+   if (!ROOT::IsImplicitMTEnabled()) {
+      nCalls = 0;
+      auto r = tdf.Filter([&nCalls](int i) {
+                     ++nCalls;
+                     return i % 2 == 0;
+                  },
+                  {"i"})
+                  .Range(100)
+                  .Count();
+      EXPECT_EQ(100U, *r);
+      EXPECT_EQ(199, nCalls.load());
+   }
+}
+
+// The trees of a chain can store a column differently: the entries of the trees in which the column cannot be read
+// in bulk are read as usual
+TEST(TEST_CATEGORY, BulkReadChainMixedStorage)
+{
+   auto treeName = "t";
+   auto fileName1 = "dataframe_simple_bulkchain1.root";
+   auto fileName2 = "dataframe_simple_bulkchain2.root";
+#ifndef testTDF_simple_bulkchain_CREATED
+#define testTDF_simple_bulkchain_CREATED
+   {
+      TFile f(fileName1, "RECREATE");
+      TTree t(treeName, treeName);
+      int i;
+      t.Branch("i", &i);
+      for (i = 0; i < 1000; ++i)
+         t.Fill();
+      t.Write();
+   }
+   {
+      // in the second file the column is stored in a friend tree
+      TFile f(fileName2, "RECREATE");
+      TTree ft("ft", "ft");
+      int i;
+      ft.Branch("i", &i);
+      for (i = 1000; i < 3000; ++i)
+         ft.Fill();
+      ft.Write();
+      TTree t(treeName, treeName);
+      int j;
+      t.Branch("j", &j);
+      for (j = 0; j < 2000; ++j)
+         t.Fill();
+      t.AddFriend(&ft);
+      t.Write();
+   }
+#endif
+
+   TChain c(treeName);
+   c.Add(fileName1);
+   c.Add(fileName2);
+   TDataFrame tdf(c);
+   auto sum = tdf.Sum<int>("i");
+   auto nEven = tdf.Filter([](int i) { return i % 2 == 0; }, {"i"}).Count();
+   EXPECT_DOUBLE_EQ(2999. * 3000. / 2., *sum);
+   EXPECT_EQ(1500U, *nEven);
+}
+
+#ifdef R__USE_IMT
+// Event loops of independent TDataFrames can run at the same time
+TEST(TEST_CATEGORY, RunAsync)
+{
+   TDataFrame d1(100);
+   TDataFrame d2(200);
+   auto c1 = d1.Count();
+   auto s2 = d2.Define("x", [](ULong64_t e) { return double(e); }, {"tdfentry_"}).Sum<double>("x");
+   auto f1 = d1.RunAsync();
+   auto f2 = d2.RunAsync();
+   f1.get();
+   EXPECT_EQ(100U, *c1);
+   EXPECT_DOUBLE_EQ(19900., *s2); // waits for the event loop of d2
+   f2.get();
+
+   // new results trigger a new event loop, also after an asynchronous one
+   auto c2 = d2.Filter([](ULong64_t e) { return e < 50; }, {"tdfentry_"}).Count();
+   EXPECT_EQ(50U, *c2);
+}
+#endif
+
+// TDataFrames over the same dataset can share their event loop
+TEST(TEST_CATEGORY, ShareEventLoop)
+{
+   auto treeName = "t";
+   auto fileName = "dataframe_simple_shareeventloop.root";
+#ifndef testTDF_simple_shareeventloop_CREATED
+#define testTDF_simple_shareeventloop_CREATED
+   {
+      TDataFrame(100).Define("i", [](ULong64_t e) { return int(e); }, {"tdfentry_"}).Snapshot<int>(treeName, fileName,
+                                                                                                   {"i"});
+   }
+#endif
+
+   TDataFrame d1(treeName, fileName);
+   TDataFrame d2(treeName, fileName);
+   TDataFrame d3(treeName, fileName);
+   d1.ShareEventLoop(d2);
+   d3.ShareEventLoop(d2.Filter([]() { return true; }));
+
+   std::atomic<unsigned int> nEntries2(0u);
+   auto sum1 = d1.Sum<int>("i");
+   auto sum2 = d2.Define("j", [&nEntries2](int i) { ++nEntries2; return 2 * i; }, {"i"}).Sum<int>("j");
+   auto count3 = d3.Filter([](int i) { return i < 10; }, {"i"}).Count();
+   EXPECT_DOUBLE_EQ(4950., *sum1);
+   // the other results were produced by the same event loop
+   EXPECT_EQ(100U, nEntries2.load());
+   EXPECT_DOUBLE_EQ(9900., *sum2);
+   EXPECT_EQ(10U, *count3);
+   EXPECT_EQ(100U, nEntries2.load());
+
+   TDataFrame empty(100);
+   EXPECT_THROW(d1.ShareEventLoop(empty), std::runtime_error);
+}
+
+// Histograms whose per-slot copies would be too large are filled concurrently instead of being copied. There are no
+// copies with a single slot: the shared mode is only used by multi-thread event loops.
+#if NSLOTS > 1
+TEST(TEST_CATEGORY, SharedHistoFill)
+{
+   TDataFrame d(10000);
+   auto dd = d.Define("x", [](ULong64_t e) { return double(e % 100); }, {"tdfentry_"})
+                .Define("y", [](ULong64_t e) { return double(e % 37); }, {"tdfentry_"})
+                .Define("v", [](ULong64_t e) { return std::vector<double>(e % 3, 1.); }, {"tdfentry_"});
+   auto hCopies = dd.Histo2D<double, double>({"h", "h", 100, 0., 100., 37, 0., 37.}, "x", "y");
+   auto pCopies = dd.Profile1D<double, double>({"p", "p", 100, 0., 100.}, "x", "y");
+   const auto prevSize = GetMaxHistoCopiesSize();
+   SetMaxHistoCopiesSize(0);
+   auto hShared = dd.Histo2D<double, double>({"h", "h", 100, 0., 100., 37, 0., 37.}, "x", "y");
+   auto pShared = dd.Profile1D<double, double>({"p", "p", 100, 0., 100.}, "x", "y");
+   auto hVec = dd.Histo1D<std::vector<double>>({"hv", "hv", 2, 0., 2.}, "v");
+   SetMaxHistoCopiesSize(prevSize);
+   // in shared mode, partial results are snapshots: the other slots do not fill them while callbacks use them
+   std::mutex partialsMutex;
+   std::set<TH2D *> partials;
+   hShared.OnPartialResultSlot(hShared.kOnce, [&](unsigned int, TH2D &h) {
+      const auto entries = h.GetEntries();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      EXPECT_EQ(entries, h.GetEntries());
+      std::lock_guard<std::mutex> lock(partialsMutex);
+      partials.insert(&h);
+   });
+
+   EXPECT_EQ(10000, hShared->GetEntries());
+   EXPECT_DOUBLE_EQ(hCopies->GetMean(1), hShared->GetMean(1));
+   EXPECT_DOUBLE_EQ(hCopies->GetMean(2), hShared->GetMean(2));
+   for (auto bin = 0; bin < hCopies->GetNcells(); ++bin)
+      EXPECT_DOUBLE_EQ(hCopies->GetBinContent(bin), hShared->GetBinContent(bin));
+   for (auto bin = 0; bin < pCopies->GetNcells(); ++bin)
+      EXPECT_DOUBLE_EQ(pCopies->GetBinContent(bin), pShared->GetBinContent(bin));
+   EXPECT_EQ(9999, hVec->GetEntries());
+   EXPECT_FALSE(partials.empty());
+   EXPECT_EQ(0u, partials.count(&*hShared));
+}
+#endif
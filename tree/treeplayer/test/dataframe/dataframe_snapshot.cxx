@@ -6,6 +6,7 @@
 #include "TTree.h"
 #include "gtest/gtest.h"
 #include <limits>
+#include <numeric>
 #include <memory>
 using namespace ROOT::Experimental;      // TDataFrame
 using namespace ROOT::Experimental::TDF; // TInterface
@@ -227,6 +228,41 @@ TEST_F(TDFSnapshotArrays, SingleThreadJitted)
    checkSnapshotArrayFile(dj, kNEvents);
 }
 
+TEST(TDFSnapshotMore, SingleThreadFundamentalBranches)
+{
+   // Branches of fundamental type are read in bulk, one basket at a time: the snapshot must write the value of
+   // every entry, across several baskets, not only the one of the first entry
+   const auto kNEntries = 10000;
+   const auto inFileName = "snapshot_fundamental_in.root";
+   const auto outFileName = "snapshot_fundamental_out.root";
+   {
+      TFile f(inFileName, "RECREATE");
+      TTree t("t", "t");
+      int i;
+      double d;
+      t.Branch("i", &i, "i/I", 1000);
+      t.Branch("d", &d, "d/D", 1000);
+      for (i = 0; i < kNEntries; ++i) {
+         d = i * 0.5;
+         t.Fill();
+      }
+      t.Write();
+   }
+
+   TDataFrame tdf("t", inFileName);
+   auto out = tdf.Snapshot<int, double>("t", outFileName, {"i", "d"});
+   auto is = out.Take<int>("i");
+   auto ds = out.Take<double>("d");
+   ASSERT_EQ(size_t(kNEntries), is->size());
+   for (auto i = 0; i < kNEntries; ++i) {
+      EXPECT_EQ(i, is->at(i));
+      EXPECT_DOUBLE_EQ(i * 0.5, ds->at(i));
+   }
+
+   gSystem->Unlink(inFileName);
+   gSystem->Unlink(outFileName);
+}
+
 /********* MULTI THREAD TESTS ***********/
 #ifdef R__USE_IMT
 TEST_F(TDFSnapshotMT, Snapshot_update)
@@ -274,6 +310,86 @@ TEST(TDFSnapshotMore, ManyTasksPerThread)
    ROOT::DisableImplicitMT();
 }
 
+TEST(TDFSnapshotMore, ManyTasksPerThreadValues)
+{
+   const auto nSlots = 4u;
+   ROOT::EnableImplicitMT(nSlots);
+
+   // output trees are re-used across tasks: check that values read from different input files all make it through
+   const std::string inputFilePrefix = "snapshot_manytasksvalues_";
+   const auto nInputFiles = nSlots * 4u;
+   const auto nEntriesPerFile = 10ull;
+   for (auto i = 0u; i < nInputFiles; ++i) {
+      ROOT::Experimental::TDataFrame d(nEntriesPerFile);
+      d.Define("x", [i]() { return int(i); })
+         .Define("v", [i]() { return std::vector<double>(i % 3, i); })
+         .Snapshot<int, std::vector<double>>("t", inputFilePrefix + std::to_string(i) + ".root", {"x", "v"});
+   }
+
+   const auto outputFile = "snapshot_manytasksvalues_out.root";
+   ROOT::Experimental::TDataFrame tdf("t", (inputFilePrefix + "*.root").c_str());
+   tdf.Snapshot<int, std::vector<double>>("t", outputFile, {"x", "v"});
+
+   ROOT::Experimental::TDataFrame checkTdf("t", outputFile);
+   auto c = checkTdf.Count();
+   auto sumX = checkTdf.Sum<int>("x");
+   auto sumV = checkTdf.Define("sv", [](const std::vector<double> &v) { return std::accumulate(v.begin(), v.end(), 0.); },
+                               {"v"})
+                  .Sum<double>("sv");
+   auto expectedSumX = 0.;
+   auto expectedSumV = 0.;
+   for (auto i = 0u; i < nInputFiles; ++i) {
+      expectedSumX += nEntriesPerFile * i;
+      expectedSumV += nEntriesPerFile * (i % 3) * i;
+   }
+   EXPECT_EQ(*c, nInputFiles * nEntriesPerFile);
+   EXPECT_DOUBLE_EQ(*sumX, expectedSumX);
+   EXPECT_DOUBLE_EQ(*sumV, expectedSumV);
+
+   for (auto i = 0u; i < nInputFiles; ++i)
+      gSystem->Unlink((inputFilePrefix + std::to_string(i) + ".root").c_str());
+   gSystem->Unlink(outputFile);
+
+   ROOT::DisableImplicitMT();
+}
+
+TEST(TDFSnapshotMore, OrderedOutput)
+{
+   ROOT::EnableImplicitMT(4);
+
+   // an input file with many clusters, processed by many tasks
+   const auto inputFile = "snapshot_ordered_in.root";
+   const auto nEntries = 10000ull;
+   {
+      ROOT::Experimental::TDataFrame d(nEntries);
+      d.SetOrderedOutput();
+      auto opts = ROOT::Experimental::TDF::TSnapshotOptions();
+      opts.fAutoFlush = 100;
+      d.Define("x", [](ULong64_t e) { return e; }, {"tdfentry_"}).Snapshot<ULong64_t>("t", inputFile, {"x"}, opts);
+   }
+
+   ROOT::Experimental::TDataFrame tdf("t", inputFile);
+   tdf.SetOrderedOutput();
+   auto filtered = tdf.Filter([](ULong64_t x) { return x % 3 != 0; }, {"x"});
+   auto xs = filtered.Take<ULong64_t>("x");
+   const auto outputFile = "snapshot_ordered_out.root";
+   filtered.Snapshot<ULong64_t>("t", outputFile, {"x"});
+
+   std::vector<ULong64_t> expected;
+   for (auto e = 0ull; e < nEntries; ++e)
+      if (e % 3 != 0)
+         expected.emplace_back(e);
+   EXPECT_EQ(*xs, expected);
+
+   // single-thread reading of the output file
+   ROOT::DisableImplicitMT();
+   ROOT::Experimental::TDataFrame checkTdf("t", outputFile);
+   EXPECT_EQ(*checkTdf.Take<ULong64_t>("x"), expected);
+
+   gSystem->Unlink(inputFile);
+   gSystem->Unlink(outputFile);
+}
+
 void checkSnapshotArrayFileMT(TInterface<TLoopManager> &df, unsigned int kNEvents)
 {
    // fixedSizeArr and varSizeArr are TResultProxy<vector<vector<T>>>
@@ -105,6 +105,41 @@ TEST(TCsvDS, ColumnReadersString)
    }
 }
 
+TEST(TCsvDS, SmallChunks)
+{
+   // a few bytes per slot: records are read in several chunks, some lines are split between chunks
+   TCsvDS tds(fileName0, true, ',', 16);
+   const auto nSlots = 2U;
+   tds.SetNSlots(nSlots);
+   auto ages = tds.GetColumnReaders<Long64_t>("Age");
+   auto names = tds.GetColumnReaders<std::string>("Name");
+   std::vector<Long64_t> readAges;
+   std::vector<std::string> readNames;
+   for (auto run : {0, 1}) {
+      tds.Initialise();
+      auto ranges = tds.GetEntryRanges();
+      while (!ranges.empty()) {
+         auto slot = 0U;
+         for (auto &&range : ranges) {
+            EXPECT_EQ(readAges.size() - run * 6U, range.first);
+            tds.InitSlot(slot, range.first);
+            for (auto i : ROOT::TSeq<ULong64_t>(range.first, range.second)) {
+               tds.SetEntry(slot, i);
+               readAges.emplace_back(**ages[slot]);
+               readNames.emplace_back(**names[slot]);
+            }
+            slot = (slot + 1) % nSlots;
+         }
+         ranges = tds.GetEntryRanges();
+      }
+   }
+   // the second event loop reads the file again
+   std::vector<Long64_t> expectedAges = {60, 50, 40, 30, 1, -1, 60, 50, 40, 30, 1, -1};
+   EXPECT_EQ(expectedAges, readAges);
+   EXPECT_EQ("Bob,Bob", readNames[1]);
+   EXPECT_EQ(" Mary Ann ", readNames[11]);
+}
+
 #ifndef NDEBUG
 
 TEST(TCsvDS, SetNSlotsTwice)
@@ -179,6 +214,16 @@ TEST(TCsvDS, FromATDFMT)
    EXPECT_DOUBLE_EQ(.7, *min);
 }
 
+TEST(TCsvDS, SmallChunksMT)
+{
+   auto tdf = MakeCsvDataFrame(fileName0, true, ',', 16);
+   auto sum = tdf.Sum<Long64_t>("Age");
+   auto c = tdf.Count();
+
+   EXPECT_EQ(6U, *c);
+   EXPECT_EQ(180, *sum);
+}
+
 TEST(TCsvDS, FromATDFWithJittingMT)
 {
    std::unique_ptr<TDataSource> tds(new TCsvDS(fileName0));
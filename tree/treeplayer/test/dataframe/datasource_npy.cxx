@@ -0,0 +1,263 @@
+#include <ROOT/TDataFrame.hxx>
+#include <ROOT/TNpyDS.hxx>
+#include <ROOT/TSeq.hxx>
+#include "RConfig.h"
+#include "TSystem.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+
+using namespace ROOT::Experimental;
+using namespace ROOT::Experimental::TDF;
+
+#ifdef R__BYTESWAP
+const std::string order = "<";
+#else
+const std::string order = ">";
+#endif
+
+// Append the nBytes least significant bytes of value, in little endian order
+void AppendLittleEndian(std::string &s, ULong64_t value, unsigned int nBytes)
+{
+   for (auto i : ROOT::TSeqU(nBytes))
+      s += static_cast<char>((value >> (8 * i)) & 0xFF);
+}
+
+template <typename T>
+void AppendValues(std::string &s, const std::vector<T> &values)
+{
+   s.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+// The content of a .npy file, version 1.0, without values
+std::string MakeNpy(const std::string &descr, const std::string &shape, bool fortranOrder = false)
+{
+   std::string dict = "{'descr': " + descr + ", 'fortran_order': " + (fortranOrder ? "True" : "False") +
+                      ", 'shape': " + shape + ", }";
+   // the values start at a multiple of 64 bytes
+   while ((10 + dict.size() + 1) % 64 != 0)
+      dict += ' ';
+   dict += '\n';
+   std::string npy("\x93NUMPY\x01\x00", 8);
+   AppendLittleEndian(npy, dict.size(), 2);
+   return npy + dict;
+}
+
+void WriteFile(const std::string &fileName, const std::string &content)
+{
+   std::ofstream(fileName, std::ios::binary) << content;
+}
+
+// A zip archive of stored, i.e. not compressed, members. CRCs are not computed.
+std::string MakeZip(const std::vector<std::pair<std::string, std::string>> &members, unsigned int method = 0)
+{
+   std::string zip, centralDirectory;
+   for (const auto &member : members) {
+      const auto &name = member.first;
+      const auto &data = member.second;
+      std::string header;
+      AppendLittleEndian(header, 20, 2);          // version
+      AppendLittleEndian(header, 0, 2);           // flags
+      AppendLittleEndian(header, method, 2);      // compression method
+      AppendLittleEndian(header, 0, 8);           // time, date, crc
+      AppendLittleEndian(header, data.size(), 4); // compressed size
+      AppendLittleEndian(header, data.size(), 4); // uncompressed size
+      AppendLittleEndian(header, name.size(), 2);
+      AppendLittleEndian(header, 0, 2); // extra field size
+
+      AppendLittleEndian(centralDirectory, 0x02014b50, 4);
+      AppendLittleEndian(centralDirectory, 20, 2); // version made by
+      centralDirectory += header;
+      AppendLittleEndian(centralDirectory, 0, 10); // comment size, disk, attributes
+      AppendLittleEndian(centralDirectory, zip.size(), 4);
+      centralDirectory += name;
+
+      AppendLittleEndian(zip, 0x04034b50, 4);
+      zip += header + name + data;
+   }
+   const auto centralDirectoryOffset = zip.size();
+   zip += centralDirectory;
+   AppendLittleEndian(zip, 0x06054b50, 4);
+   AppendLittleEndian(zip, 0, 4); // disks
+   AppendLittleEndian(zip, members.size(), 2);
+   AppendLittleEndian(zip, members.size(), 2);
+   AppendLittleEndian(zip, centralDirectory.size(), 4);
+   AppendLittleEndian(zip, centralDirectoryOffset, 4);
+   AppendLittleEndian(zip, 0, 2); // comment size
+   return zip;
+}
+
+std::string MakeNpyX()
+{
+   auto npy = MakeNpy("'" + order + "f8'", "(5,)");
+   AppendValues(npy, std::vector<double>{1., 2., 3., 4., 5.});
+   return npy;
+}
+
+std::string MakeNpyY()
+{
+   auto npy = MakeNpy("'|u1'", "(5,)");
+   AppendValues(npy, std::vector<UChar_t>{10, 20, 30, 40, 50});
+   return npy;
+}
+
+TEST(TNpyDS, ColTypeNames)
+{
+   WriteFile("TNpyDS_test_x.npy", MakeNpyX());
+   TNpyDS tds("TNpyDS_test_x.npy");
+   tds.SetNSlots(1);
+
+   auto colNames = tds.GetColumnNames();
+   ASSERT_EQ(1U, colNames.size());
+   EXPECT_STREQ("TNpyDS_test_x", colNames[0].c_str());
+   EXPECT_TRUE(tds.HasColumn("TNpyDS_test_x"));
+   EXPECT_FALSE(tds.HasColumn("x"));
+   EXPECT_STREQ("double", tds.GetTypeName("TNpyDS_test_x").c_str());
+   EXPECT_THROW(tds.GetTypeName("x"), std::runtime_error);
+   EXPECT_THROW(tds.GetColumnReaders<float>("TNpyDS_test_x"), std::runtime_error);
+   gSystem->Unlink("TNpyDS_test_x.npy");
+}
+
+TEST(TNpyDS, EntryRanges)
+{
+   WriteFile("TNpyDS_test_x.npy", MakeNpyX());
+   TNpyDS tds("TNpyDS_test_x.npy");
+   tds.SetNSlots(3U);
+   tds.Initialise();
+
+   auto ranges = tds.GetEntryRanges();
+
+   ASSERT_EQ(3U, ranges.size());
+   EXPECT_EQ(0U, ranges[0].first);
+   EXPECT_EQ(2U, ranges[0].second);
+   EXPECT_EQ(2U, ranges[1].first);
+   EXPECT_EQ(4U, ranges[1].second);
+   EXPECT_EQ(4U, ranges[2].first);
+   EXPECT_EQ(5U, ranges[2].second);
+   EXPECT_TRUE(tds.GetEntryRanges().empty());
+   gSystem->Unlink("TNpyDS_test_x.npy");
+}
+
+TEST(TNpyDS, ColumnReaders)
+{
+   WriteFile("TNpyDS_test_x.npy", MakeNpyX());
+   TNpyDS tds("TNpyDS_test_x.npy");
+   const auto nSlots = 2U;
+   tds.SetNSlots(nSlots);
+   auto vals = tds.GetColumnReaders<double>("TNpyDS_test_x");
+   tds.Initialise();
+   auto slot = 0U;
+   for (auto &&range : tds.GetEntryRanges()) {
+      tds.InitSlot(slot, range.first);
+      for (auto i : ROOT::TSeq<ULong64_t>(range.first, range.second)) {
+         tds.SetEntry(slot, i);
+         EXPECT_EQ(i + 1., **vals[slot]);
+      }
+      slot++;
+   }
+   gSystem->Unlink("TNpyDS_test_x.npy");
+}
+
+TEST(TNpyDS, TwoDimensions)
+{
+   auto cOrder = MakeNpy("'" + order + "i4'", "(3, 2)");
+   AppendValues(cOrder, std::vector<Int_t>{1, 2, 3, 4, 5, 6});
+   WriteFile("TNpyDS_test_c.npy", cOrder);
+   auto tdf = MakeNpyDataFrame("TNpyDS_test_c.npy");
+   auto col0 = tdf.Take<Int_t>("TNpyDS_test_c_0");
+   auto col1 = tdf.Take<Int_t>("TNpyDS_test_c_1");
+   EXPECT_EQ(std::vector<Int_t>({1, 3, 5}), *col0);
+   EXPECT_EQ(std::vector<Int_t>({2, 4, 6}), *col1);
+
+   auto fortranOrder = MakeNpy("'" + order + "i4'", "(3, 2)", true);
+   AppendValues(fortranOrder, std::vector<Int_t>{1, 2, 3, 4, 5, 6});
+   WriteFile("TNpyDS_test_f.npy", fortranOrder);
+   auto tdfF = MakeNpyDataFrame("TNpyDS_test_f.npy");
+   auto colF0 = tdfF.Take<Int_t>("TNpyDS_test_f_0");
+   auto colF1 = tdfF.Take<Int_t>("TNpyDS_test_f_1");
+   EXPECT_EQ(std::vector<Int_t>({1, 2, 3}), *colF0);
+   EXPECT_EQ(std::vector<Int_t>({4, 5, 6}), *colF1);
+   gSystem->Unlink("TNpyDS_test_c.npy");
+   gSystem->Unlink("TNpyDS_test_f.npy");
+}
+
+TEST(TNpyDS, Structured)
+{
+   // packed records: the doubles are not aligned
+   auto npy = MakeNpy("[('n', '" + order + "i4'), ('', '|V1'), ('x', '" + order + "f8')]", "(4,)");
+   for (auto i : ROOT::TSeqI(4)) {
+      const Int_t n = i;
+      const double x = 0.5 * i;
+      npy.append(reinterpret_cast<const char *>(&n), sizeof(n));
+      npy += '\0';
+      npy.append(reinterpret_cast<const char *>(&x), sizeof(x));
+   }
+   WriteFile("TNpyDS_test_s.npy", npy);
+   auto tdf = MakeNpyDataFrame("TNpyDS_test_s.npy");
+   const std::vector<std::string> colNames({"n", "x"});
+   EXPECT_EQ(colNames, tdf.GetColumnNames());
+   auto n = tdf.Sum<Int_t>("n");
+   auto x = tdf.Take<double>("x");
+   auto jittedX = tdf.Filter("x > 0.").Sum("x");
+   EXPECT_EQ(6, *n);
+   EXPECT_EQ(std::vector<double>({0., 0.5, 1., 1.5}), *x);
+   EXPECT_DOUBLE_EQ(3., *jittedX);
+   gSystem->Unlink("TNpyDS_test_s.npy");
+}
+
+TEST(TNpyDS, Npz)
+{
+   WriteFile("TNpyDS_test.npz", MakeZip({{"x.npy", MakeNpyX()}, {"y.npy", MakeNpyY()}}));
+   auto tdf = MakeNpyDataFrame("TNpyDS_test.npz");
+   const std::vector<std::string> colNames({"x", "y"});
+   EXPECT_EQ(colNames, tdf.GetColumnNames());
+   auto x = tdf.Sum<double>("x");
+   auto y = tdf.Take<UChar_t>("y");
+   EXPECT_DOUBLE_EQ(15., *x);
+   EXPECT_EQ(std::vector<UChar_t>({10, 20, 30, 40, 50}), *y);
+
+   WriteFile("TNpyDS_test_compressed.npz", MakeZip({{"x.npy", MakeNpyX()}}, 8));
+   EXPECT_THROW(TNpyDS("TNpyDS_test_compressed.npz"), std::runtime_error);
+   gSystem->Unlink("TNpyDS_test.npz");
+   gSystem->Unlink("TNpyDS_test_compressed.npz");
+}
+
+TEST(TNpyDS, Directory)
+{
+   gSystem->mkdir("TNpyDS_test_dir");
+   WriteFile("TNpyDS_test_dir/y.npy", MakeNpyY());
+   WriteFile("TNpyDS_test_dir/x.npy", MakeNpyX());
+   WriteFile("TNpyDS_test_dir/notes.txt", "not an array");
+   auto tdf = MakeNpyDataFrame("TNpyDS_test_dir");
+   const std::vector<std::string> colNames({"x", "y"});
+   EXPECT_EQ(colNames, tdf.GetColumnNames());
+   auto c = tdf.Filter([](double x, UChar_t y) { return x * 10 == y; }, {"x", "y"}).Count();
+   EXPECT_EQ(5U, *c);
+
+   // all columns must have the same number of entries
+   auto z = MakeNpy("'" + order + "f8'", "(2,)");
+   AppendValues(z, std::vector<double>{1., 2.});
+   WriteFile("TNpyDS_test_dir/z.npy", z);
+   EXPECT_THROW(TNpyDS("TNpyDS_test_dir"), std::runtime_error);
+   for (auto f : {"x.npy", "y.npy", "z.npy", "notes.txt"})
+      gSystem->Unlink((std::string("TNpyDS_test_dir/") + f).c_str());
+   gSystem->Unlink("TNpyDS_test_dir");
+}
+
+TEST(TNpyDS, Errors)
+{
+   EXPECT_THROW(TNpyDS("TNpyDS_test_missing.npy"), std::runtime_error);
+   WriteFile("TNpyDS_test_bad.npy", "not an array");
+   EXPECT_THROW(TNpyDS("TNpyDS_test_bad.npy"), std::runtime_error);
+   // truncated values
+   WriteFile("TNpyDS_test_bad.npy", MakeNpy("'" + order + "f8'", "(5,)"));
+   EXPECT_THROW(TNpyDS("TNpyDS_test_bad.npy"), std::runtime_error);
+   // strings are not supported
+   auto strings = MakeNpy("'<U3'", "(1,)");
+   strings.append(12, 'a');
+   WriteFile("TNpyDS_test_bad.npy", strings);
+   EXPECT_THROW(TNpyDS("TNpyDS_test_bad.npy"), std::runtime_error);
+   gSystem->Unlink("TNpyDS_test_bad.npy");
+}
@@ -1,4 +1,7 @@
+#include <TFile.h>
 #include <TGraph.h>
+#include <TSystem.h>
+#include <TTree.h>
 #include <ROOT/TDataFrame.hxx>
 #include <ROOT/TRootDS.hxx>
 #include <ROOT/TSeq.hxx>
@@ -89,6 +92,87 @@ TEST(TRootTDS, ColumnReaders)
    }
 }
 
+TEST(TRootTDS, ClusterAlignedEntryRanges)
+{
+   const auto clusteredFileName = "TRootTDS_clustered.root";
+   {
+      TFile f(clusteredFileName, "RECREATE");
+      TTree t(treeName, treeName);
+      t.SetAutoFlush(30); // clusters start at entries 0, 30, 60 and 90
+      int i = 0;
+      t.Branch("i", &i);
+      for (; i < 100; ++i)
+         t.Fill();
+      t.Write();
+   }
+
+   TRootDS tds(treeName, clusteredFileName);
+   const auto nSlots = 3U;
+   tds.SetNSlots(nSlots);
+   auto vals = tds.GetColumnReaders<int>("i");
+   tds.Initialise();
+
+   // ranges are split at the cluster boundaries that follow the even split points
+   auto ranges = tds.GetEntryRanges();
+   ASSERT_EQ(3U, ranges.size());
+   EXPECT_EQ(0U, ranges[0].first);
+   EXPECT_EQ(60U, ranges[0].second);
+   EXPECT_EQ(60U, ranges[1].first);
+   EXPECT_EQ(90U, ranges[1].second);
+   EXPECT_EQ(90U, ranges[2].first);
+   EXPECT_EQ(100U, ranges[2].second);
+
+   auto slot = 0U;
+   for (auto &&range : ranges) {
+      tds.InitSlot(slot, range.first);
+      for (auto i : ROOT::TSeq<int>(range.first, range.second)) {
+         tds.SetEntry(slot, i);
+         EXPECT_EQ(i, **vals[slot]);
+      }
+      slot++;
+   }
+   gSystem->Unlink(clusteredFileName);
+}
+
+// Only the branches of the requested columns are read
+TEST(TRootTDS, UnrequestedBranchesNotRead)
+{
+   const auto prunedFileName = "TRootTDS_pruned.root";
+   Long64_t unrequestedBytes = 0;
+   {
+      // not compressed, so that the size of each branch in the file is known
+      TFile f(prunedFileName, "RECREATE", "", 0);
+      TTree t(treeName, treeName);
+      int i = 0;
+      double big[100];
+      t.Branch("i", &i);
+      t.Branch("big", big, "big[100]/D");
+      for (; i < 1000; ++i) {
+         std::fill(std::begin(big), std::end(big), i);
+         t.Fill();
+      }
+      t.Write();
+      unrequestedBytes = t.GetBranch("big")->GetZipBytes();
+   }
+
+   TRootDS tds(treeName, prunedFileName);
+   tds.SetNSlots(1U);
+   auto vals = tds.GetColumnReaders<int>("i");
+   tds.Initialise();
+   const auto bytesReadBefore = TFile::GetFileBytesRead();
+   for (auto &&range : tds.GetEntryRanges()) {
+      tds.InitSlot(0U, range.first);
+      for (auto i : ROOT::TSeq<int>(range.first, range.second)) {
+         tds.SetEntry(0U, i);
+         EXPECT_EQ(i, **vals[0]);
+      }
+   }
+   tds.Finalise();
+   // the file metadata and the baskets of "i" are read, none of the baskets of "big"
+   EXPECT_LT(TFile::GetFileBytesRead() - bytesReadBefore, unrequestedBytes / 2);
+   gSystem->Unlink(prunedFileName);
+}
+
 #ifndef NDEBUG
 
 TEST(TRootTDS, SetNSlotsTwice)